@@ -145,6 +145,8 @@ foreach(oneflow_single_file ${oneflow_all_src})
       if(RPC_BACKEND MATCHES "GRPC")
         list(APPEND of_transport_test_cc ${oneflow_single_file})
       endif()
+    elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/core/serving/.*_main\\.cpp$")
+      list(APPEND of_main_cc ${oneflow_single_file})
     elseif("${oneflow_single_file}" MATCHES "^${PROJECT_SOURCE_DIR}/oneflow/(core|user|xrt)/.*_test\\.cpp$")
       # test file
       list(APPEND of_all_test_cc ${oneflow_single_file})
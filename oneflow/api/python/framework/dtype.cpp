@@ -36,6 +36,7 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
 
   m.attr("char") = DType::Char().get();
   m.attr("float16") = DType::Float16().get();
+  m.attr("bfloat16") = DType::BFloat16().get();
   m.attr("float") = DType::Float().get();
 
   m.attr("float32") = DType::Float().get();
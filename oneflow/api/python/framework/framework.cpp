@@ -29,6 +29,7 @@ ONEFLOW_API_PYBIND11_MODULE("", m) {
   m.def("GetSerializedInterUserJobInfo",
         []() { return py::bytes(GetSerializedInterUserJobInfo()); });
   m.def("GetSerializedJobSet", []() { return py::bytes(GetSerializedJobSet()); });
+  m.def("GetSerializedPlan", []() { return py::bytes(GetSerializedPlan()); });
   m.def("GetSerializedStructureGraph", &GetSerializedStructureGraph /* a prototxt saved to file*/);
   m.def("GetSerializedCurrentJob", []() { return py::bytes(GetSerializedCurrentJob()); });
 
@@ -88,6 +88,12 @@ inline Maybe<std::string> GetSerializedInterUserJobInfo() {
   return Global<InterUserJobInfo>::Get()->SerializeAsString();
 }
 
+inline Maybe<std::string> GetSerializedPlan() {
+  CHECK_OR_RETURN(GlobalProcessCtx::IsThisProcessMaster());
+  CHECK_NOTNULL_OR_RETURN(Global<Oneflow>::Get());
+  return Global<Oneflow>::Get()->plan().SerializeAsString();
+}
+
 inline Maybe<const JobSet&> GetJobSet() {
   JobBuildAndInferCtxMgr* job_ctx_mgr;
   if (*Global<bool, EagerExecution>::Get()) {
@@ -36,6 +36,8 @@ inline std::string GetSerializedInterUserJobInfo() {
   return oneflow::GetSerializedInterUserJobInfo().GetOrThrow();
 }
 
+inline std::string GetSerializedPlan() { return oneflow::GetSerializedPlan().GetOrThrow(); }
+
 inline std::string GetSerializedJobSet() { return oneflow::GetSerializedJobSet().GetOrThrow(); }
 
 inline std::string GetSerializedStructureGraph() {
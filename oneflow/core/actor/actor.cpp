@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/thread/thread_manager.h"
 #include "oneflow/core/job/runtime_job_descs.h"
+#include "oneflow/core/job/resource_desc.h"
+#include "oneflow/core/job/global_for.h"
 #include "oneflow/core/control/global_process_ctx.h"
 
 namespace oneflow {
@@ -39,16 +41,20 @@ void CheckInplaceRegstDescId(const TaskProto& task_proto) {
 
 void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
                  const ThreadCtx& thread_ctx) {
+  const auto start = std::chrono::steady_clock::now();
   job_desc_ = job_desc;
   actor_id_ = task_proto.task_id();
+  task_type_ = task_proto.task_type();
   act_id_ = -1;
   InitDeviceCtx(thread_ctx);
   if (task_proto.has_parallel_ctx()) {
     parallel_ctx_.reset(new ParallelContext(task_proto.parallel_ctx()));
   }
   for (const ExecNodeProto& node : task_proto.exec_sequence().exec_node()) {
+    std::unique_ptr<Kernel> kernel = ConstructKernelWithoutDevice(job_desc_, node.kernel_conf());
+    deferred_kernels_.push_back(kernel.get());
     ExecKernel ek;
-    ek.kernel = ConstructKernel(job_desc_, node.kernel_conf(), device_ctx_.get());
+    ek.kernel.reset(kernel.release());
     exec_kernel_vec_.push_back(std::move(ek));
   }
 
@@ -95,8 +101,17 @@ void Actor::Init(const JobDesc* job_desc, const TaskProto& task_proto,
   is_naive_consumed_eord_ = false;
   TakeOverNaiveConsumed(task_proto.consumed_regst_desc_id());
   TakeOverNaiveProduced(task_proto.produced_regst_desc());
-  InitBnInOp2BlobInfo(task_proto);
+  InitSlot2BlobInfo(task_proto);
   VirtualActorInit(task_proto);
+  // kernel init is timed on its own, so it is left out of the construct time
+  const double time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()
+                         / 1000.0;
+  Global<RuntimeCtx>::Get()->AddActorStartupTime("construct", task_type_, time_ms);
+  if (!Global<ResourceDesc, ForSession>::Get()->enable_lazy_kernel_init()) {
+    InitDeferredKernels();
+  }
 }
 
 void Actor::TakeOverInplaceConsumedAndProduced(
@@ -165,14 +180,20 @@ void Actor::TakeOverNaiveProduced(const PbMap<std::string, RegstDescProto>& prod
   }
 }
 
-void Actor::InitBnInOp2BlobInfo(const TaskProto& task_proto) {
+const Actor::BlobInfo& Actor::ExecKernel::BlobInfo4BnInOp(const std::string& bn_in_op) const {
+  const int64_t slot = kernel->Slot4BnInOp(bn_in_op);
+  CHECK_NE(slot, -1) << bn_in_op;
+  return slot2blob_info.at(slot);
+}
+
+void Actor::InitSlot2BlobInfo(const TaskProto& task_proto) {
   for (int64_t i = 0; i < exec_kernel_vec_.size(); ++i) {
     ExecKernel& ek = exec_kernel_vec_.at(i);
     const ExecNodeProto& node = task_proto.exec_sequence().exec_node(i);
-    for (auto& pair : node.kernel_conf().op_attribute().arg_signature().bn_in_op2lbi()) {
+    const auto& bn_in_op2lbi = node.kernel_conf().op_attribute().arg_signature().bn_in_op2lbi();
+    for (const std::string& bn : ek.kernel->slot2bn_in_op()) {
       BlobInfo blob_info;
-      blob_info.lbi = pair.second;
-      const std::string& bn = pair.first;
+      blob_info.lbi = bn_in_op2lbi.at(bn);
       auto regst_desc_id_it = node.bn_in_op2regst_desc_id().find(bn);
       if (regst_desc_id_it != node.bn_in_op2regst_desc_id().end()
           && Global<RegstMgr>::Get()->HasRegstDescId(regst_desc_id_it->second)) {
@@ -197,8 +218,9 @@ void Actor::InitBnInOp2BlobInfo(const TaskProto& task_proto) {
         blob_info.ordinal = -1;
         blob_info.rs = nullptr;
       }
-      ek.bn_in_op2blob_info.emplace(bn, std::move(blob_info));
+      ek.slot2blob_info.push_back(std::move(blob_info));
     }
+    ek.slot2blob.resize(ek.slot2blob_info.size(), nullptr);
   }
 }
 
@@ -415,8 +437,20 @@ void Actor::TryLogActEvent(const std::function<void()>& DoAct) const {
   }
 }
 
+void Actor::InitDeferredKernels() {
+  const auto start = std::chrono::steady_clock::now();
+  for (Kernel* kernel : deferred_kernels_) { kernel->InitDevice(device_ctx_.get()); }
+  deferred_kernels_.clear();
+  const double time_ms = std::chrono::duration_cast<std::chrono::microseconds>(
+                             std::chrono::steady_clock::now() - start)
+                             .count()
+                         / 1000.0;
+  Global<RuntimeCtx>::Get()->AddActorStartupTime("kernel_init", task_type_, time_ms);
+}
+
 void Actor::ActUntilFail() {
   while (IsReadReady() && IsWriteReady()) {
+    if (!deferred_kernels_.empty()) { InitDeferredKernels(); }
     act_id_ += 1;
     TryLogActEvent([&] { Act(); });
 
@@ -537,25 +571,28 @@ bool Actor::IsWriteReady() const {
 
 void Actor::AsyncLaunchKernel(const KernelCtx& kernel_ctx,
                               std::function<Regst*(int64_t)> Regst4RegstDescId) {
-  for (const ExecKernel& ek : exec_kernel_vec_) {
-    ek.kernel->Launch(kernel_ctx, [&](const std::string& bn_in_op) -> Blob* {
-      const auto blob_info_it = ek.bn_in_op2blob_info.find(bn_in_op);
-      if (blob_info_it == ek.bn_in_op2blob_info.cend()) { return nullptr; }
-      const BlobInfo& info = blob_info_it->second;
-      if (info.regst_desc_id == -1) { return nullptr; }
-      Regst* regst;
-      if (info.rs != nullptr) {
-        regst = info.rs->Front(info.regst_desc_id);
-      } else {
-        regst = Regst4RegstDescId(info.regst_desc_id);
-      }
-      if (regst == nullptr) { return nullptr; }
-      if (info.ordinal >= 0) {
-        return regst->GetBlobByOrdinal(info.ordinal);
-      } else {
-        return regst->GetBlobByLbi(info.lbi);
+  for (ExecKernel& ek : exec_kernel_vec_) {
+    FOR_RANGE(size_t, slot, 0, ek.slot2blob_info.size()) {
+      const BlobInfo& info = ek.slot2blob_info[slot];
+      Blob* blob = nullptr;
+      if (info.regst_desc_id != -1) {
+        Regst* regst;
+        if (info.rs != nullptr) {
+          regst = info.rs->Front(info.regst_desc_id);
+        } else {
+          regst = Regst4RegstDescId(info.regst_desc_id);
+        }
+        if (regst != nullptr) {
+          if (info.ordinal >= 0) {
+            blob = regst->GetBlobByOrdinal(info.ordinal);
+          } else {
+            blob = regst->GetBlobByLbi(info.lbi);
+          }
+        }
       }
-    });
+      ek.slot2blob[slot] = blob;
+    }
+    ek.kernel->Launch(kernel_ctx, ek.slot2blob);
   }
 }
 
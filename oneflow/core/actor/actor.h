@@ -56,7 +56,11 @@ class Actor {
   };
   struct ExecKernel {
     std::unique_ptr<const Kernel> kernel;
-    HashMap<std::string, BlobInfo> bn_in_op2blob_info;
+    // indexed by the slots of the kernel
+    std::vector<BlobInfo> slot2blob_info;
+    std::vector<Blob*> slot2blob;
+
+    const BlobInfo& BlobInfo4BnInOp(const std::string& bn_in_op) const;
   };
   using MsgHandler = int (Actor::*)(const ActorMsg&);
   enum class RegstNameType { kNaive = 0, kCustomized };
@@ -165,6 +169,8 @@ class Actor {
 
   // Act
   void ActUntilFail();
+  // Kernel::InitDevice of the kernels whose init is deferred to the first act
+  void InitDeferredKernels();
   virtual void Act() { UNIMPLEMENTED(); }
   virtual int64_t ActNumForEachOutput(int64_t regst_desc_id) const { return 1; }
   virtual bool CheckOutputActId(int64_t regst_desc_id) const {
@@ -182,7 +188,7 @@ class Actor {
       const PbMap<std::string, RegstDescProto>& produced_ids);
   void TakeOverNaiveConsumed(const PbMap<std::string, RegstDescIdSet>& consumed_ids);
   void TakeOverNaiveProduced(const PbMap<std::string, RegstDescProto>& produced_ids);
-  void InitBnInOp2BlobInfo(const TaskProto& task_proto);
+  void InitSlot2BlobInfo(const TaskProto& task_proto);
 
   // Send Msgs
   void AsyncSendNaiveProducedRegstMsgToConsumer();
@@ -219,9 +225,11 @@ class Actor {
 
   const JobDesc* job_desc_;
   int64_t actor_id_;
+  TaskType task_type_;
   int64_t act_id_;
   std::unique_ptr<ParallelContext> parallel_ctx_;
   std::vector<ExecKernel> exec_kernel_vec_;
+  std::vector<Kernel*> deferred_kernels_;
   HashMap<std::string, std::vector<int64_t>> name2regst_desc_id_;
   MsgHandler msg_handler_;
   std::unique_ptr<DeviceCtx> device_ctx_;
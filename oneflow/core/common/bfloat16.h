@@ -0,0 +1,91 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_BFLOAT16_H_
+#define ONEFLOW_CORE_COMMON_BFLOAT16_H_
+
+#include <cstdint>
+#include <cstring>
+
+namespace oneflow {
+
+#if defined(__CUDACC__)
+#define OF_BFLOAT16_FUNC __device__ __host__ __forceinline__
+#else
+#define OF_BFLOAT16_FUNC inline
+#endif
+
+// The upper half of an IEEE 754 float, i.e. the range of float with an 8-bit mantissa. It is
+// converted from float with round to nearest even and computed on as float
+struct alignas(2) bfloat16 {
+  uint16_t x;
+
+  bfloat16() = default;
+  OF_BFLOAT16_FUNC bfloat16(float value) : x(RoundToNearestEven(value)) {}
+
+  OF_BFLOAT16_FUNC operator float() const {
+    const uint32_t bits = static_cast<uint32_t>(x) << 16;
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  OF_BFLOAT16_FUNC bfloat16& operator+=(float rhs) {
+    return *this = static_cast<float>(*this) + rhs;
+  }
+  OF_BFLOAT16_FUNC bfloat16& operator-=(float rhs) {
+    return *this = static_cast<float>(*this) - rhs;
+  }
+  OF_BFLOAT16_FUNC bfloat16& operator*=(float rhs) {
+    return *this = static_cast<float>(*this) * rhs;
+  }
+  OF_BFLOAT16_FUNC bfloat16& operator/=(float rhs) {
+    return *this = static_cast<float>(*this) / rhs;
+  }
+
+  static OF_BFLOAT16_FUNC bfloat16 FromBits(uint16_t bits) {
+    bfloat16 ret;
+    ret.x = bits;
+    return ret;
+  }
+
+ private:
+  static OF_BFLOAT16_FUNC uint16_t RoundToNearestEven(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    // keeps NaN a quiet NaN instead of rounding it to infinity
+    if ((bits & 0x7fffffffU) > 0x7f800000U) { return static_cast<uint16_t>((bits >> 16) | 0x40U); }
+    bits += 0x7fffU + ((bits >> 16) & 1U);
+    return static_cast<uint16_t>(bits >> 16);
+  }
+};
+
+static_assert(sizeof(bfloat16) == 2, "sizeof(bfloat16) != 2");
+
+// Converts n elements at once, which the compiler vectorizes unlike the loops over bfloat16
+inline void ConvertBFloat16ToFloat(const bfloat16* src, float* dst, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    const uint32_t bits = static_cast<uint32_t>(src[i].x) << 16;
+    std::memcpy(dst + i, &bits, sizeof(bits));
+  }
+}
+
+inline void ConvertFloatToBFloat16(const float* src, bfloat16* dst, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) { dst[i] = bfloat16(src[i]); }
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_BFLOAT16_H_
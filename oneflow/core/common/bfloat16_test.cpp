@@ -0,0 +1,55 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/data_type.h"
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace oneflow {
+
+TEST(BFloat16, round_to_nearest_even) {
+  // 1 + 2^-8 is halfway between 1 and 1 + 2^-7, and rounds to 1 whose mantissa is even
+  ASSERT_EQ(bfloat16(1.00390625f).x, 0x3f80);
+  // 1 + 3 * 2^-8 is halfway between 1 + 2^-7 and 1 + 2^-6, and rounds to 1 + 2^-6
+  ASSERT_EQ(bfloat16(1.01171875f).x, 0x3f82);
+  ASSERT_EQ(bfloat16(1.005f).x, 0x3f81);
+  ASSERT_EQ(bfloat16(-2.0f).x, 0xc000);
+}
+
+TEST(BFloat16, special_values) {
+  ASSERT_EQ(bfloat16(std::numeric_limits<float>::infinity()).x, 0x7f80);
+  ASSERT_EQ(bfloat16(-std::numeric_limits<float>::infinity()).x, 0xff80);
+  ASSERT_TRUE(std::isnan(static_cast<float>(bfloat16(std::nanf("")))));
+  // the max float rounds up to infinity
+  ASSERT_EQ(bfloat16(std::numeric_limits<float>::max()).x, 0x7f80);
+  ASSERT_EQ(static_cast<float>(GetMaxVal<bfloat16>()), 3.38953139e38f);
+}
+
+TEST(BFloat16, round_trip) {
+  std::vector<float> src = {0.0f, 1.0f, -1.5f, 0.15625f, 65280.0f, 1e-30f};
+  std::vector<bfloat16> half(src.size());
+  std::vector<float> dst(src.size());
+  ConvertFloatToBFloat16(src.data(), half.data(), src.size());
+  ConvertBFloat16ToFloat(half.data(), dst.data(), half.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    ASSERT_EQ(static_cast<float>(bfloat16(src[i])), dst[i]);
+    ASSERT_LE(std::abs(dst[i] - src[i]), std::abs(src[i]) / 256);
+  }
+  ASSERT_EQ(dst[1], 1.0f);
+  ASSERT_EQ(dst[2], -1.5f);
+}
+
+}  // namespace oneflow
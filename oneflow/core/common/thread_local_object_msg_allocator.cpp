@@ -0,0 +1,229 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <algorithm>
+#include <atomic>
+#include "oneflow/core/common/thread_local_object_msg_allocator.h"
+
+namespace oneflow {
+
+struct ObjMsgSlabPool;
+
+namespace {
+
+// In front of every memory block. 16 bytes, so that the memory blocks are aligned as malloc does
+struct alignas(16) ObjMsgSlabBlockHeader final {
+  // nullptr if the memory block is allocated from the backend allocator directly
+  ObjMsgSlabPool* pool;
+};
+
+ObjMsgSlabBlockHeader* BlockHeader4MemPtr(char* mem_ptr) {
+  return reinterpret_cast<ObjMsgSlabBlockHeader*>(mem_ptr - sizeof(ObjMsgSlabBlockHeader));
+}
+
+// a free memory block holds the next free one
+char*& NextFreeMemPtr(char* mem_ptr) { return *reinterpret_cast<char**>(mem_ptr); }
+
+std::atomic<int64_t> next_allocator_id(0);
+
+}  // namespace
+
+// The free memory blocks of one size in the heap of a thread
+struct ObjMsgSlabPool final {
+  ObjMsgSlabPool(ObjMsgThreadHeap* heap, int64_t mem_size)
+      : heap(heap), mem_size(mem_size), local_free_list(nullptr), remote_free_list(nullptr) {}
+
+  ObjMsgThreadHeap* heap;
+  int64_t mem_size;
+  // only accessed by the thread of the heap
+  char* local_free_list;
+  std::vector<std::pair<char*, int64_t>> slabs;
+  // pushed by the other threads and taken as a whole by the thread of the heap
+  std::atomic<char*> remote_free_list;
+};
+
+struct ObjMsgThreadHeap final {
+  ObjMsgThreadHeap(int64_t allocator_id, int mem_size_shift_min, int mem_size_shift_max)
+      : allocator_id(allocator_id), abandoned(false) {
+    for (int shift = mem_size_shift_min; shift <= mem_size_shift_max; ++shift) {
+      pools.emplace_back(new ObjMsgSlabPool(this, static_cast<int64_t>(1) << shift));
+    }
+  }
+
+  const int64_t allocator_id;
+  std::vector<std::unique_ptr<ObjMsgSlabPool>> pools;
+  // set when the thread of the heap exits, and reset when another thread takes over the heap
+  std::atomic<bool> abandoned;
+};
+
+namespace {
+
+struct ThreadHeaps final {
+  ~ThreadHeaps() {
+    for (const auto& heap : heaps) { heap->abandoned.store(true, std::memory_order_release); }
+  }
+
+  std::vector<std::shared_ptr<ObjMsgThreadHeap>> heaps;
+};
+
+// Trivially destructible, so that they are still valid in the thread_local destructors run after
+// the heaps are abandoned
+thread_local ThreadHeaps* tls_thread_heaps = nullptr;
+thread_local ObjMsgThreadHeap* tls_last_heap = nullptr;
+thread_local bool tls_thread_exited = false;
+
+struct ThreadHeapsReaper final {
+  ThreadHeapsReaper() { tls_thread_heaps = new ThreadHeaps(); }
+  ~ThreadHeapsReaper() {
+    tls_thread_exited = true;
+    tls_last_heap = nullptr;
+    delete tls_thread_heaps;
+    tls_thread_heaps = nullptr;
+  }
+};
+
+thread_local ThreadHeapsReaper tls_thread_heaps_reaper;
+
+void AllocateSlab(ObjectMsgAllocator* backend_allocator, int64_t slab_size, ObjMsgSlabPool* pool) {
+  const int64_t block_size = sizeof(ObjMsgSlabBlockHeader) + pool->mem_size;
+  const int64_t block_cnt = std::max<int64_t>(slab_size / block_size, 1);
+  char* slab = backend_allocator->Allocate(block_cnt * block_size);
+  pool->slabs.emplace_back(slab, block_cnt * block_size);
+  for (int64_t i = block_cnt - 1; i >= 0; --i) {
+    char* mem_ptr = slab + i * block_size + sizeof(ObjMsgSlabBlockHeader);
+    BlockHeader4MemPtr(mem_ptr)->pool = pool;
+    NextFreeMemPtr(mem_ptr) = pool->local_free_list;
+    pool->local_free_list = mem_ptr;
+  }
+}
+
+}  // namespace
+
+const int ThreadLocalObjectMsgAllocator::kMemSizeShiftMin;
+
+ThreadLocalObjectMsgAllocator::ThreadLocalObjectMsgAllocator(ObjectMsgAllocator* backend_allocator,
+                                                             int64_t mem_size_shift_max,
+                                                             int64_t slab_size)
+    : backend_allocator_(backend_allocator),
+      mem_size_shift_max_(mem_size_shift_max),
+      slab_size_(slab_size),
+      allocator_id_(next_allocator_id++) {
+  CHECK_LE(mem_size_shift_max_, 32);
+  CHECK_LT(kMemSizeShiftMin, mem_size_shift_max_);
+}
+
+ThreadLocalObjectMsgAllocator::~ThreadLocalObjectMsgAllocator() {
+  std::unique_lock<std::mutex> lock(heaps_mutex_);
+  // the heaps of the living threads outlive the allocator, but are never used again
+  for (const auto& heap : heaps_) {
+    for (const auto& pool : heap->pools) {
+      for (const auto& slab : pool->slabs) {
+        backend_allocator_->Deallocate(slab.first, slab.second);
+      }
+    }
+    heap->pools.clear();
+  }
+}
+
+ThreadLocalObjectMsgAllocator* ThreadLocalObjectMsgAllocator::GlobalObjectMsgAllocator() {
+  static ThreadLocalObjectMsgAllocator* allocator =
+      new ThreadLocalObjectMsgAllocator(new ObjectMsgDefaultAllocator(), 20, 64 * 1024);
+  return allocator;
+}
+
+ObjMsgThreadHeap* ThreadLocalObjectMsgAllocator::MutThreadHeap(bool create_if_absent) {
+  if (tls_last_heap != nullptr && tls_last_heap->allocator_id == allocator_id_) {
+    return tls_last_heap;
+  }
+  if (tls_thread_exited) { return nullptr; }
+  if (tls_thread_heaps != nullptr) {
+    for (const auto& heap : tls_thread_heaps->heaps) {
+      if (heap->allocator_id == allocator_id_) {
+        tls_last_heap = heap.get();
+        return tls_last_heap;
+      }
+    }
+  }
+  if (!create_if_absent) { return nullptr; }
+  // constructs tls_thread_heaps on the first use in the thread
+  static_cast<void>(tls_thread_heaps_reaper);
+  CHECK_NOTNULL(tls_thread_heaps);
+  // drops the heaps of the deleted allocators
+  tls_last_heap = nullptr;
+  auto* heaps = &tls_thread_heaps->heaps;
+  heaps->erase(std::remove_if(heaps->begin(), heaps->end(),
+                              [](const std::shared_ptr<ObjMsgThreadHeap>& heap) {
+                                return heap.use_count() == 1;
+                              }),
+               heaps->end());
+  heaps->push_back(AdoptOrNewHeap());
+  tls_last_heap = heaps->back().get();
+  return tls_last_heap;
+}
+
+std::shared_ptr<ObjMsgThreadHeap> ThreadLocalObjectMsgAllocator::AdoptOrNewHeap() {
+  std::unique_lock<std::mutex> lock(heaps_mutex_);
+  for (const auto& heap : heaps_) {
+    bool abandoned = true;
+    if (heap->abandoned.compare_exchange_strong(abandoned, false, std::memory_order_acq_rel)) {
+      return heap;
+    }
+  }
+  heaps_.emplace_back(
+      std::make_shared<ObjMsgThreadHeap>(allocator_id_, kMemSizeShiftMin, mem_size_shift_max_));
+  return heaps_.back();
+}
+
+char* ThreadLocalObjectMsgAllocator::Allocate(std::size_t size) {
+  int shift = kMemSizeShiftMin;
+  while ((static_cast<std::size_t>(1) << shift) < size) { ++shift; }
+  ObjMsgThreadHeap* heap = shift <= mem_size_shift_max_ ? MutThreadHeap(true) : nullptr;
+  if (heap == nullptr) {
+    char* block = backend_allocator_->Allocate(sizeof(ObjMsgSlabBlockHeader) + size);
+    char* mem_ptr = block + sizeof(ObjMsgSlabBlockHeader);
+    BlockHeader4MemPtr(mem_ptr)->pool = nullptr;
+    return mem_ptr;
+  }
+  ObjMsgSlabPool* pool = heap->pools.at(shift - kMemSizeShiftMin).get();
+  if (pool->local_free_list == nullptr) {
+    pool->local_free_list = pool->remote_free_list.exchange(nullptr, std::memory_order_acquire);
+  }
+  if (pool->local_free_list == nullptr) { AllocateSlab(backend_allocator_, slab_size_, pool); }
+  char* mem_ptr = pool->local_free_list;
+  pool->local_free_list = NextFreeMemPtr(mem_ptr);
+  return mem_ptr;
+}
+
+void ThreadLocalObjectMsgAllocator::Deallocate(char* ptr, std::size_t size) {
+  ObjMsgSlabPool* pool = BlockHeader4MemPtr(ptr)->pool;
+  if (pool == nullptr) {
+    backend_allocator_->Deallocate(reinterpret_cast<char*>(BlockHeader4MemPtr(ptr)),
+                                   sizeof(ObjMsgSlabBlockHeader) + size);
+    return;
+  }
+  CHECK_LE(size, pool->mem_size);
+  if (pool->heap == MutThreadHeap(false)) {
+    NextFreeMemPtr(ptr) = pool->local_free_list;
+    pool->local_free_list = ptr;
+  } else {
+    char* head = pool->remote_free_list.load(std::memory_order_relaxed);
+    do {
+      NextFreeMemPtr(ptr) = head;
+    } while (!pool->remote_free_list.compare_exchange_weak(head, ptr, std::memory_order_release,
+                                                           std::memory_order_relaxed));
+  }
+}
+
+}  // namespace oneflow
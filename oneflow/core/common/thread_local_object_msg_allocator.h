@@ -0,0 +1,66 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_COMMON_THREAD_LOCAL_OBJECT_MSG_ALLOCATOR_H_
+#define ONEFLOW_CORE_COMMON_THREAD_LOCAL_OBJECT_MSG_ALLOCATOR_H_
+
+#include <memory>
+#include <mutex>
+#include "oneflow/core/object_msg/object_msg.h"
+
+namespace oneflow {
+
+struct ObjMsgThreadHeap;
+
+// A slab allocator with a heap for every thread, for object msgs allocated on one thread and
+// deallocated on another, e.g. the instruction msgs made on the main thread and deleted on the vm
+// scheduler thread. A thread allocates from its own heap without any lock. A memory block
+// deallocated on the thread of its heap goes back to the heap directly, and one deallocated on
+// another thread is pushed onto a lock-free list of the heap, which the thread of the heap takes
+// as a whole when it runs out of free blocks. The heap of an exited thread is taken over by the
+// next thread that needs a heap. Sizes above 2^mem_size_shift_max go to the backend allocator
+class ThreadLocalObjectMsgAllocator final : public ObjectMsgAllocator {
+ public:
+  ThreadLocalObjectMsgAllocator(const ThreadLocalObjectMsgAllocator&) = delete;
+  ThreadLocalObjectMsgAllocator(ThreadLocalObjectMsgAllocator&&) = delete;
+  // every slab allocated from the backend allocator holds at least slab_size bytes of blocks
+  ThreadLocalObjectMsgAllocator(ObjectMsgAllocator* backend_allocator, int64_t mem_size_shift_max,
+                                int64_t slab_size);
+  // the memory blocks must all have been deallocated
+  ~ThreadLocalObjectMsgAllocator() override;
+
+  // never deleted, so that object msgs can be deallocated while the process exits
+  static ThreadLocalObjectMsgAllocator* GlobalObjectMsgAllocator();
+
+  char* Allocate(std::size_t size) override;
+  void Deallocate(char* ptr, std::size_t size) override;
+
+ private:
+  ObjMsgThreadHeap* MutThreadHeap(bool create_if_absent);
+  std::shared_ptr<ObjMsgThreadHeap> AdoptOrNewHeap();
+
+  static const int kMemSizeShiftMin = 6;
+
+  ObjectMsgAllocator* backend_allocator_;
+  int mem_size_shift_max_;
+  int64_t slab_size_;
+  int64_t allocator_id_;
+  std::mutex heaps_mutex_;
+  std::vector<std::shared_ptr<ObjMsgThreadHeap>> heaps_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_COMMON_THREAD_LOCAL_OBJECT_MSG_ALLOCATOR_H_
@@ -0,0 +1,137 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/thread_local_object_msg_allocator.h"
+#include "oneflow/core/common/channel.h"
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+class TestObjMsgAllocator final : public ObjectMsgAllocator {
+ public:
+  TestObjMsgAllocator(std::atomic<int>* cnt, std::atomic<int>* total_cnt)
+      : ObjectMsgAllocator(), cnt_(cnt), total_cnt_(total_cnt) {}
+
+  char* Allocate(std::size_t size) override {
+    ++*cnt_;
+    ++*total_cnt_;
+    return ObjectMsgDefaultAllocator::GlobalObjectMsgAllocator()->Allocate(size);
+  }
+  void Deallocate(char* ptr, std::size_t size) override {
+    --*cnt_;
+    return ObjectMsgDefaultAllocator::GlobalObjectMsgAllocator()->Deallocate(ptr, size);
+  }
+
+ private:
+  std::atomic<int>* cnt_;
+  std::atomic<int>* total_cnt_;
+};
+
+}  // namespace
+
+TEST(ThreadLocalObjectMsgAllocator, no_memory_leak) {
+  std::atomic<int> cnt(0);
+  std::atomic<int> total_cnt(0);
+  {
+    TestObjMsgAllocator backend_allocator(&cnt, &total_cnt);
+    ThreadLocalObjectMsgAllocator allocator(&backend_allocator, 20, 4096);
+    for (int i = 0; i < 100; ++i) {
+      char* mem_ptr = allocator.Allocate(1024);
+      allocator.Deallocate(mem_ptr, 1024);
+    }
+    char* mem_ptr[100];
+    for (int i = 0; i < 100; ++i) { mem_ptr[i] = allocator.Allocate(1024); }
+    for (int i = 0; i < 100; ++i) { allocator.Deallocate(mem_ptr[i], 1024); }
+    char* large_mem_ptr = allocator.Allocate(1 << 22);
+    allocator.Deallocate(large_mem_ptr, 1 << 22);
+  }
+  ASSERT_EQ(cnt.load(), 0);
+}
+
+TEST(ThreadLocalObjectMsgAllocator, reuse_remote_deallocated) {
+  std::atomic<int> cnt(0);
+  std::atomic<int> total_cnt(0);
+  {
+    TestObjMsgAllocator backend_allocator(&cnt, &total_cnt);
+    ThreadLocalObjectMsgAllocator allocator(&backend_allocator, 20, 4096);
+    std::vector<char*> mem_ptrs;
+    for (int i = 0; i < 1000; ++i) { mem_ptrs.push_back(allocator.Allocate(200)); }
+    const int backend_allocated_cnt = total_cnt;
+    std::thread thread([&]() {
+      for (char* mem_ptr : mem_ptrs) { allocator.Deallocate(mem_ptr, 200); }
+    });
+    thread.join();
+    for (int i = 0; i < 1000; ++i) { allocator.Allocate(200); }
+    ASSERT_EQ(total_cnt.load(), backend_allocated_cnt);
+  }
+  ASSERT_EQ(cnt.load(), 0);
+}
+
+TEST(ThreadLocalObjectMsgAllocator, adopt_heap_of_exited_thread) {
+  std::atomic<int> cnt(0);
+  std::atomic<int> total_cnt(0);
+  {
+    TestObjMsgAllocator backend_allocator(&cnt, &total_cnt);
+    ThreadLocalObjectMsgAllocator allocator(&backend_allocator, 20, 4096);
+    const auto AllocateAndDeallocate = [&]() {
+      char* mem_ptr = allocator.Allocate(100);
+      allocator.Deallocate(mem_ptr, 100);
+    };
+    std::thread(AllocateAndDeallocate).join();
+    const int backend_allocated_cnt = total_cnt;
+    std::thread(AllocateAndDeallocate).join();
+    ASSERT_EQ(total_cnt.load(), backend_allocated_cnt);
+  }
+  ASSERT_EQ(cnt.load(), 0);
+}
+
+TEST(ThreadLocalObjectMsgAllocator, producer_consumer) {
+  std::atomic<int> cnt(0);
+  std::atomic<int> total_cnt(0);
+  {
+    TestObjMsgAllocator backend_allocator(&cnt, &total_cnt);
+    ThreadLocalObjectMsgAllocator allocator(&backend_allocator, 20, 4096);
+    Channel<char*> channel;
+    std::thread consumer([&]() {
+      char* mem_ptr = nullptr;
+      while (channel.Receive(&mem_ptr) == kChannelStatusSuccess) {
+        ASSERT_EQ(*mem_ptr, 'x');
+        allocator.Deallocate(mem_ptr, 300);
+      }
+    });
+    std::vector<std::thread> producers;
+    for (int i = 0; i < 4; ++i) {
+      producers.emplace_back([&]() {
+        for (int j = 0; j < 10000; ++j) {
+          char* mem_ptr = allocator.Allocate(300);
+          *mem_ptr = 'x';
+          channel.Send(mem_ptr);
+        }
+      });
+    }
+    for (std::thread& producer : producers) { producer.join(); }
+    channel.Close();
+    consumer.join();
+  }
+  ASSERT_EQ(cnt.load(), 0);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
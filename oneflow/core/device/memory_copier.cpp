@@ -15,7 +15,11 @@ limitations under the License.
 */
 #include "oneflow/core/device/memory_copier.h"
 #include "oneflow/core/common/auto_registration_factory.h"
-#include "oneflow/core/common/nd_index_offset_helper.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace oneflow {
 
@@ -75,28 +79,156 @@ MemoryCopyNdDesc GetDescInBytes(const MemoryCopyNdDesc& desc) {
   return desc_in_bytes;
 }
 
+// the host copies of at least kMinParallelHostCopyBytes are split across the threads of
+// Global<ThreadPool>, so that every thread copies at least kMinHostCopyBytesPerThread
+constexpr int64_t kMinParallelHostCopyBytes = 4 * 1024 * 1024;
+constexpr int64_t kMinHostCopyBytesPerThread = 1024 * 1024;
+// the host copies much larger than the cache write their long rows with non-temporal stores, which
+// do not read the dst into the cache and do not evict the data which is still used
+constexpr int64_t kMinNonTemporalHostCopyBytes = 64 * 1024 * 1024;
+constexpr int64_t kMinNonTemporalHostCopyRowBytes = 4096;
+
+void CopyHostRow(unsigned char* dst, const unsigned char* src, size_t size, bool non_temporal) {
+#if defined(__SSE2__)
+  if (non_temporal) {
+    const size_t head = (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16;
+    if (head < size) {
+      memcpy(dst, src, head);
+      dst += head;
+      src += head;
+      size -= head;
+      const size_t body = size / 64 * 64;
+      for (size_t i = 0; i < body; i += 64) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 16));
+        const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 32));
+        const __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 48));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i), v0);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 16), v1);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 32), v2);
+        _mm_stream_si128(reinterpret_cast<__m128i*>(dst + i + 48), v3);
+      }
+      memcpy(dst + body, src + body, size - body);
+      return;
+    }
+  }
+#endif
+  memcpy(dst, src, size);
+}
+
+// Walks the rows of a copy in bytes, which are contiguous along the last axis, and keeps the
+// offsets of the current row in dst and src
+class HostCopyRowIterator final {
+ public:
+  HostCopyRowIterator(const MemoryCopyNdDesc& desc, int64_t row)
+      : desc_(desc),
+        num_axes_(desc.extent.NumAxes()),
+        dst_strides_(num_axes_),
+        src_strides_(num_axes_),
+        idx_(num_axes_, 0) {
+    dst_strides_.at(num_axes_ - 1) = 1;
+    src_strides_.at(num_axes_ - 1) = 1;
+    for (int64_t i = num_axes_ - 2; i >= 0; --i) {
+      dst_strides_.at(i) = dst_strides_.at(i + 1) * desc.dst_shape.At(i + 1);
+      src_strides_.at(i) = src_strides_.at(i + 1) * desc.src_shape.At(i + 1);
+    }
+    dst_offset_ = desc.dst_pos.At(num_axes_ - 1);
+    src_offset_ = desc.src_pos.At(num_axes_ - 1);
+    for (int64_t i = num_axes_ - 2; i >= 0; --i) {
+      idx_.at(i) = row % desc.extent.At(i);
+      row /= desc.extent.At(i);
+      dst_offset_ += (desc.dst_pos.At(i) + idx_.at(i)) * dst_strides_.at(i);
+      src_offset_ += (desc.src_pos.At(i) + idx_.at(i)) * src_strides_.at(i);
+    }
+  }
+
+  int64_t dst_offset() const { return dst_offset_; }
+  int64_t src_offset() const { return src_offset_; }
+
+  void Next() {
+    for (int64_t i = num_axes_ - 2; i >= 0; --i) {
+      dst_offset_ += dst_strides_.at(i);
+      src_offset_ += src_strides_.at(i);
+      idx_.at(i) += 1;
+      if (idx_.at(i) < desc_.extent.At(i)) { return; }
+      dst_offset_ -= desc_.extent.At(i) * dst_strides_.at(i);
+      src_offset_ -= desc_.extent.At(i) * src_strides_.at(i);
+      idx_.at(i) = 0;
+    }
+  }
+
+ private:
+  const MemoryCopyNdDesc& desc_;
+  int64_t num_axes_;
+  std::vector<int64_t> dst_strides_;
+  std::vector<int64_t> src_strides_;
+  std::vector<int64_t> idx_;
+  int64_t dst_offset_;
+  int64_t src_offset_;
+};
+
+// Copies the units [unit_begin, unit_end) of a copy in bytes, whose rows are cut into
+// num_units_per_row units
+void CopyHostUnits(void* dst, const void* src, const MemoryCopyNdDesc& desc,
+                   int64_t num_units_per_row, int64_t unit_begin, int64_t unit_end,
+                   bool non_temporal) {
+  if (unit_begin >= unit_end) { return; }
+  const int64_t row_size = desc.extent.At(desc.extent.NumAxes() - 1);
+  BalancedSplitter row_splitter(row_size, num_units_per_row);
+  int64_t row = unit_begin / num_units_per_row;
+  HostCopyRowIterator row_it(desc, row);
+  FOR_RANGE(int64_t, unit, unit_begin, unit_end) {
+    if (unit / num_units_per_row != row) {
+      row_it.Next();
+      row += 1;
+    }
+    const Range range = row_splitter.At(unit % num_units_per_row);
+    CopyHostRow(reinterpret_cast<unsigned char*>(dst) + row_it.dst_offset() + range.begin(),
+                reinterpret_cast<const unsigned char*>(src) + row_it.src_offset() + range.begin(),
+                range.size(), non_temporal);
+  }
+#if defined(__SSE2__)
+  // the non-temporal stores are weakly ordered
+  if (non_temporal) { _mm_sfence(); }
+#endif
+}
+
+// Copies desc in bytes row by row, with the rows split across the threads if the copy is large.
+// The rows are cut into pieces too if there are fewer rows than threads
+void CopyHostND(void* dst, const void* src, const MemoryCopyNdDesc& desc) {
+  const int64_t copy_size = desc.extent.elem_cnt();
+  if (copy_size == 0) { return; }
+  const int64_t row_size = desc.extent.At(desc.extent.NumAxes() - 1);
+  const int64_t num_rows = copy_size / row_size;
+  const bool non_temporal =
+      copy_size >= kMinNonTemporalHostCopyBytes && row_size >= kMinNonTemporalHostCopyRowBytes;
+  int64_t num_parts = 1;
+  // a copy on a thread of the pool runs on that thread alone, as waiting for the other threads
+  // could deadlock
+  if (copy_size >= kMinParallelHostCopyBytes && Global<ThreadPool>::Get() != nullptr
+      && !Global<ThreadPool>::Get()->IsCurrentThreadInPool()) {
+    num_parts = std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                                  copy_size / kMinHostCopyBytesPerThread);
+  }
+  if (num_parts <= 1) {
+    CopyHostUnits(dst, src, desc, 1, 0, num_rows, non_temporal);
+    return;
+  }
+  const int64_t num_units_per_row =
+      std::min<int64_t>(RoundUp(num_parts, num_rows) / num_rows, row_size);
+  BalancedSplitter part_splitter(num_rows * num_units_per_row, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    const Range range = part_splitter.At(part_id);
+    CopyHostUnits(dst, src, desc, num_units_per_row, range.begin(), range.end(), non_temporal);
+  });
+}
+
 }  // namespace
 
 template<int32_t NDIMS>
 void CopyNDCpuImpl(DeviceCtx* ctx, void* dst, const void* src, const MemoryCopyNdDesc& desc) {
-  NdIndexOffsetHelper<int64_t, NDIMS> src_helper(desc.src_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> dst_helper(desc.dst_shape.dim_vec().data());
-  NdIndexOffsetHelper<int64_t, NDIMS> copy_helper(desc.extent.dim_vec().data());
-  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
-    int64_t copy_idx[NDIMS];
-    int64_t src_idx[NDIMS];
-    int64_t dst_idx[NDIMS];
-    copy_helper.OffsetToNdIndex(i, copy_idx);
-    FOR_RANGE(int64_t, j, 0, NDIMS) {
-      src_idx[j] = desc.src_pos.At(j) + copy_idx[j];
-      dst_idx[j] = desc.dst_pos.At(j) + copy_idx[j];
-    }
-    const int64_t src_offset = src_helper.NdIndexToOffset(src_idx);
-    const int64_t dst_offset = dst_helper.NdIndexToOffset(dst_idx);
-    unsigned char* dst_ptr = reinterpret_cast<unsigned char*>(dst) + dst_offset;
-    const unsigned char* src_ptr = reinterpret_cast<const unsigned char*>(src) + src_offset;
-    *dst_ptr = *src_ptr;
-  }
+  CHECK_EQ(desc.extent.NumAxes(), NDIMS);
+  CopyHostND(dst, src, desc);
 }
 
 MemoryCopyNdDesc MemoryCopyNdDesc::CreateDimReducedDesc() const {
@@ -194,22 +326,16 @@ void MemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
   UNIMPLEMENTED();
 }
 
-void HostMemoryCopier::Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const {
-  memcpy(dst, src, count);
+void HostMemoryCopier::Copy(DeviceCtx* ctx, void* dst, const void* src,
+                            const MemoryCopyNdDesc& desc) const {
+  // the copies of empty blobs have nothing to copy
+  if (desc.extent.elem_cnt() == 0) { return; }
+  CheckMemoryCopyNdDesc(desc);
+  CopyHostND(dst, src, desc.CreateDimReducedDesc());
 }
 
-void HostMemoryCopier::CopyND(DeviceCtx* ctx, void* dst, const void* src,
-                              const MemoryCopyNdDesc& desc) const {
-  const int32_t num_axes = desc.src_shape.NumAxes();
-  if (num_axes == 4) {
-    CopyNDCpuImpl<4>(ctx, dst, src, desc);
-  } else if (num_axes == 5) {
-    CopyNDCpuImpl<5>(ctx, dst, src, desc);
-  } else if (num_axes == 6) {
-    CopyNDCpuImpl<6>(ctx, dst, src, desc);
-  } else {
-    UNIMPLEMENTED();
-  }
+void HostMemoryCopier::Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const {
+  memcpy(dst, src, count);
 }
 
 #ifdef WITH_CUDA
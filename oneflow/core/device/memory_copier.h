@@ -68,9 +68,10 @@ class HostMemoryCopier final : public MemoryCopier {
   ~HostMemoryCopier() override = default;
 
  private:
+  // the large copies are split across the threads of Global<ThreadPool>
+  void Copy(DeviceCtx* ctx, void* dst, const void* src,
+            const MemoryCopyNdDesc& desc) const override;
   void Copy1D(DeviceCtx* ctx, void* dst, const void* src, size_t count) const override;
-  void CopyND(DeviceCtx* ctx, void* dst, const void* src,
-              const MemoryCopyNdDesc& desc) const override;
 };
 
 #ifdef WITH_CUDA
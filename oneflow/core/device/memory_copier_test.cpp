@@ -0,0 +1,145 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/core/device/memory_copier.h"
+#include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include <chrono>
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+MemoryCopyNdDesc NewDesc(const DimVector& dst_shape, const DimVector& src_shape,
+                         const DimVector& dst_pos, const DimVector& src_pos,
+                         const DimVector& extent) {
+  MemoryCopyNdDesc desc;
+  desc.dst_shape = Shape(dst_shape);
+  desc.src_shape = Shape(src_shape);
+  desc.dst_pos = NdIndex(dst_pos);
+  desc.src_pos = NdIndex(src_pos);
+  desc.extent = Shape(extent);
+  return desc;
+}
+
+void NaiveCopy(unsigned char* dst, const unsigned char* src, const MemoryCopyNdDesc& desc) {
+  const int64_t num_axes = desc.extent.NumAxes();
+  std::vector<int64_t> idx(num_axes);
+  FOR_RANGE(int64_t, i, 0, desc.extent.elem_cnt()) {
+    int64_t rest = i;
+    for (int64_t j = num_axes - 1; j >= 0; --j) {
+      idx.at(j) = rest % desc.extent.At(j);
+      rest /= desc.extent.At(j);
+    }
+    int64_t dst_offset = 0;
+    int64_t src_offset = 0;
+    FOR_RANGE(int64_t, j, 0, num_axes) {
+      dst_offset = dst_offset * desc.dst_shape.At(j) + desc.dst_pos.At(j) + idx.at(j);
+      src_offset = src_offset * desc.src_shape.At(j) + desc.src_pos.At(j) + idx.at(j);
+    }
+    dst[dst_offset] = src[src_offset];
+  }
+}
+
+void TestHostCopy(const MemoryCopyNdDesc& desc) {
+  std::unique_ptr<MemoryCopier> copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  std::vector<unsigned char> src(desc.src_shape.elem_cnt());
+  std::mt19937 gen(0);
+  for (auto& x : src) { x = gen(); }
+  std::vector<unsigned char> expected(desc.dst_shape.elem_cnt(), 0);
+  std::vector<unsigned char> dst(desc.dst_shape.elem_cnt(), 0);
+  NaiveCopy(expected.data(), src.data(), desc);
+  copier->Copy(nullptr, dst.data(), src.data(), desc);
+  ASSERT_TRUE(dst == expected);
+}
+
+void ForEachHostCopyDesc(const std::function<void(const MemoryCopyNdDesc&)>& Handler) {
+  Handler(NewDesc({100}, {100}, {3}, {5}, {90}));
+  // empty
+  Handler(NewDesc({4, 0}, {4, 0}, {0, 0}, {0, 0}, {4, 0}));
+  Handler(NewDesc({3, 5}, {3, 5}, {0, 0}, {0, 0}, {3, 5}));
+  // one row, which is cut into pieces across the threads
+  Handler(NewDesc({8 * 1024 * 1024 + 5}, {8 * 1024 * 1024 + 9}, {3}, {1}, {8 * 1024 * 1024}));
+  // fewer rows than threads
+  Handler(NewDesc({3, 3 * 1024 * 1024}, {5, 3 * 1024 * 1024 + 7}, {0, 1}, {1, 7},
+                  {3, 3 * 1024 * 1024 - 1}));
+  Handler(NewDesc({1024, 8193}, {2048, 8195}, {0, 1}, {11, 2}, {1024, 8192}));
+  Handler(NewDesc({64, 3, 40, 1000}, {64, 5, 41, 1003}, {0, 0, 0, 0}, {0, 1, 1, 3},
+                  {64, 3, 40, 1000}));
+  Handler(NewDesc({7, 5, 3, 4, 9, 33}, {8, 6, 5, 5, 9, 40}, {0, 0, 0, 0, 0, 0},
+                  {1, 1, 2, 1, 0, 7}, {7, 5, 3, 4, 9, 33}));
+  // written with non-temporal stores, from unaligned src and dst
+  Handler(NewDesc({2, 35 * 1024 * 1024 + 3}, {2, 35 * 1024 * 1024 + 64}, {0, 3}, {0, 1},
+                  {2, 35 * 1024 * 1024}));
+}
+
+}  // namespace
+
+TEST(HostMemoryCopier, single_thread) {
+  ForEachHostCopyDesc([](const MemoryCopyNdDesc& desc) { TestHostCopy(desc); });
+}
+
+TEST(HostMemoryCopier, multi_thread) {
+  Global<ThreadPool>::New(4);
+  ForEachHostCopyDesc([](const MemoryCopyNdDesc& desc) { TestHostCopy(desc); });
+  Global<ThreadPool>::Delete();
+}
+
+TEST(HostMemoryCopier, on_thread_pool) {
+  Global<ThreadPool>::New(4);
+  BlockingCounter bc(1);
+  Global<ThreadPool>::Get()->AddWork([&bc]() {
+    ForEachHostCopyDesc([](const MemoryCopyNdDesc& desc) { TestHostCopy(desc); });
+    bc.Decrease();
+  });
+  bc.WaitUntilCntEqualZero();
+  Global<ThreadPool>::Delete();
+}
+
+// run with --gtest_also_run_disabled_tests
+TEST(HostMemoryCopier, DISABLED_benchmark) {
+  std::unique_ptr<MemoryCopier> copier(NewDefaultMemoryCopier(DeviceType::kCPU));
+  const int64_t row_sizes[] = {4, 64, 4096, 256 * 1024 * 1024};
+  const int64_t copy_size = 256 * 1024 * 1024;
+  std::vector<unsigned char> src(copy_size * 2, 1);
+  std::vector<unsigned char> dst(copy_size, 0);
+  for (const int64_t thread_num : {0, 4, 16}) {
+    if (thread_num > 0) { Global<ThreadPool>::New(thread_num); }
+    for (const int64_t row_size : row_sizes) {
+      // copies the left half of every row of src
+      const int64_t num_rows = copy_size / row_size;
+      const MemoryCopyNdDesc desc = NewDesc({num_rows, row_size}, {num_rows, row_size * 2},
+                                            {0, 0}, {0, 0}, {num_rows, row_size});
+      copier->Copy(nullptr, dst.data(), src.data(), desc);
+      const int64_t num_iters = 10;
+      const auto start = std::chrono::steady_clock::now();
+      FOR_RANGE(int64_t, i, 0, num_iters) {
+        copier->Copy(nullptr, dst.data(), src.data(), desc);
+      }
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      LOG(INFO) << "threads: " << thread_num << ", rows: " << num_rows << " x " << row_size
+                << " bytes, " << copy_size * num_iters / elapsed.count() / 1e9 << " GB/s";
+    }
+    if (thread_num > 0) { Global<ThreadPool>::Delete(); }
+  }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "half.hpp"
 #include "oneflow/core/common/util.h"
+#include "oneflow/core/common/bfloat16.h"
 #include "oneflow/core/common/switch_func.h"
 #include "oneflow/core/common/container_util.h"
 #include "oneflow/core/common/data_type_seq.h"
@@ -33,7 +34,8 @@ std::size_t GetDataTypeBytes() {
 
 #define MAKE_DATA_TYPE_BYTES_SWITCH_ENTRY(func_name, T) func_name<T>
 DEFINE_STATIC_SWITCH_FUNC(std::size_t, GetDataTypeBytes, MAKE_DATA_TYPE_BYTES_SWITCH_ENTRY,
-                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ));
+                          MAKE_DATA_TYPE_CTRV_SEQ(POD_DATA_TYPE_SEQ FLOAT16_DATA_TYPE_SEQ
+                                                      BFLOAT16_DATA_TYPE_SEQ));
 
 class DTypeMeta final {
  public:
@@ -71,6 +73,7 @@ Maybe<const DTypeMeta&> DTypeMeta4DataType(DataType data_type) {
       {DataType::kUInt8, DTypeMeta("oneflow.uint8", false, false, false)},
       {DataType::kOFRecord, DTypeMeta("oneflow.of_record", false, false, false)},
       {DataType::kTensorBuffer, DTypeMeta("oneflow.tensor_buffer", false, false, false)},
+      {DataType::kBFloat16, DTypeMeta("oneflow.bfloat16", true, true, false)},
   };
   return MapAt(data_type2dtype_meta, data_type);
 };
@@ -25,6 +25,7 @@ limitations under the License.
 #include "oneflow/core/common/id_util.h"
 #include "oneflow/core/graph/id_serialization.h"
 #include "oneflow/core/device/cuda_stream_index.h"
+#include "oneflow/core/device/cpu_stream_index.h"
 #ifdef WITH_CUDA
 #include <nccl.h>
 #endif
@@ -35,13 +36,14 @@ using namespace boxing::collective;
 
 namespace {
 
-void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
-                            const ParallelDesc& parallel_desc, int64_t parallel_id,
-                            const std::string& name, const LogicalBlobId& lbi,
-                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+OperatorConf MakeCollectiveBoxingOpConf(DeviceType device_type, Backend backend,
+                                        const ParallelDesc& parallel_desc, int64_t parallel_id,
+                                        const std::string& name, const LogicalBlobId& lbi,
+                                        const BlobDesc& logical_blob_desc, OpType op_type,
+                                        int64_t root) {
   OperatorConf op_conf;
   op_conf.set_name(name);
-  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(DeviceType::kGPU)));
+  op_conf.set_device_tag(*CHECK_JUST(DeviceTag4DeviceType(device_type)));
   CollectiveBoxingGenericOpConf* conf = op_conf.mutable_collective_boxing_generic_conf();
   *conf->mutable_lbi() = lbi;
   RankDesc* rank_desc = conf->mutable_rank_desc();
@@ -62,9 +64,18 @@ void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
   } else {
     CHECK_EQ(root, -1);
   }
-  op_desc->set_backend(Backend::kBackendNCCL);
+  op_desc->set_backend(backend);
   rank_desc->set_rank(parallel_id);
+  return op_conf;
+}
 
+void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                            const ParallelDesc& parallel_desc, int64_t parallel_id,
+                            const std::string& name, const LogicalBlobId& lbi,
+                            const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+  const OperatorConf op_conf =
+      MakeCollectiveBoxingOpConf(DeviceType::kGPU, Backend::kBackendNCCL, parallel_desc,
+                                 parallel_id, name, lbi, logical_blob_desc, op_type, root);
   const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
   const int64_t device_index = CHECK_JUST(parallel_desc.DeviceId4ParallelId(parallel_id));
   DeviceId device_id{static_cast<DeviceId::rank_t>(machine_id), DeviceType::kGPU,
@@ -77,6 +88,27 @@ void NcclInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
   node->Init(machine_id, thrd_id, lbi, op_conf);
 }
 
+void CommNetInitCollectiveNode(CollectiveBoxingGenericTaskNode* node,
+                               const ParallelDesc& parallel_desc, int64_t parallel_id,
+                               const std::string& name, const LogicalBlobId& lbi,
+                               const BlobDesc& logical_blob_desc, OpType op_type, int64_t root) {
+  const OperatorConf op_conf =
+      MakeCollectiveBoxingOpConf(DeviceType::kCPU, Backend::kBackendCommNet, parallel_desc,
+                                 parallel_id, name, lbi, logical_blob_desc, op_type, root);
+  const int64_t machine_id = CHECK_JUST(parallel_desc.MachineId4ParallelId(parallel_id));
+  DeviceId device_id{static_cast<DeviceId::rank_t>(machine_id), DeviceType::kCPU,
+                     DeviceId::kCPUDeviceIndex};
+  auto* stream_index_generator = dynamic_cast<CPUStreamIndexGenerator*>(
+      Global<IDMgr>::Get()->GetStreamIndexGeneratorManager()->GetGenerator(device_id));
+  CHECK_NOTNULL(stream_index_generator);
+  // the collective boxing actors only enqueue the requests, so that one thread is enough for all
+  // the ranks on a machine
+  auto stream_index = stream_index_generator->GenerateIndependentTaskStreamIndex(
+      TaskType::kCollectiveBoxingGeneric);
+  const int64_t thrd_id = SerializeStreamIdToInt64(StreamId{device_id, stream_index});
+  node->Init(machine_id, thrd_id, lbi, op_conf);
+}
+
 int64_t FindRootParallelId(const ParallelDesc& multi_device, const ParallelDesc& sole_device) {
   CHECK_EQ(sole_device.parallel_num(), 1);
   const int64_t root_machine_id = CHECK_JUST(sole_device.MachineId4ParallelId(0));
@@ -551,6 +583,208 @@ class NcclCollectiveBoxingAll2AllSubTskGphBuilder final : public SubTskGphBuilde
   }
 };
 
+class CommNetCollectiveBoxingAllReduceSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingAllReduceSubTskGphBuilder);
+  CommNetCollectiveBoxingAllReduceSubTskGphBuilder() = default;
+  ~CommNetCollectiveBoxingAllReduceSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+        && out_parallel_desc.device_type() == DeviceType::kCPU
+        && out_parallel_desc.parallel_num() > 1
+        && SubTskGphBuilderUtil::IsBoxingP2B(in_sbp_parallel, out_sbp_parallel)) {
+      const std::string op_name =
+          "System-Boxing-CommNetCollectiveBoxingAllReduce-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CommNetInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                                  logical_blob_desc, OpType::kOpTypeAllReduce, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CommNetCollectiveBoxingAllReduceSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CommNetCollectiveBoxingReduceScatterSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingReduceScatterSubTskGphBuilder);
+  CommNetCollectiveBoxingReduceScatterSubTskGphBuilder() = default;
+  ~CommNetCollectiveBoxingReduceScatterSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+        && out_parallel_desc.device_type() == DeviceType::kCPU
+        && out_parallel_desc.parallel_num() > 1
+        && logical_blob_desc.shape().At(0) % out_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingP2S(in_sbp_parallel, out_sbp_parallel)
+        && out_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name =
+          "System-Boxing-CommNetCollectiveBoxingReduceScatter-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CommNetInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                                  logical_blob_desc, OpType::kOpTypeReduceScatter, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CommNetCollectiveBoxingReduceScatterSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CommNetCollectiveBoxingAllGatherSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingAllGatherSubTskGphBuilder);
+  CommNetCollectiveBoxingAllGatherSubTskGphBuilder() = default;
+  ~CommNetCollectiveBoxingAllGatherSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (out_parallel_desc.Equals(in_parallel_desc)
+        && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+        && out_parallel_desc.device_type() == DeviceType::kCPU
+        && out_parallel_desc.parallel_num() > 1
+        && logical_blob_desc.shape().At(0) % out_parallel_desc.parallel_num() == 0
+        && SubTskGphBuilderUtil::IsBoxingS2B(in_sbp_parallel, out_sbp_parallel)
+        && in_sbp_parallel.split_parallel().axis() == 0) {
+      const std::string op_name =
+          "System-Boxing-CommNetCollectiveBoxingAllGather-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CommNetInitCollectiveNode(collective_node, out_parallel_desc, i, op_name, lbi,
+                                  logical_blob_desc, OpType::kOpTypeAllGather, -1);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CommNetCollectiveBoxingAllGatherSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CommNetCollectiveBoxingReduceSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingReduceSubTskGphBuilder);
+  CommNetCollectiveBoxingReduceSubTskGphBuilder() = default;
+  ~CommNetCollectiveBoxingReduceSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (in_parallel_desc.parallel_num() > 1 && out_parallel_desc.parallel_num() == 1
+        && in_parallel_desc.device_type() == DeviceType::kCPU
+        && out_parallel_desc.device_type() == DeviceType::kCPU
+        && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+        && in_sbp_parallel.has_partial_sum_parallel()) {
+      const int64_t root_parallel_id = FindRootParallelId(in_parallel_desc, out_parallel_desc);
+      if (root_parallel_id == -1) { return Error::BoxingNotSupportedError(); }
+
+      const std::string op_name = "System-Boxing-CommNetCollectiveBoxingReduce-" + NewUniqueId();
+      sorted_ctrl_tasks->resize(out_parallel_desc.parallel_num());
+      FOR_RANGE(int64_t, i, 0, in_parallel_desc.parallel_num()) {
+        TaskNode* in_node = sorted_in_tasks.at(i);
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CommNetInitCollectiveNode(collective_node, in_parallel_desc, i, op_name, lbi,
+                                  logical_blob_desc, OpType::kOpTypeReduce, root_parallel_id);
+        ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        if (i == root_parallel_id) {
+          sorted_out_tasks->push_back(collective_node);
+        } else {
+          sorted_ctrl_tasks->at(0).push_back(collective_node);
+        }
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CommNetCollectiveBoxingReduceSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
+class CommNetCollectiveBoxingBroadcastSubTskGphBuilder final : public SubTskGphBuilder {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingBroadcastSubTskGphBuilder);
+  CommNetCollectiveBoxingBroadcastSubTskGphBuilder() = default;
+  ~CommNetCollectiveBoxingBroadcastSubTskGphBuilder() override = default;
+
+  Maybe<SubTskGphBuilderStatus> Build(
+      SubTskGphBuilderCtx* ctx, const std::vector<TaskNode*>& sorted_in_tasks,
+      std::vector<TaskNode*>* sorted_out_tasks,
+      std::vector<std::vector<TaskNode*>>* sorted_ctrl_tasks, const ParallelDesc& in_parallel_desc,
+      const ParallelDesc& out_parallel_desc, const LogicalBlobId& lbi,
+      const BlobDesc& logical_blob_desc, const SbpParallel& in_sbp_parallel,
+      const SbpParallel& out_sbp_parallel, const Shape& time_shape) const override {
+    if (in_parallel_desc.parallel_num() == 1 && out_parallel_desc.parallel_num() > 1
+        && in_parallel_desc.device_type() == DeviceType::kCPU
+        && out_parallel_desc.device_type() == DeviceType::kCPU
+        && !SubTskGphBuilderUtil::BlobHasDynamicShape(logical_blob_desc)
+        && out_sbp_parallel.has_broadcast_parallel()) {
+      const int64_t root_parallel_id = FindRootParallelId(out_parallel_desc, in_parallel_desc);
+      if (root_parallel_id == -1) { return Error::BoxingNotSupportedError(); }
+
+      TaskNode* in_node = sorted_in_tasks.front();
+      const std::string op_name =
+          "System-Boxing-CommNetCollectiveBoxingBroadcast-" + NewUniqueId();
+      FOR_RANGE(int64_t, i, 0, out_parallel_desc.parallel_num()) {
+        auto* collective_node = ctx->task_graph()->NewNode<CollectiveBoxingGenericTaskNode>();
+        CommNetInitCollectiveNode(collective_node, out_parallel_desc, i, op_name, lbi,
+                                  logical_blob_desc, OpType::kOpTypeBroadcast, root_parallel_id);
+        if (i == root_parallel_id) {
+          ctx->task_graph()->ConnectWithLbi(in_node, collective_node, lbi);
+        } else {
+          std::string regst_desc_name;
+          in_node->BuildCtrlRegstDesc(collective_node, &regst_desc_name);
+          TaskEdge* edge = ctx->task_graph()->NewEdge();
+          Connect<TaskNode>(in_node, edge, collective_node);
+          in_node->BindEdgeWithProducedRegst(edge, regst_desc_name);
+        }
+        sorted_out_tasks->push_back(collective_node);
+      }
+      return TRY(
+          BuildSubTskGphBuilderStatus("CommNetCollectiveBoxingBroadcastSubTskGphBuilder", ""));
+    } else {
+      return Error::BoxingNotSupportedError();
+    }
+  }
+};
+
 }  // namespace
 
 CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
@@ -572,6 +806,13 @@ CollectiveBoxingSubTskGphBuilder::CollectiveBoxingSubTskGphBuilder() {
     LOG(WARNING) << "nccl_enable_all_to_all is unavailable unless NCCL_VERSION > 2.7.0";
 #endif
   }
+  if (collective_boxing_conf.comm_net_enable()) {
+    builders.emplace_back(new CommNetCollectiveBoxingAllReduceSubTskGphBuilder());
+    builders.emplace_back(new CommNetCollectiveBoxingReduceScatterSubTskGphBuilder());
+    builders.emplace_back(new CommNetCollectiveBoxingAllGatherSubTskGphBuilder());
+    builders.emplace_back(new CommNetCollectiveBoxingReduceSubTskGphBuilder());
+    builders.emplace_back(new CommNetCollectiveBoxingBroadcastSubTskGphBuilder());
+  }
   chain_builder_.reset(new ChainSubTskGphBuilder(builders));
 }
 
@@ -60,4 +60,6 @@ void CollectiveBoxingGenericTaskNode::InferProducedDataRegstTimeShape() {
   if (out_regst != nullptr) { out_regst->mut_data_regst_time_shape()->reset(new Shape({1, 1})); }
 }
 
+REGISTER_INDEPENDENT_THREAD_NUM(TaskType::kCollectiveBoxingGeneric, 1);
+
 }  // namespace oneflow
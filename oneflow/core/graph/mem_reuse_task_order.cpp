@@ -0,0 +1,340 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/graph/mem_reuse_task_order.h"
+#include <numeric>
+#include <queue>
+
+namespace oneflow {
+
+namespace {
+
+// A task of a chain, whose in and out are the nearest tasks of the same chain it depends on and
+// that depend on it, even through the tasks out of the chain
+struct MemReuseOrderNode {
+  std::vector<int64_t> in;
+  std::vector<int64_t> out;
+  std::vector<int64_t> produced_regsts;
+  std::vector<int64_t> consumed_regsts;
+};
+
+// A mem reused regst of a chain, which is allocated when its producer runs and freed after its
+// last consumer in the chain, or lives until the end of the chain as IntraJobMemSharingUtil sees it
+struct MemReuseOrderRegst {
+  int64_t size;
+  int64_t num_consumers;
+  bool live_to_end;
+};
+
+// Orders the nodes of a chain by a topological sort which runs the ready node with the least peak
+// of the live bytes in the next lookahead steps, and then with the least live bytes after them
+class MemReuseOrderScheduler final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(MemReuseOrderScheduler);
+  MemReuseOrderScheduler(const std::vector<MemReuseOrderNode>& nodes,
+                         const std::vector<MemReuseOrderRegst>& regsts, int64_t lookahead)
+      : nodes_(nodes), regsts_(regsts), lookahead_(std::max<int64_t>(lookahead, 1)) {}
+  ~MemReuseOrderScheduler() = default;
+
+  int64_t PeakLiveBytes(const std::vector<int64_t>& order) {
+    Reset();
+    int64_t peak = 0;
+    for (int64_t node : order) { peak = std::max(peak, Run(node)); }
+    CHECK(ready_.empty());
+    return peak;
+  }
+
+  std::vector<int64_t> MakeOrder() {
+    Reset();
+    std::vector<int64_t> order;
+    while (!ready_.empty()) {
+      int64_t node = -1;
+      Search(lookahead_, &node);
+      Run(node);
+      order.push_back(node);
+    }
+    CHECK_EQ(order.size(), nodes_.size());
+    return order;
+  }
+
+ private:
+  // the ranking of the ready nodes by one step is cut to these before looking further ahead
+  static const int64_t kMaxNumSearchedNodes = 8;
+
+  void Reset() {
+    live_ = 0;
+    ready_.clear();
+    in_cnt_.resize(nodes_.size());
+    for (int64_t i = 0; i < nodes_.size(); ++i) {
+      in_cnt_.at(i) = nodes_.at(i).in.size();
+      if (in_cnt_.at(i) == 0) { ready_.push_back(i); }
+    }
+    consumer_cnt_.resize(regsts_.size());
+    for (int64_t i = 0; i < regsts_.size(); ++i) {
+      consumer_cnt_.at(i) = regsts_.at(i).num_consumers;
+    }
+  }
+
+  bool IsFreed(int64_t regst) const {
+    return consumer_cnt_.at(regst) == 0 && !regsts_.at(regst).live_to_end;
+  }
+
+  // returns the live bytes while node runs
+  int64_t Run(int64_t node) {
+    auto it = std::find(ready_.begin(), ready_.end(), node);
+    CHECK(it != ready_.end());
+    ready_.erase(it);
+    const MemReuseOrderNode& order_node = nodes_.at(node);
+    for (int64_t regst : order_node.produced_regsts) { live_ += regsts_.at(regst).size; }
+    const int64_t step_live = live_;
+    for (int64_t regst : order_node.consumed_regsts) {
+      consumer_cnt_.at(regst) -= 1;
+      if (IsFreed(regst)) { live_ -= regsts_.at(regst).size; }
+    }
+    for (int64_t regst : order_node.produced_regsts) {
+      if (IsFreed(regst)) { live_ -= regsts_.at(regst).size; }
+    }
+    for (int64_t out : order_node.out) {
+      in_cnt_.at(out) -= 1;
+      if (in_cnt_.at(out) == 0) { ready_.push_back(out); }
+    }
+    return step_live;
+  }
+
+  void Undo(int64_t node) {
+    const MemReuseOrderNode& order_node = nodes_.at(node);
+    for (int64_t out : order_node.out) {
+      if (in_cnt_.at(out) == 0) { ready_.erase(std::find(ready_.begin(), ready_.end(), out)); }
+      in_cnt_.at(out) += 1;
+    }
+    for (int64_t regst : order_node.produced_regsts) {
+      if (IsFreed(regst)) { live_ += regsts_.at(regst).size; }
+    }
+    for (int64_t regst : order_node.consumed_regsts) {
+      if (IsFreed(regst)) { live_ += regsts_.at(regst).size; }
+      consumer_cnt_.at(regst) += 1;
+    }
+    for (int64_t regst : order_node.produced_regsts) { live_ -= regsts_.at(regst).size; }
+    ready_.push_back(node);
+  }
+
+  // returns the least (peak, live bytes after) of the next depth steps, and its first node
+  std::pair<int64_t, int64_t> Search(int64_t depth, int64_t* best_node) {
+    std::vector<int64_t> candidates(ready_.begin(), ready_.end());
+    std::sort(candidates.begin(), candidates.end());
+    if (depth > 1 && candidates.size() > kMaxNumSearchedNodes) {
+      HashMap<int64_t, std::pair<int64_t, int64_t>> node2cost;
+      for (int64_t node : candidates) {
+        const int64_t step_live = Run(node);
+        node2cost.emplace(node, std::make_pair(step_live, live_));
+        Undo(node);
+      }
+      std::stable_sort(candidates.begin(), candidates.end(), [&](int64_t lhs, int64_t rhs) {
+        return node2cost.at(lhs) < node2cost.at(rhs);
+      });
+      candidates.resize(kMaxNumSearchedNodes);
+    }
+    std::pair<int64_t, int64_t> best_cost(std::numeric_limits<int64_t>::max(),
+                                          std::numeric_limits<int64_t>::max());
+    int64_t best = -1;
+    for (int64_t node : candidates) {
+      const int64_t step_live = Run(node);
+      std::pair<int64_t, int64_t> cost(step_live, live_);
+      if (depth > 1 && !ready_.empty()) {
+        const std::pair<int64_t, int64_t> next_cost = Search(depth - 1, nullptr);
+        cost = std::make_pair(std::max(step_live, next_cost.first), next_cost.second);
+      }
+      Undo(node);
+      if (cost < best_cost || (cost == best_cost && node < best)) {
+        best_cost = cost;
+        best = node;
+      }
+    }
+    CHECK_NE(best, -1);
+    if (best_node != nullptr) { *best_node = best; }
+    return best_cost;
+  }
+
+  const std::vector<MemReuseOrderNode>& nodes_;
+  const std::vector<MemReuseOrderRegst>& regsts_;
+  const int64_t lookahead_;
+  int64_t live_;
+  std::vector<int64_t> ready_;
+  std::vector<int64_t> in_cnt_;
+  std::vector<int64_t> consumer_cnt_;
+};
+
+// Returns the tasks in a topological order of their in tasks and the ordering edges of the chains,
+// which prefers the earlier tasks, or an empty order if there is a cycle
+std::vector<int64_t> TopoOrder(const std::vector<MemReuseOrderTask>& tasks,
+                               const std::vector<std::vector<int64_t>>& task2out,
+                               const std::vector<int64_t>& chain_next) {
+  const int64_t num_tasks = tasks.size();
+  std::vector<int64_t> in_cnt(num_tasks, 0);
+  FOR_RANGE(int64_t, i, 0, num_tasks) {
+    in_cnt.at(i) += tasks.at(i).in.size();
+    if (chain_next.at(i) != -1) { in_cnt.at(chain_next.at(i)) += 1; }
+  }
+  std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> ready;
+  FOR_RANGE(int64_t, i, 0, num_tasks) {
+    if (in_cnt.at(i) == 0) { ready.push(i); }
+  }
+  auto Release = [&](int64_t task) {
+    in_cnt.at(task) -= 1;
+    if (in_cnt.at(task) == 0) { ready.push(task); }
+  };
+  std::vector<int64_t> order;
+  while (!ready.empty()) {
+    const int64_t task = ready.top();
+    ready.pop();
+    order.push_back(task);
+    for (int64_t out : task2out.at(task)) { Release(out); }
+    if (chain_next.at(task) != -1) { Release(chain_next.at(task)); }
+  }
+  if (order.size() < num_tasks) { order.clear(); }
+  return order;
+}
+
+}  // namespace
+
+std::vector<int64_t> ReorderTasksForMemReuse(const std::vector<MemReuseOrderTask>& tasks,
+                                             const std::vector<MemReuseOrderTaskRegst>& regsts,
+                                             int64_t lookahead,
+                                             std::vector<MemReuseOrderChainPeak>* chain_peaks) {
+  const int64_t num_tasks = tasks.size();
+  std::vector<std::vector<int64_t>> task2out(num_tasks);
+  std::map<int64_t, std::vector<int64_t>> chain_id2order;
+  FOR_RANGE(int64_t, i, 0, num_tasks) {
+    for (int64_t in : tasks.at(i).in) {
+      CHECK_LT(in, i);
+      task2out.at(in).push_back(i);
+    }
+    chain_id2order[tasks.at(i).chain_id].push_back(i);
+  }
+  std::vector<std::vector<int64_t>> task2produced_regsts(num_tasks);
+  FOR_RANGE(int64_t, i, 0, regsts.size()) {
+    task2produced_regsts.at(regsts.at(i).producer).push_back(i);
+  }
+  // the ordering edges of the chains, from a task to the next one in its chain
+  std::vector<int64_t> chain_prev(num_tasks, -1);
+  std::vector<int64_t> chain_next(num_tasks, -1);
+  auto LinkChain = [&](const std::vector<int64_t>& order) {
+    FOR_RANGE(int64_t, i, 1, order.size()) {
+      chain_next.at(order.at(i - 1)) = order.at(i);
+      chain_prev.at(order.at(i)) = order.at(i - 1);
+    }
+  };
+  auto UnlinkChain = [&](const std::vector<int64_t>& order) {
+    for (int64_t task : order) {
+      chain_next.at(task) = -1;
+      chain_prev.at(task) = -1;
+    }
+  };
+  for (const auto& pair : chain_id2order) { LinkChain(pair.second); }
+  for (auto& pair : chain_id2order) {
+    std::vector<int64_t>& chain_tasks = pair.second;
+    if (chain_tasks.size() <= 2) { continue; }
+    HashMap<int64_t, int64_t> task2index;
+    FOR_RANGE(int64_t, i, 0, chain_tasks.size()) {
+      CHECK(task2index.emplace(chain_tasks.at(i), i).second);
+    }
+    std::vector<MemReuseOrderNode> order_nodes(chain_tasks.size());
+    std::vector<MemReuseOrderRegst> order_regsts;
+    FOR_RANGE(int64_t, i, 0, chain_tasks.size()) {
+      for (int64_t regst_id : task2produced_regsts.at(chain_tasks.at(i))) {
+        const MemReuseOrderTaskRegst& regst = regsts.at(regst_id);
+        MemReuseOrderRegst order_regst{};
+        order_regst.size = regst.size;
+        HashSet<int64_t> consumers;
+        for (int64_t consumer : regst.consumers) {
+          auto consumer_it = task2index.find(consumer);
+          if (consumer_it == task2index.end()) {
+            order_regst.live_to_end = true;
+          } else {
+            consumers.insert(consumer_it->second);
+          }
+        }
+        order_regst.num_consumers = consumers.size();
+        for (int64_t consumer : consumers) {
+          order_nodes.at(consumer).consumed_regsts.push_back(order_regsts.size());
+        }
+        order_nodes.at(i).produced_regsts.push_back(order_regsts.size());
+        order_regsts.push_back(order_regst);
+      }
+    }
+    if (order_regsts.empty()) { continue; }
+    // the tasks of the chain depend on each other through the other tasks and the ordering edges
+    // of the other chains, which are acyclic without the ordering edges of this chain
+    UnlinkChain(chain_tasks);
+    const std::vector<int64_t> topo_order = TopoOrder(tasks, task2out, chain_next);
+    CHECK_EQ(topo_order.size(), num_tasks);
+    // the nearest tasks of the chain that reach a task out of the chain
+    HashMap<int64_t, std::vector<int64_t>> task2chain_frontier;
+    int64_t num_visited_chain_tasks = 0;
+    for (int64_t task : topo_order) {
+      std::vector<int64_t> frontier;
+      auto AddInTask = [&](int64_t in) {
+        auto index_it = task2index.find(in);
+        if (index_it != task2index.end()) {
+          frontier.push_back(index_it->second);
+          return;
+        }
+        auto frontier_it = task2chain_frontier.find(in);
+        if (frontier_it != task2chain_frontier.end()) {
+          frontier.insert(frontier.end(), frontier_it->second.begin(), frontier_it->second.end());
+        }
+      };
+      for (int64_t in : tasks.at(task).in) { AddInTask(in); }
+      if (chain_prev.at(task) != -1) { AddInTask(chain_prev.at(task)); }
+      std::sort(frontier.begin(), frontier.end());
+      frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+      auto index_it = task2index.find(task);
+      if (index_it != task2index.end()) {
+        for (int64_t in : frontier) { order_nodes.at(in).out.push_back(index_it->second); }
+        order_nodes.at(index_it->second).in = std::move(frontier);
+        num_visited_chain_tasks += 1;
+        if (num_visited_chain_tasks == chain_tasks.size()) { break; }
+      } else if (!frontier.empty()) {
+        CHECK(task2chain_frontier.emplace(task, std::move(frontier)).second);
+      }
+    }
+    std::vector<int64_t> origin_order(chain_tasks.size());
+    std::iota(origin_order.begin(), origin_order.end(), 0);
+    MemReuseOrderScheduler scheduler(order_nodes, order_regsts, lookahead);
+    const int64_t origin_peak = scheduler.PeakLiveBytes(origin_order);
+    const std::vector<int64_t> order = scheduler.MakeOrder();
+    const int64_t peak = scheduler.PeakLiveBytes(order);
+    chain_peaks->push_back(MemReuseOrderChainPeak{pair.first, origin_peak, origin_peak});
+    if (peak < origin_peak) {
+      chain_peaks->back().peak = peak;
+      std::vector<int64_t> reordered_tasks;
+      for (int64_t index : order) { reordered_tasks.push_back(chain_tasks.at(index)); }
+      chain_tasks = std::move(reordered_tasks);
+    }
+    LinkChain(chain_tasks);
+  }
+  std::vector<int64_t> order = TopoOrder(tasks, task2out, chain_next);
+  if (order.empty()) {
+    LOG(WARNING) << "the reordered chains make a cycle, all the tasks keep their order";
+    order.resize(num_tasks);
+    std::iota(order.begin(), order.end(), 0);
+    for (MemReuseOrderChainPeak& chain_peak : *chain_peaks) {
+      chain_peak.peak = chain_peak.origin_peak;
+    }
+  }
+  return order;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,57 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_GRAPH_MEM_REUSE_TASK_ORDER_H_
+#define ONEFLOW_CORE_GRAPH_MEM_REUSE_TASK_ORDER_H_
+
+#include "oneflow/core/common/util.h"
+
+namespace oneflow {
+
+// A task of a task graph whose tasks are given in a topological order
+struct MemReuseOrderTask {
+  int64_t chain_id;
+  // the tasks it directly depends on, which are all before it
+  std::vector<int64_t> in;
+};
+
+// A mem reused regst, which is live from when its producer runs until its last consumer in the
+// chain of the producer runs, or until the end of the chain if it has consumers out of the chain
+struct MemReuseOrderTaskRegst {
+  int64_t producer;
+  std::vector<int64_t> consumers;
+  int64_t size;
+};
+
+struct MemReuseOrderChainPeak {
+  int64_t chain_id;
+  int64_t origin_peak;
+  int64_t peak;
+};
+
+// Reorders the tasks of every chain by a topological sort which runs the ready task with the least
+// peak of the live bytes of the chain in the next lookahead steps. The chains are reordered one
+// after another, each keeping the orders of the chains before it, so that the ordering edges of
+// all the chains never make a cycle. A chain keeps its order unless the new order strictly lowers
+// its peak. Returns the tasks in a topological order, in which the tasks of every chain are in
+// their new order
+std::vector<int64_t> ReorderTasksForMemReuse(const std::vector<MemReuseOrderTask>& tasks,
+                                             const std::vector<MemReuseOrderTaskRegst>& regsts,
+                                             int64_t lookahead,
+                                             std::vector<MemReuseOrderChainPeak>* chain_peaks);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_GRAPH_MEM_REUSE_TASK_ORDER_H_
@@ -0,0 +1,116 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/core/graph/mem_reuse_task_order.h"
+#include <random>
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// every task is after the tasks it depends on, and every task appears once
+void CheckTopological(const std::vector<MemReuseOrderTask>& tasks,
+                      const std::vector<int64_t>& order) {
+  ASSERT_EQ(order.size(), tasks.size());
+  std::vector<int64_t> task2position(tasks.size(), -1);
+  FOR_RANGE(int64_t, i, 0, order.size()) {
+    ASSERT_EQ(task2position.at(order.at(i)), -1);
+    task2position.at(order.at(i)) = i;
+  }
+  FOR_RANGE(int64_t, task, 0, tasks.size()) {
+    for (int64_t in : tasks.at(task).in) {
+      ASSERT_LT(task2position.at(in), task2position.at(task));
+    }
+  }
+}
+
+std::vector<int64_t> GetChainOrder(const std::vector<MemReuseOrderTask>& tasks,
+                                   const std::vector<int64_t>& order, int64_t chain_id) {
+  std::vector<int64_t> chain_order;
+  for (int64_t task : order) {
+    if (tasks.at(task).chain_id == chain_id) { chain_order.push_back(task); }
+  }
+  return chain_order;
+}
+
+}  // namespace
+
+// Both chains prefer to run their second task first, but the edges between the chains do not
+// allow both: the ctrl edges of the orders B, A and D, C would make the cycle B, A, D, C, B
+TEST(MemReuseTaskOrder, cross_chain_edges) {
+  // chain 0: S0 = 0, A = 2, B = 4, E0 = 6; chain 1: S1 = 1, C = 3, D = 5, E1 = 7
+  std::vector<MemReuseOrderTask> tasks(8);
+  tasks.at(0) = MemReuseOrderTask{0, {}};
+  tasks.at(1) = MemReuseOrderTask{1, {}};
+  tasks.at(2) = MemReuseOrderTask{0, {}};
+  tasks.at(3) = MemReuseOrderTask{1, {}};
+  tasks.at(4) = MemReuseOrderTask{0, {0, 3}};
+  tasks.at(5) = MemReuseOrderTask{1, {1, 2}};
+  tasks.at(6) = MemReuseOrderTask{0, {2, 4}};
+  tasks.at(7) = MemReuseOrderTask{1, {3, 5}};
+  // running B before A frees the 100 bytes of S before A allocates its 60 bytes
+  std::vector<MemReuseOrderTaskRegst> regsts;
+  regsts.push_back(MemReuseOrderTaskRegst{0, {4}, 100});
+  regsts.push_back(MemReuseOrderTaskRegst{2, {6}, 60});
+  regsts.push_back(MemReuseOrderTaskRegst{4, {6}, 10});
+  regsts.push_back(MemReuseOrderTaskRegst{1, {5}, 100});
+  regsts.push_back(MemReuseOrderTaskRegst{3, {7}, 60});
+  regsts.push_back(MemReuseOrderTaskRegst{5, {7}, 10});
+  std::vector<MemReuseOrderChainPeak> chain_peaks;
+  const std::vector<int64_t> order = ReorderTasksForMemReuse(tasks, regsts, 2, &chain_peaks);
+  CheckTopological(tasks, order);
+  ASSERT_TRUE(GetChainOrder(tasks, order, 0) == std::vector<int64_t>({0, 4, 2, 6}));
+  ASSERT_TRUE(GetChainOrder(tasks, order, 1) == std::vector<int64_t>({1, 3, 5, 7}));
+  ASSERT_EQ(chain_peaks.size(), 2);
+  ASSERT_EQ(chain_peaks.at(0).chain_id, 0);
+  ASSERT_EQ(chain_peaks.at(0).origin_peak, 170);
+  ASSERT_EQ(chain_peaks.at(0).peak, 110);
+  ASSERT_EQ(chain_peaks.at(1).peak, chain_peaks.at(1).origin_peak);
+}
+
+TEST(MemReuseTaskOrder, random_graphs) {
+  std::mt19937 gen(0);
+  bool lowered = false;
+  FOR_RANGE(int64_t, graph, 0, 50) {
+    const int64_t num_tasks = 60;
+    const int64_t num_chains = 1 + graph % 4;
+    std::vector<MemReuseOrderTask> tasks(num_tasks);
+    std::vector<MemReuseOrderTaskRegst> regsts;
+    FOR_RANGE(int64_t, i, 0, num_tasks) {
+      tasks.at(i).chain_id = gen() % num_chains;
+      if (i == 0) { continue; }
+      const int64_t num_ins = gen() % 3;
+      FOR_RANGE(int64_t, j, 0, num_ins) { tasks.at(i).in.push_back(gen() % i); }
+      for (int64_t in : tasks.at(i).in) {
+        regsts.push_back(MemReuseOrderTaskRegst{in, {i}, static_cast<int64_t>(gen() % 1000)});
+      }
+    }
+    std::vector<MemReuseOrderChainPeak> chain_peaks;
+    const std::vector<int64_t> order = ReorderTasksForMemReuse(tasks, regsts, 2, &chain_peaks);
+    CheckTopological(tasks, order);
+    for (const MemReuseOrderChainPeak& chain_peak : chain_peaks) {
+      ASSERT_LE(chain_peak.peak, chain_peak.origin_peak);
+      lowered = lowered || chain_peak.peak < chain_peak.origin_peak;
+    }
+  }
+  ASSERT_TRUE(lowered);
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/graph/task_graph.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/graph/inplace_lbi_graph.h"
+#include "oneflow/core/graph/mem_reuse_task_order.h"
 #include "oneflow/core/graph/id_serialization.h"
 #include "oneflow/core/register/blob_desc.h"
 #include "oneflow/core/job/global_for.h"
@@ -549,6 +550,9 @@ void TaskGraph::RemoveEmptyRegsts() {
 
 void TaskGraph::MergeChainAndAddOrderingCtrlEdgeInSameChain() {
   MergeChain();
+  if (GlobalJobDesc().enable_reorder_tasks_for_mem_reuse()) {
+    ReorderNodesInSameChainForMemReuse();
+  }
   BuildCtrlRegstDescInSameChain();
 }
 
@@ -580,6 +584,51 @@ void TaskGraph::MergeChain() {
   for (auto* node : ordered_task_nodes_) { CHECK_NE(node->chain_id(), -1); }
 }
 
+void TaskGraph::ReorderNodesInSameChainForMemReuse() {
+  HashMap<const TaskNode*, int64_t> node2index;
+  for (int64_t i = 0; i < ordered_task_nodes_.size(); ++i) {
+    CHECK(node2index.emplace(ordered_task_nodes_.at(i), i).second);
+  }
+  std::vector<MemReuseOrderTask> tasks(ordered_task_nodes_.size());
+  std::vector<MemReuseOrderTaskRegst> regsts;
+  for (int64_t i = 0; i < ordered_task_nodes_.size(); ++i) {
+    const TaskNode* node = ordered_task_nodes_.at(i);
+    tasks.at(i).chain_id = node->chain_id();
+    node->ForEachNodeOnInEdge(
+        [&](const TaskNode* in_node) { tasks.at(i).in.push_back(node2index.at(in_node)); });
+    for (const auto& name7regst : node->produced_regsts()) {
+      const RegstDesc* regst = name7regst.second.get();
+      if (!regst->mem_case().has_device_cuda_mem()
+          || !regst->regst_desc_type().has_data_regst_desc() || !regst->enable_reuse_mem()) {
+        continue;
+      }
+      MemReuseOrderTaskRegst order_regst{};
+      order_regst.producer = i;
+      regst->ForEachLbi([&](const LogicalBlobId& lbi) {
+        order_regst.size += regst->GetBlobDesc(lbi)->AlignedByteSizeOfBlobBody();
+      });
+      for (const TaskNode* consumer : regst->consumers()) {
+        order_regst.consumers.push_back(node2index.at(consumer));
+      }
+      regsts.push_back(order_regst);
+    }
+  }
+  std::vector<MemReuseOrderChainPeak> chain_peaks;
+  const std::vector<int64_t> order = ReorderTasksForMemReuse(
+      tasks, regsts, GlobalJobDesc().reorder_tasks_for_mem_reuse_lookahead(), &chain_peaks);
+  for (const MemReuseOrderChainPeak& chain_peak : chain_peaks) {
+    LOG(INFO) << "job " << GlobalJobDesc().job_name() << " chain " << chain_peak.chain_id
+              << ": peak live bytes of mem reused regsts " << chain_peak.origin_peak << " -> "
+              << chain_peak.peak;
+  }
+  // the order is topological, and the ordering ctrl edges of the chains follow it
+  const std::vector<TaskNode*> origin_ordered_task_nodes = ordered_task_nodes_;
+  for (int64_t i = 0; i < order.size(); ++i) {
+    ordered_task_nodes_.at(i) = origin_ordered_task_nodes.at(order.at(i));
+    ordered_task_nodes_.at(i)->reset_order_in_graph(i);
+  }
+}
+
 void TaskGraph::BuildCtrlRegstDescInSameChain() {
   HashMap<int64_t, TaskNode*> chain_id2node;
   for (auto* node : ordered_task_nodes_) {
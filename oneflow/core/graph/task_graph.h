@@ -81,6 +81,7 @@ class TaskGraph final : public Graph<TaskNode, TaskEdge> {
 
   void SetOrderInGraphForEachNode();
   void MergeChain();
+  void ReorderNodesInSameChainForMemReuse();
   void BuildCtrlRegstDescInSameChain();
 
   // inplace
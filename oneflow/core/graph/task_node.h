@@ -74,6 +74,7 @@ class TaskNode : public Node<TaskNode, TaskEdge> {
   void set_thrd_id(int64_t val);
   void set_chain_id(int64_t val);
   void set_order_in_graph(int64_t val);
+  void reset_order_in_graph(int64_t val);
 
   // Build
   virtual void ProduceAllRegstsAndBindEdges() = 0;
@@ -0,0 +1,586 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/collective_boxing_comm_net.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace {
+
+// from the highest bit: 1 | request index | run id | src rank | dst rank | chunk | seq, so that the
+// tokens never collide with the ones counted up from 0 by the eager transport
+const int kTokenRequestIndexBits = 16;
+const int kTokenRunIdBits = 8;
+const int kTokenRankBits = 10;
+const int kTokenChunkBits = 9;
+const int kTokenSeqBits = 10;
+static_assert(1 + kTokenRequestIndexBits + kTokenRunIdBits + 2 * kTokenRankBits + kTokenChunkBits
+                      + kTokenSeqBits
+                  == 64,
+              "");
+
+const int64_t kMaxNumRanks = static_cast<int64_t>(1) << kTokenRankBits;
+const int64_t kMaxNumChunks = static_cast<int64_t>(1) << kTokenChunkBits;
+const int64_t kMaxSeq = static_cast<int64_t>(1) << kTokenSeqBits;
+
+int64_t Mod(int64_t a, int64_t n) { return ((a % n) + n) % n; }
+
+bool IsPowerOfTwo(int64_t n) { return n > 0 && (n & (n - 1)) == 0; }
+
+int64_t CeilDiv(int64_t a, int64_t b) { return (a + b - 1) / b; }
+
+CommNetBufferSlice Slice(CommNetBufferType buffer, int64_t offset, int64_t size) {
+  CommNetBufferSlice slice;
+  slice.buffer = buffer;
+  slice.offset = offset;
+  slice.size = size;
+  return slice;
+}
+
+CommNetBufferSlice Slice(CommNetBufferType buffer, const Range& range) {
+  return Slice(buffer, range.begin(), range.size());
+}
+
+int64_t GetNumChunks(int64_t max_size, int64_t chunk_size) {
+  CHECK_GT(chunk_size, 0);
+  return std::min(std::max(CeilDiv(max_size, chunk_size), static_cast<int64_t>(1)), kMaxNumChunks);
+}
+
+// The bytes of the data cut into num_parts parts along the elements, then each part into
+// num_chunks chunks
+class CommNetDataSplitter final {
+ public:
+  CommNetDataSplitter(int64_t elem_cnt, int64_t size_of_data_type, int64_t num_parts,
+                      int64_t num_chunks)
+      : size_of_data_type_(size_of_data_type),
+        num_chunks_(num_chunks),
+        part_splitter_(elem_cnt, num_parts) {
+    max_chunk_size_ = 0;
+    FOR_RANGE(int64_t, i, 0, num_parts) {
+      const int64_t part_elem_cnt = part_splitter_.At(i).size();
+      const int64_t max_chunk_elem_cnt = CeilDiv(part_elem_cnt, num_chunks);
+      max_chunk_size_ = std::max(max_chunk_size_, max_chunk_elem_cnt * size_of_data_type);
+    }
+  }
+
+  Range Part(int64_t first_part, int64_t last_part) const {
+    const Range range = part_splitter_.At(first_part, last_part);
+    return Range(range.begin() * size_of_data_type_, range.end() * size_of_data_type_);
+  }
+  Range Part(int64_t part) const { return Part(part, part); }
+  Range Chunk(int64_t part, int64_t chunk) const {
+    const Range part_range = part_splitter_.At(part);
+    const Range range = BalancedSplitter(part_range.size(), num_chunks_).At(chunk);
+    return Range((part_range.begin() + range.begin()) * size_of_data_type_,
+                 (part_range.begin() + range.end()) * size_of_data_type_);
+  }
+  // the chunk in the part, relative to the beginning of the part
+  Range ChunkInPart(int64_t part, int64_t chunk) const {
+    const Range range = Chunk(part, chunk);
+    const int64_t part_begin = Part(part).begin();
+    return Range(range.begin() - part_begin, range.end() - part_begin);
+  }
+  int64_t max_chunk_size() const { return max_chunk_size_; }
+
+ private:
+  int64_t size_of_data_type_;
+  int64_t num_chunks_;
+  BalancedSplitter part_splitter_;
+  int64_t max_chunk_size_;
+};
+
+// The scratch buffer holds num_slots slots of slot_size bytes for every chunk
+CommNetBufferSlice ScratchSlot(int64_t num_slots, int64_t slot_size, int64_t chunk, int64_t slot,
+                               int64_t size) {
+  CHECK_LE(size, slot_size);
+  return Slice(kCommNetScratchBuffer, (chunk * num_slots + slot) * slot_size, size);
+}
+
+// The reduce-scatter part of the ring, after which rank holds the sum of the part rank. At step s
+// rank sends the part rank - s - 1 to the next rank, and adds the part rank - s - 2 from the
+// previous rank to its own. The partial sums go to the recv buffer if it holds the whole data,
+// e.g. for all-reduce, otherwise to two scratch slots by turns
+void AddRingReduceScatterSteps(const CommNetDataSplitter& splitter, int64_t rank,
+                               int64_t num_ranks, int64_t num_chunks, bool recv_buffer_is_whole,
+                               CommNetCollectivePlan* plan) {
+  const int64_t num_slots = recv_buffer_is_whole ? 1 : 3;
+  const int64_t slot_size = splitter.max_chunk_size();
+  plan->scratch_size = std::max(plan->scratch_size, num_chunks * num_slots * slot_size);
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    const auto PartialSum = [&](int64_t step, int64_t part) {
+      if (recv_buffer_is_whole) {
+        return Slice(kCommNetRecvBuffer, splitter.Chunk(part, chunk));
+      } else if (step == num_ranks - 2) {
+        CHECK_EQ(part, rank);
+        return Slice(kCommNetRecvBuffer, splitter.ChunkInPart(part, chunk));
+      } else {
+        return ScratchSlot(num_slots, slot_size, chunk, 1 + step % 2,
+                           splitter.Chunk(part, chunk).size());
+      }
+    };
+    std::vector<CommNetCollectiveStep>* steps = &plan->chunk2steps.at(chunk);
+    FOR_RANGE(int64_t, step_id, 0, num_ranks - 1) {
+      const int64_t send_part = Mod(rank - step_id - 1, num_ranks);
+      const int64_t recv_part = Mod(rank - step_id - 2, num_ranks);
+      CommNetCollectiveStep step;
+      step.send_rank = Mod(rank + 1, num_ranks);
+      step.send = step_id == 0 ? Slice(kCommNetSendBuffer, splitter.Chunk(send_part, chunk))
+                               : PartialSum(step_id - 1, send_part);
+      step.recv_rank = Mod(rank - 1, num_ranks);
+      step.recv =
+          ScratchSlot(num_slots, slot_size, chunk, 0, splitter.Chunk(recv_part, chunk).size());
+      step.reduce = true;
+      step.reduce_src = Slice(kCommNetSendBuffer, splitter.Chunk(recv_part, chunk));
+      step.reduce_dst = PartialSum(step_id, recv_part);
+      steps->push_back(step);
+    }
+  }
+}
+
+// The all-gather part of the ring. At step s rank sends the part rank - s to the next rank, and
+// receives the part rank - s - 1 from the previous rank. The send buffer holds only the part rank
+// if send_buffer_is_part, e.g. for all-gather, which is copied to the recv buffer at the first step
+void AddRingAllGatherSteps(const CommNetDataSplitter& splitter, int64_t rank, int64_t num_ranks,
+                           int64_t num_chunks, bool send_buffer_is_part,
+                           CommNetCollectivePlan* plan) {
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    std::vector<CommNetCollectiveStep>* steps = &plan->chunk2steps.at(chunk);
+    FOR_RANGE(int64_t, step_id, 0, num_ranks - 1) {
+      const int64_t send_part = Mod(rank - step_id, num_ranks);
+      const int64_t recv_part = Mod(rank - step_id - 1, num_ranks);
+      CommNetCollectiveStep step;
+      step.send_rank = Mod(rank + 1, num_ranks);
+      if (step_id == 0 && send_buffer_is_part) {
+        step.send = Slice(kCommNetSendBuffer, splitter.ChunkInPart(send_part, chunk));
+        step.copy = true;
+        step.copy_src = step.send;
+        step.copy_dst = Slice(kCommNetRecvBuffer, splitter.Chunk(send_part, chunk));
+      } else {
+        step.send = Slice(kCommNetRecvBuffer, splitter.Chunk(send_part, chunk));
+      }
+      step.recv_rank = Mod(rank - 1, num_ranks);
+      step.recv = Slice(kCommNetRecvBuffer, splitter.Chunk(recv_part, chunk));
+      steps->push_back(step);
+    }
+  }
+}
+
+// Recursive halving for the reduce-scatter, then recursive doubling for the all-gather, with the
+// data cut into num_ranks parts. At a halving step rank keeps the half of its parts on its side of
+// the peer, and adds the half from the peer to it. At a doubling step rank and the peer exchange
+// their parts
+void AddRecursiveHalvingDoublingAllReduceSteps(const CommNetDataSplitter& splitter, int64_t rank,
+                                               int64_t num_ranks, CommNetCollectivePlan* plan) {
+  CHECK(IsPowerOfTwo(num_ranks));
+  plan->scratch_size = std::max(plan->scratch_size, splitter.Part(0, num_ranks - 1).size());
+  std::vector<CommNetCollectiveStep>* steps = &plan->chunk2steps.at(0);
+  int64_t first_part = 0;
+  int64_t end_part = num_ranks;
+  for (int64_t distance = num_ranks / 2; distance >= 1; distance /= 2) {
+    const int64_t mid_part = (first_part + end_part) / 2;
+    const bool keep_lower = (rank & distance) == 0;
+    const Range keep = keep_lower ? splitter.Part(first_part, mid_part - 1)
+                                  : splitter.Part(mid_part, end_part - 1);
+    const Range give = keep_lower ? splitter.Part(mid_part, end_part - 1)
+                                  : splitter.Part(first_part, mid_part - 1);
+    const CommNetBufferType src_buffer =
+        distance == num_ranks / 2 ? kCommNetSendBuffer : kCommNetRecvBuffer;
+    CommNetCollectiveStep step;
+    step.send_rank = rank ^ distance;
+    step.send = Slice(src_buffer, give);
+    step.recv_rank = rank ^ distance;
+    step.recv = Slice(kCommNetScratchBuffer, 0, keep.size());
+    step.reduce = true;
+    step.reduce_src = Slice(src_buffer, keep);
+    step.reduce_dst = Slice(kCommNetRecvBuffer, keep);
+    steps->push_back(step);
+    if (keep_lower) {
+      end_part = mid_part;
+    } else {
+      first_part = mid_part;
+    }
+  }
+  CHECK_EQ(first_part, rank);
+  for (int64_t distance = 1; distance < num_ranks; distance *= 2) {
+    const int64_t num_parts = end_part - first_part;
+    const bool peer_is_upper = (rank & distance) == 0;
+    const int64_t peer_first_part = peer_is_upper ? end_part : first_part - num_parts;
+    CommNetCollectiveStep step;
+    step.send_rank = rank ^ distance;
+    step.send = Slice(kCommNetRecvBuffer, splitter.Part(first_part, end_part - 1));
+    step.recv_rank = rank ^ distance;
+    step.recv = Slice(kCommNetRecvBuffer,
+                      splitter.Part(peer_first_part, peer_first_part + num_parts - 1));
+    steps->push_back(step);
+    first_part = std::min(first_part, peer_first_part);
+    end_part = first_part + 2 * num_parts;
+  }
+}
+
+// Along the chain root, root + 1, ..., root - 1, every rank but the root receives a chunk into its
+// recv buffer and then passes it on
+void AddChainBroadcastSteps(const CommNetDataSplitter& splitter, int64_t rank, int64_t num_ranks,
+                            int64_t root, int64_t num_chunks, CommNetCollectivePlan* plan) {
+  const int64_t pos = Mod(rank - root, num_ranks);
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    std::vector<CommNetCollectiveStep>* steps = &plan->chunk2steps.at(chunk);
+    const Range range = splitter.Chunk(0, chunk);
+    if (pos == 0) {
+      CommNetCollectiveStep step;
+      step.send_rank = Mod(rank + 1, num_ranks);
+      step.send = Slice(kCommNetSendBuffer, range);
+      step.copy = true;
+      step.copy_src = Slice(kCommNetSendBuffer, range);
+      step.copy_dst = Slice(kCommNetRecvBuffer, range);
+      steps->push_back(step);
+    } else {
+      CommNetCollectiveStep recv_step;
+      recv_step.recv_rank = Mod(rank - 1, num_ranks);
+      recv_step.recv = Slice(kCommNetRecvBuffer, range);
+      steps->push_back(recv_step);
+      if (pos < num_ranks - 1) {
+        CommNetCollectiveStep send_step;
+        send_step.send_rank = Mod(rank + 1, num_ranks);
+        send_step.send = Slice(kCommNetRecvBuffer, range);
+        steps->push_back(send_step);
+      }
+    }
+  }
+}
+
+// Along the chain root + 1, root + 2, ..., root, every rank but the first one adds a chunk from
+// the previous rank to its own, and then passes the partial sum on
+void AddChainReduceSteps(const CommNetDataSplitter& splitter, int64_t rank, int64_t num_ranks,
+                         int64_t root, int64_t num_chunks, CommNetCollectivePlan* plan) {
+  const int64_t pos = Mod(rank - root - 1, num_ranks);
+  const int64_t num_slots = 2;
+  const int64_t slot_size = splitter.max_chunk_size();
+  if (pos != 0) { plan->scratch_size = num_chunks * num_slots * slot_size; }
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    std::vector<CommNetCollectiveStep>* steps = &plan->chunk2steps.at(chunk);
+    const Range range = splitter.Chunk(0, chunk);
+    const CommNetBufferSlice partial_sum =
+        pos == num_ranks - 1 ? Slice(kCommNetRecvBuffer, range)
+                             : ScratchSlot(num_slots, slot_size, chunk, 1, range.size());
+    if (pos != 0) {
+      CommNetCollectiveStep recv_step;
+      recv_step.recv_rank = Mod(rank - 1, num_ranks);
+      recv_step.recv = ScratchSlot(num_slots, slot_size, chunk, 0, range.size());
+      recv_step.reduce = true;
+      recv_step.reduce_src = Slice(kCommNetSendBuffer, range);
+      recv_step.reduce_dst = partial_sum;
+      steps->push_back(recv_step);
+    }
+    if (pos != num_ranks - 1) {
+      CommNetCollectiveStep send_step;
+      send_step.send_rank = Mod(rank + 1, num_ranks);
+      send_step.send = pos == 0 ? Slice(kCommNetSendBuffer, range) : partial_sum;
+      steps->push_back(send_step);
+    }
+  }
+}
+
+// Drops the empty messages, which happen when there are fewer elements than chunks, and numbers
+// the messages between every two ranks in every chunk, in the same way on both of them
+void FinalizePlan(CommNetCollectivePlan* plan) {
+  for (auto& steps : plan->chunk2steps) {
+    HashMap<int64_t, int64_t> dst_rank2num_sent;
+    HashMap<int64_t, int64_t> src_rank2num_received;
+    for (CommNetCollectiveStep& step : steps) {
+      if (step.send_rank != -1 && step.send.size == 0) { step.send_rank = -1; }
+      if (step.recv_rank != -1 && step.recv.size == 0) {
+        step.recv_rank = -1;
+        step.reduce = false;
+      }
+      if (step.copy && step.copy_src.size == 0) { step.copy = false; }
+      if (step.reduce) {
+        CHECK_EQ(step.reduce_src.size, step.recv.size);
+        CHECK_EQ(step.reduce_dst.size, step.recv.size);
+        CHECK_NE(step.reduce_dst.buffer, kCommNetSendBuffer);
+      }
+      if (step.copy) {
+        CHECK_EQ(step.copy_src.size, step.copy_dst.size);
+        CHECK_NE(step.copy_dst.buffer, kCommNetSendBuffer);
+      }
+      if (step.send_rank != -1) {
+        step.send_seq = dst_rank2num_sent[step.send_rank]++;
+        CHECK_LT(step.send_seq, kMaxSeq);
+      }
+      if (step.recv_rank != -1) {
+        CHECK_NE(step.recv.buffer, kCommNetSendBuffer);
+        step.recv_seq = src_rank2num_received[step.recv_rank]++;
+        CHECK_LT(step.recv_seq, kMaxSeq);
+      }
+    }
+  }
+}
+
+template<typename T>
+void ReduceSum(char* dst, const char* lhs, const char* rhs, int64_t size) {
+  T* dst_ptr = reinterpret_cast<T*>(dst);
+  const T* lhs_ptr = reinterpret_cast<const T*>(lhs);
+  const T* rhs_ptr = reinterpret_cast<const T*>(rhs);
+  FOR_RANGE(int64_t, i, 0, size / static_cast<int64_t>(sizeof(T))) {
+    dst_ptr[i] = lhs_ptr[i] + rhs_ptr[i];
+  }
+}
+
+void ReduceSum(DataType data_type, char* dst, const char* lhs, const char* rhs, int64_t size) {
+  switch (data_type) {
+#define REDUCE_SUM_DATA_TYPE_CASE(cpp_type, data_type) \
+  case data_type: return ReduceSum<cpp_type>(dst, lhs, rhs, size);
+    OF_PP_FOR_EACH_TUPLE(REDUCE_SUM_DATA_TYPE_CASE, ARITHMETIC_DATA_TYPE_SEQ);
+#undef REDUCE_SUM_DATA_TYPE_CASE
+    default: UNIMPLEMENTED();
+  }
+}
+
+// The state of a run of a plan, deleted when the last chunk is done
+struct CommNetCollectiveRun final {
+  CommNetCollectiveRun(const CommNetCollectivePlan* plan, int64_t request_index, int64_t run_id,
+                       const void* send_buff, void* recv_buff, char* scratch,
+                       CommNetCollectiveTransport* transport, ThreadPool* thread_pool,
+                       std::function<void()> callback)
+      : plan(plan),
+        request_index(request_index),
+        run_id(run_id),
+        send_buff(reinterpret_cast<const char*>(send_buff)),
+        recv_buff(reinterpret_cast<char*>(recv_buff)),
+        scratch(scratch),
+        transport(transport),
+        thread_pool(thread_pool),
+        callback(std::move(callback)),
+        chunk2step_id(plan->chunk2steps.size(), 0),
+        chunk2num_pending_ops(plan->chunk2steps.size()),
+        num_running_chunks(plan->chunk2steps.size()) {}
+
+  const char* Ptr(const CommNetBufferSlice& slice) const {
+    if (slice.buffer == kCommNetSendBuffer) {
+      return send_buff + slice.offset;
+    } else if (slice.buffer == kCommNetRecvBuffer) {
+      return recv_buff + slice.offset;
+    } else if (slice.buffer == kCommNetScratchBuffer) {
+      return scratch + slice.offset;
+    } else {
+      UNIMPLEMENTED();
+      return nullptr;
+    }
+  }
+  char* MutPtr(const CommNetBufferSlice& slice) const {
+    CHECK_NE(slice.buffer, kCommNetSendBuffer);
+    return const_cast<char*>(Ptr(slice));
+  }
+
+  const CommNetCollectivePlan* plan;
+  const int64_t request_index;
+  const int64_t run_id;
+  const char* send_buff;
+  char* recv_buff;
+  char* scratch;
+  CommNetCollectiveTransport* transport;
+  ThreadPool* thread_pool;
+  std::function<void()> callback;
+  // only touched by the thread running the current step of the chunk
+  std::vector<size_t> chunk2step_id;
+  std::vector<std::atomic<int64_t>> chunk2num_pending_ops;
+  std::atomic<int64_t> num_running_chunks;
+};
+
+void LaunchChunk(CommNetCollectiveRun* run, int64_t chunk);
+
+void OnStepOpDone(CommNetCollectiveRun* run, int64_t chunk) {
+  if (--run->chunk2num_pending_ops.at(chunk) == 0) {
+    run->chunk2step_id.at(chunk) += 1;
+    // never goes on in the callbacks of the transport, which may hold its threads
+    run->thread_pool->AddWork([run, chunk]() { LaunchChunk(run, chunk); });
+  }
+}
+
+// Launches the current step of chunk, or calls the callback of run if the last chunk is done
+void LaunchChunk(CommNetCollectiveRun* run, int64_t chunk) {
+  const std::vector<CommNetCollectiveStep>& steps = run->plan->chunk2steps.at(chunk);
+  size_t* step_id = &run->chunk2step_id.at(chunk);
+  while (*step_id < steps.size()) {
+    const CommNetCollectiveStep& step = steps.at(*step_id);
+    const bool has_send = step.send_rank != -1;
+    const bool has_recv = step.recv_rank != -1;
+    const bool has_copy = step.copy;
+    const int64_t num_ops = has_send + has_recv + has_copy;
+    if (num_ops == 0) {
+      *step_id += 1;
+      continue;
+    }
+    // every op of the step is counted before any of them is launched, and neither run nor step is
+    // touched after the last one is launched, since the step may be done and even the run may be
+    // deleted by then
+    run->chunk2num_pending_ops.at(chunk) = num_ops;
+    const int64_t rank = run->plan->rank;
+    if (has_copy) {
+      run->thread_pool->AddWork([run, chunk, &step]() {
+        const char* src = run->Ptr(step.copy_src);
+        char* dst = run->MutPtr(step.copy_dst);
+        if (src != dst) { std::memcpy(dst, src, step.copy_src.size); }
+        OnStepOpDone(run, chunk);
+      });
+    }
+    if (has_send) {
+      const uint64_t token = GetCommNetCollectiveToken(run->request_index, run->run_id, rank,
+                                                       step.send_rank, chunk, step.send_seq);
+      run->transport->Send(token, step.send_rank, run->Ptr(step.send), step.send.size,
+                           [run, chunk]() { OnStepOpDone(run, chunk); });
+    }
+    if (has_recv) {
+      const uint64_t token = GetCommNetCollectiveToken(run->request_index, run->run_id,
+                                                       step.recv_rank, rank, chunk, step.recv_seq);
+      run->transport->Receive(token, step.recv_rank, run->MutPtr(step.recv), step.recv.size,
+                              [run, chunk, &step]() {
+                                if (step.reduce) {
+                                  run->thread_pool->AddWork([run, chunk, &step]() {
+                                    ReduceSum(run->plan->data_type, run->MutPtr(step.reduce_dst),
+                                              run->Ptr(step.reduce_src), run->Ptr(step.recv),
+                                              step.recv.size);
+                                    OnStepOpDone(run, chunk);
+                                  });
+                                } else {
+                                  OnStepOpDone(run, chunk);
+                                }
+                              });
+    }
+    return;
+  }
+  if (--run->num_running_chunks == 0) {
+    run->callback();
+    delete run;
+  }
+}
+
+}  // namespace
+
+CommNetCollectivePlan MakeCommNetCollectivePlan(const OpDesc& op_desc, int64_t rank,
+                                                const CommNetCollectiveOptions& options) {
+  const int64_t num_ranks = op_desc.num_ranks();
+  CHECK_GT(num_ranks, 0);
+  CHECK_LE(num_ranks, kMaxNumRanks);
+  CHECK_GE(rank, 0);
+  CHECK_LT(rank, num_ranks);
+  const OpType op_type = op_desc.op_type();
+  const int64_t elem_cnt = Shape(op_desc.shape()).elem_cnt();
+  const int64_t size_of_data_type = GetSizeOfDataType(op_desc.data_type());
+  const int64_t size = elem_cnt * size_of_data_type;
+  if (op_type == OpType::kOpTypeAllReduce || op_type == OpType::kOpTypeReduceScatter
+      || op_type == OpType::kOpTypeReduce) {
+    CHECK_EQ(op_desc.reduce_method(), ReduceMethod::kReduceMethodSum);
+  }
+  CommNetCollectivePlan plan;
+  plan.rank = rank;
+  plan.data_type = op_desc.data_type();
+  plan.scratch_size = 0;
+  if (num_ranks == 1) {
+    CHECK(op_type != OpType::kOpTypeAll2All);
+    plan.chunk2steps.resize(1);
+    CommNetCollectiveStep step;
+    step.copy = true;
+    step.copy_src = Slice(kCommNetSendBuffer, 0, size);
+    step.copy_dst = Slice(kCommNetRecvBuffer, 0, size);
+    plan.chunk2steps.front().push_back(step);
+  } else if (op_type == OpType::kOpTypeAllReduce) {
+    if (IsPowerOfTwo(num_ranks) && size <= options.recursive_halving_doubling_threshold) {
+      const CommNetDataSplitter splitter(elem_cnt, size_of_data_type, num_ranks, 1);
+      plan.chunk2steps.resize(1);
+      AddRecursiveHalvingDoublingAllReduceSteps(splitter, rank, num_ranks, &plan);
+    } else {
+      const int64_t num_chunks =
+          GetNumChunks(CeilDiv(elem_cnt, num_ranks) * size_of_data_type, options.chunk_size);
+      const CommNetDataSplitter splitter(elem_cnt, size_of_data_type, num_ranks, num_chunks);
+      plan.chunk2steps.resize(num_chunks);
+      AddRingReduceScatterSteps(splitter, rank, num_ranks, num_chunks, true, &plan);
+      AddRingAllGatherSteps(splitter, rank, num_ranks, num_chunks, false, &plan);
+    }
+  } else if (op_type == OpType::kOpTypeReduceScatter || op_type == OpType::kOpTypeAllGather) {
+    CHECK_EQ(elem_cnt % num_ranks, 0);
+    const int64_t num_chunks = GetNumChunks(size / num_ranks, options.chunk_size);
+    const CommNetDataSplitter splitter(elem_cnt, size_of_data_type, num_ranks, num_chunks);
+    plan.chunk2steps.resize(num_chunks);
+    if (op_type == OpType::kOpTypeReduceScatter) {
+      AddRingReduceScatterSteps(splitter, rank, num_ranks, num_chunks, false, &plan);
+    } else {
+      AddRingAllGatherSteps(splitter, rank, num_ranks, num_chunks, true, &plan);
+    }
+  } else if (op_type == OpType::kOpTypeBroadcast || op_type == OpType::kOpTypeReduce) {
+    CHECK(op_desc.has_root());
+    const int64_t num_chunks = GetNumChunks(size, options.chunk_size);
+    const CommNetDataSplitter splitter(elem_cnt, size_of_data_type, 1, num_chunks);
+    plan.chunk2steps.resize(num_chunks);
+    if (op_type == OpType::kOpTypeBroadcast) {
+      AddChainBroadcastSteps(splitter, rank, num_ranks, op_desc.root(), num_chunks, &plan);
+    } else {
+      AddChainReduceSteps(splitter, rank, num_ranks, op_desc.root(), num_chunks, &plan);
+    }
+  } else {
+    UNIMPLEMENTED();
+  }
+  FinalizePlan(&plan);
+  return plan;
+}
+
+uint64_t GetCommNetCollectiveToken(int64_t request_index, int64_t run_id, int64_t src_rank,
+                                   int64_t dst_rank, int64_t chunk, int64_t seq) {
+  CHECK_GE(request_index, 0);
+  CHECK_LT(request_index, static_cast<int64_t>(1) << kTokenRequestIndexBits);
+  CHECK_GE(run_id, 0);
+  CHECK_LT(src_rank, kMaxNumRanks);
+  CHECK_LT(dst_rank, kMaxNumRanks);
+  CHECK_LT(chunk, kMaxNumChunks);
+  CHECK_LT(seq, kMaxSeq);
+  uint64_t token = 1;
+  token = (token << kTokenRequestIndexBits) | static_cast<uint64_t>(request_index);
+  // the runs far apart never overlap, so the run id wraps around
+  token = (token << kTokenRunIdBits)
+          | (static_cast<uint64_t>(run_id) & ((static_cast<uint64_t>(1) << kTokenRunIdBits) - 1));
+  token = (token << kTokenRankBits) | static_cast<uint64_t>(src_rank);
+  token = (token << kTokenRankBits) | static_cast<uint64_t>(dst_rank);
+  token = (token << kTokenChunkBits) | static_cast<uint64_t>(chunk);
+  token = (token << kTokenSeqBits) | static_cast<uint64_t>(seq);
+  return token;
+}
+
+void RunCommNetCollectivePlan(const CommNetCollectivePlan* plan, int64_t request_index,
+                              int64_t run_id, const void* send_buff, void* recv_buff,
+                              char* scratch, CommNetCollectiveTransport* transport,
+                              ThreadPool* thread_pool, std::function<void()> callback) {
+  if (plan->chunk2steps.empty()) {
+    callback();
+    return;
+  }
+  auto* run = new CommNetCollectiveRun(plan, request_index, run_id, send_buff, recv_buff, scratch,
+                                       transport, thread_pool, std::move(callback));
+  const int64_t num_chunks = plan->chunk2steps.size();
+  FOR_RANGE(int64_t, chunk, 0, num_chunks) {
+    thread_pool->AddWork([run, chunk]() { LaunchChunk(run, chunk); });
+  }
+}
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
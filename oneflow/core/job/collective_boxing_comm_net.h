@@ -0,0 +1,122 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_JOB_COLLECTIVE_BOXING_COMM_NET_H_
+#define ONEFLOW_CORE_JOB_COLLECTIVE_BOXING_COMM_NET_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/graph/boxing/collective_boxing.pb.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+// Moves the messages of the collective boxing on host memory between the ranks of a device set,
+// e.g. through Global<Transport>. A message is identified by its token, and the callbacks may be
+// called on any thread, even before Send/Receive returns
+class CommNetCollectiveTransport {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveTransport);
+  CommNetCollectiveTransport() = default;
+  virtual ~CommNetCollectiveTransport() = default;
+
+  virtual void Send(uint64_t token, int64_t dst_rank, const void* ptr, std::size_t size,
+                    std::function<void()> callback) = 0;
+  virtual void Receive(uint64_t token, int64_t src_rank, void* ptr, std::size_t size,
+                       std::function<void()> callback) = 0;
+};
+
+enum CommNetBufferType {
+  kCommNetSendBuffer = 0,
+  kCommNetRecvBuffer = 1,
+  kCommNetScratchBuffer = 2,
+};
+
+struct CommNetBufferSlice {
+  CommNetBufferType buffer;
+  int64_t offset;
+  int64_t size;
+};
+
+// A step of a chunk of the data of a rank, which is done when its send, its receive and the
+// reduction of the received data, and its copy are all done. The steps of a chunk run one after
+// another, and the chunks run at the same time, so that a chunk is reduced while the others are on
+// the wire
+struct CommNetCollectiveStep {
+  // -1 if there is nothing to send
+  int64_t send_rank = -1;
+  CommNetBufferSlice send;
+  // the number of the messages sent to send_rank by the previous steps of the chunk
+  int64_t send_seq = 0;
+  // -1 if there is nothing to receive
+  int64_t recv_rank = -1;
+  CommNetBufferSlice recv;
+  int64_t recv_seq = 0;
+  // reduce_dst = reduce_src + recv once the data is received
+  bool reduce = false;
+  CommNetBufferSlice reduce_src;
+  CommNetBufferSlice reduce_dst;
+  // skipped if copy_src and copy_dst are the same memory
+  bool copy = false;
+  CommNetBufferSlice copy_src;
+  CommNetBufferSlice copy_dst;
+};
+
+// What a rank does to run a request, which is the same every time the request runs
+struct CommNetCollectivePlan {
+  int64_t rank;
+  DataType data_type;
+  std::vector<std::vector<CommNetCollectiveStep>> chunk2steps;
+  int64_t scratch_size;
+};
+
+struct CommNetCollectiveOptions {
+  // the max bytes of a chunk of the data sent in a step
+  int64_t chunk_size;
+  // all-reduces of up to this many bytes on a power-of-two number of ranks use recursive
+  // halving-doubling, which takes log(num_ranks) steps instead of 2 * (num_ranks - 1)
+  int64_t recursive_halving_doubling_threshold;
+};
+
+// All-reduce, reduce-scatter and all-gather go around a ring of the ranks, which is bandwidth
+// optimal, except the small all-reduces which use recursive halving-doubling. Broadcast and reduce
+// go along a chain of the ranks starting or ending at the root. Every message is cut into chunks
+// that are pipelined
+CommNetCollectivePlan MakeCommNetCollectivePlan(const OpDesc& op_desc, int64_t rank,
+                                                const CommNetCollectiveOptions& options);
+
+// The messages of the requests running at the same time must have different tokens, so a token
+// holds the index of the request in the collective boxing plan and how many times it has run
+uint64_t GetCommNetCollectiveToken(int64_t request_index, int64_t run_id, int64_t src_rank,
+                                   int64_t dst_rank, int64_t chunk, int64_t seq);
+
+// Runs plan with a scratch buffer of plan->scratch_size bytes, and calls callback when the rank is
+// done. Never blocks: the steps go on in the callbacks of transport, and the reductions and the
+// copies run on thread_pool
+void RunCommNetCollectivePlan(const CommNetCollectivePlan* plan, int64_t request_index,
+                              int64_t run_id, const void* send_buff, void* recv_buff,
+                              char* scratch, CommNetCollectiveTransport* transport,
+                              ThreadPool* thread_pool, std::function<void()> callback);
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_JOB_COLLECTIVE_BOXING_COMM_NET_H_
@@ -0,0 +1,223 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job/collective_boxing_comm_net.h"
+
+namespace oneflow {
+
+namespace boxing {
+
+namespace collective {
+
+namespace test {
+
+namespace {
+
+// Delivers the messages of the ranks in the same process by matching the sends and the receives
+// of a token
+class TestTransport final : public CommNetCollectiveTransport {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestTransport);
+  TestTransport() = default;
+  ~TestTransport() override = default;
+
+  void Send(uint64_t token, int64_t dst_rank, const void* ptr, std::size_t size,
+            std::function<void()> callback) override {
+    Match(token, Message{true, const_cast<void*>(ptr), size, std::move(callback)});
+  }
+  void Receive(uint64_t token, int64_t src_rank, void* ptr, std::size_t size,
+               std::function<void()> callback) override {
+    Match(token, Message{false, ptr, size, std::move(callback)});
+  }
+
+  int64_t num_pending() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return token2message_.size();
+  }
+
+ private:
+  struct Message {
+    bool is_send;
+    void* ptr;
+    std::size_t size;
+    std::function<void()> callback;
+  };
+
+  void Match(uint64_t token, Message message) {
+    Message matched;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto it = token2message_.find(token);
+      if (it == token2message_.end()) {
+        token2message_.emplace(token, std::move(message));
+        return;
+      }
+      matched = std::move(it->second);
+      token2message_.erase(it);
+    }
+    CHECK_NE(matched.is_send, message.is_send);
+    const Message& send = message.is_send ? message : matched;
+    const Message& recv = message.is_send ? matched : message;
+    CHECK_EQ(send.size, recv.size);
+    std::memcpy(recv.ptr, send.ptr, send.size);
+    message.callback();
+    matched.callback();
+  }
+
+  std::mutex mutex_;
+  HashMap<uint64_t, Message> token2message_;
+};
+
+OpDesc MakeOpDesc(OpType op_type, int64_t elem_cnt, int64_t num_ranks, int64_t root) {
+  OpDesc op_desc;
+  op_desc.set_name("test");
+  op_desc.set_op_type(op_type);
+  if (op_type == OpType::kOpTypeAllReduce || op_type == OpType::kOpTypeReduceScatter
+      || op_type == OpType::kOpTypeReduce) {
+    op_desc.set_reduce_method(ReduceMethod::kReduceMethodSum);
+  }
+  if (root != -1) { op_desc.set_root(root); }
+  op_desc.set_data_type(DataType::kInt64);
+  op_desc.mutable_shape()->add_dim(elem_cnt);
+  op_desc.set_num_ranks(num_ranks);
+  op_desc.set_backend(Backend::kBackendCommNet);
+  return op_desc;
+}
+
+// Runs op_type on every number of ranks and checks the outputs of the ranks against
+// GetExpectedOutput(inputs, rank), which is empty for the ranks without output
+void TestCollective(
+    OpType op_type, int64_t root,
+    const std::function<std::vector<int64_t>(const std::vector<std::vector<int64_t>>&, int64_t)>&
+        GetExpectedOutput) {
+  ThreadPool thread_pool(4);
+  TestTransport transport;
+  std::mt19937 gen(0);
+  for (int64_t num_ranks : {1, 2, 3, 4, 5, 8}) {
+    for (int64_t elem_cnt : {0, 7, 120, 4200}) {
+      if ((op_type == OpType::kOpTypeReduceScatter || op_type == OpType::kOpTypeAllGather)
+          && elem_cnt % num_ranks != 0) {
+        continue;
+      }
+      for (int64_t chunk_size : {64, 1 << 20}) {
+        for (int64_t threshold : {0, 1 << 20}) {
+          const int64_t rank_root = root == -1 ? -1 : root % num_ranks;
+          const OpDesc op_desc = MakeOpDesc(op_type, elem_cnt, num_ranks, rank_root);
+          const CommNetCollectiveOptions options{chunk_size, threshold};
+          std::vector<std::vector<int64_t>> inputs(num_ranks);
+          std::vector<std::vector<int64_t>> outputs(num_ranks);
+          std::vector<std::vector<int64_t>> expected_outputs(num_ranks);
+          const int64_t in_elem_cnt =
+              op_type == OpType::kOpTypeAllGather ? elem_cnt / num_ranks : elem_cnt;
+          for (auto& input : inputs) {
+            input.resize(in_elem_cnt);
+            for (int64_t& x : input) { x = gen() % 1000; }
+          }
+          std::vector<CommNetCollectivePlan> plans;
+          std::vector<std::vector<char>> scratches(num_ranks);
+          for (int64_t rank = 0; rank < num_ranks; ++rank) {
+            plans.push_back(MakeCommNetCollectivePlan(op_desc, rank, options));
+            scratches.at(rank).resize(plans.back().scratch_size);
+            expected_outputs.at(rank) = GetExpectedOutput(inputs, rank);
+            outputs.at(rank).assign(expected_outputs.at(rank).size(), -1);
+          }
+          // the second run checks that the tokens of the runs of a request do not collide
+          for (int64_t run_id = 0; run_id < 2; ++run_id) {
+            std::atomic<int64_t> num_done(0);
+            for (int64_t rank = 0; rank < num_ranks; ++rank) {
+              const void* send_buff = inputs.at(rank).data();
+              if (op_type == OpType::kOpTypeBroadcast && rank != rank_root) {
+                send_buff = nullptr;
+              }
+              void* recv_buff = outputs.at(rank).data();
+              if (op_type == OpType::kOpTypeReduce && rank != rank_root) { recv_buff = nullptr; }
+              RunCommNetCollectivePlan(&plans.at(rank), 0, run_id, send_buff, recv_buff,
+                                       scratches.at(rank).data(), &transport, &thread_pool,
+                                       [&num_done]() { num_done += 1; });
+            }
+            while (num_done < num_ranks) { std::this_thread::yield(); }
+            ASSERT_EQ(transport.num_pending(), 0);
+            for (int64_t rank = 0; rank < num_ranks; ++rank) {
+              ASSERT_EQ(outputs.at(rank), expected_outputs.at(rank));
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+std::vector<int64_t> Sum(const std::vector<std::vector<int64_t>>& inputs) {
+  std::vector<int64_t> sum(inputs.front().size(), 0);
+  for (const auto& input : inputs) {
+    for (size_t i = 0; i < input.size(); ++i) { sum.at(i) += input.at(i); }
+  }
+  return sum;
+}
+
+}  // namespace
+
+TEST(CommNetCollective, all_reduce) {
+  TestCollective(OpType::kOpTypeAllReduce, -1,
+                 [](const std::vector<std::vector<int64_t>>& inputs, int64_t rank) {
+                   return Sum(inputs);
+                 });
+}
+
+TEST(CommNetCollective, reduce_scatter) {
+  TestCollective(OpType::kOpTypeReduceScatter, -1,
+                 [](const std::vector<std::vector<int64_t>>& inputs, int64_t rank) {
+                   const std::vector<int64_t> sum = Sum(inputs);
+                   const int64_t part_size = sum.size() / inputs.size();
+                   return std::vector<int64_t>(sum.begin() + rank * part_size,
+                                               sum.begin() + (rank + 1) * part_size);
+                 });
+}
+
+TEST(CommNetCollective, all_gather) {
+  TestCollective(OpType::kOpTypeAllGather, -1,
+                 [](const std::vector<std::vector<int64_t>>& inputs, int64_t rank) {
+                   std::vector<int64_t> gathered;
+                   for (const auto& input : inputs) {
+                     gathered.insert(gathered.end(), input.begin(), input.end());
+                   }
+                   return gathered;
+                 });
+}
+
+TEST(CommNetCollective, broadcast) {
+  TestCollective(OpType::kOpTypeBroadcast, 1,
+                 [](const std::vector<std::vector<int64_t>>& inputs, int64_t rank) {
+                   return inputs.at(1 % inputs.size());
+                 });
+}
+
+TEST(CommNetCollective, reduce) {
+  TestCollective(OpType::kOpTypeReduce, 2,
+                 [](const std::vector<std::vector<int64_t>>& inputs, int64_t rank) {
+                   if (rank != 2 % static_cast<int64_t>(inputs.size())) {
+                     return std::vector<int64_t>();
+                   }
+                   return Sum(inputs);
+                 });
+}
+
+}  // namespace test
+
+}  // namespace collective
+
+}  // namespace boxing
+
+}  // namespace oneflow
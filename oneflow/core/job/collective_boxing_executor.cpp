@@ -23,6 +23,8 @@ limitations under the License.
 #include "oneflow/core/kernel/batch_memcpy_kernel_util.h"
 #include "oneflow/core/job/global_for.h"
 #include "oneflow/core/thread/thread_pool.h"
+#include "oneflow/core/job/collective_boxing_comm_net.h"
+#include "oneflow/core/transport/transport.h"
 #ifdef WITH_CUDA
 #include <nccl.h>
 #endif
@@ -75,8 +77,6 @@ int64_t GetAlignedRequestSize(const RequestDesc* request) {
 
 }  // namespace
 
-#ifdef WITH_CUDA
-
 void CollectiveBoxingExecutorBackend::GroupRequests(
     const std::vector<const RequestDesc*>& requests,
     std::vector<std::vector<const RequestDesc*>>* groups) {
@@ -85,6 +85,8 @@ void CollectiveBoxingExecutorBackend::GroupRequests(
   }
 }
 
+#ifdef WITH_CUDA
+
 class NcclCollectiveBoxingExecutorBackend : public CollectiveBoxingExecutorBackend {
  public:
   OF_DISALLOW_COPY_AND_MOVE(NcclCollectiveBoxingExecutorBackend)
@@ -508,6 +510,152 @@ void NcclCollectiveBoxingExecutorBackend::Init(const CollectiveBoxingPlan& colle
 
 #endif  // WITH_CUDA
 
+class CommNetCollectiveBoxingExecutorBackend : public CollectiveBoxingExecutorBackend {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CommNetCollectiveBoxingExecutorBackend)
+  CommNetCollectiveBoxingExecutorBackend();
+  ~CommNetCollectiveBoxingExecutorBackend() override = default;
+
+ private:
+  void Init(const CollectiveBoxingPlan& collective_boxing_plan) override;
+  void ExecuteGroup(const std::vector<const RequestDesc*>& group,
+                    const std::vector<std::map<int64_t, RuntimeRequestInfo>>& ranks) override;
+
+  // Sends the messages between the ranks of a device set through Global<Transport>, which also
+  // copies the ones between the ranks on the same machine
+  class DeviceSetTransport final : public CommNetCollectiveTransport {
+   public:
+    OF_DISALLOW_COPY_AND_MOVE(DeviceSetTransport);
+    explicit DeviceSetTransport(const DeviceSet& device_set) : device_set_(device_set) {}
+    ~DeviceSetTransport() override = default;
+
+    void Send(uint64_t token, int64_t dst_rank, const void* ptr, std::size_t size,
+              std::function<void()> callback) override {
+      Global<Transport>::Get()->Send(token, device_set_.device(dst_rank).machine_id(), ptr, size,
+                                     std::move(callback));
+    }
+    void Receive(uint64_t token, int64_t src_rank, void* ptr, std::size_t size,
+                 std::function<void()> callback) override {
+      Global<Transport>::Get()->Receive(token, device_set_.device(src_rank).machine_id(), ptr,
+                                        size, std::move(callback));
+    }
+
+   private:
+    const DeviceSet device_set_;
+  };
+
+  struct RequestCtx {
+    RequestCtx(int64_t p_request_index, const DeviceSet& device_set)
+        : request_index(p_request_index), run_id(0), transport(device_set) {}
+
+    // a scratch buffer is taken by a run of the rank until it is done, and reused by the next runs
+    char* AcquireScratch(int64_t rank);
+    void ReleaseScratch(int64_t rank, char* scratch);
+
+    const int64_t request_index;
+    // only touched by ExecuteGroup, which the executor never calls concurrently
+    int64_t run_id;
+    DeviceSetTransport transport;
+    std::map<int64_t, CommNetCollectivePlan> rank2plan;
+    std::mutex scratch_mutex;
+    std::map<int64_t, std::vector<std::unique_ptr<char[]>>> rank2free_scratches;
+  };
+
+  const CollectiveBoxingConf collective_boxing_conf_;
+  std::unique_ptr<ThreadPool> thread_pool_;
+  HashMap<std::string, std::unique_ptr<RequestCtx>> name2request_ctx_;
+};
+
+CommNetCollectiveBoxingExecutorBackend::CommNetCollectiveBoxingExecutorBackend()
+    : collective_boxing_conf_(Global<ResourceDesc, ForSession>::Get()->collective_boxing_conf()) {
+  CHECK_GT(collective_boxing_conf_.comm_net_num_threads(), 0);
+  thread_pool_.reset(new ThreadPool(collective_boxing_conf_.comm_net_num_threads()));
+}
+
+void CommNetCollectiveBoxingExecutorBackend::Init(
+    const CollectiveBoxingPlan& collective_boxing_plan) {
+  CHECK_GT(collective_boxing_conf_.comm_net_chunk_size_kb(), 0);
+  CHECK_GE(collective_boxing_conf_.comm_net_recursive_halving_doubling_threshold_kb(), 0);
+  CommNetCollectiveOptions options{};
+  options.chunk_size = collective_boxing_conf_.comm_net_chunk_size_kb() * 1024;
+  options.recursive_halving_doubling_threshold =
+      collective_boxing_conf_.comm_net_recursive_halving_doubling_threshold_kb() * 1024;
+  // the requests are numbered in the same way on all the machines, for the tokens of their messages
+  std::vector<int64_t> job_ids;
+  for (const auto& job_id7request_set : collective_boxing_plan.job_id2request_set()) {
+    job_ids.push_back(job_id7request_set.first);
+  }
+  std::sort(job_ids.begin(), job_ids.end());
+  int64_t request_index = 0;
+  for (const int64_t job_id : job_ids) {
+    std::vector<const RequestDesc*> requests;
+    for (const RequestDesc& request :
+         collective_boxing_plan.job_id2request_set().at(job_id).request()) {
+      if (request.op_desc().backend() == Backend::kBackendCommNet) { requests.push_back(&request); }
+    }
+    SortRequestsByOrder(&requests);
+    for (const RequestDesc* request : requests) {
+      std::unique_ptr<RequestCtx> request_ctx(new RequestCtx(request_index, request->device_set()));
+      request_index += 1;
+      const DeviceSet& device_set = request->device_set();
+      for (int64_t rank = 0; rank < device_set.device_size(); ++rank) {
+        if (!IsDeviceOnThisMachine(device_set.device(rank))) { continue; }
+        request_ctx->rank2plan.emplace(
+            rank, MakeCommNetCollectivePlan(request->op_desc(), rank, options));
+      }
+      if (request_ctx->rank2plan.empty()) { continue; }
+      CHECK(name2request_ctx_.emplace(request->op_desc().name(), std::move(request_ctx)).second);
+    }
+  }
+}
+
+void CommNetCollectiveBoxingExecutorBackend::ExecuteGroup(
+    const std::vector<const RequestDesc*>& group,
+    const std::vector<std::map<int64_t, RuntimeRequestInfo>>& ranks) {
+  CHECK_EQ(group.size(), ranks.size());
+  CHECK_NOTNULL(Global<Transport>::Get());
+  for (int64_t i = 0; i < group.size(); ++i) {
+    RequestCtx* request_ctx = name2request_ctx_.at(group.at(i)->op_desc().name()).get();
+    const int64_t run_id = request_ctx->run_id;
+    request_ctx->run_id += 1;
+    for (const auto& rank7request_info : ranks.at(i)) {
+      const int64_t rank = rank7request_info.first;
+      const RuntimeRequestInfo& request_info = rank7request_info.second;
+      char* scratch = request_ctx->AcquireScratch(rank);
+      auto callback = request_info.callback;
+      RunCommNetCollectivePlan(&request_ctx->rank2plan.at(rank), request_ctx->request_index,
+                               run_id, request_info.send_buff, request_info.recv_buff, scratch,
+                               &request_ctx->transport, thread_pool_.get(),
+                               [request_ctx, rank, scratch, callback]() {
+                                 request_ctx->ReleaseScratch(rank, scratch);
+                                 (*callback)(Maybe<void>::Ok());
+                               });
+    }
+  }
+}
+
+char* CommNetCollectiveBoxingExecutorBackend::RequestCtx::AcquireScratch(int64_t rank) {
+  const int64_t scratch_size = rank2plan.at(rank).scratch_size;
+  if (scratch_size == 0) { return nullptr; }
+  {
+    std::unique_lock<std::mutex> lock(scratch_mutex);
+    auto& free_scratches = rank2free_scratches[rank];
+    if (!free_scratches.empty()) {
+      char* scratch = free_scratches.back().release();
+      free_scratches.pop_back();
+      return scratch;
+    }
+  }
+  return new char[scratch_size];
+}
+
+void CommNetCollectiveBoxingExecutorBackend::RequestCtx::ReleaseScratch(int64_t rank,
+                                                                        char* scratch) {
+  if (scratch == nullptr) { return; }
+  std::unique_lock<std::mutex> lock(scratch_mutex);
+  rank2free_scratches[rank].emplace_back(scratch);
+}
+
 CollectiveBoxingExecutor::CollectiveBoxingExecutor(const Plan& plan)
     : collective_boxing_plan_(plan.collective_boxing_plan()) {
   HashMap<int32_t, int64_t> backend2count;
@@ -525,6 +673,13 @@ CollectiveBoxingExecutor::CollectiveBoxingExecutor(const Plan& plan)
     it->second->Init(collective_boxing_plan_);
   }
 #endif
+  if (backend2count.count(static_cast<int32_t>(Backend::kBackendCommNet)) != 0) {
+    auto it = backends_
+                  .emplace(Backend::kBackendCommNet,
+                           std::make_unique<CommNetCollectiveBoxingExecutorBackend>())
+                  .first;
+    it->second->Init(collective_boxing_plan_);
+  }
   Init();
   DumpSummary();
 }
@@ -29,6 +29,7 @@ enum MemAllocAlgoType {
   kMemSizeFirstAlgo = 0,
   kMutualExclusionFirstAlgo = 1,
   kTimeLineAlgo = 2,
+  kBestFitIntervalPackingAlgo = 3,
 };
 
 }  // namespace oneflow
@@ -48,11 +49,6 @@ namespace oneflow {
 
 namespace {
 
-struct MemBlockResultInfo {
-  size_t mem_block_size;
-  HashMap<RegstDescProto*, int64_t> regst_desc2offset;
-};
-
 int64_t GenDeviceUniqueId(int64_t machine_id, int64_t device_id) {
   return (machine_id << 32) | device_id;
 }
@@ -184,6 +180,106 @@ bool IsTaskConnectedL2R(const TaskProto* src, const TaskProto* dst) {
   return false;
 }
 
+bool IsReusableHostRegst(const RegstDescProto& regst_desc) {
+  const MemoryCase& mem_case = regst_desc.mem_case();
+  return mem_case.has_host_mem() && !mem_case.host_mem().has_cuda_pinned_mem()
+         && !mem_case.host_mem().used_by_network() && regst_desc.enable_reuse_mem()
+         && regst_desc.register_num() == 1 && regst_desc.mem_block_id() == -1
+         && regst_desc.mem_block_offset() == -1
+         && regst_desc.regst_desc_type().has_data_regst_desc();
+}
+
+bool IsCpuUserOpTask(const Plan* plan, const TaskProto* task, const std::string& op_type_name) {
+  if (task->task_type() != TaskType::kNormalForward
+      || task->exec_sequence().exec_node_size() != 1) {
+    return false;
+  }
+  if (Global<IDMgr>::Get()->GetDeviceTypeFromThrdId(task->thrd_id()) != DeviceType::kCPU) {
+    return false;
+  }
+  const KernelConf& kernel_conf = task->exec_sequence().exec_node(0).kernel_conf();
+  const OperatorConf& op_conf =
+      PlanUtil::GetOpAttribute(plan, task->job_id(), kernel_conf).op_conf();
+  return op_conf.has_user_conf() && op_conf.user_conf().op_type_name() == op_type_name;
+}
+
+// The cpu regsts are not reused, as the cpu tasks are not merged in chains. On cpu,
+// HostActivationOffloadPass spills an activation to a file by spill_to_file and reads it back by
+// load_spilled_file, which only saves memory if the spilled regst and the loaded one are reused.
+// So they are put in a mem chain of each rank with their producers and consumers, in which a
+// spilled regst is freed after its forward consumers and a loaded one is allocated in the backward
+// pass. The tasks of the chain are ordered by ctrl edges as the tasks of a gpu chain are
+void InitHostOffloadMemoryChains(Plan* plan, HashMap<int64_t, MemoryChain>* rank2mem_chain) {
+  HashMap<int64_t, TaskProto*> task_id2proto;
+  HashMap<int64_t, std::pair<TaskProto*, RegstDescProto*>> regst_desc_id2producer7regst;
+  for (int64_t i = 0; i < plan->task_size(); ++i) {
+    TaskProto* task = plan->mutable_task(i);
+    CHECK(task_id2proto.emplace(task->task_id(), task).second);
+    for (auto& pair : *task->mutable_produced_regst_desc()) {
+      CHECK(regst_desc_id2producer7regst
+                .emplace(pair.second.regst_desc_id(), std::make_pair(task, &pair.second))
+                .second);
+    }
+  }
+  HashMap<int64_t, HashSet<TaskProto*>> rank2tasks;
+  auto TryAddRegst = [&](TaskProto* producer, RegstDescProto* regst_desc) {
+    if (!IsReusableHostRegst(*regst_desc)) { return; }
+    if (producer->task_type() != TaskType::kNormalForward) { return; }
+    const int64_t rank =
+        GenDeviceUniqueId(producer->machine_id(), producer->parallel_ctx().parallel_id());
+    MemoryChain* mem_chain = &(*rank2mem_chain)[rank];
+    const Shape regst_time_shape(regst_desc->regst_desc_type().data_regst_desc().time_shape());
+    if (mem_chain->time_shape.elem_cnt() == 0) {
+      mem_chain->time_shape = regst_time_shape;
+    } else if (mem_chain->time_shape != regst_time_shape) {
+      return;
+    }
+    if (!mem_chain->mem_reused_regsts.insert(regst_desc).second) { return; }
+    mem_chain->total_mem_reused_size += RtRegstDesc(*regst_desc).TotalMainByteSize4AllRegst();
+    rank2tasks[rank].insert(producer);
+    // the consumers of other ranks or of other task types free the regst at the end of the chain
+    for (int64_t consumer_task_id : regst_desc->consumer_task_id()) {
+      TaskProto* consumer = task_id2proto.at(consumer_task_id);
+      if (consumer->task_type() == TaskType::kNormalForward
+          && consumer->machine_id() == producer->machine_id()
+          && consumer->parallel_ctx().parallel_id() == producer->parallel_ctx().parallel_id()) {
+        rank2tasks[rank].insert(consumer);
+      }
+    }
+  };
+  for (int64_t i = 0; i < plan->task_size(); ++i) {
+    TaskProto* task = plan->mutable_task(i);
+    if (IsCpuUserOpTask(plan, task, "spill_to_file")) {
+      for (const auto& pair : task->consumed_regst_desc_id()) {
+        for (int64_t regst_desc_id : pair.second.regst_desc_id()) {
+          const auto& producer7regst = regst_desc_id2producer7regst.at(regst_desc_id);
+          TryAddRegst(producer7regst.first, producer7regst.second);
+        }
+      }
+    } else if (IsCpuUserOpTask(plan, task, "load_spilled_file")) {
+      for (auto& pair : *task->mutable_produced_regst_desc()) { TryAddRegst(task, &pair.second); }
+    }
+  }
+  for (auto& pair : *rank2mem_chain) {
+    MemoryChain* mem_chain = &pair.second;
+    const HashSet<TaskProto*>& tasks = rank2tasks.at(pair.first);
+    mem_chain->sorted_tasks.assign(tasks.begin(), tasks.end());
+    std::sort(mem_chain->sorted_tasks.begin(), mem_chain->sorted_tasks.end(),
+              [&](const TaskProto* lhs, const TaskProto* rhs) {
+                int64_t lhs_order_in_graph = lhs->task_set_info().order_in_graph();
+                int64_t rhs_order_in_graph = rhs->task_set_info().order_in_graph();
+                CHECK_NE(lhs_order_in_graph, rhs_order_in_graph);
+                return lhs_order_in_graph < rhs_order_in_graph;
+              });
+    // the order in graph is topological, so that the ctrl edges make no cycle
+    for (int64_t i = 1; i < mem_chain->sorted_tasks.size(); ++i) {
+      TaskProto* src = mem_chain->sorted_tasks.at(i - 1);
+      TaskProto* dst = mem_chain->sorted_tasks.at(i);
+      if (!IsTaskConnectedL2R(src, dst)) { TryConnectWithMemSafeGuardCtrlRegstDesc(src, dst); }
+    }
+  }
+}
+
 void GenMemChainTasksAndRegsts(
     Plan* plan,
     const std::function<bool(const std::string&, const std::string&)>& IsOpNameDataOrCtrlReachable,
@@ -258,6 +354,16 @@ void GenMemChainTasksAndRegsts(
     }
   }
 
+  HashMap<int64_t, MemoryChain> rank2host_mem_chain;
+  InitHostOffloadMemoryChains(plan, &rank2host_mem_chain);
+  for (auto& pair : rank2host_mem_chain) {
+    CHECK((*mem_chain2sorted_tasks).emplace(mem_chain_id, pair.second.sorted_tasks).second);
+    CHECK((*mem_chain2mem_reused_regsts)
+              .emplace(mem_chain_id, pair.second.mem_reused_regsts)
+              .second);
+    ++mem_chain_id;
+  }
+
   CHECK_EQ(mem_chain2sorted_tasks->size(), mem_chain2mem_reused_regsts->size());
 
   // NOTE(chengcheng): add ctrl safe guard for each mem chain
@@ -519,6 +625,8 @@ void MemReusedAlgorithm_AllocateByOrderAndMutualExclusion(
   result->mem_block_size = buffer_size;
 }
 
+}  // namespace
+
 void MemReusedAlgorithm_MemSizeFirstAlgo(
     const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusion_regsts,
     MemBlockResultInfo* result) {
@@ -554,6 +662,8 @@ void MemReusedAlgorithm_MutualExclusionFirstAlgo(
                                                        regst2mutual_exclusion_regsts, result);
 }
 
+namespace {
+
 class BfcAllocator final {
  public:
   BfcAllocator(int64_t size) : buffer_size_(size) {
@@ -661,6 +771,8 @@ void BfcAllocator::FreeRaw(int64_t offset, int64_t size) {
   MergeFreePieceAndCheckValid();
 }
 
+}  // namespace
+
 void MemReusedAlgorithm_TimeLineAlgo(
     const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
     const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline, MemBlockResultInfo* result) {
@@ -688,6 +800,104 @@ void MemReusedAlgorithm_TimeLineAlgo(
   result->mem_block_size = bfc_allocator.buffer_size();
 }
 
+void MemReusedAlgorithm_BestFitIntervalPackingAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline, MemBlockResultInfo* result) {
+  // the regst lives from the task allocating it to the task freeing it, both included
+  struct Interval {
+    RegstDescProto* regst;
+    int64_t size;
+    int64_t alloc_index;
+    int64_t free_index;
+  };
+  std::vector<Interval> intervals;
+  HashMap<RegstDescProto*, int64_t> regst2interval_index;
+  CHECK_EQ(alloc_regsts_timeline.size(), free_regsts_timeline.size());
+  for (int64_t i = 0; i < alloc_regsts_timeline.size(); ++i) {
+    for (RegstDescProto* alloc_regst : alloc_regsts_timeline.at(i)) {
+      CHECK(regst2interval_index.emplace(alloc_regst, intervals.size()).second);
+      intervals.push_back(Interval{
+          alloc_regst, static_cast<int64_t>(RtRegstDesc(*alloc_regst).TotalMainByteSize4AllRegst()),
+          i, -1});
+    }
+    for (RegstDescProto* free_regst : free_regsts_timeline.at(i)) {
+      intervals.at(regst2interval_index.at(free_regst)).free_index = i;
+    }
+  }
+  // the larger and the longer lived regsts are placed first, so that the smaller ones fill the
+  // holes between them
+  std::sort(intervals.begin(), intervals.end(), [](const Interval& lhs, const Interval& rhs) {
+    if (lhs.size != rhs.size) { return lhs.size > rhs.size; }
+    const int64_t lhs_length = lhs.free_index - lhs.alloc_index;
+    const int64_t rhs_length = rhs.free_index - rhs.alloc_index;
+    if (lhs_length != rhs_length) { return lhs_length > rhs_length; }
+    if (lhs.alloc_index != rhs.alloc_index) { return lhs.alloc_index < rhs.alloc_index; }
+    return lhs.regst->regst_desc_id() < rhs.regst->regst_desc_id();
+  });
+  HashMap<RegstDescProto*, int64_t>* regst_desc2offset = &(result->regst_desc2offset);
+  std::vector<const Interval*> placed_intervals;
+  int64_t buffer_size = 1;
+  for (const Interval& interval : intervals) {
+    CHECK_GE(interval.free_index, interval.alloc_index);
+    // the memory taken by the placed regsts living at the same time, with the overlapping and the
+    // adjacent ranges coalesced
+    std::vector<std::pair<int64_t, int64_t>> occupied_ranges;
+    for (const Interval* placed : placed_intervals) {
+      if (placed->alloc_index <= interval.free_index
+          && interval.alloc_index <= placed->free_index) {
+        const int64_t offset = regst_desc2offset->at(placed->regst);
+        occupied_ranges.emplace_back(offset, offset + placed->size);
+      }
+    }
+    std::sort(occupied_ranges.begin(), occupied_ranges.end());
+    std::vector<std::pair<int64_t, int64_t>> coalesced_ranges;
+    for (const auto& range : occupied_ranges) {
+      if (!coalesced_ranges.empty() && range.first <= coalesced_ranges.back().second) {
+        coalesced_ranges.back().second = std::max(coalesced_ranges.back().second, range.second);
+      } else {
+        coalesced_ranges.push_back(range);
+      }
+    }
+    // best fit: the smallest hole holding the regst, or the top of the occupied ranges
+    int64_t offset = coalesced_ranges.empty() ? 0 : coalesced_ranges.back().second;
+    int64_t best_hole_size = -1;
+    int64_t hole_begin = 0;
+    for (const auto& range : coalesced_ranges) {
+      const int64_t hole_size = range.first - hole_begin;
+      if (hole_size >= interval.size && (best_hole_size == -1 || hole_size < best_hole_size)) {
+        best_hole_size = hole_size;
+        offset = hole_begin;
+      }
+      hole_begin = range.second;
+    }
+    CHECK(regst_desc2offset->emplace(interval.regst, offset).second);
+    placed_intervals.push_back(&interval);
+    buffer_size = std::max(buffer_size, offset + interval.size);
+  }
+  result->mem_block_size = buffer_size;
+}
+
+// The max bytes of the regsts living at the same time, which no offset assignment goes below
+int64_t MemReusedLowerBound(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                            const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline) {
+  int64_t live_size = 0;
+  int64_t lower_bound = 0;
+  CHECK_EQ(alloc_regsts_timeline.size(), free_regsts_timeline.size());
+  for (int64_t i = 0; i < alloc_regsts_timeline.size(); ++i) {
+    for (RegstDescProto* alloc_regst : alloc_regsts_timeline.at(i)) {
+      live_size += RtRegstDesc(*alloc_regst).TotalMainByteSize4AllRegst();
+    }
+    lower_bound = std::max(lower_bound, live_size);
+    for (RegstDescProto* free_regst : free_regsts_timeline.at(i)) {
+      live_size -= RtRegstDesc(*free_regst).TotalMainByteSize4AllRegst();
+    }
+  }
+  CHECK_EQ(live_size, 0);
+  return lower_bound;
+}
+
+namespace {
+
 void SelectAlgorithmGenMemBlockOffset4Regsts(
     MemAllocAlgoType algo_id, const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
     const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline,
@@ -705,6 +915,10 @@ void SelectAlgorithmGenMemBlockOffset4Regsts(
     case kTimeLineAlgo:
       MemReusedAlgorithm_TimeLineAlgo(alloc_regsts_timeline, free_regsts_timeline, result);
       break;
+    case kBestFitIntervalPackingAlgo:
+      MemReusedAlgorithm_BestFitIntervalPackingAlgo(alloc_regsts_timeline, free_regsts_timeline,
+                                                    result);
+      break;
     default: UNIMPLEMENTED();
   }
   CHECK_GT(result->mem_block_size, 0);
@@ -718,6 +932,7 @@ int64_t CountMemAllocAlgoNum() {
   if (mem_alloc_algo_conf.use_mem_size_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_mutual_exclusion_first_algo()) { ++ret; }
   if (mem_alloc_algo_conf.use_time_line_algo()) { ++ret; }
+  if (mem_alloc_algo_conf.use_best_fit_interval_packing_algo()) { ++ret; }
   CHECK_GE(ret, 0);
   return ret;
 }
@@ -735,6 +950,9 @@ void InitAlgo2Result(HashMap<MemAllocAlgoType, MemBlockResultInfo>* algo2result)
   if (mem_alloc_algo_conf.use_time_line_algo()) {
     CHECK(algo2result->emplace(kTimeLineAlgo, MemBlockResultInfo()).second);
   }
+  if (mem_alloc_algo_conf.use_best_fit_interval_packing_algo()) {
+    CHECK(algo2result->emplace(kBestFitIntervalPackingAlgo, MemBlockResultInfo()).second);
+  }
 }
 
 }  // namespace
@@ -798,12 +1016,23 @@ void IntraJobMemSharingUtil::InferMemBlockId4MemReusedRegst(
   // step 3: choose best one for each mem chain and set offset for inplace consumer regst
   for (const auto& pair : mem_chain2algo2result) {
     const MemBlockResultInfo* best_result = nullptr;
+    MemAllocAlgoType best_algo_id = kMemSizeFirstAlgo;
     for (const auto& algo_result_pair : pair.second) {
       if (!best_result || algo_result_pair.second.mem_block_size < best_result->mem_block_size) {
         best_result = &algo_result_pair.second;
+        best_algo_id = algo_result_pair.first;
       }
     }
     CHECK(best_result != nullptr);
+    const int64_t lower_bound = MemReusedLowerBound(mem_chain2task2alloc_regsts.at(pair.first),
+                                                    mem_chain2task2free_regsts.at(pair.first));
+    CHECK_GE(best_result->mem_block_size, lower_bound);
+    LOG(INFO) << "job " << GlobalJobDesc().job_name() << " chain "
+              << mem_chain2sorted_tasks.at(pair.first).front()->task_set_info().chain_id()
+              << ": mem_block_size " << best_result->mem_block_size << " by algo "
+              << best_algo_id << ", lower bound " << lower_bound << ", fragmentation gap "
+              << (best_result->mem_block_size - lower_bound) * 100.0 / best_result->mem_block_size
+              << "%";
     int64_t mem_block_id = Global<IDMgr>::Get()->NewMemBlockId();
     CHECK_EQ(mem_chain2mem_reused_regsts.at(pair.first).size(),
              (best_result->regst_desc2offset.size()
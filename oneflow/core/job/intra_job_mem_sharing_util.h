@@ -17,11 +17,35 @@ limitations under the License.
 #define ONEFLOW_CORE_JOB_IN_JOB_MEM_SHARING_UTIL_H_
 
 #include "oneflow/core/job/plan.pb.h"
+#include "oneflow/core/common/util.h"
 #include <functional>
 #include <string>
 
 namespace oneflow {
 
+struct MemBlockResultInfo {
+  size_t mem_block_size;
+  HashMap<RegstDescProto*, int64_t> regst_desc2offset;
+};
+
+// The offset assignment algorithms of a mem chain. The timelines hold the regsts allocated and
+// freed by each task of the chain in order, and a regst is mutually exclusive with the regsts
+// living at the same time.
+void MemReusedAlgorithm_MemSizeFirstAlgo(
+    const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusion_regsts,
+    MemBlockResultInfo* result);
+void MemReusedAlgorithm_MutualExclusionFirstAlgo(
+    const HashMap<RegstDescProto*, std::vector<RegstDescProto*>>& regst2mutual_exclusion_regsts,
+    MemBlockResultInfo* result);
+void MemReusedAlgorithm_TimeLineAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline, MemBlockResultInfo* result);
+void MemReusedAlgorithm_BestFitIntervalPackingAlgo(
+    const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+    const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline, MemBlockResultInfo* result);
+int64_t MemReusedLowerBound(const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline,
+                            const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline);
+
 struct IntraJobMemSharingUtil {
   static void InferMemBlockId4MemReusedRegst(
       Plan* plan, const std::function<bool(const std::string&, const std::string&)>&
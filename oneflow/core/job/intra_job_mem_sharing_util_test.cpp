@@ -0,0 +1,146 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/job/intra_job_mem_sharing_util.h"
+#include "oneflow/core/register/blob_desc.h"
+#include "oneflow/core/register/runtime_register_desc.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+// A mem chain of tasks, each allocating at most one regst. Every regst lives from the task
+// allocating it to the task freeing it, both included.
+class MemChainCase final {
+ public:
+  explicit MemChainCase(int64_t task_num)
+      : alloc_regsts_timeline_(task_num), free_regsts_timeline_(task_num) {}
+
+  void AddRegst(int64_t size, int64_t alloc_index, int64_t free_index) {
+    std::unique_ptr<RegstDescProto> regst(new RegstDescProto());
+    regst->set_regst_desc_id(regsts_.size());
+    regst->set_producer_task_id(alloc_index);
+    regst->set_register_num(1);
+    regst->mutable_mem_case()->mutable_device_cuda_mem()->set_device_id(0);
+    DataRegstDesc* data_regst_desc = regst->mutable_regst_desc_type()->mutable_data_regst_desc();
+    LbiBlobDescPair* pair = data_regst_desc->add_lbi2blob_desc();
+    pair->mutable_lbi()->set_op_name("op" + std::to_string(regsts_.size()));
+    pair->mutable_lbi()->set_blob_name("out");
+    BlobDescProto* blob_desc = pair->mutable_blob_desc();
+    blob_desc->mutable_shape()->add_dim(size / GetSizeOfDataType(DataType::kFloat));
+    blob_desc->set_data_type(DataType::kFloat);
+    blob_desc->set_is_dynamic(false);
+    data_regst_desc->mutable_time_shape()->add_dim(1);
+    alloc_regsts_timeline_.at(alloc_index).insert(regst.get());
+    free_regsts_timeline_.at(free_index).insert(regst.get());
+    regst2lifetime_.emplace(regst.get(), std::make_pair(alloc_index, free_index));
+    regsts_.emplace_back(std::move(regst));
+  }
+
+  bool IsLifetimeOverlapped(RegstDescProto* lhs, RegstDescProto* rhs) const {
+    return regst2lifetime_.at(lhs).first <= regst2lifetime_.at(rhs).second
+           && regst2lifetime_.at(rhs).first <= regst2lifetime_.at(lhs).second;
+  }
+
+  HashMap<RegstDescProto*, std::vector<RegstDescProto*>> GenRegst2MutualExclusionRegsts() const {
+    HashMap<RegstDescProto*, std::vector<RegstDescProto*>> regst2mutual_exclusion_regsts;
+    for (const auto& lhs : regsts_) {
+      auto* mutual_exclusion_regsts = &regst2mutual_exclusion_regsts[lhs.get()];
+      for (const auto& rhs : regsts_) {
+        if (lhs != rhs && IsLifetimeOverlapped(lhs.get(), rhs.get())) {
+          mutual_exclusion_regsts->push_back(rhs.get());
+        }
+      }
+    }
+    return regst2mutual_exclusion_regsts;
+  }
+
+  void CheckResult(const MemBlockResultInfo& result) const {
+    ASSERT_EQ(result.regst_desc2offset.size(), regsts_.size());
+    for (const auto& lhs : regsts_) {
+      const int64_t lhs_begin = result.regst_desc2offset.at(lhs.get());
+      const int64_t lhs_end = lhs_begin + RtRegstDesc(*lhs).TotalMainByteSize4AllRegst();
+      ASSERT_GE(lhs_begin, 0);
+      ASSERT_LE(lhs_end, static_cast<int64_t>(result.mem_block_size));
+      for (const auto& rhs : regsts_) {
+        if (lhs == rhs || !IsLifetimeOverlapped(lhs.get(), rhs.get())) { continue; }
+        const int64_t rhs_begin = result.regst_desc2offset.at(rhs.get());
+        const int64_t rhs_end = rhs_begin + RtRegstDesc(*rhs).TotalMainByteSize4AllRegst();
+        ASSERT_TRUE(lhs_end <= rhs_begin || rhs_end <= lhs_begin);
+      }
+    }
+  }
+
+  const std::vector<HashSet<RegstDescProto*>>& alloc_regsts_timeline() const {
+    return alloc_regsts_timeline_;
+  }
+  const std::vector<HashSet<RegstDescProto*>>& free_regsts_timeline() const {
+    return free_regsts_timeline_;
+  }
+
+ private:
+  std::vector<std::unique_ptr<RegstDescProto>> regsts_;
+  HashMap<RegstDescProto*, std::pair<int64_t, int64_t>> regst2lifetime_;
+  std::vector<HashSet<RegstDescProto*>> alloc_regsts_timeline_;
+  std::vector<HashSet<RegstDescProto*>> free_regsts_timeline_;
+};
+
+}  // namespace
+
+TEST(IntraJobMemSharingUtil, best_fit_interval_packing) {
+  const int64_t unit = BlobDesc::kAlignSize;
+  MemChainCase mem_chain(7);
+  mem_chain.AddRegst(4 * unit, 0, 1);
+  mem_chain.AddRegst(1 * unit, 1, 6);
+  mem_chain.AddRegst(2 * unit, 2, 4);
+  mem_chain.AddRegst(3 * unit, 3, 6);
+  mem_chain.AddRegst(5 * unit, 4, 4);
+  const int64_t lower_bound =
+      MemReusedLowerBound(mem_chain.alloc_regsts_timeline(), mem_chain.free_regsts_timeline());
+  // the regsts living at the task 4
+  ASSERT_EQ(lower_bound, 11 * unit);
+
+  MemBlockResultInfo best_fit_result{};
+  MemReusedAlgorithm_BestFitIntervalPackingAlgo(mem_chain.alloc_regsts_timeline(),
+                                                mem_chain.free_regsts_timeline(),
+                                                &best_fit_result);
+  mem_chain.CheckResult(best_fit_result);
+  const int64_t best_fit_size = best_fit_result.mem_block_size;
+  ASSERT_GE(best_fit_size, lower_bound);
+
+  const auto regst2mutual_exclusion_regsts = mem_chain.GenRegst2MutualExclusionRegsts();
+  MemBlockResultInfo mem_size_first_result{};
+  MemReusedAlgorithm_MemSizeFirstAlgo(regst2mutual_exclusion_regsts, &mem_size_first_result);
+  mem_chain.CheckResult(mem_size_first_result);
+  MemBlockResultInfo mutual_exclusion_first_result{};
+  MemReusedAlgorithm_MutualExclusionFirstAlgo(regst2mutual_exclusion_regsts,
+                                              &mutual_exclusion_first_result);
+  mem_chain.CheckResult(mutual_exclusion_first_result);
+  MemBlockResultInfo time_line_result{};
+  MemReusedAlgorithm_TimeLineAlgo(mem_chain.alloc_regsts_timeline(),
+                                  mem_chain.free_regsts_timeline(), &time_line_result);
+  mem_chain.CheckResult(time_line_result);
+  ASSERT_LE(best_fit_size, static_cast<int64_t>(mem_size_first_result.mem_block_size));
+  ASSERT_LE(best_fit_size, static_cast<int64_t>(mutual_exclusion_first_result.mem_block_size));
+  ASSERT_LE(best_fit_size, static_cast<int64_t>(time_line_result.mem_block_size));
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -55,7 +55,19 @@ class JobDesc final {
   bool IsPredict() const { return job_conf_.has_predict_conf(); }
   bool enable_reuse_mem() const { return job_conf_.enable_reuse_mem(); }
   bool enable_inplace() const { return job_conf_.enable_inplace(); }
+  bool enable_reorder_tasks_for_mem_reuse() const {
+    return job_conf_.enable_reorder_tasks_for_mem_reuse();
+  }
+  int64_t reorder_tasks_for_mem_reuse_lookahead() const {
+    return job_conf_.reorder_tasks_for_mem_reuse_lookahead();
+  }
+  bool enable_host_activation_offload() const {
+    return job_conf_.enable_host_activation_offload();
+  }
   bool enable_auto_mixed_precision() const { return job_conf_.enable_auto_mixed_precision(); }
+  bool enable_cpu_auto_mixed_precision() const {
+    return job_conf_.enable_cpu_auto_mixed_precision();
+  }
   bool do_parallel_cast_before_widening_type_cast() const {
     return job_conf_.do_parallel_cast_before_widening_type_cast();
   };
@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/control/ctrl_client.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/common/buffer_manager.h"
+#include "oneflow/core/common/id_util.h"
 #include "oneflow/core/job/compiler.h"
 #include "oneflow/core/job/job_desc.h"
 #include "oneflow/core/job/job_builder.h"
@@ -246,6 +247,8 @@ void GetDeviceDesc(const TaskProto* task_proto, boxing::collective::DeviceDesc*
   device_desc->set_device_type(Global<IDMgr>::Get()->GetDeviceTypeFromThrdId(thrd_id));
   if (device_desc->device_type() == DeviceType::kGPU) {
     device_desc->set_device_id(Global<IDMgr>::Get()->GetGpuPhyIdFromThrdId(thrd_id));
+  } else if (device_desc->device_type() == DeviceType::kCPU) {
+    device_desc->set_device_id(DeviceId::kCPUDeviceIndex);
   } else {
     UNIMPLEMENTED();
   }
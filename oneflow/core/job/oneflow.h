@@ -32,6 +32,7 @@ class Oneflow final {
   ~Oneflow();
 
   Maybe<void> Init(const oneflow::JobSet& job_set);
+  const Plan& plan() const { return plan_; }
 
  private:
   Plan plan_;
@@ -53,6 +53,7 @@ class ResourceDesc final {
     return resource_.thread_enable_local_message_queue();
   }
   bool enable_thread_local_cache() const { return resource_.enable_thread_local_cache(); }
+  bool enable_lazy_kernel_init() const { return resource_.enable_lazy_kernel_init(); }
   size_t thread_local_cache_max_size() const { return resource_.thread_local_cache_max_size(); }
   int32_t ComputeThreadPoolSize() const;
   bool enable_debug_mode() const;
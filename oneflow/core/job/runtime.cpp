@@ -79,10 +79,16 @@ Runtime::Runtime(const Plan& plan, size_t total_piece_num, bool is_experiment_ph
   }
   RuntimeCtx* runtime_ctx = Global<RuntimeCtx>::Get();
   runtime_ctx->NewCounter("constructing_actor_cnt", this_machine_task_num);
+  const auto construct_start = std::chrono::steady_clock::now();
   HandoutTasks(source_tasks);
   HandoutTasks(other_tasks);
   runtime_ctx->WaitUntilCntEqualZero("constructing_actor_cnt");
-  LOG(INFO) << "Actors on this machine constructed";
+  LOG(INFO) << "Actors on this machine constructed in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - construct_start)
+                   .count()
+            << " ms";
+  runtime_ctx->LogActorStartupTimes();
   OF_SESSION_BARRIER();
   LOG(INFO) << "Actors on every machine constructed";
   if (Global<CommNet>::Get()) { Global<CommNet>::Get()->RegisterMemoryDone(); }
@@ -93,6 +99,10 @@ Runtime::Runtime(const Plan& plan, size_t total_piece_num, bool is_experiment_ph
 
 Runtime::~Runtime() {
   Global<RuntimeCtx>::Get()->WaitUntilCntEqualZero("running_actor_cnt");
+  // with the kernel init deferred, the startup of the actors ends with their first act
+  if (Global<ResourceDesc, ForSession>::Get()->enable_lazy_kernel_init()) {
+    Global<RuntimeCtx>::Get()->LogActorStartupTimes();
+  }
   OF_SESSION_BARRIER();
   DeleteAllGlobal();
 }
@@ -31,6 +31,35 @@ void RuntimeCtx::WaitUntilCntEqualZero(const std::string& name) {
   counters_.at(name)->WaitUntilCntEqualZero();
 }
 
+void RuntimeCtx::AddActorStartupTime(const std::string& phase, TaskType task_type,
+                                     double time_ms) {
+  std::unique_lock<std::mutex> lock(startup_time_mutex_);
+  auto it = phase_and_task_type2startup_time_.find(std::make_pair(phase, task_type));
+  if (it == phase_and_task_type2startup_time_.end()) {
+    StartupTime startup_time;
+    startup_time.actor_num = 0;
+    startup_time.total_ms = 0;
+    startup_time.max_ms = 0;
+    it = phase_and_task_type2startup_time_.emplace(std::make_pair(phase, task_type), startup_time)
+             .first;
+  }
+  it->second.actor_num += 1;
+  it->second.total_ms += time_ms;
+  it->second.max_ms = std::max(it->second.max_ms, time_ms);
+}
+
+void RuntimeCtx::LogActorStartupTimes() const {
+  std::unique_lock<std::mutex> lock(startup_time_mutex_);
+  for (const auto& pair : phase_and_task_type2startup_time_) {
+    const StartupTime& startup_time = pair.second;
+    LOG(INFO) << "actor startup " << pair.first.first << " "
+              << TaskType_Name(static_cast<TaskType>(pair.first.second)) << ": "
+              << startup_time.actor_num << " actors, total " << startup_time.total_ms
+              << " ms, mean " << startup_time.total_ms / startup_time.actor_num << " ms, max "
+              << startup_time.max_ms << " ms";
+  }
+}
+
 RuntimeCtx::RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase) {
   total_piece_num_ = total_piece_num;
   is_experiment_phase_ = is_experiment_phase;
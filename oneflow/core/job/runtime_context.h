@@ -19,6 +19,7 @@ limitations under the License.
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/job/id_manager.h"
 #include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/job/task.pb.h"
 #include "oneflow/core/persistence/persistent_in_stream.h"
 #include "oneflow/core/persistence/persistent_out_stream.h"
 
@@ -40,13 +41,26 @@ class RuntimeCtx final {
   void DecreaseCounter(const std::string& name);
   void WaitUntilCntEqualZero(const std::string& name);
 
+  // The time the actors of this machine take to start up, by phase, e.g. "construct" or
+  // "kernel_init", and by actor type. Thread safe
+  void AddActorStartupTime(const std::string& phase, TaskType task_type, double time_ms);
+  void LogActorStartupTimes() const;
+
  private:
   friend class Global<RuntimeCtx>;
   RuntimeCtx(int64_t total_piece_num, bool is_experiment_phase);
 
+  struct StartupTime {
+    int64_t actor_num;
+    double total_ms;
+    double max_ms;
+  };
+
   int64_t total_piece_num_;
   bool is_experiment_phase_;
   HashMap<std::string, std::unique_ptr<BlockingCounter>> counters_;
+  mutable std::mutex startup_time_mutex_;
+  std::map<std::pair<std::string, int32_t>, StartupTime> phase_and_task_type2startup_time_;
 };
 
 }  // namespace oneflow
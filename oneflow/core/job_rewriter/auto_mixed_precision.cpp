@@ -13,15 +13,15 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
-
-#ifdef WITH_CUDA
-
 #include "oneflow/core/job_rewriter/auto_mixed_precision_lists.h"
 
 #include <algorithm>
 
+#ifdef WITH_CUDA
 #include "oneflow/core/device/cuda_util.h"
+#endif  // WITH_CUDA
 #include "oneflow/core/framework/framework.h"
+#include "oneflow/core/framework/to_string.h"
 #include "oneflow/core/job_rewriter/job_pass.h"
 #include "oneflow/core/job_rewriter/pass_util.h"
 #include "oneflow/core/job/job_desc.h"
@@ -53,10 +53,18 @@ bool FindInNoCastRegisry(const std::string& op_type, const OpArg& op_arg) {
   return false;
 }
 
-std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph) {
+// float16 on gpu and bfloat16 on cpu
+DataType ReducedPrecisionDataType4DeviceType(DeviceType device_type) {
+  if (device_type == DeviceType::kGPU) { return DataType::kFloat16; }
+  CHECK_EQ(device_type, DeviceType::kCPU);
+  return DataType::kBFloat16;
+}
+
+std::function<bool(OpNode*)> MakePredicatorIsAllowedToRunWithHalf(const OpGraph& op_graph,
+                                                                   DeviceType device_type) {
   auto allowed_set = std::make_shared<HashSet<OpNode*>>();
   op_graph.ForEachNode([&](OpNode* node) {
-    if (node->parallel_desc().device_type() != DeviceType::kGPU) { return; }
+    if (node->parallel_desc().device_type() != device_type) { return; }
     if (node->op().output_bns().size() > 0) { INSERT_CHECK(allowed_set->insert(node)); }
   });
   return [allowed_set](OpNode* node) -> bool { return IsKeyFound(*allowed_set, node); };
@@ -86,31 +94,48 @@ void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>&
             << Container2Str<HashSet<OpEdge*>, OpEdge*>(white_set_edges, EdgeName4Edge);
   }
 
-  HashMap<std::string, std::vector<OpEdge*>> edges_group_by_lbn;
+  // the white node of an edge decides the reduced precision data type, so a blob consumed by the
+  // white nodes on both gpu and cpu is cast twice
+  auto WhiteNode4Edge = [f2h](OpEdge* edge) { return f2h ? edge->dst_node() : edge->src_node(); };
+  HashMap<std::pair<std::string, DataType>, std::vector<OpEdge*>> edges_group_by_lbn;
   {
     for (OpEdge* edge : white_set_edges) {
       CHECK_EQ(1, edge->lbis().size());
       std::string lbn = GenLogicalBlobName(edge->lbis().front());
-      edges_group_by_lbn[lbn].push_back(edge);
+      DataType reduced_data_type = ReducedPrecisionDataType4DeviceType(
+          WhiteNode4Edge(edge)->parallel_desc().device_type());
+      edges_group_by_lbn[std::make_pair(lbn, reduced_data_type)].push_back(edge);
     }
   }
 
   HashMap<std::string, OperatorConf> dst_op_name2dst_op_confs;
   for (auto& pair : edges_group_by_lbn) {
-    const std::string& lbn = pair.first;
+    const std::string& lbn = pair.first.first;
+    const DataType reduced_data_type = pair.first.second;
     OpNode* src_node = pair.second.front()->src_node();
 
     const BlobDesc& blob_desc = src_node->LogicalBlobDesc4Lbi(GenLogicalBlobId(lbn));
     if (blob_desc.data_type() != DataType::kFloat) { continue; }
 
-    std::string cast_suffix = f2h ? "-cast_f2h" : "-cast_h2f";
-    DataType cast_data_type = f2h ? DataType::kFloat16 : DataType::kFloat;
+    std::string cast_suffix;
+    if (reduced_data_type == DataType::kFloat16) {
+      cast_suffix = f2h ? "-cast_f2h" : "-cast_h2f";
+    } else {
+      cast_suffix = f2h ? "-cast_f2bf16" : "-cast_bf162f";
+    }
+    DataType cast_data_type = f2h ? reduced_data_type : DataType::kFloat;
+    // there are no bfloat16 cast kernels on gpu, so a blob from gpu is cast on the cpu consumer
+    OpNode* cast_node = src_node;
+    if (reduced_data_type == DataType::kBFloat16
+        && src_node->parallel_desc().device_type() != DeviceType::kCPU) {
+      cast_node = WhiteNode4Edge(pair.second.front());
+    }
     auto cast_op = user_op::UserOpConfWrapperBuilder(ReplaceSlashToDash4Lbn(lbn) + cast_suffix)
                        .Op("cast")
                        .Input("in", lbn)
                        .Output("out")
                        .Attr<DataType>("dtype", cast_data_type)
-                       .ScopeSymbolId(src_node->op().op_conf().scope_symbol_id())
+                       .ScopeSymbolId(cast_node->op().op_conf().scope_symbol_id())
                        .Build();
 
     bool cast_is_consumed = false;
@@ -141,7 +166,7 @@ void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>&
     }
 
     if (cast_is_consumed) {
-      job_builder->AddOps(src_node->parallel_desc().parallel_conf(),
+      job_builder->AddOps(cast_node->parallel_desc().parallel_conf(),
                           std::vector<OperatorConf>{cast_op.op_conf()});
       LOG(INFO) << "Insert CastOp: " << cast_op.op_name() << " between " << lbn;
     }
@@ -153,85 +178,120 @@ void InsertCastOpImpl(bool f2h, const OpGraph& op_graph, const HashSet<OpNode*>&
   job_builder->MutOpsOnlyOnce(dst_op_confs);
 }
 
+struct AMPLists final {
+  const AMPList& white_list;
+  const AMPList& black_list;
+  const AMPList& gray_list;
+  const AMPList& clear_list;
+};
+
 class AutoMixedPrecision final : public JobPass {
  public:
   OF_DISALLOW_COPY_AND_MOVE(AutoMixedPrecision);
   AutoMixedPrecision()
-      : white_list_(AutoMixedPrecisionLists::WhiteList()),
-        black_list_(AutoMixedPrecisionLists::BlackList()),
-        gray_list_(AutoMixedPrecisionLists::GrayList()),
-        clear_list_(AutoMixedPrecisionLists::ClearList()) {}
+      : gpu_lists_{AutoMixedPrecisionLists::WhiteList(), AutoMixedPrecisionLists::BlackList(),
+                   AutoMixedPrecisionLists::GrayList(), AutoMixedPrecisionLists::ClearList()},
+        cpu_lists_{AutoMixedPrecisionLists::CpuWhiteList(), AutoMixedPrecisionLists::CpuBlackList(),
+                   AutoMixedPrecisionLists::CpuGrayList(),
+                   AutoMixedPrecisionLists::CpuClearList()} {}
   ~AutoMixedPrecision() = default;
 
   bool IsEnabled(const JobPassCtx& ctx) const {
-    return ctx.job_desc().enable_auto_mixed_precision();
+    return ctx.job_desc().enable_auto_mixed_precision()
+           || ctx.job_desc().enable_cpu_auto_mixed_precision();
   }
 
-  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+  Maybe<void> Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                    JobBuilder* job_builder) const;
 
   Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
     if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
     const OpGraph op_graph(*job);
     JobBuilder job_builder(job);
-    return Apply(op_graph, &job_builder);
+    return Apply(op_graph, ctx->job_desc(), &job_builder);
   }
 
  private:
-  void FillBlackSet(const OpGraph& op_graph, HashSet<OpNode*>* black_set) const;
-  void FillWhiteSet(const OpGraph& op_graph, std::function<bool(OpNode*)> IsAllowedToRunWithHalf,
+  void FillWhiteSetOfDevice(const OpGraph& op_graph, DeviceType device_type,
+                            const AMPLists& lists, HashSet<OpNode*>* white_set) const;
+  void FillBlackSet(const OpGraph& op_graph, const AMPLists& lists,
+                    HashSet<OpNode*>* black_set) const;
+  void FillWhiteSet(const OpGraph& op_graph, const AMPLists& lists,
+                    std::function<bool(OpNode*)> IsAllowedToRunWithHalf,
                     const HashSet<OpNode*>& black_set, HashSet<OpNode*>* white_set) const;
-  void PropagateWhiteThroughClearNodes(const OpGraph& op_graph,
+  void PropagateWhiteThroughClearNodes(const OpGraph& op_graph, const AMPLists& lists,
                                        std::function<bool(OpNode*)> IsAllowedToRunWithHalf,
                                        const HashSet<OpNode*>& black_set,
                                        HashSet<OpNode*>* white_set) const;
   void InsertCastOp(const OpGraph& op_graph, const HashSet<OpNode*>& white_set,
                     JobBuilder* job_builder) const;
 
-  const AMPList& white_list_;
-  const AMPList& black_list_;
-  const AMPList& gray_list_;
-  const AMPList& clear_list_;
+  const AMPLists gpu_lists_;
+  const AMPLists cpu_lists_;
 };
 
-Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, JobBuilder* job_builder) const {
-  CHECK_GE(CUDA_VERSION, 10000);
+Maybe<void> AutoMixedPrecision::Apply(const OpGraph& op_graph, const JobDesc& job_desc,
+                                      JobBuilder* job_builder) const {
   CHECK(GlobalJobDesc().DefaultDataType() == DataType::kFloat);
 
-  VerifyAMPList(white_list_);
-  VerifyAMPList(black_list_);
-  VerifyAMPList(gray_list_);
-  VerifyAMPList(clear_list_);
+  // the white sets of the devices are disjoint, as a node only runs with half on its own device
+  HashSet<OpNode*> white_set;
+  if (job_desc.enable_auto_mixed_precision()) {
+#ifdef WITH_CUDA
+    CHECK_GE(CUDA_VERSION, 10000);
+    FillWhiteSetOfDevice(op_graph, DeviceType::kGPU, gpu_lists_, &white_set);
+#else
+    LOG(WARNING) << "enable_auto_mixed_precision is ignored when oneflow is built without cuda";
+#endif  // WITH_CUDA
+  }
+  if (job_desc.enable_cpu_auto_mixed_precision()) {
+    FillWhiteSetOfDevice(op_graph, DeviceType::kCPU, cpu_lists_, &white_set);
+  }
+
+  InsertCastOp(op_graph, white_set, job_builder);
+  return Maybe<void>::Ok();
+}
+
+void AutoMixedPrecision::FillWhiteSetOfDevice(const OpGraph& op_graph, DeviceType device_type,
+                                              const AMPLists& lists,
+                                              HashSet<OpNode*>* white_set) const {
+  VerifyAMPList(lists.white_list);
+  VerifyAMPList(lists.black_list);
+  VerifyAMPList(lists.gray_list);
+  VerifyAMPList(lists.clear_list);
 
   std::function<std::string(OpNode* const&)> OpName4Node = [](OpNode* const& node) {
     return node->op().op_name();
   };
+  const std::string device_tag = *CHECK_JUST(DeviceTag4DeviceType(device_type));
   HashSet<OpNode*> black_set;
-  HashSet<OpNode*> white_set;
+  HashSet<OpNode*> device_white_set;
 
-  FillBlackSet(op_graph, &black_set);
-  VLOG(1) << "BlackSet include: "
+  FillBlackSet(op_graph, lists, &black_set);
+  VLOG(1) << "BlackSet of " << device_tag << " include: "
           << Container2Str<HashSet<OpNode*>, OpNode*>(black_set, OpName4Node);
 
-  auto IsAllowedToRunWithHalf = MakePredicatorIsAllowedToRunWithHalf(op_graph);
-  FillWhiteSet(op_graph, IsAllowedToRunWithHalf, black_set, &white_set);
-  VLOG(2) << "WhiteSet Before Propagate include: "
-          << Container2Str<HashSet<OpNode*>, OpNode*>(white_set, OpName4Node);
-  PropagateWhiteThroughClearNodes(op_graph, IsAllowedToRunWithHalf, black_set, &white_set);
-  VLOG(1) << "WhiteSet include: "
-          << Container2Str<HashSet<OpNode*>, OpNode*>(white_set, OpName4Node);
+  auto IsAllowedToRunWithHalf = MakePredicatorIsAllowedToRunWithHalf(op_graph, device_type);
+  FillWhiteSet(op_graph, lists, IsAllowedToRunWithHalf, black_set, &device_white_set);
+  VLOG(2) << "WhiteSet of " << device_tag << " Before Propagate include: "
+          << Container2Str<HashSet<OpNode*>, OpNode*>(device_white_set, OpName4Node);
+  PropagateWhiteThroughClearNodes(op_graph, lists, IsAllowedToRunWithHalf, black_set,
+                                  &device_white_set);
+  VLOG(1) << "WhiteSet of " << device_tag << " include: "
+          << Container2Str<HashSet<OpNode*>, OpNode*>(device_white_set, OpName4Node);
 
-  InsertCastOp(op_graph, white_set, job_builder);
-  return Maybe<void>::Ok();
+  for (OpNode* node : device_white_set) { INSERT_CHECK(white_set->insert(node)); }
 }
 
-void AutoMixedPrecision::FillBlackSet(const OpGraph& op_graph, HashSet<OpNode*>* black_set) const {
+void AutoMixedPrecision::FillBlackSet(const OpGraph& op_graph, const AMPLists& lists,
+                                      HashSet<OpNode*>* black_set) const {
   HashSet<OpNode*> upstream_or_part_of_black_and_gray;
   DfsTopoGraphTraversal(
       op_graph, true,
       [&](OpNode* node) {
-        return IsNodeInList(black_list_, node) || IsNodeInList(gray_list_, node);
+        return IsNodeInList(lists.black_list, node) || IsNodeInList(lists.gray_list, node);
       },
-      [&](OpNode* node) { return IsNodeInList(clear_list_, node); },
+      [&](OpNode* node) { return IsNodeInList(lists.clear_list, node); },
       [&](OpNode* node) { return IsKeyFound(upstream_or_part_of_black_and_gray, node); },
       [&](OpNode* node) {
         INSERT_CHECK(upstream_or_part_of_black_and_gray.insert(node));
@@ -241,7 +301,7 @@ void AutoMixedPrecision::FillBlackSet(const OpGraph& op_graph, HashSet<OpNode*>*
 
   // propagate black through upstream_or_part_of_black_and_gray
   DfsTopoGraphTraversal(
-      op_graph, false, [&](OpNode* node) { return IsNodeInList(black_list_, node); },
+      op_graph, false, [&](OpNode* node) { return IsNodeInList(lists.black_list, node); },
       [&](OpNode* node) { return IsKeyFound(upstream_or_part_of_black_and_gray, node); },
       [&](OpNode* node) { return IsKeyFound(*black_set, node); },
       [&](OpNode* node) {
@@ -250,19 +310,19 @@ void AutoMixedPrecision::FillBlackSet(const OpGraph& op_graph, HashSet<OpNode*>*
       });
 }
 
-void AutoMixedPrecision::FillWhiteSet(const OpGraph& op_graph,
+void AutoMixedPrecision::FillWhiteSet(const OpGraph& op_graph, const AMPLists& lists,
                                       std::function<bool(OpNode*)> IsAllowedToRunWithHalf,
                                       const HashSet<OpNode*>& black_set,
                                       HashSet<OpNode*>* white_set) const {
   HashSet<OpNode*> upstream_or_part_of_white;
   auto IsWhiteAndAllowedToRunHalf = [&](OpNode* node) {
-    return IsAllowedToRunWithHalf(node) && IsNodeInList(white_list_, node);
+    return IsAllowedToRunWithHalf(node) && IsNodeInList(lists.white_list, node);
   };
   DfsTopoGraphTraversal(
       op_graph, true, IsWhiteAndAllowedToRunHalf,
       [&](OpNode* node) {
         return !IsKeyFound(black_set, node) && IsAllowedToRunWithHalf(node)
-               && (IsNodeInList(gray_list_, node) || IsNodeInList(clear_list_, node));
+               && (IsNodeInList(lists.gray_list, node) || IsNodeInList(lists.clear_list, node));
       },
       [&](OpNode* node) { return IsKeyFound(upstream_or_part_of_white, node); },
       [&](OpNode* node) {
@@ -282,14 +342,15 @@ void AutoMixedPrecision::FillWhiteSet(const OpGraph& op_graph,
 }
 
 void AutoMixedPrecision::PropagateWhiteThroughClearNodes(
-    const OpGraph& op_graph, std::function<bool(OpNode*)> IsAllowedToRunWithHalf,
-    const HashSet<OpNode*>& black_set, HashSet<OpNode*>* white_set) const {
+    const OpGraph& op_graph, const AMPLists& lists,
+    std::function<bool(OpNode*)> IsAllowedToRunWithHalf, const HashSet<OpNode*>& black_set,
+    HashSet<OpNode*>* white_set) const {
   auto PropagateIntoOneDirection = [&](bool is_downward) {
     DfsTopoGraphTraversal(
         op_graph, !is_downward, [&](OpNode* node) { return false; },
         [&](OpNode* node) {
           return !IsKeyFound(*white_set, node) && !IsKeyFound(black_set, node)
-                 && IsNodeInList(clear_list_, node) && IsAllowedToRunWithHalf(node);
+                 && IsNodeInList(lists.clear_list, node) && IsAllowedToRunWithHalf(node);
         },
         [&](OpNode* node) { return IsKeyFound(*white_set, node); },
         [&](OpNode* node) {
@@ -342,5 +403,3 @@ REGISTER_NO_CAST_REGISTRY("normalization_add_relu", "beta", 0)
 }  // namespace
 
 }  // namespace oneflow
-
-#endif  // WITH_CUDA
@@ -93,4 +93,33 @@ const AMPList& AutoMixedPrecisionLists::ClearList() {
   return clear_list;
 }
 
+const AMPList& AutoMixedPrecisionLists::CpuWhiteList() {
+  static AMPList white_list = {"matmul", "batch_matmul", "broadcast_matmul", "conv2d",
+                               "amp_white_identity"};
+  return white_list;
+}
+
+const AMPList& AutoMixedPrecisionLists::CpuBlackList() {
+  static AMPList black_list = {};
+  return black_list;
+}
+
+const AMPList& AutoMixedPrecisionLists::CpuGrayList() {
+  static AMPList gray_list = {"add_n", "bias_add"};
+  return gray_list;
+}
+
+const AMPList& AutoMixedPrecisionLists::CpuClearList() {
+  static AMPList clear_list = {"reshape",
+                               "relu",
+                               "identity",
+                               "flatten",
+                               "squeeze",
+                               "expand_dims",
+                               "parallel_cast",
+                               "hierarchical_parallel_cast",
+                               "hierarchical_parallel_cast_like"};
+  return clear_list;
+}
+
 }  // namespace oneflow
@@ -30,6 +30,12 @@ class AutoMixedPrecisionLists final {
   static const AMPList& BlackList();
   static const AMPList& GrayList();
   static const AMPList& ClearList();
+
+  // The ops run with bfloat16 on cpu, which all have bfloat16 cpu kernels, and so do their grads
+  static const AMPList& CpuWhiteList();
+  static const AMPList& CpuBlackList();
+  static const AMPList& CpuGrayList();
+  static const AMPList& CpuClearList();
 };
 
 }  // namespace oneflow
@@ -84,6 +84,117 @@ void CollectAllCheckpointingOpsInForwardPass(
   });
 }
 
+// the outputs of the ops with fewer flops per byte, e.g. the elementwise ones, are always
+// recomputed by the cost model policy, as they are cheaper to recompute than to keep
+constexpr double kMinFlopsPerByteToKeep = 1.0;
+
+int64_t BlobBytes4Bn(const OpNode* node, const std::string& bn) {
+  const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(node->op().BnInOp2Lbi(bn));
+  int64_t bytes = blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+  if (node->SbpParallel4BnInOp(bn).has_split_parallel()) {
+    bytes /= node->parallel_desc().parallel_num();
+  }
+  return bytes;
+}
+
+// the bytes of the outputs of node on a device
+int64_t OutBytes4OpNode(const OpNode* node) {
+  int64_t bytes = 0;
+  for (const std::string& obn : node->op().output_bns()) { bytes += BlobBytes4Bn(node, obn); }
+  return bytes;
+}
+
+// A rough estimate of the flops of node on a device, by the shapes of its blobs
+int64_t Flops4OpNode(const OpNode* node) {
+  int64_t in_elem_cnt = 0;
+  for (const std::string& ibn : node->op().input_bns()) {
+    const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(node->op().BnInOp2Lbi(ibn));
+    in_elem_cnt += BlobBytes4Bn(node, ibn) / GetSizeOfDataType(blob_desc.data_type());
+  }
+  int64_t out_elem_cnt = 0;
+  for (const std::string& obn : node->op().output_bns()) {
+    const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(node->op().BnInOp2Lbi(obn));
+    out_elem_cnt += BlobBytes4Bn(node, obn) / GetSizeOfDataType(blob_desc.data_type());
+  }
+  const OperatorConf& op_conf = node->op().op_conf();
+  if (!op_conf.has_user_conf()) { return std::max(in_elem_cnt, out_elem_cnt); }
+  const user_op::UserOpConfWrapper conf(op_conf);
+  const std::string& op_type_name = conf.op_type_name();
+  if (op_type_name == "matmul" || op_type_name == "batch_matmul"
+      || op_type_name == "broadcast_matmul") {
+    const Shape& a_shape = node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("a", 0))).shape();
+    const int64_t num_axes = a_shape.NumAxes();
+    const int64_t k = conf.attr<bool>("transpose_a") ? a_shape.At(num_axes - 2)
+                                                     : a_shape.At(num_axes - 1);
+    return 2 * out_elem_cnt * k;
+  } else if (op_type_name == "conv1d" || op_type_name == "conv2d" || op_type_name == "conv3d") {
+    const Shape& weight_shape =
+        node->LogicalBlobDesc4Lbi(GenLogicalBlobId(conf.input("weight", 0))).shape();
+    return 2 * out_elem_cnt * (weight_shape.elem_cnt() / weight_shape.At(0));
+  } else {
+    return std::max(in_elem_cnt, out_elem_cnt);
+  }
+}
+
+// Keeps the outputs of the checkpointing ops with the most flops per byte, as long as they fit in
+// the memory budget
+void GenKeptCheckpointingOpNodes(
+    const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
+    int64_t memory_budget, HashSet<const OpNode*>* kept_nodes) {
+  std::vector<std::pair<double, const OpNode*>> flops_per_byte7nodes;
+  for (const auto& pair : checkpointing_op_name2op_node) {
+    const OpNode* node = pair.second;
+    const int64_t out_bytes = OutBytes4OpNode(node);
+    if (out_bytes == 0) { continue; }
+    const double flops_per_byte = static_cast<double>(Flops4OpNode(node)) / out_bytes;
+    if (flops_per_byte < kMinFlopsPerByteToKeep) { continue; }
+    flops_per_byte7nodes.emplace_back(flops_per_byte, node);
+  }
+  std::sort(flops_per_byte7nodes.begin(), flops_per_byte7nodes.end(),
+            [](const std::pair<double, const OpNode*>& lhs,
+               const std::pair<double, const OpNode*>& rhs) {
+              if (lhs.first != rhs.first) { return lhs.first > rhs.first; }
+              return lhs.second->op().op_name() < rhs.second->op().op_name();
+            });
+  int64_t kept_bytes = 0;
+  for (const auto& pair : flops_per_byte7nodes) {
+    const int64_t out_bytes = OutBytes4OpNode(pair.second);
+    if (kept_bytes + out_bytes > memory_budget) { continue; }
+    kept_bytes += out_bytes;
+    CHECK(kept_nodes->insert(pair.second).second);
+  }
+}
+
+// The ops of subgraph recomputed in the backward pass, which are the ones not kept that the
+// backward pass consumes, directly or through the other recomputed ops
+void GenRecomputedOpNodes(const HashSet<const OpNode*>& subgraph,
+                          const HashSet<const OpNode*>& kept_nodes,
+                          HashSet<const OpNode*>* recomputed_nodes) {
+  std::queue<const OpNode*> queued_nodes;
+  for (const OpNode* node : subgraph) {
+    if (kept_nodes.find(node) != kept_nodes.end()) { continue; }
+    bool has_bw_consumer = false;
+    node->ForEachNodeOnOutEdge([&](const OpNode* out_node) {
+      if (!IsForwardPassScope(Scope4OpNode(out_node))) { has_bw_consumer = true; }
+    });
+    if (has_bw_consumer) {
+      CHECK(recomputed_nodes->insert(node).second);
+      queued_nodes.push(node);
+    }
+  }
+  while (!queued_nodes.empty()) {
+    const OpNode* cur_node = queued_nodes.front();
+    queued_nodes.pop();
+    cur_node->ForEachNodeOnInEdge([&](const OpNode* in_node) {
+      if (subgraph.find(in_node) != subgraph.end()
+          && kept_nodes.find(in_node) == kept_nodes.end()
+          && recomputed_nodes->insert(in_node).second) {
+        queued_nodes.push(in_node);
+      }
+    });
+  }
+}
+
 void GenConnectedCheckpointingSubgraphs(
     const HashMap<std::string, const OpNode*>& checkpointing_op_name2op_node,
     std::vector<HashSet<const OpNode*>>* checkpointing_subgraphs) {
@@ -131,6 +242,19 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
   std::vector<HashSet<const OpNode*>> checkpointing_subgraphs;
   GenConnectedCheckpointingSubgraphs(checkpointing_op_name2op_node, &checkpointing_subgraphs);
 
+  // step 3. choose the ops whose outputs are kept instead of recomputed.
+  const JobConfigProto& job_conf = job_builder->job().job_conf();
+  const std::string& policy = job_conf.checkpointing_policy();
+  CHECK_OR_RETURN(policy == "all" || policy == "cost_model")
+      << "Unknown checkpointing_policy: " << policy;
+  HashSet<const OpNode*> kept_nodes;
+  if (policy == "cost_model") {
+    const int64_t memory_budget = job_conf.has_checkpointing_memory_budget_mbyte()
+                                      ? job_conf.checkpointing_memory_budget_mbyte() * 1024 * 1024
+                                      : GetMaxVal<int64_t>();
+    GenKeptCheckpointingOpNodes(checkpointing_op_name2op_node, memory_budget, &kept_nodes);
+  }
+
   HashMap<const OpNode*, int32_t> op_node2order;
   int32_t order = 0;
   op_graph.TopoForEachNode([&](const OpNode* op_node) {
@@ -138,17 +262,27 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
     ++order;
   });
 
-  // step 3. for each subgraphs:
+  // step 4. for each subgraphs:
 
   // NOTE(chengcheng):
   //   maybe a bw consumer will consume multi subgraph for recompute.
   //   so we need collect bw consumer between subgraphs, and update them in job builder only once.
   HashMap<std::string, OperatorConf> total_bw_consumers_op_name2conf;
+  int64_t recomputed_op_num = 0;
+  int64_t saved_bytes = 0;
+  int64_t extra_flops = 0;
 
   for (auto& subgraph : checkpointing_subgraphs) {
-    // step 3.1 ignore this subgraph if there is no direct edge to backward pass op.
+    HashSet<const OpNode*> recomputed_nodes;
+    if (policy == "all") {
+      recomputed_nodes = subgraph;
+    } else {
+      GenRecomputedOpNodes(subgraph, kept_nodes, &recomputed_nodes);
+    }
+
+    // step 4.1 ignore this subgraph if there is no direct edge to backward pass op.
     HashSet<const OpNode*> bw_consumers;
-    for (const OpNode* node : subgraph) {
+    for (const OpNode* node : recomputed_nodes) {
       node->ForEachNodeOnOutEdge([&](const OpNode* out_node) {
         if (!IsForwardPassScope(Scope4OpNode(out_node))) {
           bw_consumers.insert(out_node);
@@ -158,17 +292,22 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
     }
     if (bw_consumers.empty()) { continue; }
 
+    // NOTE: only the recomputed ops are replaced by their fake ops, the kept ones are consumed
+    // as they are
     HashMap<std::string, const OpNode*> subgraph_op_name2op_node;
     ParallelConf parallel_conf;
-    for (const OpNode* node : subgraph) {
+    for (const OpNode* node : recomputed_nodes) {
       subgraph_op_name2op_node.emplace(node->op().op_name(), node);
       parallel_conf = node->parallel_desc().parallel_conf();
+      recomputed_op_num += 1;
+      saved_bytes += OutBytes4OpNode(node);
+      extra_flops += Flops4OpNode(node);
     }
 
-    // step 3.2 generate fake subgraph for recomputation
+    // step 4.2 generate fake subgraph for recomputation
     HashMap<std::string, OperatorConf> fake_op_name2conf;
     HashSet<std::string> source_node_in_fake_subgraph;
-    for (const OpNode* node : subgraph) {
+    for (const OpNode* node : recomputed_nodes) {
       OperatorConf fake_op_conf = node->op().op_conf();
       std::string fake_op_name = kCheckpointingFakeOpNamePrefix + fake_op_conf.name();
       fake_op_conf.set_name(fake_op_name);
@@ -223,7 +362,7 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
 
     const OpNode* first_bw_consumer = nullptr;
     int32_t first_bw_order = std::numeric_limits<int32_t>::max();
-    // step 3.3 change bw consumers input from subgraph to fake subgraph
+    // step 4.3 change bw consumers input from subgraph to fake subgraph
     for (const OpNode* node : bw_consumers) {
       std::string bw_consumer_name = node->op().op_name();
       OperatorConf bw_consumer_op_conf;
@@ -264,7 +403,7 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
       }
     }
 
-    // step 3.4 add control edge from End Op to all source node in fake subgraph
+    // step 4.4 add control edge from End Op to all source node in fake subgraph
     CHECK(first_bw_consumer != nullptr);
     std::string end_op_name = kCheckpointingBadOpName;
     int32_t end_order = -1;
@@ -283,19 +422,32 @@ Maybe<void> CheckpointingPass::Apply(const OpGraph& op_graph, JobBuilder* job_bu
       fake_op_name2conf.at(source_op_name).add_ctrl_in_op_name(end_op_name);
     }
 
-    // step 3.5 add fake subgraph ops to job builder
+    // step 4.5 add fake subgraph ops to job builder
     std::vector<OperatorConf> fake_op_confs;
     for (auto& pair : fake_op_name2conf) { fake_op_confs.push_back(pair.second); }
     job_builder->AddOps(parallel_conf, fake_op_confs);
   }
 
-  // step 4. update bw consumers in job builder only once
+  // step 5. update bw consumers in job builder only once
   std::vector<OperatorConf> total_bw_consumer_op_confs;
   for (auto& pair : total_bw_consumers_op_name2conf) {
     total_bw_consumer_op_confs.push_back(pair.second);
   }
   job_builder->MutOpsOnlyOnce(total_bw_consumer_op_confs);
 
+  int64_t kept_bytes = 0;
+  for (const OpNode* node : kept_nodes) { kept_bytes += OutBytes4OpNode(node); }
+  int64_t forward_flops = 0;
+  op_graph.ForEachNode([&](const OpNode* node) {
+    if (!node->op().op_conf().has_user_conf()) { return; }
+    if (IsForwardPassScope(Scope4OpNode(node))) { forward_flops += Flops4OpNode(node); }
+  });
+  LOG(INFO) << "CheckpointingPass of job " << job_conf.job_name() << " with policy " << policy
+            << ": recompute " << recomputed_op_num << " ops, which saves "
+            << saved_bytes / 1024.0 / 1024.0 << " MB of activations for " << extra_flops
+            << " extra flops (" << 100.0 * extra_flops / std::max<int64_t>(forward_flops, 1)
+            << "% of the forward pass), and keep the outputs of " << kept_nodes.size()
+            << " ops, which take " << kept_bytes / 1024.0 / 1024.0 << " MB";
   return Maybe<void>::Ok();
 }
 
@@ -0,0 +1,221 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/job/job.pb.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/job_rewriter/calculation_pass.h"
+#include "oneflow/core/job_rewriter/pass_util.h"
+#include "oneflow/core/vm/symbol_storage.h"
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/common/str_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// HostActivationOffloadPass moves the large forward activations consumed by the backward pass out
+// of the device memory while the rest of the forward pass and the beginning of the backward pass
+// run, and brings them back a few backward ops before they are consumed.
+//
+// On gpu, the activation is consumed by an identity op on the cpu of the same devices, so that
+// the boxing copies it to the pinned host memory by a CopyHdTaskNode right after it is produced.
+// The identity op waits for the backward op the prefetch starts after, and its output is copied
+// back to the device by another CopyHdTaskNode for the backward consumers.
+//
+// On cpu, the activation is spilled to a file by spill_to_file right after it is produced, and
+// load_spilled_file reads it back after the backward op the prefetch starts after. The memory of
+// the spilled activations and the loaded ones is reused by IntraJobMemSharingUtil.
+class HostActivationOffloadPass final : public JobPass {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(HostActivationOffloadPass);
+  HostActivationOffloadPass() = default;
+  ~HostActivationOffloadPass() = default;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    return ctx.job_desc().IsTrain() && ctx.job_desc().enable_host_activation_offload();
+  }
+
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+};
+
+const std::string kHostActivationOffloadOpNamePrefix = "System-HostActivationOffload-";
+
+bool IsForwardPassOpNode(const OpNode* op_node) {
+  const OperatorConf& op_conf = op_node->op().op_conf();
+  // the system ops without scope are taken as forward ops, which are never prefetched after
+  if (!op_conf.has_scope_symbol_id()) { return true; }
+  CHECK(Global<symbol::Storage<Scope>>::Get()->Has(op_conf.scope_symbol_id()));
+  const Scope& scope = Global<symbol::Storage<Scope>>::Get()->Get(op_conf.scope_symbol_id());
+  return scope.scope_proto().calculation_pass_name() == kForwardPass;
+}
+
+int64_t BlobBytes4Lbi(const OpNode* node, const LogicalBlobId& lbi) {
+  const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(lbi);
+  int64_t bytes = blob_desc.shape().elem_cnt() * GetSizeOfDataType(blob_desc.data_type());
+  if (node->SbpParallel4Lbi(lbi).has_split_parallel()) {
+    bytes /= node->parallel_desc().parallel_num();
+  }
+  return bytes;
+}
+
+Maybe<void> HostActivationOffloadPass::Apply(const OpGraph& op_graph,
+                                             JobBuilder* job_builder) const {
+  const JobConfigProto& job_conf = job_builder->job().job_conf();
+  const int64_t threshold = job_conf.host_activation_offload_threshold_mbyte() * 1024 * 1024;
+  const int64_t lookahead = job_conf.host_activation_offload_prefetch_lookahead();
+  CHECK_GT_OR_RETURN(lookahead, 0);
+
+  std::vector<const OpNode*> ordered_op_nodes;
+  HashMap<const OpNode*, int64_t> op_node2order;
+  op_graph.TopoForEachNode([&](const OpNode* node) {
+    op_node2order.emplace(node, ordered_op_nodes.size());
+    ordered_op_nodes.push_back(node);
+  });
+
+  HashMap<std::string, OperatorConf> consumer_op_name2op_conf;
+  int64_t offloaded_blob_num = 0;
+  int64_t offloaded_bytes = 0;
+  for (const OpNode* node : ordered_op_nodes) {
+    // variables and the other system ops are not offloaded
+    if (!node->op().op_conf().has_user_conf()) { continue; }
+    if (!IsForwardPassOpNode(node)) { continue; }
+    const DeviceType device_type = node->parallel_desc().device_type();
+    if (device_type != DeviceType::kGPU && device_type != DeviceType::kCPU) { continue; }
+    const int64_t order = op_node2order.at(node);
+    const Shape& time_shape = *JUST(node->op().GetOpTimeShape());
+    for (const std::string& obn : node->op().output_bns()) {
+      const LogicalBlobId& lbi = node->op().BnInOp2Lbi(obn);
+      const BlobDesc& blob_desc = node->LogicalBlobDesc4Lbi(lbi);
+      if (blob_desc.is_dynamic()) { continue; }
+      const int64_t bytes = BlobBytes4Lbi(node, lbi);
+      if (bytes < threshold) { continue; }
+
+      std::vector<const OpEdge*> bw_edges;
+      int64_t first_bw_order = GetMaxVal<int64_t>();
+      for (const OpEdge* edge : node->out_edges()) {
+        if (edge->lbi2ibns().find(lbi) == edge->lbi2ibns().end()) { continue; }
+        if (IsForwardPassOpNode(edge->dst_node())) { continue; }
+        bw_edges.push_back(edge);
+        first_bw_order = std::min(first_bw_order, op_node2order.at(edge->dst_node()));
+      }
+      if (bw_edges.empty()) { continue; }
+
+      // the prefetch starts after the lookahead-th backward op before the first backward consumer,
+      // so that the copy back overlaps with the computation of these backward ops. The
+      // activations consumed by the backward pass right after they are produced are skipped
+      const OpNode* prefetch_after = nullptr;
+      int64_t num_ahead = 0;
+      for (int64_t i = first_bw_order - 1; i > order && num_ahead < lookahead; --i) {
+        const OpNode* candidate = ordered_op_nodes.at(i);
+        if (IsForwardPassOpNode(candidate)) { continue; }
+        if (candidate->parallel_desc().parallel_num() != node->parallel_desc().parallel_num()) {
+          continue;
+        }
+        if (JUST(candidate->op().GetOpTimeShape())->elem_cnt() != time_shape.elem_cnt()) {
+          continue;
+        }
+        prefetch_after = candidate;
+        num_ahead += 1;
+      }
+      if (prefetch_after == nullptr) { continue; }
+
+      const std::string lbn = GenLogicalBlobName(lbi);
+      const std::string op_name_prefix =
+          kHostActivationOffloadOpNamePrefix + ReplaceSlashToDash4Lbn(lbn);
+      const int64_t bw_scope_symbol_id = prefetch_after->op().op_conf().scope_symbol_id();
+      std::string prefetched_lbn;
+      if (device_type == DeviceType::kGPU) {
+        ParallelConf host_parallel_conf = node->parallel_desc().parallel_conf();
+        host_parallel_conf.set_device_tag("cpu");
+        auto prefetch_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "-prefetch")
+                               .Op("identity")
+                               .Input("in", lbn)
+                               .Output("out")
+                               .ScopeSymbolId(bw_scope_symbol_id)
+                               .Build();
+        OperatorConf prefetch_op_conf = prefetch_op.op_conf();
+        prefetch_op_conf.add_ctrl_in_op_name(prefetch_after->op().op_name());
+        job_builder->AddOps(host_parallel_conf, {prefetch_op_conf});
+        prefetched_lbn = prefetch_op.output("out", 0);
+      } else {
+        const std::string path = JoinPath(job_conf.host_activation_offload_spill_dir(),
+                                          job_conf.job_name() + "-" + op_name_prefix);
+        const std::string sbp_parallel_str = SbpParallelToString(node->SbpParallel4Lbi(lbi));
+        auto spill_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "-spill")
+                            .Op("spill_to_file")
+                            .Input("in", lbn)
+                            .Output("handle")
+                            .Attr<std::string>("path", path)
+                            .Attr<std::string>("sbp_parallel", sbp_parallel_str)
+                            .ScopeSymbolId(node->op().op_conf().scope_symbol_id())
+                            .Build();
+        auto load_op = user_op::UserOpConfWrapperBuilder(op_name_prefix + "-load")
+                           .Op("load_spilled_file")
+                           .Input("handle", spill_op.output("handle", 0))
+                           .Output("out")
+                           .Attr<std::string>("path", path)
+                           .Attr<Shape>("shape", blob_desc.shape())
+                           .Attr<DataType>("dtype", blob_desc.data_type())
+                           .Attr<std::string>("sbp_parallel", sbp_parallel_str)
+                           .ScopeSymbolId(bw_scope_symbol_id)
+                           .Build();
+        OperatorConf load_op_conf = load_op.op_conf();
+        load_op_conf.add_ctrl_in_op_name(prefetch_after->op().op_name());
+        job_builder->AddOps(node->parallel_desc().parallel_conf(),
+                            {spill_op.op_conf(), load_op_conf});
+        prefetched_lbn = load_op.output("out", 0);
+      }
+
+      for (const OpEdge* edge : bw_edges) {
+        const OpNode* consumer = edge->dst_node();
+        const std::string& consumer_op_name = consumer->op().op_name();
+        if (consumer_op_name2op_conf.find(consumer_op_name) == consumer_op_name2op_conf.end()) {
+          consumer_op_name2op_conf.emplace(consumer_op_name, consumer->op().op_conf());
+        }
+        OperatorConf* consumer_op_conf = &consumer_op_name2op_conf.at(consumer_op_name);
+        for (const std::string& ibn : edge->lbi2ibns().at(lbi)) {
+          const std::string old_lbn =
+              ReplaceInputLbnInOpCustomizedConf(consumer_op_conf, ibn, prefetched_lbn);
+          CHECK_EQ_OR_RETURN(old_lbn, lbn);
+        }
+      }
+      offloaded_blob_num += 1;
+      offloaded_bytes += bytes;
+    }
+  }
+
+  std::vector<OperatorConf> consumer_op_confs;
+  for (const auto& pair : consumer_op_name2op_conf) { consumer_op_confs.push_back(pair.second); }
+  job_builder->MutOpsOnlyOnce(consumer_op_confs);
+  LOG(INFO) << "HostActivationOffloadPass of job " << job_conf.job_name() << ": offload "
+            << offloaded_blob_num << " activations, " << offloaded_bytes / 1024.0 / 1024.0
+            << " MB per rank";
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+REGISTER_JOB_PASS("HostActivationOffloadPass", HostActivationOffloadPass);
+
+}  // namespace oneflow
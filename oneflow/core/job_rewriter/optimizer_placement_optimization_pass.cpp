@@ -75,7 +75,11 @@ Maybe<void> GetDataParallelVariableAndNaiveSuccNode(
     std::vector<const OpNode*>* out) {
   if (!start->op().op_conf().has_variable_conf()) { return Maybe<void>::Ok(); }
   const ParallelDesc& pd = start->parallel_desc();
-  if (pd.device_type() != DeviceType::kGPU) { return Maybe<void>::Ok(); }
+  // on cpu, the partial sum gradients are reduce-scattered and the split variables are
+  // all-gathered by the comm net collective boxing if it is enabled, otherwise by slice boxing
+  if (pd.device_type() != DeviceType::kGPU && pd.device_type() != DeviceType::kCPU) {
+    return Maybe<void>::Ok();
+  }
   if (pd.parallel_num() == 1) { return Maybe<void>::Ok(); }
   const OpNode* cur_node = start;
   while (cur_node != nullptr) {
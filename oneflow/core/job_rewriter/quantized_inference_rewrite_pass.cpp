@@ -0,0 +1,193 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/job_rewriter/job_pass.h"
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+struct FakeQuantInput {
+  std::string in;
+  std::string scale;
+  std::string zero_point;
+  std::string quantization_scheme;
+  int64_t scale_cnt;
+  bool is_variable;
+};
+
+// Gets the input of the fake_quantization op which produces lbn, if it is an int8 one of the
+// google formula, i.e. one that the quantized kernels compute the same way
+bool GetFakeQuantInput(const OpGraph& op_graph, const OpNode* consumer, const std::string& lbn,
+                       FakeQuantInput* input) {
+  const OpNode* producer = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+  const OperatorConf& op_conf = producer->op().op_conf();
+  if (!op_conf.has_user_conf() || op_conf.user_conf().op_type_name() != "fake_quantization") {
+    return false;
+  }
+  if (producer->parallel_desc() != consumer->parallel_desc()) { return false; }
+  const user_op::UserOpConfWrapper conf(op_conf);
+  if (conf.attr<std::string>("quantization_formula") != "google") { return false; }
+  if (conf.attr<int32_t>("quantization_bit") != 8) { return false; }
+  input->in = conf.input("in", 0);
+  input->scale = conf.input("scale", 0);
+  input->zero_point = conf.input("zero_point", 0);
+  input->quantization_scheme = conf.attr<std::string>("quantization_scheme");
+  input->scale_cnt =
+      producer->LogicalBlobDesc4Lbi(GenLogicalBlobId(input->scale)).shape().elem_cnt();
+  input->is_variable = op_graph.OpNode4OpName(GenLogicalBlobId(input->in).op_name())
+                           ->op()
+                           .op_conf()
+                           .has_variable_conf();
+  return true;
+}
+
+// The quantized op of an int8 op whose activation and weight are fake quantized. The weight must
+// be a variable, which the kernels pack before the gemm
+bool MakeQuantizedOpConf(const OpGraph& op_graph, const OpNode* node, OperatorConf* new_op_conf,
+                         std::vector<std::string>* fake_quant_lbns) {
+  const OperatorConf& op_conf = node->op().op_conf();
+  const user_op::UserOpConfWrapper conf(op_conf);
+  const std::string& op_type_name = conf.op_type_name();
+  std::string activation_arg;
+  std::string weight_arg;
+  if (op_type_name == "matmul") {
+    if (conf.attr<bool>("transpose_a") || conf.attr<double>("alpha") != 1.0
+        || conf.has_input("_add_to_output", 0)) {
+      return false;
+    }
+    activation_arg = "a";
+    weight_arg = "b";
+  } else if (op_type_name == "conv2d") {
+    if (conf.attr<std::string>("data_format") != "channels_first"
+        || conf.attr<int32_t>("groups") != 1 || conf.has_input("bias", 0)) {
+      return false;
+    }
+    activation_arg = "in";
+    weight_arg = "weight";
+  } else {
+    return false;
+  }
+  FakeQuantInput activation;
+  FakeQuantInput weight;
+  if (!GetFakeQuantInput(op_graph, node, conf.input(activation_arg, 0), &activation)
+      || !GetFakeQuantInput(op_graph, node, conf.input(weight_arg, 0), &weight)) {
+    return false;
+  }
+  if (activation.quantization_scheme != weight.quantization_scheme) { return false; }
+  if (activation.scale_cnt != 1 || !weight.is_variable) { return false; }
+
+  user_op::UserOpConfWrapperBuilder builder(op_conf.name());
+  builder.Op("quantized_" + op_type_name)
+      .Input(activation_arg, activation.in)
+      .Input(activation_arg + "_scale", activation.scale)
+      .Input(activation_arg + "_zero_point", activation.zero_point)
+      .Input(weight_arg, weight.in)
+      .Input(weight_arg + "_scale", weight.scale)
+      .Input(weight_arg + "_zero_point", weight.zero_point)
+      .Output("out")
+      .Attr<std::string>("quantization_scheme", weight.quantization_scheme)
+      .Attr<int32_t>("quantization_bit", 8)
+      .ScopeSymbolId(op_conf.scope_symbol_id());
+  if (op_type_name == "matmul") {
+    const bool transpose_b = conf.attr<bool>("transpose_b");
+    // the per-channel scales of b are along its axis 0, which is k unless b is transposed
+    if (weight.scale_cnt != 1 && !transpose_b) { return false; }
+    builder.Attr<bool>("transpose_b", transpose_b);
+  } else {
+    builder.Attr<int32_t>("filters", conf.attr<int32_t>("filters"))
+        .Attr<std::vector<int32_t>>("padding_before",
+                                    conf.attr<std::vector<int32_t>>("padding_before"))
+        .Attr<std::string>("data_format", conf.attr<std::string>("data_format"))
+        .Attr<std::vector<int32_t>>("kernel_size", conf.attr<std::vector<int32_t>>("kernel_size"))
+        .Attr<std::vector<int32_t>>("strides", conf.attr<std::vector<int32_t>>("strides"))
+        .Attr<std::vector<int32_t>>("dilation_rate",
+                                    conf.attr<std::vector<int32_t>>("dilation_rate"))
+        .Attr<int32_t>("groups", 1);
+  }
+  *new_op_conf = builder.Build().op_conf();
+  new_op_conf->set_device_tag(op_conf.device_tag());
+  fake_quant_lbns->push_back(conf.input(activation_arg, 0));
+  fake_quant_lbns->push_back(conf.input(weight_arg, 0));
+  return true;
+}
+
+}  // namespace
+
+// Replaces the fake quantized matmul and conv2d on cpu by the int8 kernels in the inference jobs,
+// so that the quantization simulated by QuantAwareTraining is really executed. The outputs of the
+// quantized ops are dequantized to float for the float ops after them
+class QuantizedInferenceRewritePass final : public JobPass {
+ public:
+  QuantizedInferenceRewritePass() = default;
+  ~QuantizedInferenceRewritePass() override = default;
+
+  bool IsEnabled(const JobPassCtx& ctx) const {
+    const JobConfigProto& job_conf = ctx.job_desc().job_conf();
+    return job_conf.enable_quantization_aware_training()
+           && job_conf.qat_config().int8_cpu_inference() && !ctx.job_desc().IsTrain();
+  }
+  Maybe<void> Apply(const OpGraph& op_graph, JobBuilder* job_builder) const;
+
+  Maybe<void> Apply(Job* job, JobPassCtx* ctx) const override {
+    if (!IsEnabled(*ctx)) { return Maybe<void>::Ok(); }
+    const OpGraph op_graph(*job);
+    JobBuilder job_builder(job);
+    return Apply(op_graph, &job_builder);
+  }
+};
+
+Maybe<void> QuantizedInferenceRewritePass::Apply(const OpGraph& op_graph,
+                                                 JobBuilder* job_builder) const {
+  std::vector<OperatorConf> quantized_op_confs;
+  HashSet<std::string> quantized_op_names;
+  std::vector<std::string> fake_quant_lbns;
+  op_graph.ForEachNode([&](const OpNode* op_node) {
+    if (op_node->parallel_desc().device_type() != DeviceType::kCPU) { return; }
+    if (!op_node->op().op_conf().has_user_conf()) { return; }
+    OperatorConf new_op_conf;
+    if (!MakeQuantizedOpConf(op_graph, op_node, &new_op_conf, &fake_quant_lbns)) { return; }
+    VLOG(2) << "QuantizedInferenceRewritePass: replace " << op_node->op().op_name() << " with "
+            << new_op_conf.user_conf().op_type_name();
+    quantized_op_names.insert(new_op_conf.name());
+    quantized_op_confs.push_back(new_op_conf);
+  });
+  job_builder->MutOpsOnlyOnce(quantized_op_confs);
+
+  // the fake_quantization ops only consumed by the quantized ops are no longer needed
+  HashSet<std::string> deleted_op_names;
+  std::vector<std::string> deleted_ops;
+  for (const std::string& lbn : fake_quant_lbns) {
+    const OpNode* fake_quant_node = op_graph.OpNode4OpName(GenLogicalBlobId(lbn).op_name());
+    const std::string& fake_quant_op_name = fake_quant_node->op().op_name();
+    if (IsKeyFound(deleted_op_names, fake_quant_op_name)) { continue; }
+    bool is_only_consumed_by_quantized_ops = true;
+    for (const OpEdge* edge : fake_quant_node->out_edges()) {
+      if (!IsKeyFound(quantized_op_names, edge->dst_node()->op().op_name())) {
+        is_only_consumed_by_quantized_ops = false;
+      }
+    }
+    if (!is_only_consumed_by_quantized_ops) { continue; }
+    deleted_op_names.insert(fake_quant_op_name);
+    deleted_ops.push_back(fake_quant_op_name);
+  }
+  job_builder->DelOps(deleted_ops);
+  return Maybe<void>::Ok();
+}
+
+REGISTER_JOB_PASS("QuantizedInferenceRewritePass", QuantizedInferenceRewritePass);
+
+}  // namespace oneflow
@@ -0,0 +1,204 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/cpu_slice_boxing_plan.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include "oneflow/core/thread/thread_manager.h"
+
+namespace oneflow {
+
+namespace {
+
+// boxings smaller than this run on the calling thread
+constexpr int64_t kMinParallelCpuSliceBoxingBytes = 4 * 1024 * 1024;
+constexpr int64_t kMinCpuSliceBoxingTaskBytes = 256 * 1024;
+// more tasks than threads balance the threads when the boxes have different in slices
+constexpr int64_t kCpuSliceBoxingTasksPerThread = 4;
+
+std::vector<int64_t> GetStrides(const Shape& shape) {
+  std::vector<int64_t> strides(shape.NumAxes());
+  int64_t stride = 1;
+  for (int64_t axis = shape.NumAxes() - 1; axis >= 0; --axis) {
+    strides.at(axis) = stride;
+    stride *= shape.At(axis);
+  }
+  return strides;
+}
+
+}  // namespace
+
+CpuSliceBoxingPlan::CpuSliceBoxingPlan(const TensorSliceView& out_slice,
+                                       const std::vector<TensorSliceView>& in_slices,
+                                       DataType data_type, bool is_add)
+    : is_add_(is_add),
+      size_of_data_type_(GetSizeOfDataType(data_type)),
+      num_ins_(in_slices.size()) {
+  CHECK(!out_slice.IsEmpty());
+  const int64_t num_axes = out_slice.shape().NumAxes();
+  std::vector<TensorSliceView> intersections;
+  for (const TensorSliceView& in_slice : in_slices) {
+    CHECK_EQ(in_slice.shape().NumAxes(), num_axes);
+    intersections.push_back(out_slice.Intersect(in_slice));
+  }
+  if (out_slice.shape().elem_cnt() == 0) {
+    InitTasks();
+    return;
+  }
+  std::vector<std::vector<int64_t>> axis2bounds(num_axes);
+  FOR_RANGE(int64_t, axis, 0, num_axes) {
+    std::vector<int64_t>& bounds = axis2bounds.at(axis);
+    bounds.push_back(out_slice.At(axis).begin());
+    bounds.push_back(out_slice.At(axis).end());
+    for (const TensorSliceView& intersection : intersections) {
+      if (intersection.IsEmpty()) { continue; }
+      bounds.push_back(intersection.At(axis).begin());
+      bounds.push_back(intersection.At(axis).end());
+    }
+    std::sort(bounds.begin(), bounds.end());
+    bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  }
+  const Shape out_shape = out_slice.shape();
+  const std::vector<int64_t> out_strides = GetStrides(out_shape);
+  std::vector<Shape> in_shapes;
+  std::vector<std::vector<int64_t>> in_strides;
+  for (const TensorSliceView& in_slice : in_slices) {
+    in_shapes.push_back(in_slice.shape());
+    in_strides.push_back(GetStrides(in_shapes.back()));
+  }
+  std::vector<int64_t> cell(num_axes, 0);
+  while (true) {
+    std::vector<Range> ranges;
+    FOR_RANGE(int64_t, axis, 0, num_axes) {
+      const std::vector<int64_t>& bounds = axis2bounds.at(axis);
+      ranges.emplace_back(bounds.at(cell.at(axis)), bounds.at(cell.at(axis) + 1));
+    }
+    const TensorSliceView cell_slice(ranges);
+    std::vector<int64_t> in_ids;
+    FOR_RANGE(int64_t, i, 0, num_ins_) {
+      if (intersections.at(i).IsEmpty() || !intersections.at(i).Contains(cell_slice)) { continue; }
+      if (!is_add_) { in_ids.clear(); }
+      in_ids.push_back(i);
+    }
+    if (is_add_ || !in_ids.empty()) {
+      Box box;
+      box.out_offset = 0;
+      box.in_ids = in_ids;
+      box.in_offsets.resize(in_ids.size(), 0);
+      box.in_strides.resize(in_ids.size());
+      // an axis is merged into the previous one if the box spans it in out and all the in slices
+      FOR_RANGE(int64_t, axis, 0, num_axes) {
+        const int64_t extent = ranges.at(axis).size();
+        box.out_offset += (ranges.at(axis).begin() - out_slice.At(axis).begin())
+                          * out_strides.at(axis);
+        bool mergeable = !box.extent.empty() && extent == out_shape.At(axis);
+        FOR_RANGE(size_t, j, 0, in_ids.size()) {
+          const int64_t in_id = in_ids.at(j);
+          box.in_offsets.at(j) += (ranges.at(axis).begin() - in_slices.at(in_id).At(axis).begin())
+                                  * in_strides.at(in_id).at(axis);
+          mergeable = mergeable && extent == in_shapes.at(in_id).At(axis);
+        }
+        if (mergeable) {
+          box.extent.back() *= extent;
+          box.out_strides.back() = out_strides.at(axis);
+          FOR_RANGE(size_t, j, 0, in_ids.size()) {
+            box.in_strides.at(j).back() = in_strides.at(in_ids.at(j)).at(axis);
+          }
+        } else {
+          box.extent.push_back(extent);
+          box.out_strides.push_back(out_strides.at(axis));
+          FOR_RANGE(size_t, j, 0, in_ids.size()) {
+            box.in_strides.at(j).push_back(in_strides.at(in_ids.at(j)).at(axis));
+          }
+        }
+      }
+      boxes_.push_back(box);
+    }
+    int64_t axis = num_axes - 1;
+    for (; axis >= 0; --axis) {
+      cell.at(axis) += 1;
+      if (cell.at(axis) + 1 < axis2bounds.at(axis).size()) { break; }
+      cell.at(axis) = 0;
+    }
+    if (axis < 0) { break; }
+  }
+  InitTasks();
+}
+
+void CpuSliceBoxingPlan::InitTasks() {
+  int64_t total_elem_cnt = 0;
+  for (const Box& box : boxes_) {
+    total_elem_cnt += std::accumulate(box.extent.cbegin(), box.extent.cend(), int64_t(1),
+                                      std::multiplies<int64_t>());
+  }
+  const int64_t total_bytes = total_elem_cnt * size_of_data_type_;
+  const int64_t thread_num =
+      Global<ThreadPool>::Get() == nullptr ? 1 : Global<ThreadPool>::Get()->thread_num();
+  is_parallel_ = thread_num > 1 && total_bytes >= kMinParallelCpuSliceBoxingBytes;
+  int64_t task_elem_cnt = GetMaxVal<int64_t>();
+  if (is_parallel_) {
+    const int64_t min_task_elem_cnt =
+        kMinCpuSliceBoxingTaskBytes / static_cast<int64_t>(size_of_data_type_);
+    task_elem_cnt = std::max(total_elem_cnt / (thread_num * kCpuSliceBoxingTasksPerThread),
+                             min_task_elem_cnt);
+  }
+  FOR_RANGE(int64_t, box_id, 0, boxes_.size()) {
+    const Box& box = boxes_.at(box_id);
+    const int64_t num_cols = box.extent.back();
+    const int64_t num_rows = std::accumulate(box.extent.cbegin(), box.extent.cend() - 1,
+                                             int64_t(1), std::multiplies<int64_t>());
+    if (num_cols > task_elem_cnt) {
+      const int64_t num_col_parts = RoundUp(num_cols, task_elem_cnt) / task_elem_cnt;
+      const BalancedSplitter col_splitter(num_cols, num_col_parts);
+      FOR_RANGE(int64_t, row, 0, num_rows) {
+        FOR_RANGE(int64_t, i, 0, num_col_parts) {
+          const Range cols = col_splitter.At(i);
+          tasks_.push_back(Task{box_id, row, row + 1, cols.begin(), cols.end()});
+        }
+      }
+    } else {
+      const int64_t rows_per_task = task_elem_cnt / num_cols;
+      for (int64_t row = 0; row < num_rows; row += rows_per_task) {
+        tasks_.push_back(
+            Task{box_id, row, std::min(row + rows_per_task, num_rows), 0, num_cols});
+      }
+    }
+  }
+  is_parallel_ = is_parallel_ && tasks_.size() > 1;
+}
+
+void CpuSliceBoxingPlan::ForEachTask(const std::function<void(const Task&)>& Handler) const {
+  if (is_parallel_) {
+    MultiThreadLoop(tasks_.size(), [&](size_t i) { Handler(tasks_.at(i)); });
+  } else {
+    for (const Task& task : tasks_) { Handler(task); }
+  }
+}
+
+void CpuSliceBoxingPlan::Copy(void* out, const std::vector<const void*>& ins) const {
+  CHECK(!is_add_);
+  CHECK_EQ(ins.size(), num_ins_);
+  ForEachTask([&](const Task& task) {
+    const Box& box = boxes_.at(task.box_id);
+    const void* in = ins.at(box.in_ids.front());
+    const size_t row_bytes = (task.col_end - task.col_begin) * size_of_data_type_;
+    ForEachRow(task, [&](int64_t out_offset, const std::vector<int64_t>& in_offsets) {
+      std::memcpy(reinterpret_cast<char*>(out) + out_offset * size_of_data_type_,
+                  reinterpret_cast<const char*>(in) + in_offsets.front() * size_of_data_type_,
+                  row_bytes);
+    });
+  });
+}
+
+}  // namespace oneflow
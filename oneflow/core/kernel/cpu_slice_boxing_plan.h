@@ -0,0 +1,155 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_CPU_SLICE_BOXING_PLAN_H_
+#define ONEFLOW_CORE_KERNEL_CPU_SLICE_BOXING_PLAN_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/register/tensor_slice_view.h"
+
+namespace oneflow {
+
+// The copies and the adds of a slice boxing on cpu, which are planned once and run in one pass
+// over out without any intermediate buffer. out is cut into boxes by the bounds of the in slices,
+// so that every box is covered by the same in slices. The rows of the boxes are grouped into tasks
+// of about the same size, which run on Global<ThreadPool> if the boxing is large
+class CpuSliceBoxingPlan final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(CpuSliceBoxingPlan);
+  // if is_add, a box is the sum of the in slices covering it, and zero if there is none. Otherwise
+  // it is copied from the last in slice covering it, and left as it is if there is none
+  CpuSliceBoxingPlan(const TensorSliceView& out_slice,
+                     const std::vector<TensorSliceView>& in_slices, DataType data_type,
+                     bool is_add);
+  ~CpuSliceBoxingPlan() = default;
+
+  void Copy(void* out, const std::vector<const void*>& ins) const;
+  template<typename T>
+  void Add(T* out, const std::vector<const T*>& ins) const;
+
+ private:
+  struct Box {
+    // the last axis of a box is contiguous in out and in the in slices, the offsets of the first
+    // elem of the box and the strides are in elems
+    std::vector<int64_t> extent;
+    int64_t out_offset;
+    std::vector<int64_t> out_strides;
+    std::vector<int64_t> in_ids;
+    std::vector<int64_t> in_offsets;
+    std::vector<std::vector<int64_t>> in_strides;
+  };
+
+  // the rows [row_begin, row_end) of a box, of which the elems [col_begin, col_end) are in the task
+  struct Task {
+    int64_t box_id;
+    int64_t row_begin;
+    int64_t row_end;
+    int64_t col_begin;
+    int64_t col_end;
+  };
+
+  void InitTasks();
+  void ForEachTask(const std::function<void(const Task&)>& Handler) const;
+  // calls Handler(out_offset, in_offsets) with the offsets of the first elem of each row of task
+  template<typename HandlerT>
+  void ForEachRow(const Task& task, const HandlerT& Handler) const;
+
+  bool is_add_;
+  size_t size_of_data_type_;
+  int64_t num_ins_;
+  std::vector<Box> boxes_;
+  std::vector<Task> tasks_;
+  bool is_parallel_;
+};
+
+template<typename HandlerT>
+void CpuSliceBoxingPlan::ForEachRow(const Task& task, const HandlerT& Handler) const {
+  const Box& box = boxes_.at(task.box_id);
+  const int64_t num_outer_axes = box.extent.size() - 1;
+  const int64_t num_ins = box.in_ids.size();
+  std::vector<int64_t> idx(num_outer_axes);
+  int64_t out_offset = box.out_offset + task.col_begin;
+  std::vector<int64_t> in_offsets(num_ins);
+  FOR_RANGE(int64_t, j, 0, num_ins) { in_offsets.at(j) = box.in_offsets.at(j) + task.col_begin; }
+  int64_t rest = task.row_begin;
+  for (int64_t axis = num_outer_axes - 1; axis >= 0; --axis) {
+    idx.at(axis) = rest % box.extent.at(axis);
+    rest /= box.extent.at(axis);
+    out_offset += idx.at(axis) * box.out_strides.at(axis);
+    FOR_RANGE(int64_t, j, 0, num_ins) {
+      in_offsets.at(j) += idx.at(axis) * box.in_strides.at(j).at(axis);
+    }
+  }
+  FOR_RANGE(int64_t, row, task.row_begin, task.row_end) {
+    Handler(out_offset, in_offsets);
+    for (int64_t axis = num_outer_axes - 1; axis >= 0; --axis) {
+      out_offset += box.out_strides.at(axis);
+      FOR_RANGE(int64_t, j, 0, num_ins) { in_offsets.at(j) += box.in_strides.at(j).at(axis); }
+      idx.at(axis) += 1;
+      if (idx.at(axis) < box.extent.at(axis)) { break; }
+      out_offset -= box.extent.at(axis) * box.out_strides.at(axis);
+      FOR_RANGE(int64_t, j, 0, num_ins) {
+        in_offsets.at(j) -= box.extent.at(axis) * box.in_strides.at(j).at(axis);
+      }
+      idx.at(axis) = 0;
+    }
+  }
+}
+
+template<typename T>
+void CpuSliceBoxingPlan::Add(T* out, const std::vector<const T*>& ins) const {
+  CHECK(is_add_);
+  CHECK_EQ(sizeof(T), size_of_data_type_);
+  CHECK_EQ(ins.size(), num_ins_);
+  // the rows are summed chunk by chunk, so that the partial sums stay in the cache and out is
+  // written once
+  constexpr int64_t kChunkSize = 1024;
+  ForEachTask([&](const Task& task) {
+    const Box& box = boxes_.at(task.box_id);
+    const int64_t num_cols = task.col_end - task.col_begin;
+    const int64_t num_box_ins = box.in_ids.size();
+    std::vector<const T*> row_ins(num_box_ins);
+    ForEachRow(task, [&](int64_t out_offset, const std::vector<int64_t>& in_offsets) {
+      T* row_out = out + out_offset;
+      if (num_box_ins == 0) {
+        std::fill(row_out, row_out + num_cols, GetZeroVal<T>());
+        return;
+      }
+      FOR_RANGE(int64_t, j, 0, num_box_ins) {
+        row_ins.at(j) = ins.at(box.in_ids.at(j)) + in_offsets.at(j);
+      }
+      if (num_box_ins == 1) {
+        std::copy(row_ins.front(), row_ins.front() + num_cols, row_out);
+        return;
+      }
+      for (int64_t begin = 0; begin < num_cols; begin += kChunkSize) {
+        const int64_t size = std::min(kChunkSize, num_cols - begin);
+        T* chunk_out = row_out + begin;
+        const T* a = row_ins.at(0) + begin;
+        const T* b = row_ins.at(1) + begin;
+        for (int64_t k = 0; k < size; ++k) { chunk_out[k] = a[k] + b[k]; }
+        FOR_RANGE(int64_t, j, 2, num_box_ins) {
+          const T* c = row_ins.at(j) + begin;
+          for (int64_t k = 0; k < size; ++k) { chunk_out[k] += c[k]; }
+        }
+      }
+    });
+  });
+}
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_CPU_SLICE_BOXING_PLAN_H_
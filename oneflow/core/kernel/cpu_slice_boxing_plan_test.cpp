@@ -0,0 +1,134 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/core/kernel/cpu_slice_boxing_plan.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+std::vector<Range> GetRanges(const std::vector<std::pair<int64_t, int64_t>>& bounds) {
+  std::vector<Range> ranges;
+  for (const auto& pair : bounds) { ranges.emplace_back(pair.first, pair.second); }
+  return ranges;
+}
+
+// the offset in slice of the elem at index of the whole tensor, or -1 if slice does not hold it
+int64_t GetOffsetInSlice(const TensorSliceView& slice, const std::vector<int64_t>& index) {
+  int64_t offset = 0;
+  FOR_RANGE(int64_t, axis, 0, index.size()) {
+    const Range& range = slice.At(axis);
+    if (index.at(axis) < range.begin() || index.at(axis) >= range.end()) { return -1; }
+    offset = offset * range.size() + index.at(axis) - range.begin();
+  }
+  return offset;
+}
+
+void TestCpuSliceBoxing(const TensorSliceView& out_slice,
+                        const std::vector<TensorSliceView>& in_slices, bool is_add) {
+  std::vector<std::vector<float>> ins;
+  FOR_RANGE(int64_t, i, 0, in_slices.size()) {
+    ins.emplace_back(in_slices.at(i).shape().elem_cnt());
+    FOR_RANGE(int64_t, j, 0, ins.back().size()) { ins.back().at(j) = i * 7 + j % 1001; }
+  }
+  const int64_t num_axes = out_slice.NumAxes();
+  std::vector<float> expected(out_slice.shape().elem_cnt(), -1);
+  std::vector<int64_t> index(num_axes);
+  FOR_RANGE(int64_t, out_offset, 0, expected.size()) {
+    int64_t rest = out_offset;
+    for (int64_t axis = num_axes - 1; axis >= 0; --axis) {
+      index.at(axis) = out_slice.At(axis).begin() + rest % out_slice.At(axis).size();
+      rest /= out_slice.At(axis).size();
+    }
+    if (is_add) { expected.at(out_offset) = 0; }
+    FOR_RANGE(int64_t, i, 0, in_slices.size()) {
+      const int64_t in_offset = GetOffsetInSlice(in_slices.at(i), index);
+      if (in_offset == -1) { continue; }
+      if (is_add) {
+        expected.at(out_offset) += ins.at(i).at(in_offset);
+      } else {
+        expected.at(out_offset) = ins.at(i).at(in_offset);
+      }
+    }
+  }
+  std::vector<float> out(expected.size(), -1);
+  CpuSliceBoxingPlan plan(out_slice, in_slices, DataType::kFloat, is_add);
+  if (is_add) {
+    std::vector<const float*> in_ptrs;
+    for (const auto& in : ins) { in_ptrs.push_back(in.data()); }
+    plan.Add<float>(out.data(), in_ptrs);
+  } else {
+    std::vector<const void*> in_ptrs;
+    for (const auto& in : ins) { in_ptrs.push_back(in.data()); }
+    plan.Copy(out.data(), in_ptrs);
+  }
+  ASSERT_TRUE(out == expected);
+}
+
+void ForEachCpuSliceBoxing(
+    const std::function<void(const TensorSliceView&, const std::vector<TensorSliceView>&)>&
+        Handler) {
+  // split(0) -> split(1)
+  Handler(TensorSliceView(GetRanges({{0, 8}, {0, 3}})),
+          {TensorSliceView(GetRanges({{0, 4}, {0, 6}})),
+           TensorSliceView(GetRanges({{4, 8}, {0, 6}}))});
+  // broadcast -> split(1), of uneven parts
+  Handler(TensorSliceView(GetRanges({{0, 5}, {3, 7}, {0, 9}})),
+          {TensorSliceView(GetRanges({{0, 5}, {0, 7}, {0, 9}}))});
+  // split(1) -> split(0), of which the boxes merge the last two axes
+  Handler(TensorSliceView(GetRanges({{2, 4}, {0, 6}, {0, 5}})),
+          {TensorSliceView(GetRanges({{0, 4}, {0, 2}, {0, 5}})),
+           TensorSliceView(GetRanges({{0, 4}, {2, 3}, {0, 5}})),
+           TensorSliceView(GetRanges({{0, 4}, {3, 6}, {0, 5}}))});
+  // in slices that overlap, leave holes in out, or do not intersect out
+  Handler(TensorSliceView(GetRanges({{0, 6}, {0, 6}})),
+          {TensorSliceView(GetRanges({{0, 4}, {0, 4}})),
+           TensorSliceView(GetRanges({{2, 6}, {1, 3}})),
+           TensorSliceView(GetRanges({{6, 8}, {0, 6}})),
+           TensorSliceView(GetRanges({{1, 5}, {3, 6}}))});
+  // large enough to run on the threads, by rows and by cutting the rows
+  Handler(TensorSliceView(GetRanges({{0, 1024}, {1024, 3072}})),
+          {TensorSliceView(GetRanges({{0, 512}, {0, 4096}})),
+           TensorSliceView(GetRanges({{512, 1024}, {0, 4096}}))});
+  Handler(TensorSliceView(GetRanges({{0, 2}, {0, 2 * 1024 * 1024}})),
+          {TensorSliceView(GetRanges({{0, 2}, {0, 1024 * 1024 + 3}})),
+           TensorSliceView(GetRanges({{0, 2}, {1024 * 1024 + 3, 2 * 1024 * 1024}}))});
+}
+
+void TestAllCpuSliceBoxing() {
+  ForEachCpuSliceBoxing(
+      [](const TensorSliceView& out_slice, const std::vector<TensorSliceView>& in_slices) {
+        TestCpuSliceBoxing(out_slice, in_slices, false);
+        TestCpuSliceBoxing(out_slice, in_slices, true);
+      });
+}
+
+}  // namespace
+
+TEST(CpuSliceBoxingPlan, single_thread) { TestAllCpuSliceBoxing(); }
+
+TEST(CpuSliceBoxingPlan, multi_thread) {
+  Global<ThreadPool>::New(4);
+  TestAllCpuSliceBoxing();
+  Global<ThreadPool>::Delete();
+}
+
+}  // namespace test
+
+}  // namespace oneflow
@@ -14,7 +14,6 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/core/kernel/kernel.h"
-#include "oneflow/core/kernel/kernel_helper.h"
 #include "oneflow/core/kernel/runtime_blob_shape_infer_helper.h"
 #include "oneflow/core/profiler/profiler.h"
 #include "oneflow/core/profiler/kernel.h"
@@ -25,28 +24,71 @@ Kernel::~Kernel() {
   if (shape_infer_helper_ != nullptr) { delete shape_infer_helper_; }
 }
 
+Blob* SlotBnInOp2Blob::operator()(const std::string& bn_in_op) const {
+  const int64_t slot = kernel_->Slot4BnInOp(bn_in_op);
+  if (slot == -1) { return nullptr; }
+  return Blob4Slot(slot);
+}
+
 void Kernel::InitBase(const JobDesc* job_desc, const KernelConf& kernel_conf) {
   if (!(job_desc_ == nullptr || shape_infer_helper_ == nullptr)) { return; }
   job_desc_ = job_desc;
   kernel_conf_ = kernel_conf;
   shape_infer_helper_ =
       new RuntimeBlobShapeInferHelper(this->op_conf(), this->kernel_conf(), &this->job_desc());
+  InitSlots();
+}
+
+void Kernel::InitSlots() {
+  for (const auto& pair : op_attribute().arg_signature().bn_in_op2lbi()) {
+    CHECK(bn_in_op2slot_.emplace(pair.first, slot2bn_in_op_.size()).second);
+    slot2bn_in_op_.push_back(pair.first);
+  }
+  const auto& modifier_map = op_attribute().arg_modifier_signature().obn2output_blob_modifier();
+  for (const std::string& obn : op_attribute().output_bns()) {
+    OutputSlot output_slot;
+    output_slot.obn = obn;
+    output_slot.slot = bn_in_op2slot_.at(obn);
+    output_slot.header_infered_before_compute =
+        modifier_map.at(obn).header_infered_before_compute();
+    output_slot.is_mutable = modifier_map.at(obn).is_mutable();
+    output_slots_.push_back(output_slot);
+  }
 }
 
 void Kernel::Init(const JobDesc* job_desc, const KernelConf& kernel_conf, DeviceCtx* device_ctx) {
+  InitWithoutDevice(job_desc, kernel_conf);
+  InitDevice(device_ctx);
+}
+
+void Kernel::InitWithoutDevice(const JobDesc* job_desc, const KernelConf& kernel_conf) {
   InitBase(job_desc, kernel_conf);
-  VirtualKernelInit(device_ctx);
 }
 
-void Kernel::Launch(const KernelCtx& ctx,
-                    std::function<Blob*(const std::string&)> BnInOp2Blob) const {
-  Forward(ctx, BnInOp2Blob);
+void Kernel::InitDevice(DeviceCtx* device_ctx) { VirtualKernelInit(device_ctx); }
+
+void Kernel::Launch(const KernelCtx& ctx, const std::vector<Blob*>& slot2blob) const {
+  CHECK_EQ(slot2blob.size(), slot2bn_in_op_.size());
+  Forward(ctx, SlotBnInOp2Blob(this, &slot2blob));
 }
 
 const LogicalBlobId& Kernel::BnInOp2Lbi(const std::string& bn_in_op) const {
   return op_attribute().arg_signature().bn_in_op2lbi().at(bn_in_op);
 }
 
+int64_t Kernel::Slot4BnInOp(const std::string& bn_in_op) const {
+  const auto it = bn_in_op2slot_.find(bn_in_op);
+  if (it == bn_in_op2slot_.end()) { return -1; }
+  return it->second;
+}
+
+const SlotBnInOp2Blob* Kernel::GetSlotBnInOp2Blob(
+    const std::function<Blob*(const std::string&)>& BnInOp2Blob) const {
+  const SlotBnInOp2Blob* slot_bn_in_op2blob = BnInOp2Blob.target<SlotBnInOp2Blob>();
+  if (slot_bn_in_op2blob == nullptr || slot_bn_in_op2blob->kernel() != this) { return nullptr; }
+  return slot_bn_in_op2blob;
+}
+
 void Kernel::CheckSameDim0ValidNum(
     const PbRpf<std::string>& bns,
     const std::function<Blob*(const std::string&)>& BnInOp2Blob) const {
@@ -55,43 +97,51 @@ void Kernel::CheckSameDim0ValidNum(
 
 void Kernel::SetOutputBlobProducerInferAccessChecker(
     std::function<Blob*(const std::string&)> BnInOp2Blob) const {
-  ForEachObnAndIsHeaderInferedBeforeCompute(BnInOp2Blob, [&](const std::string& obn, bool _) {
-    BnInOp2Blob(obn)->set_blob_access_checker(Global<BlobAccessCheckerIf<true, false>>::Get());
+  ForEachOutputBlob(BnInOp2Blob, [&](const OutputSlot& output_slot, Blob* blob) {
+    blob->set_blob_access_checker(Global<BlobAccessCheckerIf<true, false>>::Get());
   });
 }
 
 void Kernel::SetOutputBlobProducerComputeAccessChecker(
     std::function<Blob*(const std::string&)> BnInOp2Blob) const {
-  ForEachObnAndIsHeaderInferedBeforeCompute(
-      BnInOp2Blob, [&](const std::string& obn, bool is_header_infered_before_compute) {
-        const BlobAccessChecker* checker = nullptr;
-        if (is_header_infered_before_compute) {
-          checker = Global<BlobAccessCheckerIf<false, true>>::Get();
-        } else {
-          checker = Global<BlobAccessCheckerIf<true, true>>::Get();
-        }
-        BnInOp2Blob(obn)->set_blob_access_checker(checker);
-      });
+  ForEachOutputBlob(BnInOp2Blob, [&](const OutputSlot& output_slot, Blob* blob) {
+    const BlobAccessChecker* checker = nullptr;
+    if (output_slot.header_infered_before_compute) {
+      checker = Global<BlobAccessCheckerIf<false, true>>::Get();
+    } else {
+      checker = Global<BlobAccessCheckerIf<true, true>>::Get();
+    }
+    blob->set_blob_access_checker(checker);
+  });
 }
 
 void Kernel::SetOutputBlobConsumerAccessChecker(
     std::function<Blob*(const std::string&)> BnInOp2Blob) const {
-  ForEachObnAndIsMutableByConsumer(BnInOp2Blob, [&](const std::string& obn, bool is_mutable) {
+  ForEachOutputBlob(BnInOp2Blob, [&](const OutputSlot& output_slot, Blob* blob) {
     const BlobAccessChecker* checker = nullptr;
-    if (is_mutable) {
+    if (output_slot.is_mutable) {
       checker = Global<BlobAccessCheckerIf<false, true>>::Get();
     } else {
       checker = Global<BlobAccessCheckerIf<false, false>>::Get();
     }
-    BnInOp2Blob(obn)->set_blob_access_checker(checker);
+    blob->set_blob_access_checker(checker);
   });
 }
 
+bool Kernel::IsAllOutputBlobEmpty(
+    const std::function<Blob*(const std::string&)>& BnInOp2Blob) const {
+  bool is_all_empty = true;
+  ForEachOutputBlob(BnInOp2Blob, [&](const OutputSlot& output_slot, Blob* blob) {
+    if (!blob->IsBodyEmpty()) { is_all_empty = false; }
+  });
+  return is_all_empty;
+}
+
 void Kernel::Forward(const KernelCtx& ctx,
                      std::function<Blob*(const std::string&)> BnInOp2Blob) const {
   SetOutputBlobProducerInferAccessChecker(BnInOp2Blob);
   ForwardHeader(ctx, BnInOp2Blob);
-  if (IsAllBlobEmpty(op_attribute().output_bns(), BnInOp2Blob) && IsStateless()) { return; }
+  if (IsAllOutputBlobEmpty(BnInOp2Blob) && IsStateless()) { return; }
   SetOutputBlobProducerComputeAccessChecker(BnInOp2Blob);
   OF_PROFILER_ONLY_CODE(profiler::TraceKernelForwardDataContentStart(this, ctx, BnInOp2Blob));
   ForwardDataContent(ctx, BnInOp2Blob);
@@ -111,12 +161,19 @@ void Kernel::ForwardShape(const KernelCtx& ctx,
 
 std::unique_ptr<const Kernel> ConstructKernel(const JobDesc* job_desc, const KernelConf& conf,
                                               DeviceCtx* device_ctx) {
+  std::unique_ptr<Kernel> kernel = ConstructKernelWithoutDevice(job_desc, conf);
+  kernel->InitDevice(device_ctx);
+  return std::unique_ptr<const Kernel>(kernel.release());
+}
+
+std::unique_ptr<Kernel> ConstructKernelWithoutDevice(const JobDesc* job_desc,
+                                                     const KernelConf& conf) {
   auto op_type = conf.op_attribute().op_conf().op_type_case();
   Kernel* rptr = kernel_registration::CreateKernel(conf);
   if (rptr == nullptr) { rptr = NewObj<int32_t, Kernel>(op_type, conf); }
   CHECK_NOTNULL(rptr);
-  rptr->Init(job_desc, conf, device_ctx);
-  return std::unique_ptr<const Kernel>(rptr);
+  rptr->InitWithoutDevice(job_desc, conf);
+  return std::unique_ptr<Kernel>(rptr);
 }
 
 #define INSTANTIATE_KERNEL_IF(device_type) template class KernelIf<device_type>;
@@ -31,6 +31,25 @@ limitations under the License.
 namespace oneflow {
 
 class RuntimeBlobShapeInferHelper;
+class Kernel;
+
+// The BnInOp2Blob of a launch by slot. The kernel numbers the bns of its op with slots at init and
+// is launched with the blobs of the slots, so a bn is resolved with one lookup of its slot instead
+// of going through the regsts of the actor. Kernels in the hot path get it back from BnInOp2Blob
+// with Kernel::GetSlotBnInOp2Blob and read the blobs by slot, with no lookup at all
+class SlotBnInOp2Blob final {
+ public:
+  SlotBnInOp2Blob(const Kernel* kernel, const std::vector<Blob*>* slot2blob)
+      : kernel_(kernel), slot2blob_(slot2blob) {}
+
+  Blob* operator()(const std::string& bn_in_op) const;
+  Blob* Blob4Slot(int64_t slot) const { return (*slot2blob_)[slot]; }
+  const Kernel* kernel() const { return kernel_; }
+
+ private:
+  const Kernel* kernel_;
+  const std::vector<Blob*>* slot2blob_;
+};
 
 class Kernel {
  public:
@@ -40,10 +59,21 @@ class Kernel {
   const JobDesc& job_desc() const { return *job_desc_; }
 
   void Init(const JobDesc* job_desc, const KernelConf&, DeviceCtx*);
+  // Init in two steps. InitDevice builds what the kernel computes with, e.g. the cudnn handles or
+  // the OpKernelState of a user kernel, and the kernel can't be launched until then
+  void InitWithoutDevice(const JobDesc* job_desc, const KernelConf&);
+  void InitDevice(DeviceCtx*);
 
-  void Launch(const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob) const;
+  // slot2blob holds the blob of every slot, nullptr if there is none
+  void Launch(const KernelCtx& ctx, const std::vector<Blob*>& slot2blob) const;
 
   const LogicalBlobId& BnInOp2Lbi(const std::string& bn_in_op) const;
+  // -1 if the op has no such bn
+  int64_t Slot4BnInOp(const std::string& bn_in_op) const;
+  const std::vector<std::string>& slot2bn_in_op() const { return slot2bn_in_op_; }
+  // nullptr unless BnInOp2Blob is the SlotBnInOp2Blob of a launch of this kernel
+  const SlotBnInOp2Blob* GetSlotBnInOp2Blob(
+      const std::function<Blob*(const std::string&)>& BnInOp2Blob) const;
   const OperatorConf& op_conf() const { return op_attribute().op_conf(); }
   const OpAttribute& op_attribute() const { return kernel_conf().op_attribute(); }
   /*
@@ -78,35 +108,27 @@ class Kernel {
   virtual void VirtualKernelInit() {}
   const KernelConf& kernel_conf() const { return kernel_conf_; }
 
-  template<typename HandlerT>
-  void ForEachObnAndIsHeaderInferedBeforeCompute(
-      std::function<Blob*(const std::string&)> BnInOp2Blob, const HandlerT& Handler) const {
-    const auto& modifier_map =
-        this->kernel_conf_.op_attribute().arg_modifier_signature().obn2output_blob_modifier();
-    for (const std::string& obn : this->op_attribute().output_bns()) {
-      Blob* blob = BnInOp2Blob(obn);
-      if (blob) {
-        bool is_header_infered_before_compute =
-            modifier_map.at(obn).header_infered_before_compute();
-        Handler(obn, is_header_infered_before_compute);
-      }
-    }
-  }
+  struct OutputSlot {
+    std::string obn;
+    int64_t slot;
+    bool header_infered_before_compute;
+    bool is_mutable;
+  };
 
+  // Handler(output_slot, blob) for the outputs with a blob
   template<typename HandlerT>
-  void ForEachObnAndIsMutableByConsumer(std::function<Blob*(const std::string&)> BnInOp2Blob,
-                                        const HandlerT& Handler) const {
-    const auto& modifier_map =
-        this->kernel_conf_.op_attribute().arg_modifier_signature().obn2output_blob_modifier();
-    for (const std::string& obn : this->op_attribute().output_bns()) {
-      Blob* blob = BnInOp2Blob(obn);
-      if (blob) {
-        bool is_mutable_by_consumer = modifier_map.at(obn).is_mutable();
-        Handler(obn, is_mutable_by_consumer);
-      }
+  void ForEachOutputBlob(const std::function<Blob*(const std::string&)>& BnInOp2Blob,
+                         const HandlerT& Handler) const {
+    const SlotBnInOp2Blob* slot_bn_in_op2blob = GetSlotBnInOp2Blob(BnInOp2Blob);
+    for (const OutputSlot& output_slot : output_slots_) {
+      Blob* blob = slot_bn_in_op2blob ? slot_bn_in_op2blob->Blob4Slot(output_slot.slot)
+                                      : BnInOp2Blob(output_slot.obn);
+      if (blob) { Handler(output_slot, blob); }
     }
   }
 
+  bool IsAllOutputBlobEmpty(const std::function<Blob*(const std::string&)>& BnInOp2Blob) const;
+
   virtual void ForwardHeader(const KernelCtx& ctx,
                              std::function<Blob*(const std::string&)> BnInOp2Blob) const;
   virtual void ForwardShape(const KernelCtx& ctx,
@@ -122,9 +144,14 @@ class Kernel {
                              const std::function<Blob*(const std::string&)>& BnInOp2Blob) const;
 
  private:
+  void InitSlots();
+
   const JobDesc* job_desc_;
   RuntimeBlobShapeInferHelper* shape_infer_helper_;
   KernelConf kernel_conf_;
+  HashMap<std::string, int64_t> bn_in_op2slot_;
+  std::vector<std::string> slot2bn_in_op_;
+  std::vector<OutputSlot> output_slots_;
 };
 
 template<DeviceType device_type>
@@ -169,6 +196,8 @@ class KernelIf : public Kernel {
 
 std::unique_ptr<const Kernel> ConstructKernel(const JobDesc* job_desc, const KernelConf&,
                                               DeviceCtx*);
+// Kernel::InitDevice must be called before it is launched
+std::unique_ptr<Kernel> ConstructKernelWithoutDevice(const JobDesc* job_desc, const KernelConf&);
 
 }  // namespace oneflow
 
@@ -17,6 +17,7 @@ limitations under the License.
 #include "oneflow/core/common/balanced_splitter.h"
 #include "oneflow/core/register/register_manager.h"
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/kernel/philox_random.h"
 #include "oneflow/core/memory/memory_case.pb.h"
 
 namespace oneflow {
@@ -28,9 +29,7 @@ void RngUniform(const int64_t elem_cnt, const T min, const T max, uint32_t rando
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_LE(min, max);
-  std::mt19937 generator(random_seed);
-  std::uniform_real_distribution<T> random_distribution(min, std::nextafter(max, GetMaxVal<T>()));
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(generator); }
+  PhiloxUniform<T>(random_seed, 0, elem_cnt, min, max, dptr);
 }
 
 template<typename T>
@@ -49,10 +48,7 @@ void RngNormal(const int64_t elem_cnt, const T mean, const T std, uint32_t rando
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_GT(std, 0.0);
-  std::mt19937 generator(random_seed);
-  std::normal_distribution<T> random_distribution(mean, std);
-
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(generator); }
+  PhiloxNormal<T>(random_seed, 0, elem_cnt, mean, std, dptr);
 }
 
 template<typename T>
@@ -61,17 +57,7 @@ void RngTruncatedNormal(const int64_t elem_cnt, const T mean, const T std, uint3
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_GT(std, 0.0);
-  T truncated_value = 2 * std;
-  std::mt19937 generator(random_seed);
-  std::normal_distribution<T> random_distribution(mean, std);
-  int64_t index = 0;
-  while (true) {
-    T val = random_distribution(generator);
-    if (std::abs(val - mean) < truncated_value) {
-      dptr[index++] = val;
-      if (index >= elem_cnt) { break; }
-    }
-  }
+  PhiloxTruncatedNormal<T>(random_seed, elem_cnt, mean, std, dptr);
 }
 
 template<typename T>
@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/kernel/kernel.h"
+#include "oneflow/core/kernel/variable_write_count.h"
 #include "oneflow/core/register/tensor_slice_copier.h"
 #include "oneflow/core/device/cpu_device_context.h"
 #include "oneflow/core/common/nd_index_offset_helper.h"
@@ -267,6 +268,7 @@ class ModelInitV2Kernel final : public KernelIf<device_type> {
         UNIMPLEMENTED();
       }
     }
+    IncreaseVariableWriteCount();
   }
 
   std::vector<int64_t> seeds_;
@@ -321,6 +323,7 @@ class ModelLoadV2Kernel final : public KernelIf<device_type> {
       AutoSyncBlobAccessor<device_type> ref_accessor(ctx.device_ctx, ref, false, true);
       reader.Read(var_lbn, logical_blob_shape, tensor_slice_views_.at(i), ref_accessor.host_blob());
     }
+    IncreaseVariableWriteCount();
   }
   std::vector<TensorSliceView> tensor_slice_views_;
 };
@@ -0,0 +1,224 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/philox_random.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+// Counters generated before a batch is transformed, so that the transform runs as a plain loop
+// over contiguous values and the log, sqrt and sin/cos of Box-Muller get vectorized
+constexpr int64_t kCountersPerBatch = 16;
+// Fills smaller than this many counters per thread are not worth a trip through the thread pool
+constexpr int64_t kMinCountersPerPart = 16384;
+constexpr int64_t kMinTruncatedNormalElemsPerPart = 4096;
+
+// Uniform in [0, 1) from the top 24 bits
+float ToUniformFloat(uint32_t x) { return (x >> 8) * (1.0f / 16777216.0f); }
+
+// Uniform in [0, 1) from the top 53 bits of two values
+double ToUniformDouble(uint32_t hi, uint32_t lo) {
+  return (((static_cast<uint64_t>(hi) << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+template<typename T>
+struct UniformTransform;
+
+template<>
+struct UniformTransform<float> {
+  enum { kValuesPerCounter = 4 };
+  float min;
+  float range;
+  void operator()(const uint32_t* raw, int64_t n, float* out) const {
+    FOR_RANGE(int64_t, i, 0, n) { out[i] = min + range * ToUniformFloat(raw[i]); }
+  }
+};
+
+template<>
+struct UniformTransform<double> {
+  enum { kValuesPerCounter = 2 };
+  double min;
+  double range;
+  void operator()(const uint32_t* raw, int64_t n, double* out) const {
+    FOR_RANGE(int64_t, i, 0, n) {
+      out[i] = min + range * ToUniformDouble(raw[2 * i], raw[2 * i + 1]);
+    }
+  }
+};
+
+// Box-Muller on n / 2 pairs of uniforms, u1 taken from (0, 1] to keep the log finite
+template<typename T>
+void BoxMuller(const T* u1, const T* u2, int64_t n, T mean, T std, T* out) {
+  const T two_pi = static_cast<T>(2.0 * M_PI);
+  FOR_RANGE(int64_t, i, 0, n / 2) {
+    const T radius = std * std::sqrt(static_cast<T>(-2) * std::log(1 - u1[i]));
+    const T theta = two_pi * u2[i];
+    out[2 * i] = mean + radius * std::cos(theta);
+    out[2 * i + 1] = mean + radius * std::sin(theta);
+  }
+}
+
+template<typename T>
+struct NormalTransform;
+
+template<>
+struct NormalTransform<float> {
+  enum { kValuesPerCounter = 4 };
+  float mean;
+  float std;
+  void operator()(const uint32_t* raw, int64_t n, float* out) const {
+    float u1[kCountersPerBatch * 2];
+    float u2[kCountersPerBatch * 2];
+    FOR_RANGE(int64_t, i, 0, n / 2) {
+      u1[i] = ToUniformFloat(raw[2 * i]);
+      u2[i] = ToUniformFloat(raw[2 * i + 1]);
+    }
+    BoxMuller(u1, u2, n, mean, std, out);
+  }
+};
+
+template<>
+struct NormalTransform<double> {
+  enum { kValuesPerCounter = 2 };
+  double mean;
+  double std;
+  void operator()(const uint32_t* raw, int64_t n, double* out) const {
+    double u1[kCountersPerBatch];
+    double u2[kCountersPerBatch];
+    FOR_RANGE(int64_t, i, 0, n / 2) {
+      u1[i] = ToUniformDouble(raw[4 * i], raw[4 * i + 1]);
+      u2[i] = ToUniformDouble(raw[4 * i + 2], raw[4 * i + 3]);
+    }
+    BoxMuller(u1, u2, n, mean, std, out);
+  }
+};
+
+struct BernoulliMaskTransform {
+  enum { kValuesPerCounter = 4 };
+  float rate;
+  void operator()(const uint32_t* raw, int64_t n, int8_t* out) const {
+    FOR_RANGE(int64_t, i, 0, n) { out[i] = ToUniformFloat(raw[i]) >= rate; }
+  }
+};
+
+void ParallelForEachRange(int64_t num, int64_t min_num_per_part,
+                          const std::function<void(int64_t begin, int64_t end)>& Handler) {
+  if (num < 2 * min_num_per_part) {
+    Handler(0, num);
+    return;
+  }
+  const int64_t num_parts =
+      std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(), num / min_num_per_part);
+  const BalancedSplitter bs(num, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    Handler(range.begin(), range.end());
+  });
+}
+
+// Counter i of the fill yields values [i * kValuesPerCounter, (i + 1) * kValuesPerCounter)
+template<typename T, typename Transform>
+uint64_t PhiloxFill(uint64_t seed, uint64_t offset, int64_t elem_cnt, const Transform& transform,
+                    T* dptr) {
+  CHECK_GE(elem_cnt, 0);
+  const int64_t values_per_counter = Transform::kValuesPerCounter;
+  const int64_t counter_num = (elem_cnt + values_per_counter - 1) / values_per_counter;
+  ParallelForEachRange(counter_num, kMinCountersPerPart, [&](int64_t begin, int64_t end) {
+    PhiloxRandom generator(seed, 0, offset + begin);
+    uint32_t raw[kCountersPerBatch * 4];
+    T values[kCountersPerBatch * 4];
+    for (int64_t counter_id = begin; counter_id < end; counter_id += kCountersPerBatch) {
+      const int64_t batch_counter_num = std::min(kCountersPerBatch, end - counter_id);
+      FOR_RANGE(int64_t, i, 0, batch_counter_num) { generator.Next(raw + i * 4); }
+      const int64_t value_offset = counter_id * values_per_counter;
+      const int64_t value_num =
+          std::min(batch_counter_num * values_per_counter, elem_cnt - value_offset);
+      transform(raw, batch_counter_num * values_per_counter, values);
+      std::copy(values, values + value_num, dptr + value_offset);
+    }
+  });
+  return offset + counter_num;
+}
+
+}  // namespace
+
+template<typename T>
+uint64_t PhiloxUniform(uint64_t seed, uint64_t offset, int64_t elem_cnt, T min, T max, T* dptr) {
+  CHECK_LE(min, max);
+  UniformTransform<T> transform;
+  transform.min = min;
+  transform.range = max - min;
+  return PhiloxFill(seed, offset, elem_cnt, transform, dptr);
+}
+
+template<typename T>
+uint64_t PhiloxNormal(uint64_t seed, uint64_t offset, int64_t elem_cnt, T mean, T std, T* dptr) {
+  CHECK_GT(std, 0.0);
+  NormalTransform<T> transform;
+  transform.mean = mean;
+  transform.std = std;
+  return PhiloxFill(seed, offset, elem_cnt, transform, dptr);
+}
+
+uint64_t PhiloxBernoulliMask(uint64_t seed, uint64_t offset, int64_t elem_cnt, float rate,
+                             int8_t* mask) {
+  BernoulliMaskTransform transform;
+  transform.rate = rate;
+  return PhiloxFill(seed, offset, elem_cnt, transform, mask);
+}
+
+template<typename T>
+void PhiloxTruncatedNormal(uint64_t seed, int64_t elem_cnt, T mean, T std, T* dptr) {
+  CHECK_GE(elem_cnt, 0);
+  CHECK_GT(std, 0.0);
+  const T truncated_value = 2 * std;
+  NormalTransform<T> transform;
+  transform.mean = mean;
+  transform.std = std;
+  const int64_t values_per_counter = NormalTransform<T>::kValuesPerCounter;
+  ParallelForEachRange(elem_cnt, kMinTruncatedNormalElemsPerPart, [&](int64_t begin, int64_t end) {
+    uint32_t raw[4];
+    T values[4];
+    FOR_RANGE(int64_t, i, begin, end) {
+      PhiloxRandom generator(seed, i, 0);
+      bool is_accepted = false;
+      while (!is_accepted) {
+        generator.Next(raw);
+        transform(raw, values_per_counter, values);
+        FOR_RANGE(int64_t, j, 0, values_per_counter) {
+          if (std::abs(values[j] - mean) < truncated_value) {
+            dptr[i] = values[j];
+            is_accepted = true;
+            break;
+          }
+        }
+      }
+    }
+  });
+}
+
+#define INSTANTIATE_PHILOX_FILL(T, type_proto)                                                \
+  template uint64_t PhiloxUniform<T>(uint64_t seed, uint64_t offset, int64_t elem_cnt, T min, \
+                                     T max, T* dptr);                                         \
+  template uint64_t PhiloxNormal<T>(uint64_t seed, uint64_t offset, int64_t elem_cnt, T mean, \
+                                    T std, T* dptr);                                          \
+  template void PhiloxTruncatedNormal<T>(uint64_t seed, int64_t elem_cnt, T mean, T std, T* dptr);
+
+OF_PP_FOR_EACH_TUPLE(INSTANTIATE_PHILOX_FILL, FLOATING_DATA_TYPE_SEQ);
+
+}  // namespace oneflow
@@ -0,0 +1,105 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
+#define ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
+
+#include "oneflow/core/common/util.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2,
+// 3", SC'11), laid out like curand's Philox4_32_10: the key is the seed, the low half of the
+// counter is the offset in units of 4 values and the high half is the subsequence. Any position of
+// a stream is reachable in O(1), which is what makes parallel and resumable generation possible
+class PhiloxRandom final {
+ public:
+  OF_DEVICE_FUNC PhiloxRandom(uint64_t seed, uint64_t subsequence, uint64_t offset) {
+    key_[0] = static_cast<uint32_t>(seed);
+    key_[1] = static_cast<uint32_t>(seed >> 32);
+    counter_[0] = static_cast<uint32_t>(offset);
+    counter_[1] = static_cast<uint32_t>(offset >> 32);
+    counter_[2] = static_cast<uint32_t>(subsequence);
+    counter_[3] = static_cast<uint32_t>(subsequence >> 32);
+  }
+
+  // Writes the 4 values of the current counter and moves to the next one
+  OF_DEVICE_FUNC void Next(uint32_t* out) {
+    uint32_t ctr[4] = {counter_[0], counter_[1], counter_[2], counter_[3]};
+    uint32_t key[2] = {key_[0], key_[1]};
+    for (int32_t round = 0; round < 10; ++round) {
+      if (round > 0) {
+        key[0] += kPhiloxW32A;
+        key[1] += kPhiloxW32B;
+      }
+      const uint64_t prod0 = static_cast<uint64_t>(kPhiloxM4x32A) * ctr[0];
+      const uint64_t prod1 = static_cast<uint64_t>(kPhiloxM4x32B) * ctr[2];
+      const uint32_t hi0 = static_cast<uint32_t>(prod0 >> 32);
+      const uint32_t lo0 = static_cast<uint32_t>(prod0);
+      const uint32_t hi1 = static_cast<uint32_t>(prod1 >> 32);
+      const uint32_t lo1 = static_cast<uint32_t>(prod1);
+      ctr[0] = hi1 ^ ctr[1] ^ key[0];
+      ctr[1] = lo1;
+      ctr[2] = hi0 ^ ctr[3] ^ key[1];
+      ctr[3] = lo0;
+    }
+    out[0] = ctr[0];
+    out[1] = ctr[1];
+    out[2] = ctr[2];
+    out[3] = ctr[3];
+    Skip(1);
+  }
+
+  OF_DEVICE_FUNC void Skip(uint64_t count) {
+    const uint64_t offset = ((static_cast<uint64_t>(counter_[1]) << 32) | counter_[0]) + count;
+    counter_[0] = static_cast<uint32_t>(offset);
+    counter_[1] = static_cast<uint32_t>(offset >> 32);
+  }
+
+ private:
+  static const uint32_t kPhiloxM4x32A = 0xD2511F53;
+  static const uint32_t kPhiloxM4x32B = 0xCD9E8D57;
+  static const uint32_t kPhiloxW32A = 0x9E3779B9;
+  static const uint32_t kPhiloxW32B = 0xBB67AE85;
+
+  uint32_t key_[2];
+  uint32_t counter_[4];
+};
+
+// The fills below are a pure function of (seed, offset, element index), so the output does not
+// depend on how the work is split across threads. They start at counter `offset` of subsequence 0
+// and return the offset just past the last counter used, for generators that keep a stream going
+
+// Uniform in [min, max)
+template<typename T>
+uint64_t PhiloxUniform(uint64_t seed, uint64_t offset, int64_t elem_cnt, T min, T max, T* dptr);
+
+// Normal via Box-Muller
+template<typename T>
+uint64_t PhiloxNormal(uint64_t seed, uint64_t offset, int64_t elem_cnt, T mean, T std, T* dptr);
+
+// mask[i] = uniform(0, 1) >= rate, the same test as the gpu dropout mask
+uint64_t PhiloxBernoulliMask(uint64_t seed, uint64_t offset, int64_t elem_cnt, float rate,
+                             int8_t* mask);
+
+// Normal redrawn until within 2 std of the mean. Element i draws from its own subsequence i, so a
+// rejection never shifts the values of other elements
+template<typename T>
+void PhiloxTruncatedNormal(uint64_t seed, int64_t elem_cnt, T mean, T std, T* dptr);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_PHILOX_RANDOM_H_
@@ -0,0 +1,98 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/kernel/philox_random.h"
+#include "oneflow/core/thread/thread_pool.h"
+
+namespace oneflow {
+
+namespace test {
+
+namespace {
+
+void CheckPhilox(uint64_t seed, uint64_t subsequence, uint64_t offset,
+                 const std::vector<uint32_t>& expected) {
+  PhiloxRandom generator(seed, subsequence, offset);
+  uint32_t out[4];
+  generator.Next(out);
+  FOR_RANGE(int32_t, i, 0, 4) { ASSERT_EQ(out[i], expected.at(i)); }
+}
+
+}  // namespace
+
+// known answers of Philox4x32-10 from Random123
+TEST(PhiloxRandom, known_answer) {
+  CheckPhilox(0, 0, 0, {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  CheckPhilox(0xffffffffffffffff, 0xffffffffffffffff, 0xffffffffffffffff,
+              {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+  CheckPhilox(0x299f31d0a4093822, 0x0370734413198a2e, 0x85a308d3243f6a88,
+              {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+
+TEST(PhiloxRandom, skip) {
+  PhiloxRandom generator(1234, 5, 0);
+  uint32_t out[4];
+  FOR_RANGE(int32_t, i, 0, 7) { generator.Next(out); }
+  PhiloxRandom skipped(1234, 5, 0);
+  skipped.Skip(7);
+  uint32_t skipped_out[4];
+  generator.Next(out);
+  skipped.Next(skipped_out);
+  FOR_RANGE(int32_t, i, 0, 4) { ASSERT_EQ(out[i], skipped_out[i]); }
+}
+
+TEST(PhiloxRandom, resume_from_offset) {
+  std::vector<float> whole(1000);
+  ASSERT_EQ(PhiloxUniform<float>(42, 0, whole.size(), -1, 1, whole.data()), 250);
+  std::vector<float> parts(1000);
+  const uint64_t offset = PhiloxUniform<float>(42, 0, 400, -1, 1, parts.data());
+  ASSERT_EQ(offset, 100);
+  PhiloxUniform<float>(42, offset, 600, -1, 1, parts.data() + 400);
+  ASSERT_TRUE(whole == parts);
+  for (float val : whole) {
+    ASSERT_GE(val, -1);
+    ASSERT_LT(val, 1);
+  }
+}
+
+TEST(PhiloxRandom, normal_moments) {
+  const int64_t elem_cnt = 100001;
+  std::vector<double> values(elem_cnt);
+  Global<ThreadPool>::New(4);
+  PhiloxNormal<double>(7, 0, elem_cnt, 3, 2, values.data());
+  Global<ThreadPool>::Delete();
+  double sum = 0;
+  double square_sum = 0;
+  for (double val : values) {
+    sum += val;
+    square_sum += val * val;
+  }
+  const double mean = sum / elem_cnt;
+  const double variance = square_sum / elem_cnt - mean * mean;
+  ASSERT_NEAR(mean, 3, 0.05);
+  ASSERT_NEAR(variance, 4, 0.1);
+}
+
+TEST(PhiloxRandom, truncated_normal_bound) {
+  std::vector<float> values(10000);
+  Global<ThreadPool>::New(4);
+  PhiloxTruncatedNormal<float>(7, values.size(), 0, 1, values.data());
+  Global<ThreadPool>::Delete();
+  for (float val : values) { ASSERT_LT(std::abs(val), 2); }
+}
+
+}  // namespace test
+
+}  // namespace oneflow
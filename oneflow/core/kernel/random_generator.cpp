@@ -15,6 +15,7 @@ limitations under the License.
 */
 #include "oneflow/core/kernel/random_generator.h"
 #include "oneflow/core/common/preprocessor.h"
+#include "oneflow/core/kernel/philox_random.h"
 
 namespace oneflow {
 
@@ -29,8 +30,7 @@ void RandomGenerator<DeviceType::kCPU>::Uniform(const int64_t elem_cnt, const T
   CHECK_GE(elem_cnt, 0);
   CHECK(dptr);
   CHECK_LE(min, max);
-  std::uniform_real_distribution<T> random_distribution(min, std::nextafter(max, GetMaxVal<T>()));
-  for (int64_t i = 0; i < elem_cnt; ++i) { dptr[i] = random_distribution(mt19937_generator_); }
+  offset_ = PhiloxUniform<T>(seed_, offset_, elem_cnt, min, max, dptr);
 }
 
 #define INITIATE_CPU_RANDOM_GENERATOR_UNIFORM(T, typeproto)                                        \
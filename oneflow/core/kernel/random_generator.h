@@ -31,7 +31,7 @@ template<>
 class RandomGenerator<DeviceType::kCPU> final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(RandomGenerator);
-  RandomGenerator(int64_t seed, DeviceCtx* device_ctx) : mt19937_generator_(seed) {}
+  RandomGenerator(int64_t seed, DeviceCtx* device_ctx) : seed_(seed), offset_(0) {}
   ~RandomGenerator() {}
 
   template<typename T>
@@ -40,7 +40,9 @@ class RandomGenerator<DeviceType::kCPU> final {
   void Uniform(const int64_t elem_cnt, const T min, const T max, T* dptr);
 
  private:
-  std::mt19937 mt19937_generator_;
+  uint64_t seed_;
+  // philox counter the next call starts from
+  uint64_t offset_;
 };
 
 template<>
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/device/memory_copier.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/core/kernel/slice_boxing_kernel_util.h"
+#include "oneflow/core/kernel/cpu_slice_boxing_plan.h"
 
 namespace oneflow {
 
@@ -32,12 +33,14 @@ class SliceBoxingKernel : public KernelIf<device_type> {
   virtual const SliceBoxingConf& GetCustomizedBoxingConf() const = 0;
   MemoryCopier* memory_copier() const;
   const std::vector<std::shared_ptr<TensorSliceCopier>>& tensor_slice_copier_vec() const;
+  const CpuSliceBoxingPlan& cpu_slice_boxing_plan() const;
 
  private:
   void VirtualKernelInit() override;
 
   std::vector<std::shared_ptr<TensorSliceCopier>> tensor_slice_copier_vec_;
   std::unique_ptr<MemoryCopier> memory_copier_;
+  std::unique_ptr<CpuSliceBoxingPlan> cpu_slice_boxing_plan_;
 };
 
 template<DeviceType device_type, typename T>
@@ -71,11 +74,18 @@ void SliceBoxingKernel<device_type, T>::VirtualKernelInit() {
   memory_copier_.reset(NewDefaultMemoryCopier(device_type));
   const SliceBoxingConf& conf = GetCustomizedBoxingConf();
   const TensorSliceView out_slice(conf.out_slice());
+  std::vector<TensorSliceView> in_slices;
   for (const TensorSliceViewProto& in_slice_proto : conf.in_slice()) {
     const TensorSliceView in_slice(in_slice_proto);
+    in_slices.push_back(in_slice);
     tensor_slice_copier_vec_.emplace_back(
         new TensorSliceCopier(out_slice, in_slice, this->kernel_conf().data_type()));
   }
+  if (device_type == DeviceType::kCPU) {
+    cpu_slice_boxing_plan_.reset(
+        new CpuSliceBoxingPlan(out_slice, in_slices, this->kernel_conf().data_type(),
+                               this->op_conf().has_slice_boxing_add_conf()));
+  }
 }
 
 template<DeviceType device_type, typename T>
@@ -89,6 +99,11 @@ SliceBoxingKernel<device_type, T>::tensor_slice_copier_vec() const {
   return tensor_slice_copier_vec_;
 }
 
+template<DeviceType device_type, typename T>
+const CpuSliceBoxingPlan& SliceBoxingKernel<device_type, T>::cpu_slice_boxing_plan() const {
+  return *cpu_slice_boxing_plan_;
+}
+
 template<DeviceType device_type, typename T>
 const SliceBoxingConf& SliceBoxingCopyKernel<device_type, T>::GetCustomizedBoxingConf() const {
   return this->op_conf().slice_boxing_copy_conf().slice_boxing_conf();
@@ -98,6 +113,14 @@ template<DeviceType device_type, typename T>
 void SliceBoxingCopyKernel<device_type, T>::ForwardDataContent(
     const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob) const {
   Blob* out = BnInOp2Blob("out");
+  if (device_type == DeviceType::kCPU) {
+    std::vector<const void*> in_ptrs;
+    FOR_RANGE(int64_t, i, 0, this->op_attribute().input_bns().size()) {
+      in_ptrs.push_back(BnInOp2Blob(GenRepeatedBn("in", i))->dptr());
+    }
+    this->cpu_slice_boxing_plan().Copy(out->mut_dptr(), in_ptrs);
+    return;
+  }
   FOR_RANGE(int64_t, i, 0, this->op_attribute().input_bns().size()) {
     const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
     this->tensor_slice_copier_vec().at(i)->Copy(ctx.device_ctx, *this->memory_copier(), out, in_i);
@@ -113,6 +136,15 @@ template<DeviceType device_type, typename T>
 void SliceBoxingAddKernel<device_type, T>::ForwardDataContent(
     const KernelCtx& ctx, std::function<Blob*(const std::string&)> BnInOp2Blob) const {
   Blob* out = BnInOp2Blob("out");
+  if (device_type == DeviceType::kCPU) {
+    // summed in one pass over out, without copying the in slices to buf first
+    std::vector<const T*> in_ptrs;
+    FOR_RANGE(int64_t, i, 0, this->op_attribute().input_bns().size()) {
+      in_ptrs.push_back(BnInOp2Blob(GenRepeatedBn("in", i))->dptr<T>());
+    }
+    this->cpu_slice_boxing_plan().template Add<T>(out->mut_dptr<T>(), in_ptrs);
+    return;
+  }
   FOR_RANGE(int64_t, i, 0, this->op_attribute().input_bns().size()) {
     const Blob* in_i = BnInOp2Blob(GenRepeatedBn("in", i));
     if (i == 0) {
@@ -25,6 +25,7 @@ limitations under the License.
 #include "oneflow/core/kernel/eager_kernel.h"
 #include "oneflow/core/kernel/kernel.h"
 #include "oneflow/core/kernel/kernel_helper.h"
+#include "oneflow/core/kernel/variable_write_count.h"
 
 namespace oneflow {
 
@@ -308,20 +309,103 @@ class UserKernelOpInferContext : public user_op::InferContext {
   HashMap<std::pair<std::string, int32_t>, user_op::NaiveTensorDesc> arg2logical_tensor_desc_;
 };
 
+namespace {
+
+struct BnTensorPair {
+  std::string bn;
+  // -1 if the kernel has no such bn
+  int64_t slot;
+  std::unique_ptr<user_op::BlobTensorView> tensor;
+};
+
+BnTensorPair MakeBnTensorPair(const Kernel* kernel, const std::string& bn) {
+  BnTensorPair pair;
+  pair.bn = bn;
+  pair.slot = kernel->Slot4BnInOp(bn);
+  return pair;
+}
+
+BnTensorPair MakeBnTensorPair(const Kernel* kernel, const std::string& bn,
+                              std::unique_ptr<user_op::BlobTensorView>&& tensor) {
+  BnTensorPair pair = MakeBnTensorPair(kernel, bn);
+  pair.tensor = std::move(tensor);
+  return pair;
+}
+
+// BnTensorPairs of the args of a kernel, laid out arg by arg in one vector. The few arg names
+// are scanned and the index is added to the offset of the arg, so a lookup hashes nothing
+class ArgBnTensorPairs final {
+ public:
+  ArgBnTensorPairs() = default;
+  ~ArgBnTensorPairs() = default;
+
+  void Add(const Kernel* kernel, const std::string& arg_name, int32_t num) {
+    CHECK(Find(arg_name, 0) == nullptr) << "Arg " << arg_name << " is added twice";
+    args_.emplace_back(ArgRange{arg_name, static_cast<int32_t>(pairs_.size()), num});
+    for (int32_t i = 0; i < num; ++i) {
+      pairs_.emplace_back(MakeBnTensorPair(kernel, GenRepeatedBn(arg_name, i)));
+    }
+  }
+
+  BnTensorPair* Find(const std::string& arg_name, int32_t index) {
+    for (const ArgRange& arg : args_) {
+      if (arg.name != arg_name) { continue; }
+      if (index < 0 || index >= arg.num) { return nullptr; }
+      return &pairs_.at(arg.offset + index);
+    }
+    return nullptr;
+  }
+
+  std::vector<BnTensorPair>* mut_pairs() { return &pairs_; }
+
+ private:
+  struct ArgRange {
+    std::string name;
+    int32_t offset;
+    int32_t num;
+  };
+
+  std::vector<ArgRange> args_;
+  std::vector<BnTensorPair> pairs_;
+};
+
+// Points the tensor of every pair to its blob, read by slot if BnInOp2Blob is the
+// SlotBnInOp2Blob of a launch of kernel
+void UpdateBnTensorPairs(const Kernel* kernel,
+                         const std::function<Blob*(const std::string&)>& BnInOp2Blob,
+                         std::vector<BnTensorPair>* pairs) {
+  const SlotBnInOp2Blob* slot_bn_in_op2blob = kernel->GetSlotBnInOp2Blob(BnInOp2Blob);
+  for (BnTensorPair& pair : *pairs) {
+    BnTensorPair* bn_tensor_pair = &pair;
+    Blob* blob = nullptr;
+    if (slot_bn_in_op2blob == nullptr) {
+      blob = BnInOp2Blob(bn_tensor_pair->bn);
+    } else if (bn_tensor_pair->slot != -1) {
+      blob = slot_bn_in_op2blob->Blob4Slot(bn_tensor_pair->slot);
+    }
+    if (blob == nullptr) { continue; }
+    if (bn_tensor_pair->tensor) {
+      bn_tensor_pair->tensor->Reset(blob);
+    } else {
+      bn_tensor_pair->tensor.reset(new user_op::BlobTensorView(blob));
+    }
+  }
+}
+
+}  // namespace
+
 class UserKernelInferContext final : public user_op::KernelInferContext {
  public:
-  explicit UserKernelInferContext(DeviceCtx* device_ctx, const KernelConf& kernel_conf,
-                                  const JobDesc& job_desc)
+  explicit UserKernelInferContext(DeviceCtx* device_ctx, const Kernel* kernel,
+                                  const KernelConf& kernel_conf, const JobDesc& job_desc)
       : user_op_conf_(kernel_conf.op_attribute().op_conf()),
         device_ctx_(device_ctx),
+        kernel_(kernel),
         base_ctx_(UserKernelBaseContext(kernel_conf, job_desc)),
         op_infer_ctx_(kernel_conf, &job_desc) {
     auto InitArg2Blob = [this](const PbMap<std::string, UserOpConf::ListString>& arg_map) {
       for (auto it = arg_map.begin(); it != arg_map.end(); ++it) {
-        const std::string& arg_name = it->first;
-        for (int32_t i = 0; i < it->second.s_size(); ++i) {
-          arg2tensor_.emplace(std::make_pair(arg_name, i), nullptr);
-        }
+        arg_bn_tensor_pairs_.Add(kernel_, it->first, it->second.s_size());
       }
     };
     InitArg2Blob(kernel_conf.op_attribute().op_conf().user_conf().input());
@@ -349,9 +433,9 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
 
   DeviceCtx* device_ctx() override { return device_ctx_; }
   user_op::Tensor* Tensor4ArgNameAndIndex(const std::string& arg_name, int32_t arg_index) override {
-    auto it = arg2tensor_.find(std::make_pair(arg_name, arg_index));
-    CHECK(it != arg2tensor_.end()) << "Arg (" << arg_name << "," << arg_index << ") is not found";
-    return it->second.get();
+    BnTensorPair* pair = arg_bn_tensor_pairs_.Find(arg_name, arg_index);
+    CHECK(pair != nullptr) << "Arg (" << arg_name << "," << arg_index << ") is not found";
+    return pair->tensor.get();
   }
   const ShapeView& ShapeView4ArgNameAndIndex(const std::string& arg_name,
                                              int32_t arg_index) override {
@@ -372,17 +456,7 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
   const user_op::TensorDescInferFn& GetOpInferFn() const override { return tensor_desc_infer_fn_; }
 
   void UpdateArg2Tensor(const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
-    for (auto& pair : arg2tensor_) {
-      const auto& arg_pair = pair.first;
-      std::unique_ptr<user_op::BlobTensorView>* arg_tensor_ptr = &pair.second;
-      Blob* blob = BnInOp2Blob(GenRepeatedBn(arg_pair.first, arg_pair.second));
-      if (blob == nullptr) { continue; }
-      if (*arg_tensor_ptr) {
-        arg_tensor_ptr->get()->Reset(blob);
-      } else {
-        arg_tensor_ptr->reset(new user_op::BlobTensorView(blob));
-      }
-    }
+    UpdateBnTensorPairs(kernel_, BnInOp2Blob, arg_bn_tensor_pairs_.mut_pairs());
   }
 
  private:
@@ -394,55 +468,29 @@ class UserKernelInferContext final : public user_op::KernelInferContext {
 
   user_op::UserOpConfWrapper user_op_conf_;
   DeviceCtx* device_ctx_;
+  const Kernel* kernel_;
   UserKernelBaseContext base_ctx_;
   UserKernelOpInferContext op_infer_ctx_;
   user_op::TensorDescInferFn tensor_desc_infer_fn_;
-  HashMap<std::pair<std::string, int32_t>, std::unique_ptr<user_op::BlobTensorView>> arg2tensor_;
+  ArgBnTensorPairs arg_bn_tensor_pairs_;
 };
 
-namespace {
-
-struct BnTensorPair {
-  std::string bn;
-  std::unique_ptr<user_op::BlobTensorView> tensor;
-};
-
-BnTensorPair MakeBnTensorPair(const std::string& bn) {
-  BnTensorPair pair;
-  pair.bn = bn;
-  return pair;
-}
-
-BnTensorPair MakeBnTensorPair(const std::string& bn,
-                              std::unique_ptr<user_op::BlobTensorView>&& tensor) {
-  BnTensorPair pair;
-  pair.bn = bn;
-  pair.tensor = std::move(tensor);
-  return pair;
-}
-
-}  // namespace
-
 class UserKernelComputeContext final : public user_op::KernelComputeContext {
  public:
-  explicit UserKernelComputeContext(DeviceCtx* device_ctx, const KernelConf& kernel_conf,
-                                    const JobDesc& job_desc)
+  explicit UserKernelComputeContext(DeviceCtx* device_ctx, const Kernel* kernel,
+                                    const KernelConf& kernel_conf, const JobDesc& job_desc)
       : user_op_conf_(kernel_conf.op_attribute().op_conf()),
         device_ctx_(device_ctx),
+        kernel_(kernel),
         base_ctx_(std::move(UserKernelBaseContext(kernel_conf, job_desc))) {
     auto InitInOrOut = [&](const PbMap<std::string, UserOpConf::ListString>& arg_map) {
       for (const auto& it : arg_map) {
-        const std::string& arg_name = it.first;
-        for (int32_t i = 0; i < it.second.s_size(); ++i) {
-          arg2bn_tensor_pair_.emplace(std::make_pair(arg_name, i),
-                                      MakeBnTensorPair(GenRepeatedBn(arg_name, i)));
-        }
+        arg_bn_tensor_pairs_.Add(kernel_, it.first, it.second.s_size());
       }
     };
     InitInOrOut(kernel_conf.op_attribute().op_conf().user_conf().input());
     InitInOrOut(kernel_conf.op_attribute().op_conf().user_conf().output());
-    arg2bn_tensor_pair_.emplace(std::make_pair("tmp_buffer", 0),
-                                MakeBnTensorPair(GenRepeatedBn("tmp_buffer", 0)));
+    arg_bn_tensor_pairs_.Add(kernel_, "tmp_buffer", 1);
   }
   ~UserKernelComputeContext() = default;
 
@@ -452,23 +500,14 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
   }
 
   user_op::Tensor* Tensor4ArgNameAndIndex(const std::string& arg_name, int32_t index) override {
-    auto it = arg2bn_tensor_pair_.find(std::make_pair(arg_name, index));
-    if (it == arg2bn_tensor_pair_.end()) { return nullptr; }
-    return it->second.tensor.get();
+    BnTensorPair* pair = arg_bn_tensor_pairs_.Find(arg_name, index);
+    if (pair == nullptr) { return nullptr; }
+    return pair->tensor.get();
   }
   DeviceCtx* device_ctx() override { return device_ctx_; }
 
   void UpdateTensorWithCorrBlob(const std::function<Blob*(const std::string&)>& BnInOp2Blob) {
-    for (auto& pair : arg2bn_tensor_pair_) {
-      std::unique_ptr<user_op::BlobTensorView>* arg_tensor_ptr = &pair.second.tensor;
-      Blob* blob = BnInOp2Blob(pair.second.bn);
-      if (blob == nullptr) { continue; }
-      if (*arg_tensor_ptr) {
-        arg_tensor_ptr->get()->Reset(blob);
-      } else {
-        arg_tensor_ptr->reset(new user_op::BlobTensorView(blob));
-      }
-    }
+    UpdateBnTensorPairs(kernel_, BnInOp2Blob, arg_bn_tensor_pairs_.mut_pairs());
   }
 
   DeviceType device_type() const override { return base_ctx_.device_type(); }
@@ -488,7 +527,8 @@ class UserKernelComputeContext final : public user_op::KernelComputeContext {
 
   user_op::UserOpConfWrapper user_op_conf_;
   DeviceCtx* device_ctx_;
-  HashMap<std::pair<std::string, int32_t>, BnTensorPair> arg2bn_tensor_pair_;
+  const Kernel* kernel_;
+  ArgBnTensorPairs arg_bn_tensor_pairs_;
   UserKernelBaseContext base_ctx_;
 };
 
@@ -522,8 +562,8 @@ class UserKernelRegContext final : public user_op::KernelRegContext {
 };
 
 void UserKernel::InitUserKernel(DeviceCtx* device_ctx) {
-  ctx_.reset(new UserKernelComputeContext(device_ctx, kernel_conf(), job_desc()));
-  infer_ctx_.reset(new UserKernelInferContext(device_ctx, kernel_conf(), job_desc()));
+  ctx_.reset(new UserKernelComputeContext(device_ctx, this, kernel_conf(), job_desc()));
+  infer_ctx_.reset(new UserKernelInferContext(device_ctx, this, kernel_conf(), job_desc()));
   infer_cache_.reset(new user_op::OpKernelInferCache(kernel_conf(), job_desc()));
   {
     const std::string& op_type_name =
@@ -535,6 +575,10 @@ void UserKernel::InitUserKernel(DeviceCtx* device_ctx) {
     KernelCreateContext create_ctx(kernel_conf());
     kernel_.reset(kernel_reg_val->create_fn(&create_ctx));
   }
+  for (const auto& pair :
+       kernel_conf().op_attribute().arg_modifier_signature().ibn2input_blob_modifier()) {
+    if (pair.second.is_mutable()) { has_mutable_input_ = true; }
+  }
 }
 
 std::shared_ptr<user_op::OpKernelState> UserKernel::CreateOpKernelState(DeviceCtx* device_ctx) {
@@ -550,6 +594,7 @@ void UserKernel::ForwardUserKernel(std::function<Blob*(const std::string&)> BnIn
                                    user_op::OpKernelState* opkernel_state) const {
   ctx_->UpdateTensorWithCorrBlob(BnInOp2Blob);
   kernel_->Compute(ctx_.get(), opkernel_state);
+  if (has_mutable_input_) { IncreaseVariableWriteCount(); }
 }
 
 void UserKernel::VirtualKernelInit(DeviceCtx* device_ctx) {
@@ -617,7 +662,7 @@ void EagerKernel::InitOpKernel(const KernelConf& kernel_conf) {
 
 void EagerKernel::Infer(std::function<Blob*(const std::string&)> BnInOp2Blob) const {
   if (!kernel_conf().need_do_shape()) { return; }
-  UserKernelInferContext infer_ctx(nullptr, kernel_conf(), job_desc());
+  UserKernelInferContext infer_ctx(nullptr, this, kernel_conf(), job_desc());
   infer_ctx.UpdateArg2Tensor(BnInOp2Blob);
   auto* op_infer_ctx = dynamic_cast<UserKernelOpInferContext*>(infer_ctx.MutOpInferContext());
   if (op_infer_ctx) { op_infer_ctx->UpdateArg2TensorDesc(BnInOp2Blob); }
@@ -642,7 +687,7 @@ std::shared_ptr<user_op::OpKernelState> EagerKernel::EagerForward(
   }
 
   // TODO(lixinqi): refactor to a lightweight KernelComputeContext
-  UserKernelComputeContext compute_ctx(device_ctx, kernel_conf(), job_desc());
+  UserKernelComputeContext compute_ctx(device_ctx, this, kernel_conf(), job_desc());
   compute_ctx.UpdateTensorWithCorrBlob(BnInOp2Blob);
   kernel_->Compute(&compute_ctx, new_opkernel_state.get());
   return new_opkernel_state;
@@ -55,6 +55,8 @@ class UserKernel final : public Kernel {
   std::unique_ptr<UserKernelComputeContext> ctx_;
   std::unique_ptr<UserKernelInferContext> infer_ctx_;
   std::unique_ptr<user_op::OpKernelInferCache> infer_cache_;
+  // a mutable input is a variable written by the kernel, e.g. the model of a model update
+  bool has_mutable_input_ = false;
 };
 
 }  // namespace oneflow
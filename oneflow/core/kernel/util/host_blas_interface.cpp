@@ -32,6 +32,36 @@ static void Gemm(DeviceCtx* ctx, const enum CBLAS_ORDER order, enum CBLAS_TRANSP
                 static_cast<T>(beta), c, ldc);
 }
 
+// Float copies of gemms up to this many elements are kept in a buffer of the calling thread.
+// Larger ones get a buffer of their own call, so one big gemm does not pin its memory for the
+// life of the thread
+constexpr int64_t kMaxCachedBFloat16GemmElemCnt = 1 << 20;
+
+// Converts the operands to float and accumulates in float with the float gemm
+void BFloat16Gemm(DeviceCtx* ctx, const enum CBLAS_ORDER order, enum CBLAS_TRANSPOSE trans_a,
+                  enum CBLAS_TRANSPOSE trans_b, const int m, const int n, const int k,
+                  const double alpha, const bfloat16* a, const bfloat16* b, const double beta,
+                  bfloat16* c) {
+  static thread_local std::vector<float> cached_float_buf;
+  const int64_t a_elem_cnt = static_cast<int64_t>(m) * k;
+  const int64_t b_elem_cnt = static_cast<int64_t>(k) * n;
+  const int64_t c_elem_cnt = static_cast<int64_t>(m) * n;
+  const int64_t buf_elem_cnt = a_elem_cnt + b_elem_cnt + c_elem_cnt;
+  std::vector<float> uncached_float_buf;
+  std::vector<float>* float_buf = &cached_float_buf;
+  if (buf_elem_cnt > kMaxCachedBFloat16GemmElemCnt) { float_buf = &uncached_float_buf; }
+  if (float_buf->size() < buf_elem_cnt) { float_buf->resize(buf_elem_cnt); }
+  float* float_a = float_buf->data();
+  float* float_b = float_a + a_elem_cnt;
+  float* float_c = float_b + b_elem_cnt;
+  ConvertBFloat16ToFloat(a, float_a, a_elem_cnt);
+  ConvertBFloat16ToFloat(b, float_b, b_elem_cnt);
+  // c is not read by the gemm when beta is 0
+  if (beta != 0) { ConvertBFloat16ToFloat(c, float_c, c_elem_cnt); }
+  Gemm<float>(ctx, order, trans_a, trans_b, m, n, k, alpha, float_a, float_b, beta, float_c);
+  ConvertFloatToBFloat16(float_c, c, c_elem_cnt);
+}
+
 template<typename T>
 static void AxpyImpl(DeviceCtx* ctx, const int n, const T alpha, const T* x, const int incx, T* y,
                      const int incy) {
@@ -72,6 +102,13 @@ void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans
   Gemm<double>(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                      enum CBLAS_TRANSPOSE trans_b, const int m, const int n,
+                                      const int k, const double alpha, const bfloat16* a,
+                                      const bfloat16* b, const double beta, bfloat16* c) {
+  BFloat16Gemm(ctx, CblasRowMajor, trans_a, trans_b, m, n, k, alpha, a, b, beta, c);
+}
+
 void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
                                              enum CBLAS_TRANSPOSE trans_b, const int batch_size,
                                              const int m, const int n, const int k,
@@ -90,6 +127,15 @@ void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOS
                           beta, c);
 }
 
+void BlasIf<DeviceType::kCPU>::OFBatchedGemm(DeviceCtx* ctx, enum CBLAS_TRANSPOSE trans_a,
+                                             enum CBLAS_TRANSPOSE trans_b, const int batch_size,
+                                             const int m, const int n, const int k,
+                                             const double alpha, const bfloat16* a,
+                                             const bfloat16* b, const double beta, bfloat16* c) {
+  BatchedGemmImpl<bfloat16>(ctx, CblasRowMajor, trans_a, trans_b, batch_size, m, n, k, alpha, a,
+                            b, beta, c);
+}
+
 void BlasIf<DeviceType::kCPU>::Axpy(DeviceCtx* ctx, const int n, const float alpha, const float* x,
                                     const int incx, float* y, const int incy) {
   AxpyImpl<float>(ctx, n, alpha, x, incx, y, incy);
@@ -0,0 +1,32 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_KERNEL_VARIABLE_WRITE_COUNT_H_
+#define ONEFLOW_CORE_KERNEL_VARIABLE_WRITE_COUNT_H_
+
+#include <cstdint>
+
+namespace oneflow {
+
+// The number of runs of the kernels writing variables in this process: the model init and load
+// kernels, the user kernels with a mutable input such as the model updates and the assigns, and
+// the slice assigns of the eager checkpoint loading. A kernel caching what it derives from a
+// variable, e.g. a packed weight, derives it again only after this count has changed
+int64_t VariableWriteCount();
+void IncreaseVariableWriteCount();
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_KERNEL_VARIABLE_WRITE_COUNT_H_
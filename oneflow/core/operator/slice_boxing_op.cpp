@@ -133,7 +133,10 @@ void SliceBoxingAddOp::VirtualInitFromOpConf() { EnrollTmpBn("buf"); }
 Maybe<void> SliceBoxingAddOp::InferInternalBlobDescs(
     const std::function<BlobDesc*(const std::string&)>& GetBlobDesc4BnInOp,
     const ParallelContext* parallel_ctx, const JobDesc* job_desc) const {
-  *GetBlobDesc4BnInOp("buf") = *GetBlobDesc4BnInOp("out");
+  BlobDesc* buf = GetBlobDesc4BnInOp("buf");
+  *buf = *GetBlobDesc4BnInOp("out");
+  // the cpu kernel sums the in slices straight into out
+  if (device_type() == DeviceType::kCPU) { buf->mut_shape() = Shape({0}); }
   return Maybe<void>::Ok();
 }
 
@@ -43,6 +43,9 @@ class OfBlob final {
   void AutoMemCopyTo(T* ptr, int64_t len) const;
   template<typename T>
   void AutoMemCopyFrom(const T* ptr, int64_t len) const;
+  // untyped versions for callers that check data_type() themselves
+  void AutoMemCopyBytesTo(void* ptr, size_t capacity) const;
+  void AutoMemCopyBytesFrom(const void* ptr, size_t nbytes) const;
   void AsyncAutoMemset(const char value) const;
 
  private:
@@ -88,6 +91,18 @@ void OfBlob::AutoMemCopyFrom(const T* ptr, int64_t len) const {
                  mem_case_);
 }
 
+inline void OfBlob::AutoMemCopyBytesTo(void* ptr, size_t capacity) const {
+  const size_t nbytes = blob_->shape().elem_cnt() * GetSizeOfDataType(blob_->data_type());
+  CHECK_LE(nbytes, capacity);
+  SyncAutoMemcpy(device_ctx_, ptr, blob_->dptr(), nbytes, mem_case_, blob_->mem_case());
+}
+
+inline void OfBlob::AutoMemCopyBytesFrom(const void* ptr, size_t nbytes) const {
+  blob_->blob_access_checker()->CheckBodyMutable();
+  CHECK_EQ(blob_->shape().elem_cnt() * GetSizeOfDataType(blob_->data_type()), nbytes);
+  SyncAutoMemcpy(device_ctx_, blob_->mut_dptr(), ptr, nbytes, blob_->mem_case(), mem_case_);
+}
+
 inline void OfBlob::AsyncAutoMemset(const char value) const {
   ::oneflow::AutoMemset(device_ctx_, blob_->mut_dptr(), value,
                         blob_->shape().elem_cnt() * GetSizeOfDataType(blob_->data_type()),
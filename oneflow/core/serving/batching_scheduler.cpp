@@ -0,0 +1,280 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/batching_scheduler.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/data_type.h"
+
+namespace oneflow {
+
+namespace {
+
+size_t SampleBytes(const InferenceBlobInfo& info) {
+  return info.static_shape.Count(1) * GetSizeOfDataType(info.data_type);
+}
+
+}  // namespace
+
+const size_t BatchingScheduler::kNumRecentLatencies;
+
+struct BatchingScheduler::Request {
+  Request(const HashMap<std::string, InferenceTensor>* inputs,
+          HashMap<std::string, InferenceTensor>* outputs, int64_t batch_size)
+      : inputs(inputs),
+        outputs(outputs),
+        batch_size(batch_size),
+        queued_time(std::chrono::steady_clock::now()),
+        done_counter(1) {}
+
+  const HashMap<std::string, InferenceTensor>* inputs;
+  HashMap<std::string, InferenceTensor>* outputs;
+  int64_t batch_size;
+  std::chrono::steady_clock::time_point queued_time;
+  BlockingCounter done_counter;
+  // nullptr if the request succeeds
+  std::shared_ptr<cfg::ErrorProto> error;
+};
+
+struct BatchingScheduler::BatchBuffers {
+  HashMap<std::string, InferenceTensor> inputs;
+  HashMap<std::string, InferenceTensor> outputs;
+  std::vector<std::vector<char>> memory;
+};
+
+BatchingScheduler::BatchingScheduler(const InferenceSession* session, int64_t max_batch_size,
+                                     int64_t max_delay_us, int32_t num_batch_threads)
+    : session_(session),
+      batch_size_(-1),
+      max_delay_(max_delay_us),
+      num_queued_samples_(0),
+      closed_(false),
+      num_requests_(0),
+      num_batches_(0),
+      num_samples_(0),
+      next_latency_index_(0) {
+  CHECK_GE(max_delay_us, 0);
+  CHECK_GT(num_batch_threads, 0);
+  for (const std::string& name : session_->ListInputs()) {
+    input_name2info_.emplace(name, CHECK_JUST(session_->InputInfo(name)));
+  }
+  for (const std::string& name : session_->ListOutputs()) {
+    output_name2info_.emplace(name, CHECK_JUST(session_->OutputInfo(name)));
+  }
+  const auto CheckBatchMajor = [this](const std::string& name, const InferenceBlobInfo& info) {
+    CHECK(!info.is_dynamic) << name << " is dynamic";
+    CHECK_GT(info.static_shape.NumAxes(), 0) << name << " has no batch dimension";
+    if (batch_size_ == -1) { batch_size_ = info.static_shape.At(0); }
+    CHECK_EQ(info.static_shape.At(0), batch_size_) << "batch size of " << name;
+  };
+  for (const auto& pair : input_name2info_) { CheckBatchMajor(pair.first, pair.second); }
+  for (const auto& pair : output_name2info_) { CheckBatchMajor(pair.first, pair.second); }
+  CHECK_GT(batch_size_, 0);
+  max_batch_size_ = max_batch_size > 0 ? std::min(max_batch_size, batch_size_) : batch_size_;
+
+  FOR_RANGE(int32_t, i, 0, num_batch_threads) {
+    batch_threads_.emplace_back(&BatchingScheduler::PollBatches, this);
+  }
+}
+
+BatchingScheduler::~BatchingScheduler() {
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    closed_ = true;
+  }
+  queue_cond_.notify_all();
+  for (std::thread& thread : batch_threads_) { thread.join(); }
+  LOG(INFO) << "batching scheduler: " << GetStats();
+}
+
+Maybe<int64_t> BatchingScheduler::CheckRequest(
+    const HashMap<std::string, InferenceTensor>& inputs,
+    const HashMap<std::string, InferenceTensor>& outputs) const {
+  int64_t batch_size = -1;
+  for (const auto& pair : input_name2info_) {
+    const auto it = inputs.find(pair.first);
+    CHECK_OR_RETURN(it != inputs.end()) << "input " << pair.first << " is absent";
+    const InferenceTensor& input = it->second;
+    const Shape& static_shape = pair.second.static_shape;
+    CHECK_EQ_OR_RETURN(input.data_type, pair.second.data_type) << "data type of " << pair.first;
+    CHECK_EQ_OR_RETURN(input.shape.NumAxes(), static_shape.NumAxes()) << "shape of " << pair.first;
+    FOR_RANGE(int64_t, i, 1, static_shape.NumAxes()) {
+      CHECK_EQ_OR_RETURN(input.shape.At(i), static_shape.At(i)) << "shape of " << pair.first;
+    }
+    if (batch_size == -1) { batch_size = input.shape.At(0); }
+    CHECK_EQ_OR_RETURN(input.shape.At(0), batch_size) << "batch size of " << pair.first;
+    CHECK_EQ_OR_RETURN(input.nbytes, batch_size * SampleBytes(pair.second))
+        << "size of " << pair.first;
+  }
+  CHECK_GT_OR_RETURN(batch_size, 0);
+  CHECK_LE_OR_RETURN(batch_size, max_batch_size_);
+  for (const auto& pair : outputs) {
+    const auto it = output_name2info_.find(pair.first);
+    CHECK_OR_RETURN(it != output_name2info_.end()) << "output " << pair.first << " not found";
+    CHECK_EQ_OR_RETURN(pair.second.data_type, it->second.data_type)
+        << "data type of " << pair.first;
+    CHECK_GE_OR_RETURN(pair.second.nbytes, batch_size * SampleBytes(it->second))
+        << "size of " << pair.first;
+  }
+  return batch_size;
+}
+
+Maybe<void> BatchingScheduler::Run(const HashMap<std::string, InferenceTensor>& inputs,
+                                   HashMap<std::string, InferenceTensor>* outputs) {
+  const int64_t batch_size = JUST(CheckRequest(inputs, *outputs));
+  Request request(&inputs, outputs, batch_size);
+  {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    CHECK_OR_RETURN(!closed_) << "batching scheduler closed";
+    queue_.push_back(&request);
+    num_queued_samples_ += batch_size;
+  }
+  queue_cond_.notify_all();
+  request.done_counter.WaitUntilCntEqualZero();
+  if (request.error) { return request.error; }
+  return Maybe<void>::Ok();
+}
+
+std::vector<BatchingScheduler::Request*> BatchingScheduler::TakeBatch() {
+  std::unique_lock<std::mutex> take_batch_lock(take_batch_mutex_);
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  queue_cond_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+  std::vector<Request*> batch;
+  if (queue_.empty()) { return batch; }
+  const auto deadline = queue_.front()->queued_time + max_delay_;
+  queue_cond_.wait_until(lock, deadline, [this]() {
+    return closed_ || num_queued_samples_ >= max_batch_size_;
+  });
+  int64_t num_samples = 0;
+  while (!queue_.empty() && num_samples + queue_.front()->batch_size <= max_batch_size_) {
+    num_samples += queue_.front()->batch_size;
+    batch.push_back(queue_.front());
+    queue_.pop_front();
+  }
+  num_queued_samples_ -= num_samples;
+  return batch;
+}
+
+void BatchingScheduler::RunBatch(const std::vector<Request*>& batch, BatchBuffers* buffers) {
+  for (auto& pair : buffers->inputs) {
+    const size_t sample_bytes = SampleBytes(input_name2info_.at(pair.first));
+    char* dst = static_cast<char*>(pair.second.data);
+    size_t offset = 0;
+    for (const Request* request : batch) {
+      const size_t nbytes = request->batch_size * sample_bytes;
+      std::memcpy(dst + offset, request->inputs->at(pair.first).data, nbytes);
+      offset += nbytes;
+    }
+    std::memset(dst + offset, 0, pair.second.nbytes - offset);
+  }
+  const Maybe<void> status = session_->Run(buffers->inputs, &buffers->outputs);
+  if (status.IsOk()) {
+    for (const auto& pair : buffers->outputs) {
+      const InferenceBlobInfo& info = output_name2info_.at(pair.first);
+      const char* src = static_cast<const char*>(pair.second.data);
+      size_t offset = 0;
+      for (Request* request : batch) {
+        const size_t nbytes = request->batch_size * SampleBytes(info);
+        const auto it = request->outputs->find(pair.first);
+        if (it != request->outputs->end()) {
+          DimVector dim_vec = info.static_shape.dim_vec();
+          dim_vec.at(0) = request->batch_size;
+          it->second.shape = Shape(dim_vec);
+          std::memcpy(it->second.data, src + offset, nbytes);
+        }
+        offset += nbytes;
+      }
+    }
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+    num_batches_ += 1;
+    for (const Request* request : batch) {
+      const double latency_ms =
+          std::chrono::duration_cast<std::chrono::microseconds>(now - request->queued_time).count()
+          / 1000.0;
+      if (recent_latencies_ms_.size() < kNumRecentLatencies) {
+        recent_latencies_ms_.push_back(latency_ms);
+      } else {
+        recent_latencies_ms_.at(next_latency_index_) = latency_ms;
+      }
+      next_latency_index_ = (next_latency_index_ + 1) % kNumRecentLatencies;
+      num_requests_ += 1;
+      num_samples_ += request->batch_size;
+    }
+  }
+  // the requests are gone once they are done
+  for (Request* request : batch) {
+    if (!status.IsOk()) { request->error = status.error(); }
+    request->done_counter.Decrease();
+  }
+}
+
+void BatchingScheduler::PollBatches() {
+  BatchBuffers buffers;
+  const auto AddTensor = [&buffers](const std::string& name, const InferenceBlobInfo& info,
+                                    HashMap<std::string, InferenceTensor>* tensors) {
+    const size_t nbytes = info.static_shape.elem_cnt() * GetSizeOfDataType(info.data_type);
+    buffers.memory.emplace_back(nbytes, 0);
+    InferenceTensor tensor;
+    tensor.data_type = info.data_type;
+    tensor.shape = info.static_shape;
+    tensor.data = buffers.memory.back().data();
+    tensor.nbytes = nbytes;
+    tensors->emplace(name, tensor);
+  };
+  for (const auto& pair : input_name2info_) { AddTensor(pair.first, pair.second, &buffers.inputs); }
+  for (const auto& pair : output_name2info_) {
+    AddTensor(pair.first, pair.second, &buffers.outputs);
+  }
+  while (true) {
+    const std::vector<Request*> batch = TakeBatch();
+    if (batch.empty()) { break; }
+    RunBatch(batch, &buffers);
+  }
+}
+
+BatchingScheduler::Stats BatchingScheduler::GetStats() const {
+  Stats stats;
+  std::vector<double> latencies_ms;
+  {
+    std::unique_lock<std::mutex> lock(stats_mutex_);
+    stats.num_requests = num_requests_;
+    stats.num_batches = num_batches_;
+    stats.batch_fill =
+        num_batches_ > 0 ? static_cast<double>(num_samples_) / (num_batches_ * batch_size_) : 0;
+    latencies_ms = recent_latencies_ms_;
+  }
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  const auto Percentile = [&latencies_ms](double percent) -> double {
+    if (latencies_ms.empty()) { return 0; }
+    const size_t index =
+        std::min<size_t>(latencies_ms.size() * percent / 100, latencies_ms.size() - 1);
+    return latencies_ms.at(index);
+  };
+  stats.p50_latency_ms = Percentile(50);
+  stats.p99_latency_ms = Percentile(99);
+  return stats;
+}
+
+std::ostream& operator<<(std::ostream& out, const BatchingScheduler::Stats& stats) {
+  out << "requests " << stats.num_requests << ", batches " << stats.num_batches
+      << ", batch fill " << stats.batch_fill << ", p50 latency " << stats.p50_latency_ms
+      << " ms, p99 latency " << stats.p99_latency_ms << " ms";
+  return out;
+}
+
+}  // namespace oneflow
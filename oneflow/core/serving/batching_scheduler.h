@@ -0,0 +1,95 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_BATCHING_SCHEDULER_H_
+#define ONEFLOW_CORE_SERVING_BATCHING_SCHEDULER_H_
+
+#include "oneflow/core/serving/inference_session.h"
+#include <chrono>
+
+namespace oneflow {
+
+// Coalesces concurrent requests into batches of the batch size the session is compiled with. The
+// inputs and the outputs of the session must be static and have the batch size as their first
+// dimension, and a request holds any number of samples up to max_batch_size along it. A batch is
+// run as soon as it can't take the next queued request or max_delay_us after its first request
+// was queued, whichever comes first, and the rest of the batch is padded with zeros.
+// num_batch_threads batches run at the same time, so that a batch can be made while the previous
+// ones are running
+class BatchingScheduler final {
+ public:
+  struct Stats {
+    int64_t num_requests;
+    int64_t num_batches;
+    // the samples of the requests over the samples of the batches run
+    double batch_fill;
+    // of the last kNumRecentLatencies requests, from being queued to having the outputs
+    double p50_latency_ms;
+    double p99_latency_ms;
+  };
+  static const size_t kNumRecentLatencies = 10000;
+
+  OF_DISALLOW_COPY_AND_MOVE(BatchingScheduler);
+  BatchingScheduler(const InferenceSession* session, int64_t max_batch_size, int64_t max_delay_us,
+                    int32_t num_batch_threads);
+  // Runs the queued requests before returning
+  ~BatchingScheduler();
+
+  // The same as InferenceSession::Run, except that the first dimension of the inputs is the
+  // number of samples of the request, and so is that of the outputs
+  Maybe<void> Run(const HashMap<std::string, InferenceTensor>& inputs,
+                  HashMap<std::string, InferenceTensor>* outputs);
+  Stats GetStats() const;
+
+ private:
+  struct Request;
+  struct BatchBuffers;
+
+  Maybe<int64_t> CheckRequest(const HashMap<std::string, InferenceTensor>& inputs,
+                              const HashMap<std::string, InferenceTensor>& outputs) const;
+  // Empty if there is no request left after the scheduler is closed
+  std::vector<Request*> TakeBatch();
+  void RunBatch(const std::vector<Request*>& batch, BatchBuffers* buffers);
+  void PollBatches();
+
+  const InferenceSession* session_;
+  int64_t batch_size_;
+  int64_t max_batch_size_;
+  std::chrono::microseconds max_delay_;
+  HashMap<std::string, InferenceBlobInfo> input_name2info_;
+  HashMap<std::string, InferenceBlobInfo> output_name2info_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cond_;
+  std::deque<Request*> queue_;
+  int64_t num_queued_samples_;
+  bool closed_;
+  // only one thread makes a batch at a time, or two threads would split the queued requests
+  std::mutex take_batch_mutex_;
+  std::vector<std::thread> batch_threads_;
+
+  mutable std::mutex stats_mutex_;
+  int64_t num_requests_;
+  int64_t num_batches_;
+  int64_t num_samples_;
+  std::vector<double> recent_latencies_ms_;
+  size_t next_latency_index_;
+};
+
+std::ostream& operator<<(std::ostream& out, const BatchingScheduler::Stats& stats);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_BATCHING_SCHEDULER_H_
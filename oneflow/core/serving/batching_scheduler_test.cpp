@@ -0,0 +1,131 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/serving/batching_scheduler.h"
+#include "oneflow/core/serving/test_util.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+const int64_t kBatchSize = 4;
+const int64_t kSampleSize = 3;
+const float kScale = 2;
+
+// Sends a request of num_samples samples starting from first_value and checks that it gets back
+// its own samples scaled
+void RunAndCheck(BatchingScheduler* scheduler, int64_t num_samples, float first_value) {
+  const Shape shape({num_samples, kSampleSize});
+  std::vector<float> x(shape.elem_cnt());
+  std::vector<float> out(shape.elem_cnt(), 0);
+  FOR_RANGE(int64_t, i, 0, x.size()) { x.at(i) = first_value + i; }
+  HashMap<std::string, InferenceTensor> inputs;
+  inputs.emplace("x", InferenceTensor{DataType::kFloat, shape, x.data(), x.size() * sizeof(float)});
+  HashMap<std::string, InferenceTensor> outputs;
+  outputs.emplace("out", InferenceTensor{DataType::kFloat, Shape(), out.data(),
+                                         out.size() * sizeof(float)});
+  CHECK_JUST(scheduler->Run(inputs, &outputs));
+  ASSERT_EQ(outputs.at("out").shape, shape);
+  FOR_RANGE(int64_t, i, 0, x.size()) { ASSERT_FLOAT_EQ(out.at(i), kScale * x.at(i)); }
+}
+
+int64_t ElapsedMs(const std::chrono::steady_clock::time_point& start) {
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+}  // namespace
+
+class BatchingSchedulerTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { env_scope_.reset(new TestServingEnvScope()); }
+  static void TearDownTestCase() { env_scope_.reset(); }
+
+  void SetUp() override {
+    if (!env_scope_->is_inited()) { return; }
+    saved_model_dir_.reset(new TestSavedModelDir("tmp_test_batching_scheduler_model"));
+    WriteScaleSavedModel(saved_model_dir_->path(), Shape({kBatchSize, kSampleSize}), kScale);
+    session_.reset(new InferenceSession(InferenceSessionOption{}));
+    CHECK_JUST(session_->LoadSavedModel(saved_model_dir_->path(), -1, "", ""));
+  }
+
+  void TearDown() override {
+    if (!env_scope_->is_inited()) { return; }
+    CHECK_JUST(session_->Close());
+    session_.reset();
+    saved_model_dir_.reset();
+  }
+
+  static std::unique_ptr<TestServingEnvScope> env_scope_;
+  std::unique_ptr<TestSavedModelDir> saved_model_dir_;
+  std::unique_ptr<InferenceSession> session_;
+};
+
+std::unique_ptr<TestServingEnvScope> BatchingSchedulerTest::env_scope_;
+
+TEST_F(BatchingSchedulerTest, batch_by_size) {
+  if (!env_scope_->is_inited()) { return; }
+  const int64_t max_delay_ms = 10000;
+  BatchingScheduler scheduler(session_.get(), kBatchSize, max_delay_ms * 1000, 1);
+  const auto start = std::chrono::steady_clock::now();
+  // the two requests fill a batch, which runs without waiting for the delay
+  std::thread thread(RunAndCheck, &scheduler, 2, 100);
+  RunAndCheck(&scheduler, 2, 200);
+  thread.join();
+  ASSERT_LT(ElapsedMs(start), max_delay_ms);
+  const BatchingScheduler::Stats stats = scheduler.GetStats();
+  ASSERT_EQ(stats.num_requests, 2);
+  ASSERT_EQ(stats.num_batches, 1);
+  ASSERT_DOUBLE_EQ(stats.batch_fill, 1);
+}
+
+TEST_F(BatchingSchedulerTest, flush_on_timeout) {
+  if (!env_scope_->is_inited()) { return; }
+  const int64_t max_delay_ms = 100;
+  BatchingScheduler scheduler(session_.get(), kBatchSize, max_delay_ms * 1000, 1);
+  const auto start = std::chrono::steady_clock::now();
+  // the request can't fill a batch, which runs once the delay is over
+  RunAndCheck(&scheduler, 1, 100);
+  ASSERT_GE(ElapsedMs(start), max_delay_ms);
+  const BatchingScheduler::Stats stats = scheduler.GetStats();
+  ASSERT_EQ(stats.num_requests, 1);
+  ASSERT_EQ(stats.num_batches, 1);
+  ASSERT_DOUBLE_EQ(stats.batch_fill, 0.25);
+}
+
+TEST_F(BatchingSchedulerTest, results_to_right_requests) {
+  if (!env_scope_->is_inited()) { return; }
+  const int32_t num_threads = 4;
+  const int32_t num_requests = 50;
+  BatchingScheduler scheduler(session_.get(), kBatchSize, 1000, 2);
+  std::vector<std::thread> threads;
+  FOR_RANGE(int32_t, thread_id, 0, num_threads) {
+    threads.emplace_back([&scheduler, thread_id]() {
+      FOR_RANGE(int32_t, i, 0, num_requests) {
+        // every request has its own values and 1 or 2 samples
+        RunAndCheck(&scheduler, 1 + (thread_id + i) % 2, (thread_id * num_requests + i) * 10);
+      }
+    });
+  }
+  for (std::thread& thread : threads) { thread.join(); }
+  const BatchingScheduler::Stats stats = scheduler.GetStats();
+  ASSERT_EQ(stats.num_requests, num_threads * num_requests);
+  ASSERT_LE(stats.num_batches, stats.num_requests);
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,212 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/inference_session.h"
+#include "oneflow/core/serving/batching_scheduler.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/data_type.h"
+#include "oneflow/core/job/cluster_instruction.h"
+#include "oneflow/core/job/env.pb.h"
+#include "oneflow/core/job/env_global_objects_scope.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace oneflow {
+
+namespace {
+
+EnvProto GetEnvProto(int32_t ctrl_port) {
+  EnvProto ret;
+  auto* machine0 = ret.add_machine();
+  machine0->set_id(0);
+  machine0->set_addr("127.0.0.1");
+  ret.set_ctrl_port(ctrl_port);
+  return ret;
+}
+
+// The buffers of one request, so that every thread sends requests with its own buffers
+struct RequestBuffers {
+  HashMap<std::string, InferenceTensor> inputs;
+  HashMap<std::string, InferenceTensor> outputs;
+  std::vector<std::vector<char>> memory;
+};
+
+// batch_size replaces the first dimension of the static shape unless it is -1
+void AddTensor(const InferenceBlobInfo& info, const std::string& name, int64_t batch_size,
+               HashMap<std::string, InferenceTensor>* tensors, RequestBuffers* buffers) {
+  DimVector dim_vec = info.static_shape.dim_vec();
+  if (batch_size != -1) { dim_vec.at(0) = batch_size; }
+  const Shape shape(dim_vec);
+  const size_t nbytes = shape.elem_cnt() * GetSizeOfDataType(info.data_type);
+  buffers->memory.emplace_back(nbytes, 0);
+  InferenceTensor tensor;
+  tensor.data_type = info.data_type;
+  tensor.shape = shape;
+  tensor.data = buffers->memory.back().data();
+  tensor.nbytes = nbytes;
+  tensors->emplace(name, tensor);
+}
+
+std::unique_ptr<RequestBuffers> NewRequestBuffers(const InferenceSession& session,
+                                                  int64_t batch_size) {
+  std::unique_ptr<RequestBuffers> buffers(new RequestBuffers());
+  // the inputs are all zeros
+  for (const std::string& name : session.ListInputs()) {
+    AddTensor(CHECK_JUST(session.InputInfo(name)), name, batch_size, &buffers->inputs,
+              buffers.get());
+  }
+  for (const std::string& name : session.ListOutputs()) {
+    AddTensor(CHECK_JUST(session.OutputInfo(name)), name, batch_size, &buffers->outputs,
+              buffers.get());
+  }
+  return buffers;
+}
+
+double Percentile(const std::vector<double>& sorted_latencies, double percent) {
+  const size_t index = std::min<size_t>(sorted_latencies.size() * percent / 100,
+                                        sorted_latencies.size() - 1);
+  return sorted_latencies.at(index);
+}
+
+// scheduler is nullptr if the requests go to the session directly, and otherwise every request
+// holds request_batch_size samples
+void Benchmark(const InferenceSession& session, BatchingScheduler* scheduler,
+               int64_t request_batch_size, int32_t num_threads, int32_t num_requests,
+               int32_t num_warmup_requests) {
+  const auto RunRequest = [&](RequestBuffers* buffers) {
+    if (scheduler == nullptr) {
+      CHECK_JUST(session.Run(buffers->inputs, &buffers->outputs));
+    } else {
+      CHECK_JUST(scheduler->Run(buffers->inputs, &buffers->outputs));
+    }
+  };
+  std::vector<double> latencies(num_threads * num_requests);
+  std::vector<std::thread> threads;
+  // the timing starts when all the threads are done with the warmup requests
+  BlockingCounter warmup_counter(num_threads);
+  FOR_RANGE(int32_t, thread_id, 0, num_threads) {
+    threads.emplace_back([&, thread_id]() {
+      std::unique_ptr<RequestBuffers> buffers =
+          NewRequestBuffers(session, scheduler == nullptr ? -1 : request_batch_size);
+      FOR_RANGE(int32_t, i, 0, num_warmup_requests) { RunRequest(buffers.get()); }
+      warmup_counter.Decrease();
+      warmup_counter.WaitUntilCntEqualZero();
+      FOR_RANGE(int32_t, i, 0, num_requests) {
+        std::chrono::steady_clock::time_point request_begin = std::chrono::steady_clock::now();
+        RunRequest(buffers.get());
+        std::chrono::steady_clock::time_point request_end = std::chrono::steady_clock::now();
+        latencies.at(thread_id * num_requests + i) =
+            std::chrono::duration_cast<std::chrono::microseconds>(request_end - request_begin)
+                .count()
+            / 1000.0;
+      }
+    });
+  }
+  warmup_counter.WaitUntilCntEqualZero();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (std::thread& thread : threads) { thread.join(); }
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double duration_sec =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() / 1000000.0;
+
+  std::sort(latencies.begin(), latencies.end());
+  double latency_sum = 0;
+  for (double latency : latencies) { latency_sum += latency; }
+  std::cout << std::setw(15) << std::left << "#threads" << std::setw(15) << std::left
+            << "#requests" << std::setw(15) << std::left << "qps" << std::setw(15) << std::left
+            << "mean[ms]" << std::setw(15) << std::left << "p50[ms]" << std::setw(15) << std::left
+            << "p90[ms]" << std::setw(15) << std::left << "p99[ms]" << std::setw(15) << std::left
+            << "max[ms]" << std::endl;
+  std::cout << std::setw(15) << std::left << num_threads << std::setw(15) << std::left
+            << latencies.size() << std::setw(15) << std::left << latencies.size() / duration_sec
+            << std::setw(15) << std::left << latency_sum / latencies.size() << std::setw(15)
+            << std::left << Percentile(latencies, 50) << std::setw(15) << std::left
+            << Percentile(latencies, 90) << std::setw(15) << std::left
+            << Percentile(latencies, 99) << std::setw(15) << std::left << latencies.back()
+            << std::endl;
+  if (scheduler != nullptr) { std::cout << scheduler->GetStats() << std::endl; }
+}
+
+Maybe<void> RunInferenceBenchmark(const std::string& saved_model_dir, int64_t model_version,
+                                  const std::string& graph_name, const std::string& signature_name,
+                                  const std::string& device_tag, int32_t device_num,
+                                  int64_t max_batch_size, int64_t max_batch_delay_us,
+                                  int32_t num_batch_threads, int64_t request_batch_size,
+                                  int32_t num_threads, int32_t num_requests,
+                                  int32_t num_warmup_requests, int32_t ctrl_port) {
+  CHECK_GT_OR_RETURN(num_threads, 0);
+  CHECK_GT_OR_RETURN(num_requests, 0);
+  Global<EnvGlobalObjectsScope>::SetAllocated(new EnvGlobalObjectsScope());
+  JUST(Global<EnvGlobalObjectsScope>::Get()->Init(GetEnvProto(ctrl_port)));
+  {
+    InferenceSessionOption option;
+    option.device_tag = device_tag;
+    option.device_num = device_num;
+    InferenceSession session(option);
+    JUST(session.LoadSavedModel(saved_model_dir, model_version, graph_name, signature_name));
+    if (max_batch_size > 0) {
+      BatchingScheduler scheduler(&session, max_batch_size, max_batch_delay_us,
+                                  num_batch_threads);
+      Benchmark(session, &scheduler, request_batch_size, num_threads, num_requests,
+                num_warmup_requests);
+    } else {
+      Benchmark(session, nullptr, -1, num_threads, num_requests, num_warmup_requests);
+    }
+    JUST(session.Close());
+  }
+  ClusterInstruction::MasterSendHalt();
+  Global<EnvGlobalObjectsScope>::Delete();
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+}  // namespace oneflow
+
+/*
+ * Measures the latency and the throughput of serving a saved model, e.g.
+ *     ./inference_benchmark_main --saved_model_dir=./saved_models/resnet50 \
+ *          --device_tag=gpu --num_threads=4 --num_requests=1000
+ * and with the requests of 2 samples each batched together
+ *     ./inference_benchmark_main --saved_model_dir=./saved_models/resnet50 \
+ *          --num_threads=16 --max_batch_size=32 --request_batch_size=2
+ */
+DEFINE_string(saved_model_dir, "", "the directory of the saved model, holding its versions");
+DEFINE_int64(model_version, -1, "the version of the saved model, -1 for the latest one");
+DEFINE_string(graph_name, "", "the graph to run, empty for the default one");
+DEFINE_string(signature_name, "", "the signature of the graph, empty for the default one");
+DEFINE_string(device_tag, "cpu", "cpu or gpu");
+DEFINE_int32(device_num, 1, "the number of devices to run the graph on");
+DEFINE_int64(max_batch_size, 0, "the max samples of a batch of requests, 0 for no batching");
+DEFINE_int64(max_batch_delay_us, 1000, "the max time a request waits for a batch");
+DEFINE_int32(num_batch_threads, 2, "the number of batches running at the same time");
+DEFINE_int64(request_batch_size, 1, "the samples of every request when batching");
+DEFINE_int32(num_threads, 1, "the number of threads sending requests concurrently");
+DEFINE_int32(num_requests, 1000, "the number of requests every thread sends");
+DEFINE_int32(num_warmup_requests, 10, "the number of requests every thread sends before timing");
+DEFINE_int32(ctrl_port, 12143, "the control port for init CtrlServer/Client.");
+
+int main(int argc, char* argv[]) {
+  using namespace oneflow;
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  CHECK_JUST(RunInferenceBenchmark(FLAGS_saved_model_dir, FLAGS_model_version, FLAGS_graph_name,
+                                   FLAGS_signature_name, FLAGS_device_tag, FLAGS_device_num,
+                                   FLAGS_max_batch_size, FLAGS_max_batch_delay_us,
+                                   FLAGS_num_batch_threads, FLAGS_request_batch_size,
+                                   FLAGS_num_threads, FLAGS_num_requests,
+                                   FLAGS_num_warmup_requests, FLAGS_ctrl_port));
+  return 0;
+}
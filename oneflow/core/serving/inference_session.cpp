@@ -0,0 +1,398 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/inference_session.h"
+#include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/buffer_manager.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/control/ctrl_client.h"
+#include "oneflow/core/control/global_process_ctx.h"
+#include "oneflow/core/framework/instructions_builder.h"
+#include "oneflow/core/framework/session_util.h"
+#include "oneflow/core/job/cluster_instruction.h"
+#include "oneflow/core/job/env_desc.h"
+#include "oneflow/core/job/foreign_job_instance.h"
+#include "oneflow/core/job/global_for.h"
+#include "oneflow/core/job/job_build_and_infer_ctx_mgr.h"
+#include "oneflow/core/job/job_desc.h"
+#include "oneflow/core/job/oneflow.h"
+#include "oneflow/core/job/scope.h"
+#include "oneflow/core/job/session.h"
+#include "oneflow/core/job/session_global_objects_scope.h"
+#include "oneflow/core/persistence/file_system.h"
+#include "oneflow/core/register/ofblob.h"
+
+namespace oneflow {
+
+namespace {
+
+const std::string kSavedModelMetaFileBasename = "saved_model";
+
+// The C++ counterpart of the JobInstance in python/framework/job_instance.py
+class NativeJobInstance final : public ForeignJobInstance {
+ public:
+  NativeJobInstance(const std::string& job_name, const std::function<void(OfBlob*)>& push_cb,
+                    const std::function<void(OfBlob*)>& pull_cb,
+                    const std::shared_ptr<BlockingCounter>& finish_counter)
+      : job_name_(job_name),
+        push_cb_(push_cb),
+        pull_cb_(pull_cb),
+        finish_counter_(finish_counter) {}
+  ~NativeJobInstance() override = default;
+
+  std::string job_name() const override { return job_name_; }
+  void PushBlob(uint64_t ofblob_ptr) const override {
+    CHECK(push_cb_) << "job " << job_name_ << " has nothing to push";
+    push_cb_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void PullBlob(uint64_t ofblob_ptr) const override {
+    CHECK(pull_cb_) << "job " << job_name_ << " has nothing to pull";
+    pull_cb_(reinterpret_cast<OfBlob*>(ofblob_ptr));
+  }
+  void Finish() const override { finish_counter_->Decrease(); }
+
+ private:
+  std::string job_name_;
+  std::function<void(OfBlob*)> push_cb_;
+  std::function<void(OfBlob*)> pull_cb_;
+  std::shared_ptr<BlockingCounter> finish_counter_;
+};
+
+void LaunchNativeJob(const std::shared_ptr<ForeignJobInstance>& job_instance) {
+  const std::string job_name = job_instance->job_name();
+  auto* buffer_mgr = Global<BufferMgr<std::shared_ptr<ForeignJobInstance>>>::Get();
+  const int64_t job_id = Global<JobName2JobId>::Get()->at(job_name);
+  if (IsPullJob(job_name, *Global<InterUserJobInfo>::Get())) {
+    buffer_mgr->Get(GetForeignOutputBufferName(job_name))->Send(job_instance);
+  }
+  if (IsPushJob(job_name, *Global<InterUserJobInfo>::Get())) {
+    buffer_mgr->Get(GetForeignInputBufferName(job_name))->Send(job_instance);
+  }
+  buffer_mgr->Get(GetCallbackNotifierBufferName(job_name))->Send(job_instance);
+  Global<BufferMgr<int64_t>>::Get()->Get(kBufferNameGlobalWaitJobId)->Send(job_id);
+}
+
+Maybe<int64_t> FindLatestModelVersion(const std::string& saved_model_dir) {
+  int64_t latest_version = -1;
+  for (const std::string& name : LocalFS()->ListDir(saved_model_dir)) {
+    if (!LocalFS()->IsDirectory(JoinPath(saved_model_dir, name))) { continue; }
+    if (!std::all_of(name.cbegin(), name.cend(), [](char c) { return std::isdigit(c); })) {
+      continue;
+    }
+    latest_version = std::max<int64_t>(latest_version, std::stoll(name));
+  }
+  CHECK_GE_OR_RETURN(latest_version, 0) << "no model version found in " << saved_model_dir;
+  return latest_version;
+}
+
+Maybe<void> ParseSavedModel(const std::string& saved_model_path, SavedModel* saved_model) {
+  const std::string pb_file_path = JoinPath(saved_model_path, kSavedModelMetaFileBasename + ".pb");
+  const std::string prototxt_file_path =
+      JoinPath(saved_model_path, kSavedModelMetaFileBasename + ".prototxt");
+  if (LocalFS()->FileExists(pb_file_path)) {
+    CHECK_OR_RETURN(TryParseProtoFromPbFile(pb_file_path, saved_model))
+        << "failed to parse " << pb_file_path;
+  } else if (LocalFS()->FileExists(prototxt_file_path)) {
+    CHECK_OR_RETURN(TryParseProtoFromTextFile(prototxt_file_path, saved_model))
+        << "failed to parse " << prototxt_file_path;
+  } else {
+    return Error::ValueError("saved model meta file " + kSavedModelMetaFileBasename
+                             + " does not exist in " + saved_model_path);
+  }
+  return Maybe<void>::Ok();
+}
+
+Maybe<InferenceBlobInfo> GetBlobInfo(const JobBuildAndInferCtx& ctx, const std::string& op_name) {
+  const std::string lbn = *JUST(ctx.GetOpBlobLbn(op_name, "out"));
+  InferenceBlobInfo info;
+  info.static_shape = *JUST(ctx.GetStaticShape(lbn));
+  info.data_type = JUST(ctx.GetDataType(lbn));
+  info.is_dynamic = JUST(ctx.IsDynamic(lbn));
+  return info;
+}
+
+Maybe<void> CheckInput(const std::string& name, const InferenceBlobInfo& info,
+                       const InferenceTensor& input) {
+  CHECK_EQ_OR_RETURN(input.data_type, info.data_type) << "data type of input " << name;
+  if (info.is_dynamic) {
+    CHECK_EQ_OR_RETURN(input.shape.NumAxes(), info.static_shape.NumAxes())
+        << "shape of input " << name;
+    CHECK_LE_OR_RETURN(input.shape.elem_cnt(), info.static_shape.elem_cnt())
+        << "shape of input " << name;
+  } else {
+    CHECK_EQ_OR_RETURN(input.shape, info.static_shape) << "shape of input " << name;
+  }
+  CHECK_EQ_OR_RETURN(input.nbytes, input.shape.elem_cnt() * GetSizeOfDataType(input.data_type))
+      << "size of input " << name;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> CheckOutput(const std::string& name, const InferenceBlobInfo& info,
+                        const InferenceTensor& output) {
+  CHECK_EQ_OR_RETURN(output.data_type, info.data_type) << "data type of output " << name;
+  CHECK_GE_OR_RETURN(output.nbytes,
+                     info.static_shape.elem_cnt() * GetSizeOfDataType(info.data_type))
+      << "size of output " << name;
+  return Maybe<void>::Ok();
+}
+
+}  // namespace
+
+InferenceSession::InferenceSession(const InferenceSessionOption& option)
+    : option_(option), status_(kNew), session_id_(-1) {}
+
+InferenceSession::~InferenceSession() {
+  if (status_ != kClosed) { CHECK_JUST(Close()); }
+}
+
+Maybe<void> InferenceSession::LoadSavedModel(const std::string& saved_model_dir,
+                                             int64_t model_version, const std::string& graph_name,
+                                             const std::string& signature_name) {
+  CHECK_EQ_OR_RETURN(status_, kNew) << "a saved model has been loaded";
+  CHECK_OR_RETURN(LocalFS()->IsDirectory(saved_model_dir))
+      << saved_model_dir << " is not a valid directory";
+  if (model_version < 0) { model_version = JUST(FindLatestModelVersion(saved_model_dir)); }
+  const std::string saved_model_path = JoinPath(saved_model_dir, std::to_string(model_version));
+  CHECK_OR_RETURN(LocalFS()->IsDirectory(saved_model_path))
+      << "version " << model_version << " of saved model in " << saved_model_dir
+      << " does not exist";
+  SavedModel saved_model;
+  JUST(ParseSavedModel(saved_model_path, &saved_model));
+
+  const std::string& job_name = graph_name.empty() ? saved_model.default_graph_name() : graph_name;
+  const auto graph_it = saved_model.graphs().find(job_name);
+  CHECK_OR_RETURN(graph_it != saved_model.graphs().end()) << "graph " << job_name << " not found";
+  const GraphDef& graph_def = graph_it->second;
+  const JobSignatureDef* signature = nullptr;
+  if (!signature_name.empty() || graph_def.has_default_signature_name()) {
+    const std::string& name =
+        signature_name.empty() ? graph_def.default_signature_name() : signature_name;
+    const auto signature_it = graph_def.signatures().find(name);
+    CHECK_OR_RETURN(signature_it != graph_def.signatures().end())
+        << "signature " << name << " not found";
+    signature = &signature_it->second;
+  }
+
+  JUST(InitSession());
+  JUST(Compile(job_name, graph_def, signature));
+  JUST(Launch(JoinPath(saved_model_path, saved_model.checkpoint_dir())));
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::InitSession() {
+  CHECK_NOTNULL_OR_RETURN(Global<EnvDesc>::Get()) << "env not found";
+  CHECK_OR_RETURN(GlobalProcessCtx::IsThisProcessMaster());
+  CHECK_ISNULL_OR_RETURN(Global<SessionGlobalObjectsScope>::Get()) << "session exists";
+  session_id_ = NewSessionId();
+  JUST(RegsiterSession(session_id_));
+
+  ConfigProto config_proto;
+  config_proto.set_session_id(session_id_);
+  Resource* resource = config_proto.mutable_resource();
+  resource->set_machine_num(GlobalProcessCtx::NodeSize());
+  if (option_.device_tag == "gpu") {
+    resource->set_gpu_device_num(option_.device_num);
+    resource->set_cpu_device_num(std::thread::hardware_concurrency());
+  } else if (option_.device_tag == "cpu") {
+    resource->set_gpu_device_num(0);
+    resource->set_cpu_device_num(option_.device_num);
+  } else {
+    UNIMPLEMENTED_THEN_RETURN() << "device tag " << option_.device_tag;
+  }
+  config_proto.mutable_io_conf()->mutable_data_fs_conf()->mutable_localfs_conf();
+  config_proto.mutable_io_conf()->mutable_snapshot_fs_conf()->mutable_localfs_conf();
+  config_proto.mutable_io_conf()->set_enable_legacy_model_io(true);
+
+  ClusterInstruction::MasterSendSessionStart();
+  Global<CtrlClient>::Get()->PushKV("config_proto", config_proto);
+  Global<SessionGlobalObjectsScope>::SetAllocated(new SessionGlobalObjectsScope());
+  JUST(Global<SessionGlobalObjectsScope>::Get()->Init(config_proto));
+  status_ = kOpen;
+  return Maybe<void>::Ok();
+}
+
+Maybe<int64_t> InferenceSession::MakeInitialScopeSymbolId(const JobConfigProto& job_conf) const {
+  std::vector<std::string> machine_device_ids;
+  FOR_RANGE(int64_t, machine_id, 0, GlobalProcessCtx::NodeSize()) {
+    machine_device_ids.push_back(std::to_string(machine_id) + ":0-"
+                                 + std::to_string(option_.device_num - 1));
+  }
+  const auto cfg_job_conf = std::make_shared<cfg::JobConfigProto>(job_conf);
+  std::shared_ptr<Scope> scope;
+  JUST(LogicalRun([&](InstructionsBuilder* builder) -> Maybe<void> {
+    scope = JUST(builder->BuildInitialScope(session_id_, cfg_job_conf, option_.device_tag,
+                                            machine_device_ids, nullptr, false));
+    return Maybe<void>::Ok();
+  }));
+  CHECK_NOTNULL_OR_RETURN(scope) << "failed to build the initial scope";
+  return scope->symbol_id();
+}
+
+Maybe<void> InferenceSession::Compile(const std::string& job_name, const GraphDef& graph_def,
+                                      const JobSignatureDef* signature) {
+  CHECK_EQ_OR_RETURN(status_, kOpen);
+  JobConfigProto job_conf;
+  job_conf.set_job_name(job_name);
+  job_conf.mutable_predict_conf();
+  if (signature != nullptr) { *job_conf.mutable_signature() = *signature; }
+
+  auto* mgr = JUST(GlobalJobBuildAndInferCtxMgr());
+  JUST(mgr->OpenJobBuildAndInferCtx(job_name));
+  auto* ctx = JUST(GetCurInferCtx());
+  JUST(ctx->SetJobConf(job_conf));
+  const int64_t scope_symbol_id = JUST(MakeInitialScopeSymbolId(job_conf));
+  for (OperatorConf op_conf : graph_def.op_list()) {
+    op_conf.set_scope_symbol_id(scope_symbol_id);
+    if (!op_conf.has_device_tag()) {
+      op_conf.set_device_tag(option_.device_tag);
+    } else if (!op_conf.has_return_conf() && op_conf.device_tag() != option_.device_tag) {
+      LOG(WARNING) << "the device_tag of op " << op_conf.name()
+                   << " is not equal to the device_tag of the session (" << op_conf.device_tag()
+                   << " vs. " << option_.device_tag
+                   << "), which may cause the op graph to be incompatible";
+    }
+    JUST(ctx->AddAndInferConsistentOp(op_conf));
+  }
+  JUST(ctx->Complete());
+  JUST(ctx->Rebuild());
+  JUST(mgr->CloseCurrentJobBuildAndInferCtx());
+  job_name_ = job_name;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Launch(const std::string& checkpoint_path) {
+  CHECK_EQ_OR_RETURN(status_, kOpen);
+  const JobSet& job_set = Global<LazyJobBuildAndInferCtxMgr>::Get()->job_set();
+  CHECK_ISNULL_OR_RETURN(Global<Oneflow>::Get());
+  Global<CtrlClient>::Get()->PushKV("session_job_set", job_set);
+  Global<const InterJobReuseMemStrategy>::New(job_set.inter_job_reuse_mem_strategy());
+  Global<Oneflow>::New();
+  JUST(Global<Oneflow>::Get()->Init(job_set));
+  status_ = kRunning;
+  inter_user_job_info_ = *Global<InterUserJobInfo>::Get();
+
+  const auto* ctx = JUST(GetJobBuildAndInferCtx(job_name_));
+  for (const auto& pair : inter_user_job_info_.input_or_var_op_name2push_job_name()) {
+    input_name2info_.emplace(pair.first, *JUST(GetBlobInfo(*ctx, pair.first)));
+  }
+  for (const auto& pair : inter_user_job_info_.output_or_var_op_name2pull_job_name()) {
+    output_name2info_.emplace(pair.first, *JUST(GetBlobInfo(*ctx, pair.first)));
+  }
+
+  const auto finish_counter = std::make_shared<BlockingCounter>(1);
+  const auto PushCheckpointPath = [&checkpoint_path](OfBlob* of_blob) {
+    CHECK_EQ(of_blob->data_type(), DataType::kInt8);
+    const int64_t path_length = checkpoint_path.size();
+    of_blob->CopyShapeFrom(&path_length, 1);
+    of_blob->AutoMemCopyBytesFrom(checkpoint_path.data(), path_length);
+  };
+  LaunchNativeJob(std::make_shared<NativeJobInstance>(
+      inter_user_job_info_.global_model_load_job_name(), PushCheckpointPath, nullptr,
+      finish_counter));
+  finish_counter->WaitUntilCntEqualZero();
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Close() {
+  if (status_ == kRunning) {
+    Global<Oneflow>::Delete();
+    Global<const InterJobReuseMemStrategy>::Delete();
+  }
+  if (status_ == kOpen || status_ == kRunning) {
+    Global<SessionGlobalObjectsScope>::Delete();
+    JUST(ClearSessionById(session_id_));
+  }
+  status_ = kClosed;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferenceSession::Run(const HashMap<std::string, InferenceTensor>& inputs,
+                                  HashMap<std::string, InferenceTensor>* outputs) const {
+  CHECK_EQ_OR_RETURN(status_, kRunning) << "no saved model is loaded";
+  for (const auto& pair : input_name2info_) {
+    const auto it = inputs.find(pair.first);
+    CHECK_OR_RETURN(it != inputs.end()) << "input " << pair.first << " is absent";
+    JUST(CheckInput(pair.first, pair.second, it->second));
+  }
+  for (const auto& pair : *outputs) {
+    const auto it = output_name2info_.find(pair.first);
+    CHECK_OR_RETURN(it != output_name2info_.end()) << "output " << pair.first << " not found";
+    JUST(CheckOutput(pair.first, it->second, pair.second));
+  }
+
+  const auto& input_name2push_job_name = inter_user_job_info_.input_or_var_op_name2push_job_name();
+  const auto& output_name2pull_job_name =
+      inter_user_job_info_.output_or_var_op_name2pull_job_name();
+  const auto finish_counter = std::make_shared<BlockingCounter>(
+      input_name2push_job_name.size() + 1 + output_name2pull_job_name.size());
+  {
+    // a request must not interleave with the others, or they would get each other's blobs
+    std::unique_lock<std::mutex> lock(launch_mutex_);
+    for (const auto& pair : input_name2push_job_name) {
+      const InferenceTensor* input = &inputs.at(pair.first);
+      const auto Push = [input](OfBlob* of_blob) {
+        of_blob->CopyShapeFrom(input->shape.dim_vec().data(), input->shape.NumAxes());
+        of_blob->AutoMemCopyBytesFrom(input->data, input->nbytes);
+      };
+      LaunchNativeJob(
+          std::make_shared<NativeJobInstance>(pair.second, Push, nullptr, finish_counter));
+    }
+    LaunchNativeJob(
+        std::make_shared<NativeJobInstance>(job_name_, nullptr, nullptr, finish_counter));
+    for (const auto& pair : output_name2pull_job_name) {
+      const auto it = outputs->find(pair.first);
+      InferenceTensor* output = it == outputs->end() ? nullptr : &it->second;
+      const auto Pull = [output](OfBlob* of_blob) {
+        if (output == nullptr) { return; }
+        DimVector dim_vec(of_blob->NumAxes());
+        of_blob->CopyShapeTo(dim_vec.data(), dim_vec.size());
+        output->shape = Shape(dim_vec);
+        of_blob->AutoMemCopyBytesTo(output->data, output->nbytes);
+      };
+      LaunchNativeJob(
+          std::make_shared<NativeJobInstance>(pair.second, nullptr, Pull, finish_counter));
+    }
+  }
+  finish_counter->WaitUntilCntEqualZero();
+  return Maybe<void>::Ok();
+}
+
+std::vector<std::string> InferenceSession::ListInputs() const {
+  std::vector<std::string> input_names;
+  for (const auto& pair : input_name2info_) { input_names.push_back(pair.first); }
+  return input_names;
+}
+
+std::vector<std::string> InferenceSession::ListOutputs() const {
+  std::vector<std::string> output_names;
+  for (const auto& pair : output_name2info_) { output_names.push_back(pair.first); }
+  return output_names;
+}
+
+Maybe<const InferenceBlobInfo&> InferenceSession::InputInfo(const std::string& input_name) const {
+  const auto it = input_name2info_.find(input_name);
+  CHECK_OR_RETURN(it != input_name2info_.end()) << "input " << input_name << " not found";
+  return it->second;
+}
+
+Maybe<const InferenceBlobInfo&> InferenceSession::OutputInfo(
+    const std::string& output_name) const {
+  const auto it = output_name2info_.find(output_name);
+  CHECK_OR_RETURN(it != output_name2info_.end()) << "output " << output_name << " not found";
+  return it->second;
+}
+
+}  // namespace oneflow
@@ -0,0 +1,99 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
+#define ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
+
+#include "oneflow/core/common/maybe.h"
+#include "oneflow/core/common/shape.h"
+#include "oneflow/core/common/data_type.pb.h"
+#include "oneflow/core/job/inter_user_job_info.pb.h"
+#include "oneflow/core/job/job_conf.pb.h"
+#include "oneflow/core/job/job_set.pb.h"
+#include "oneflow/core/serving/saved_model.pb.h"
+
+namespace oneflow {
+
+struct InferenceSessionOption {
+  std::string device_tag = "cpu";
+  int64_t device_num = 1;
+};
+
+struct InferenceBlobInfo {
+  Shape static_shape;
+  DataType data_type;
+  bool is_dynamic;
+};
+
+// A tensor in memory owned by the caller. For an input, data holds nbytes bytes of a tensor of
+// shape, which must be the static shape unless the input is dynamic. For an output, data can hold
+// nbytes bytes, at least the size of the static shape, and shape is set to the shape of the result
+struct InferenceTensor {
+  DataType data_type;
+  Shape shape;
+  void* data;
+  size_t nbytes;
+};
+
+// Serves a SavedModel from C++ without going through Python. The model is compiled and launched
+// once in LoadSavedModel, after which Run can be called from any number of threads. Inputs are
+// copied straight from the caller buffers into the input blobs and outputs straight from the
+// output blobs into the caller buffers, with no other copies in between. The requests are queued
+// to the runtime under a lock and then run in a pipeline, so they finish in the order they were
+// queued. There can be only one session in a process, and the env must be initialized
+class InferenceSession final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(InferenceSession);
+  explicit InferenceSession(const InferenceSessionOption& option);
+  ~InferenceSession();
+
+  // Loads model_version of the saved model in saved_model_dir, the latest one if model_version is
+  // -1, and the graph_name graph with the signature_name signature, the default ones if empty
+  Maybe<void> LoadSavedModel(const std::string& saved_model_dir, int64_t model_version,
+                             const std::string& graph_name, const std::string& signature_name);
+  // Must not be called before all the Run calls return
+  Maybe<void> Close();
+
+  // Blocks until the outputs are ready. Outputs absent from outputs are discarded
+  Maybe<void> Run(const HashMap<std::string, InferenceTensor>& inputs,
+                  HashMap<std::string, InferenceTensor>* outputs) const;
+
+  std::vector<std::string> ListInputs() const;
+  std::vector<std::string> ListOutputs() const;
+  Maybe<const InferenceBlobInfo&> InputInfo(const std::string& input_name) const;
+  Maybe<const InferenceBlobInfo&> OutputInfo(const std::string& output_name) const;
+
+ private:
+  enum Status { kNew = 0, kOpen = 1, kRunning = 2, kClosed = 3 };
+
+  Maybe<void> InitSession();
+  Maybe<int64_t> MakeInitialScopeSymbolId(const JobConfigProto& job_conf) const;
+  Maybe<void> Compile(const std::string& job_name, const GraphDef& graph_def,
+                      const JobSignatureDef* signature);
+  Maybe<void> Launch(const std::string& checkpoint_path);
+
+  InferenceSessionOption option_;
+  Status status_;
+  int64_t session_id_;
+  std::string job_name_;
+  InterUserJobInfo inter_user_job_info_;
+  HashMap<std::string, InferenceBlobInfo> input_name2info_;
+  HashMap<std::string, InferenceBlobInfo> output_name2info_;
+  mutable std::mutex launch_mutex_;
+};
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_INFERENCE_SESSION_H_
@@ -0,0 +1,63 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include <gtest/gtest.h>
+#include "oneflow/core/serving/inference_session.h"
+#include "oneflow/core/serving/test_util.h"
+
+namespace oneflow {
+namespace test {
+
+class InferenceSessionTest : public ::testing::Test {
+ protected:
+  static void SetUpTestCase() { env_scope_.reset(new TestServingEnvScope()); }
+  static void TearDownTestCase() { env_scope_.reset(); }
+
+  static std::unique_ptr<TestServingEnvScope> env_scope_;
+};
+
+std::unique_ptr<TestServingEnvScope> InferenceSessionTest::env_scope_;
+
+TEST_F(InferenceSessionTest, load_and_run) {
+  if (!env_scope_->is_inited()) { return; }
+  TestSavedModelDir saved_model_dir("tmp_test_inference_session_model");
+  const Shape shape({4, 3});
+  WriteScaleSavedModel(saved_model_dir.path(), shape, 2);
+
+  InferenceSession session(InferenceSessionOption{});
+  CHECK_JUST(session.LoadSavedModel(saved_model_dir.path(), -1, "", ""));
+  ASSERT_EQ(session.ListInputs(), std::vector<std::string>{"x"});
+  ASSERT_EQ(session.ListOutputs(), std::vector<std::string>{"out"});
+  const InferenceBlobInfo input_info = CHECK_JUST(session.InputInfo("x"));
+  ASSERT_EQ(input_info.static_shape, shape);
+  ASSERT_EQ(input_info.data_type, DataType::kFloat);
+  ASSERT_FALSE(input_info.is_dynamic);
+
+  std::vector<float> x(shape.elem_cnt());
+  std::vector<float> out(shape.elem_cnt(), 0);
+  FOR_RANGE(int64_t, i, 0, x.size()) { x.at(i) = i - 5.5f; }
+  HashMap<std::string, InferenceTensor> inputs;
+  inputs.emplace("x", InferenceTensor{DataType::kFloat, shape, x.data(), x.size() * sizeof(float)});
+  HashMap<std::string, InferenceTensor> outputs;
+  outputs.emplace("out", InferenceTensor{DataType::kFloat, Shape(), out.data(),
+                                         out.size() * sizeof(float)});
+  CHECK_JUST(session.Run(inputs, &outputs));
+  ASSERT_EQ(outputs.at("out").shape, shape);
+  FOR_RANGE(int64_t, i, 0, x.size()) { ASSERT_FLOAT_EQ(out.at(i), 2 * x.at(i)); }
+  CHECK_JUST(session.Close());
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,107 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/serving/test_util.h"
+#include "oneflow/core/serving/saved_model.pb.h"
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/control/ctrl_util.h"
+#include "oneflow/core/framework/user_op_conf.h"
+#include "oneflow/core/job/cluster_instruction.h"
+#include "oneflow/core/job/env.pb.h"
+#include "oneflow/core/job/env_global_objects_scope.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace test {
+
+namespace {
+
+EnvProto GetEnvProto(int32_t ctrl_port) {
+  EnvProto ret;
+  auto* machine0 = ret.add_machine();
+  machine0->set_id(0);
+  machine0->set_addr("127.0.0.1");
+  ret.set_ctrl_port(ctrl_port);
+  return ret;
+}
+
+}  // namespace
+
+TestServingEnvScope::TestServingEnvScope() : is_inited_(false) {
+  const int ctrl_port = CtrlUtil().FindAvailablePort();
+  if (ctrl_port == -1) { return; }
+  Global<EnvGlobalObjectsScope>::SetAllocated(new EnvGlobalObjectsScope());
+  CHECK_JUST(Global<EnvGlobalObjectsScope>::Get()->Init(GetEnvProto(ctrl_port)));
+  is_inited_ = true;
+}
+
+TestServingEnvScope::~TestServingEnvScope() {
+  if (!is_inited_) { return; }
+  ClusterInstruction::MasterSendHalt();
+  Global<EnvGlobalObjectsScope>::Delete();
+}
+
+TestSavedModelDir::TestSavedModelDir(const std::string& name) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  path_ = JoinPath(current_dir, name);
+  if (LocalFS()->IsDirectory(path_)) { LocalFS()->RecursivelyDeleteDir(path_); }
+  LocalFS()->RecursivelyCreateDir(path_);
+}
+
+TestSavedModelDir::~TestSavedModelDir() { LocalFS()->RecursivelyDeleteDir(path_); }
+
+void WriteScaleSavedModel(const std::string& saved_model_dir, const Shape& shape, float scale) {
+  const std::string kGraphName = "scale";
+  SavedModel saved_model;
+  saved_model.set_name(kGraphName);
+  saved_model.set_version(1);
+  saved_model.set_checkpoint_dir("variables");
+  saved_model.set_default_graph_name(kGraphName);
+  GraphDef* graph_def = &(*saved_model.mutable_graphs())[kGraphName];
+
+  OperatorConf* input_op_conf = graph_def->add_op_list();
+  input_op_conf->set_name("x");
+  InputOpConf* input_conf = input_op_conf->mutable_input_conf();
+  input_conf->set_out("out");
+  shape.ToProto(input_conf->mutable_blob_conf()->mutable_shape());
+  input_conf->mutable_blob_conf()->set_data_type(DataType::kFloat);
+  input_conf->mutable_blob_conf()->set_is_dynamic(false);
+
+  const auto scale_op = user_op::UserOpConfWrapperBuilder("scale")
+                            .Op("scalar_mul")
+                            .Input("in", "x/out")
+                            .Output("out")
+                            .Attr<bool>("has_int_operand", false)
+                            .Attr<bool>("has_float_operand", true)
+                            .Attr<int64_t>("int_operand", 0)
+                            .Attr<double>("float_operand", scale)
+                            .Build();
+  *graph_def->add_op_list() = scale_op.op_conf();
+
+  OperatorConf* return_op_conf = graph_def->add_op_list();
+  return_op_conf->set_name("out");
+  return_op_conf->mutable_return_conf()->set_in(scale_op.output("out", 0));
+  return_op_conf->mutable_return_conf()->set_out("out");
+
+  const std::string saved_model_path = JoinPath(saved_model_dir, "1");
+  LocalFS()->RecursivelyCreateDir(JoinPath(saved_model_path, saved_model.checkpoint_dir()));
+  PrintProtoToTextFile(saved_model, JoinPath(saved_model_path, "saved_model.prototxt"));
+}
+
+}  // namespace test
+}  // namespace oneflow
@@ -0,0 +1,59 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_CORE_SERVING_TEST_UTIL_H_
+#define ONEFLOW_CORE_SERVING_TEST_UTIL_H_
+
+#include "oneflow/core/common/shape.h"
+
+namespace oneflow {
+namespace test {
+
+// Initializes the env of a single machine on a free control port and halts it on destruction.
+// is_inited() is false if no port is free, in which case the serving tests do nothing
+class TestServingEnvScope final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestServingEnvScope);
+  TestServingEnvScope();
+  ~TestServingEnvScope();
+
+  bool is_inited() const { return is_inited_; }
+
+ private:
+  bool is_inited_;
+};
+
+// Makes a directory under the current one for the saved models of a test and removes it on
+// destruction
+class TestSavedModelDir final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(TestSavedModelDir);
+  explicit TestSavedModelDir(const std::string& name);
+  ~TestSavedModelDir();
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+// Writes version 1 of a saved model without variables, whose default graph multiplies the float
+// input "x" of the static shape by scale into the output "out"
+void WriteScaleSavedModel(const std::string& saved_model_dir, const Shape& shape, float scale);
+
+}  // namespace test
+}  // namespace oneflow
+
+#endif  // ONEFLOW_CORE_SERVING_TEST_UTIL_H_
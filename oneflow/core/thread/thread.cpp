@@ -75,10 +75,16 @@ void Thread::PollMsgChannel(const ThreadCtx& thread_ctx) {
 
 void Thread::ConstructActor(int64_t actor_id, const ThreadCtx& thread_ctx) {
   LOG(INFO) << "thread " << thrd_id_ << " construct actor " << actor_id;
-  std::unique_lock<std::mutex> lck(id2task_mtx_);
-  auto task_it = id2task_.find(actor_id);
-  CHECK(id2actor_ptr_.emplace(actor_id, NewActor(task_it->second, thread_ctx)).second);
-  id2task_.erase(task_it);
+  TaskProto task;
+  {
+    // the lock is not held while constructing, or it would hold up AddTask for the other actors
+    std::unique_lock<std::mutex> lck(id2task_mtx_);
+    auto task_it = id2task_.find(actor_id);
+    CHECK(task_it != id2task_.end());
+    task.Swap(&task_it->second);
+    id2task_.erase(task_it);
+  }
+  CHECK(id2actor_ptr_.emplace(actor_id, NewActor(task, thread_ctx)).second);
   Global<RuntimeCtx>::Get()->DecreaseCounter("constructing_actor_cnt");
 }
 
@@ -75,4 +75,19 @@ void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback) {
   bc.WaitUntilCntEqualZero();
 }
 
+void ParallelForEachTask(int64_t num_tasks, const std::function<void(int64_t task_id)>& Handler) {
+  if (num_tasks == 0) { return; }
+  // a work of the pool waiting for other works of the pool could wait for itself
+  if (Global<ThreadPool>::Get()->IsCurrentThreadInPool()) {
+    FOR_RANGE(int64_t, task_id, 0, num_tasks) { Handler(task_id); }
+    return;
+  }
+  const int64_t num_parts = std::min<int64_t>(num_tasks, Global<ThreadPool>::Get()->thread_num());
+  const BalancedSplitter bs(num_tasks, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, task_id, range.begin(), range.end()) { Handler(task_id); }
+  });
+}
+
 }  // namespace oneflow
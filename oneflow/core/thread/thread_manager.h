@@ -43,6 +43,9 @@ class ThreadMgr final {
 
 void SingleThreadLoop(size_t num, std::function<void(size_t i)> Callback);
 void MultiThreadLoop(size_t num, std::function<void(size_t i)> Callback);
+// Runs Handler(task_id) for task_id in [0, num_tasks) with contiguous chunks of tasks per thread
+// of the pool, or all on the calling thread if it is a thread of the pool itself
+void ParallelForEachTask(int64_t num_tasks, const std::function<void(int64_t task_id)>& Handler);
 
 #define REGISTER_DEVICE_THREAD_CREATOR_WITH_STREAM_ID(device, creator) \
   REGISTER_CLASS_CREATOR(int, device, Thread, creator, const StreamId&)
@@ -17,11 +17,18 @@ limitations under the License.
 
 namespace oneflow {
 
+namespace {
+
+thread_local const ThreadPool* current_thread_pool = nullptr;
+
+}  // namespace
+
 ThreadPool::ThreadPool(int32_t thread_num)
     : work_chans_(thread_num), threads_(thread_num), work_cnt_(0) {
   FOR_RANGE(int32_t, i, 0, thread_num) {
     Channel<std::function<void()>>* chan = &(work_chans_.at(i));
-    threads_[i] = std::thread([chan]() {
+    threads_[i] = std::thread([this, chan]() {
+      current_thread_pool = this;
       std::function<void()> work;
       while (chan->Receive(&work) == kChannelStatusSuccess) { work(); }
     });
@@ -41,4 +48,6 @@ void ThreadPool::AddWork(const std::function<void()>& work) {
   work_chans_.at(cur_chan_idx).Send(work);
 }
 
+bool ThreadPool::IsCurrentThreadInPool() const { return current_thread_pool == this; }
+
 }  // namespace oneflow
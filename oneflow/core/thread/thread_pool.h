@@ -30,6 +30,9 @@ class ThreadPool final {
 
   int32_t thread_num() const { return threads_.size(); }
   void AddWork(const std::function<void()>& work);
+  // a work waiting for other works of the pool must not run on a thread of the pool, which the
+  // other works may be queued behind
+  bool IsCurrentThreadInPool() const;
 
  private:
   std::vector<Channel<std::function<void()>>> work_chans_;
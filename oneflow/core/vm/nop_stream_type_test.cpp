@@ -167,6 +167,35 @@ TEST(NopStreamType, one_argument_triger_all_instructions) {
   DestroyNumProcessPerNode();
 }
 
+TEST(NopStreamType, dispatch_prescheduled_instructions_at_once) {
+  InitNumProcessPerNode();
+  auto vm_desc = ObjectMsgPtr<VmDesc>::New(TestUtil::NewVmResourceDesc().Get());
+  TestUtil::AddStreamDescByInstrNames(vm_desc.Mutable(), {"Nop", "NewObject"});
+  auto vm = NaiveNewVirtualMachine(vm_desc.Get());
+  InstructionMsgList list;
+  int64_t object_id = TestUtil::NewObject(&list, "cpu", "0:0");
+  for (int i = 0; i < 3; ++i) {
+    auto nop_instr_msg = NewInstruction("Nop");
+    nop_instr_msg->add_mut_operand(object_id);
+    list.EmplaceBack(std::move(nop_instr_msg));
+  }
+  vm->Receive(&list);
+  vm->Schedule();
+  // the nops depending on each other on the same stream are all dispatched by one Schedule
+  ASSERT_TRUE(vm->ready_instruction_list().empty());
+  ASSERT_TRUE(vm->dispatching_thread_ctx_list().empty());
+  auto* thread_ctx = FindNopThreadCtx(vm.Mutable());
+  ASSERT_TRUE(thread_ctx != nullptr);
+  auto* stream = thread_ctx->mut_stream_list()->Begin();
+  ASSERT_TRUE(stream != nullptr);
+  ASSERT_EQ(stream->running_instruction_list().size(), 3);
+  while (!vm->Empty()) {
+    vm->Schedule();
+    OBJECT_MSG_LIST_FOR_EACH_PTR(vm->mut_thread_ctx_list(), t) { t->TryReceiveAndRun(); }
+  }
+  DestroyNumProcessPerNode();
+}
+
 }  // namespace
 
 }  // namespace test
@@ -18,13 +18,16 @@ limitations under the License.
 #include "oneflow/core/vm/no_arg_cb_phy_instr_operand.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/common/blocking_counter.h"
+#include "oneflow/core/common/thread_local_object_msg_allocator.h"
 #include "oneflow/core/control/global_process_ctx.h"
 #include "oneflow/core/job/global_for.h"
 
 namespace oneflow {
 
 OneflowVM::OneflowVM(const Resource& resource, int64_t this_machine_id)
-    : vm_(ObjectMsgPtr<vm::VirtualMachine>::New(vm::MakeVmDesc(resource, this_machine_id).Get())) {
+    : vm_(ObjectMsgPtr<vm::VirtualMachine>::NewFrom(
+        ThreadLocalObjectMsgAllocator::GlobalObjectMsgAllocator(),
+        vm::MakeVmDesc(resource, this_machine_id).Get())) {
   OBJECT_MSG_LIST_UNSAFE_FOR_EACH_PTR(vm_->mut_thread_ctx_list(), thread_ctx) {
     auto thread = std::make_unique<std::thread>(&vm::ThreadCtx::LoopRun, thread_ctx);
     worker_threads_.push_back(std::move(thread));
@@ -34,9 +34,13 @@ OBJECT_MSG_BEGIN(ThreadCtx);
 
   // links
   OBJECT_MSG_DEFINE_LIST_LINK(thread_ctx_link);
+  OBJECT_MSG_DEFINE_LIST_LINK(dispatching_thread_ctx_link);
   OBJECT_MSG_DEFINE_LIST_HEAD(Stream, thread_ctx_stream_link, stream_list);
   OBJECT_MSG_DEFINE_CONDITION_LIST_HEAD(Instruction, pending_instruction_link,
                                         pending_instruction_list);
+  // only accessed by the scheduler thread, moved to pending_instruction_list at once
+  OBJECT_MSG_DEFINE_LIST_HEAD(Instruction, pending_instruction_link,
+                              dispatching_instruction_list);
 
   OF_PRIVATE ObjectMsgConditionListStatus ReceiveAndRun();
   OF_PUBLIC ObjectMsgConditionListStatus TryReceiveAndRun();
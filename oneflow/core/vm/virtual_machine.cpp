@@ -515,21 +515,37 @@ void VirtualMachine::DispatchAndPrescheduleInstructions(
   PrescheduledInstructionList prescheduled;
   auto* active_stream_list = mut_active_stream_list();
   auto* vm_stat_running_list = mut_vm_stat_running_instruction_list();
-  OBJECT_MSG_LIST_FOR_EACH_PTR(ready_instruction_list, instruction) {
-    vm_stat_running_list->PushBack(instruction);
-    auto* stream = instruction->mut_stream();
-    ready_instruction_list->MoveToDstBack(instruction, stream->mut_running_instruction_list());
-    if (stream->is_active_stream_link_empty()) { active_stream_list->PushBack(stream); }
-    const auto& stream_type = stream->stream_type();
-    if (stream_type.SharingVirtualMachineThread()) {
-      stream_type.Run(this, instruction);
-    } else {
-      stream->mut_thread_ctx()->mut_pending_instruction_list()->PushBack(instruction);
+  auto* dispatching_thread_ctx_list = mut_dispatching_thread_ctx_list();
+  // The instructions prescheduled behind the dispatched ones are dispatched in the same round, so
+  // that a run of dependent instructions on a stream, e.g. tiny eager ops, reaches the worker
+  // thread as one batch
+  while (!ready_instruction_list->empty()) {
+    OBJECT_MSG_LIST_FOR_EACH_PTR(ready_instruction_list, instruction) {
+      vm_stat_running_list->PushBack(instruction);
+      auto* stream = instruction->mut_stream();
+      ready_instruction_list->MoveToDstBack(instruction, stream->mut_running_instruction_list());
+      if (stream->is_active_stream_link_empty()) { active_stream_list->PushBack(stream); }
+      const auto& stream_type = stream->stream_type();
+      if (stream_type.SharingVirtualMachineThread()) {
+        stream_type.Run(this, instruction);
+      } else {
+        auto* thread_ctx = stream->mut_thread_ctx();
+        thread_ctx->mut_dispatching_instruction_list()->PushBack(instruction);
+        if (thread_ctx->is_dispatching_thread_ctx_link_empty()) {
+          dispatching_thread_ctx_list->PushBack(thread_ctx);
+        }
+      }
+      TryMoveWaitingToReady(instruction, &prescheduled,
+                            [stream](Instruction* dst) { return &dst->stream() == stream; });
     }
-    TryMoveWaitingToReady(instruction, &prescheduled,
-                          [stream](Instruction* dst) { return &dst->stream() == stream; });
+    prescheduled.MoveTo(ready_instruction_list);
+  }
+  // one lock and at most one wakeup for every worker thread
+  OBJECT_MSG_LIST_FOR_EACH_PTR(dispatching_thread_ctx_list, thread_ctx) {
+    thread_ctx->mut_pending_instruction_list()->MoveFrom(
+        thread_ctx->mut_dispatching_instruction_list());
+    dispatching_thread_ctx_list->Erase(thread_ctx);
   }
-  prescheduled.MoveTo(ready_instruction_list);
 }
 
 template<typename ReadyList, typename IsEdgeReadyT>
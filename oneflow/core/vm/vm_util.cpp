@@ -16,6 +16,7 @@ limitations under the License.
 #include "oneflow/core/common/blocking_counter.h"
 #include "oneflow/core/common/util.h"
 #include "oneflow/core/common/protobuf.h"
+#include "oneflow/core/common/thread_local_object_msg_allocator.h"
 #include "oneflow/core/job/cluster_instruction.h"
 #include "oneflow/core/vm/vm_util.h"
 #include "oneflow/core/vm/oneflow_vm.h"
@@ -31,7 +32,9 @@ namespace oneflow {
 namespace vm {
 
 ObjectMsgPtr<InstructionMsg> NewInstruction(const std::string& instr_type_name) {
-  return ObjectMsgPtr<InstructionMsg>::New(instr_type_name);
+  // made on the main thread and deleted on the scheduler thread
+  return ObjectMsgPtr<InstructionMsg>::NewFrom(
+      ThreadLocalObjectMsgAllocator::GlobalObjectMsgAllocator(), instr_type_name);
 }
 
 Maybe<void> Run(vm::InstructionMsgList* instr_msg_list) {
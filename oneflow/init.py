@@ -29,6 +29,7 @@ locals()["dtype"] = oneflow._oneflow_internal.dtype
 locals()["char"] = oneflow._oneflow_internal.char
 locals()["float16"] = oneflow._oneflow_internal.float16
 locals()["half"] = oneflow._oneflow_internal.float16
+locals()["bfloat16"] = oneflow._oneflow_internal.bfloat16
 locals()["float32"] = oneflow._oneflow_internal.float32
 locals()["float"] = oneflow._oneflow_internal.float
 locals()["double"] = oneflow._oneflow_internal.double
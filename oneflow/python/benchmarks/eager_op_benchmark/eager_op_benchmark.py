@@ -0,0 +1,77 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+"""
+Measures how many eager ops per second are run on tiny tensors, where the time goes to
+dispatching the ops and to the virtual machine rather than to the kernels, e.g.
+
+    python3 eager_op_benchmark.py --op=add --shape=1,4 --num_ops=100000
+"""
+import argparse
+import time
+
+import numpy as np
+import oneflow.experimental as flow
+
+parser = argparse.ArgumentParser(description="flags for eager op benchmark")
+parser.add_argument("--op", type=str, default="add", choices=["add", "mul", "neg"])
+parser.add_argument("--device", type=str, default="cpu", help="cpu or cuda")
+parser.add_argument("--shape", type=str, default="1,4", help="shape of the input tensors")
+parser.add_argument("--num_ops", type=int, default=100000)
+parser.add_argument("--num_warmup_ops", type=int, default=1000)
+parser.add_argument("--num_iters", type=int, default=3)
+args = parser.parse_args()
+
+
+def run_ops(x, y, num_ops):
+    if args.op == "add":
+        for _ in range(num_ops):
+            x = flow.add(x, y)
+    elif args.op == "mul":
+        for _ in range(num_ops):
+            x = flow.mul(x, y)
+    else:
+        for _ in range(num_ops):
+            x = flow.neg(x)
+    # blocks until all the ops are done
+    return x.numpy()
+
+
+def main():
+    flow.enable_eager_execution()
+    shape = tuple(int(dim) for dim in args.shape.split(","))
+    device = flow.device(args.device)
+    x = flow.Tensor(np.ones(shape, dtype=np.float32), device=device)
+    y = flow.Tensor(np.ones(shape, dtype=np.float32), device=device)
+    run_ops(x, y, args.num_warmup_ops)
+    for i in range(args.num_iters):
+        start = time.time()
+        run_ops(x, y, args.num_ops)
+        duration = time.time() - start
+        print(
+            "iter {}: {} {} ops on shape {} in {:.3f} s, {:.1f} ops/sec, {:.2f} us/op".format(
+                i,
+                args.num_ops,
+                args.op,
+                shape,
+                duration,
+                args.num_ops / duration,
+                duration * 1e6 / args.num_ops,
+            )
+        )
+
+
+if __name__ == "__main__":
+    main()
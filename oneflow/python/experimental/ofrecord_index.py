@@ -0,0 +1,121 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import argparse
+
+from oneflow.python.oneflow_export import oneflow_export
+
+# keep in sync with OFRecordIndex in oneflow/user/data/ofrecord_random_access_dataset.h
+_MAGIC_CODE = b"OFRIDX\x00\x00"
+_VERSION = 1
+
+
+def get_part_file_path(
+    ofrecord_dir, part_id, part_name_prefix="part-", part_name_suffix_length=-1
+):
+    num = str(part_id)
+    zero_count = max(part_name_suffix_length - len(num), 0)
+    return os.path.join(ofrecord_dir, part_name_prefix + "0" * zero_count + num)
+
+
+def build_part_file_index(part_file_path):
+    offsets = []
+    lengths = []
+    part_file_size = os.path.getsize(part_file_path)
+    with open(part_file_path, "rb") as f:
+        pos = 0
+        while pos < part_file_size:
+            size_bytes = f.read(8)
+            assert len(size_bytes) == 8, "truncated record at {} of {}".format(
+                pos, part_file_path
+            )
+            (length,) = struct.unpack("<q", size_bytes)
+            assert length > 0, "bad record size {} at {} of {}".format(
+                length, pos, part_file_path
+            )
+            assert (
+                pos + 8 + length <= part_file_size
+            ), "truncated record at {} of {}".format(pos, part_file_path)
+            offsets.append(pos + 8)
+            lengths.append(length)
+            pos += 8 + length
+            f.seek(pos)
+    index_file_path = part_file_path + ".idx"
+    with open(index_file_path + ".tmp", "wb") as f:
+        f.write(_MAGIC_CODE)
+        f.write(struct.pack("<QQQ", _VERSION, part_file_size, len(offsets)))
+        f.write(struct.pack("<{}q".format(len(offsets)), *offsets))
+        f.write(struct.pack("<{}q".format(len(lengths)), *lengths))
+    os.replace(index_file_path + ".tmp", index_file_path)
+    return len(offsets)
+
+
+@oneflow_export("data.build_ofrecord_index")
+def build_ofrecord_index(
+    ofrecord_dir: str,
+    data_part_num: int = 1,
+    part_name_prefix: str = "part-",
+    part_name_suffix_length: int = -1,
+) -> int:
+    r"""Build the index file of every part file of an ofrecord dataset, which is needed to read
+    the dataset by :func:`oneflow.data.ofrecord_reader` with `random_access=True`. The index of
+    a part file is written next to it, with the suffix ".idx". Rebuild the index whenever the part
+    file changes.
+
+    Args:
+        ofrecord_dir (str): Path to ofrecord dataset.
+        data_part_num (int, optional): Number of dataset's partitions. Defaults to 1.
+        part_name_prefix (str, optional): Prefix of dataset's parition file. Defaults to "part-".
+        part_name_suffix_length (int, optional): Total length of padded suffix number , -1 means no padding. eg: 3 for `part-001`. Defaults to -1.
+
+    Returns:
+        int: Number of records in the dataset
+
+    It can be run as a script as well:
+
+    .. code-block:: shell
+
+        python3 -m oneflow.python.experimental.ofrecord_index ./dataset/ --data_part_num 8
+
+    """
+    num_records = 0
+    for part_id in range(data_part_num):
+        num_records += build_part_file_index(
+            get_part_file_path(
+                ofrecord_dir, part_id, part_name_prefix, part_name_suffix_length
+            )
+        )
+    return num_records
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("ofrecord_dir", type=str)
+    parser.add_argument("--data_part_num", type=int, default=1)
+    parser.add_argument("--part_name_prefix", type=str, default="part-")
+    parser.add_argument("--part_name_suffix_length", type=int, default=-1)
+    args = parser.parse_args()
+    print(
+        "indexed {} records".format(
+            build_ofrecord_index(
+                args.ofrecord_dir,
+                args.data_part_num,
+                args.part_name_prefix,
+                args.part_name_suffix_length,
+            )
+        )
+    )
@@ -23,6 +23,7 @@ import oneflow.core.job.env_pb2 as env_pb2
 import oneflow.core.job.job_set_pb2 as job_set_pb
 import oneflow.core.job.job_pb2 as job_pb
 import oneflow.core.job.placement_pb2 as placement_pb
+import oneflow.core.job.plan_pb2 as plan_pb
 import oneflow.core.job.resource_pb2 as resource_util
 import oneflow.core.operator.op_attribute_pb2 as op_attribute_pb
 import oneflow.core.operator.op_conf_pb2 as op_conf_util
@@ -259,6 +260,14 @@ def GetJobSet():
     return ret
 
 
+@oneflow_export("experimental.get_plan")
+def GetPlan():
+    plan = oneflow._oneflow_internal.GetSerializedPlan()
+    ret = plan_pb.Plan()
+    ret.ParseFromString(plan)
+    return ret
+
+
 def GetCurrentJob():
     serialized_job = oneflow._oneflow_internal.GetSerializedCurrentJob()
     ret = job_pb.Job()
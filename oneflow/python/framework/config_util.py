@@ -464,6 +464,25 @@ def enable_mem_chain_merge(val=True):
     sess.config_proto.resource.enable_mem_chain_merge = val
 
 
+@oneflow_export("config.enable_lazy_kernel_init")
+def api_enable_lazy_kernel_init(val: bool = True) -> None:
+    r"""Whether or not to defer the device part of kernel init, e.g. creating cudnn handles and
+    the states of user op kernels, from the construction of the actors to their first act,
+    which makes large jobs start faster.
+
+    Args:
+        val (bool, optional): True or False. Defaults to True.
+    """
+    return enable_if.unique([enable_lazy_kernel_init, do_nothing])(val=val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def enable_lazy_kernel_init(val=True):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.enable_lazy_kernel_init = val
+
+
 @oneflow_export("config.nccl_use_compute_stream")
 def api_nccl_use_compute_stream(val: bool = False) -> None:
     r"""Whether or not nccl use compute stream to reuse nccl memory and speedup
@@ -687,6 +706,80 @@ def nccl_enable_mixed_fusion(val):
     sess.config_proto.resource.collective_boxing_conf.nccl_enable_mixed_fusion = val
 
 
+@oneflow_export("config.collective_boxing.comm_net_enable")
+def api_comm_net_enable(val: bool) -> None:
+    r"""Whether or not use collective boxing over comm net for the placements on cpu
+
+    Args:
+        val (bool): True or False
+    """
+    return enable_if.unique([comm_net_enable, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_enable(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is bool
+    sess.config_proto.resource.collective_boxing_conf.comm_net_enable = val
+
+
+@oneflow_export("config.collective_boxing.comm_net_chunk_size_kb")
+def api_comm_net_chunk_size_kb(val: int) -> None:
+    r"""Set up the size of the chunks of comm net collective boxing messages
+
+    Args:
+        val (int): int number, e.g. 1024(kb)
+    """
+    return enable_if.unique([comm_net_chunk_size_kb, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_chunk_size_kb(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.comm_net_chunk_size_kb = val
+
+
+@oneflow_export("config.collective_boxing.comm_net_num_threads")
+def api_comm_net_num_threads(val: int) -> None:
+    r"""Set up the number of threads of comm net collective boxing
+
+    Args:
+        val (int): number of threads
+    """
+    return enable_if.unique([comm_net_num_threads, do_nothing])(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_num_threads(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.comm_net_num_threads = val
+
+
+@oneflow_export(
+    "config.collective_boxing.comm_net_recursive_halving_doubling_threshold_kb"
+)
+def api_comm_net_recursive_halving_doubling_threshold_kb(val: int) -> None:
+    r"""Set up the max size of the all-reduces using recursive halving-doubling
+
+    Args:
+        val (int): int number, e.g. 256(kb)
+    """
+    return enable_if.unique(
+        [comm_net_recursive_halving_doubling_threshold_kb, do_nothing]
+    )(val)
+
+
+@enable_if.condition(hob.in_normal_mode & ~hob.session_initialized)
+def comm_net_recursive_halving_doubling_threshold_kb(val):
+    sess = session_ctx.GetDefaultSession()
+    assert type(val) is int
+    sess.config_proto.resource.collective_boxing_conf.comm_net_recursive_halving_doubling_threshold_kb = (
+        val
+    )
+
+
 @enable_if.condition(hob.in_normal_mode & hob.session_initialized)
 def do_nothing(*args, **kwargs):
     print("Nothing happened because the session is running")
@@ -356,10 +356,26 @@ def policy_time_line(func_desc):
     return "use_time_line_algo"
 
 
+@oneflow_function_config(
+    "static_mem_alloc_policy_white_list.policy_best_fit_interval_packing"
+)
+def policy_best_fit_interval_packing(func_desc):
+    r"""A static memory allocation policy called: best_fit_interval_packing
+
+    Args:
+        func_desc ([type]): [description]
+
+    Returns:
+        [type]: [description]
+    """
+    return "use_best_fit_interval_packing_algo"
+
+
 @oneflow_function_config("static_mem_alloc_algo_white_list.show")
 def show_static_mem_alloc_algo_white_list(func_desc):
     r"""Show configuration of  static memory allocation policy,
-          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo"
+          including: "use_mem_size_first_algo", "use_mutual_exclusion_first_algo", "use_time_line_algo",
+          "use_best_fit_interval_packing_algo"
 
     Args:
         func_desc ([type]): [description]
@@ -371,6 +387,7 @@ def show_static_mem_alloc_algo_white_list(func_desc):
         "use_mem_size_first_algo",
         "use_mutual_exclusion_first_algo",
         "use_time_line_algo",
+        "use_best_fit_interval_packing_algo",
     ]
 
 
@@ -508,6 +525,95 @@ def set_enable_inplace(func_desc, value=True):
     func_desc.job_config_proto.set_enable_inplace(value)
 
 
+@oneflow_function_config("enable_reorder_tasks_for_mem_reuse")
+def set_enable_reorder_tasks_for_mem_reuse(func_desc, value=True):
+    r"""Whether reorder the independent tasks on a device to lower the peak memory or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_reorder_tasks_for_mem_reuse(value)
+
+
+@oneflow_function_config("reorder_tasks_for_mem_reuse_lookahead")
+def set_reorder_tasks_for_mem_reuse_lookahead(func_desc, value):
+    r"""Set the number of the tasks looked ahead while reordering the tasks, e.g. 2
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_reorder_tasks_for_mem_reuse_lookahead(value)
+
+
+@oneflow_function_config("checkpointing_policy")
+def set_checkpointing_policy(func_desc, value):
+    r"""Set which ops in the checkpointing scopes are recomputed in the backward pass
+
+    Args:
+        func_desc ([type]): [description]
+        value (str): "all" recomputes every op, "cost_model" keeps the outputs of the ops which are expensive to recompute, such as matmul and conv, and recomputes the others
+    """
+    assert value in ["all", "cost_model"]
+    func_desc.job_config_proto.set_checkpointing_policy(value)
+
+
+@oneflow_function_config("checkpointing_memory_budget_mbyte")
+def set_checkpointing_memory_budget_mbyte(func_desc, value):
+    r"""Set the memory in MB for the outputs kept by the "cost_model" checkpointing policy, which is unlimited by default
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_checkpointing_memory_budget_mbyte(value)
+
+
+@oneflow_function_config("enable_host_activation_offload")
+def set_enable_host_activation_offload(func_desc, value=True):
+    r"""Whether move the large forward activations consumed by the backward pass to the host memory, or to files on cpu, until the backward pass needs them or not
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_host_activation_offload(value)
+
+
+@oneflow_function_config("host_activation_offload_threshold_mbyte")
+def set_host_activation_offload_threshold_mbyte(func_desc, value):
+    r"""Set the min size in MB per rank of the activations moved to the host, e.g. 16
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_host_activation_offload_threshold_mbyte(value)
+
+
+@oneflow_function_config("host_activation_offload_prefetch_lookahead")
+def set_host_activation_offload_prefetch_lookahead(func_desc, value):
+    r"""Set how many backward ops before the first backward consumer an offloaded activation starts to be brought back, e.g. 2
+
+    Args:
+        func_desc ([type]): [description]
+        value ([type]): [description]
+    """
+    func_desc.job_config_proto.set_host_activation_offload_prefetch_lookahead(value)
+
+
+@oneflow_function_config("host_activation_offload_spill_dir")
+def set_host_activation_offload_spill_dir(func_desc, value):
+    r"""Set the directory of the files which the activations on cpu are spilled to, e.g. "/tmp"
+
+    Args:
+        func_desc ([type]): [description]
+        value (str): [description]
+    """
+    func_desc.job_config_proto.set_host_activation_offload_spill_dir(value)
+
+
 @oneflow_function_config("enable_inplace_in_reduce_struct")
 def set_enable_inplace_in_reduce_struct(func_desc, value=True):
     print(
@@ -748,6 +854,11 @@ def set_qat_symmetric(func_desc, value: str):
     func_desc.job_config_proto.mutable_qat_config().set_target_backend(value)
 
 
+@oneflow_function_config("qat.int8_cpu_inference")
+def set_qat_int8_cpu_inference(func_desc, value=True):
+    func_desc.job_config_proto.mutable_qat_config().set_int8_cpu_inference(value)
+
+
 @oneflow_function_config("enable_auto_mixed_precision")
 def set_enable_auto_mixed_precision(func_desc, value=True):
     r"""If true, then job will use mixed precision mode, it means use both float16 and float32 during model training.
@@ -759,6 +870,17 @@ def set_enable_auto_mixed_precision(func_desc, value=True):
     func_desc.job_config_proto.set_enable_auto_mixed_precision(value)
 
 
+@oneflow_function_config("enable_cpu_auto_mixed_precision")
+def set_enable_cpu_auto_mixed_precision(func_desc, value=True):
+    r"""If true, then the ops of job on cpu will use mixed precision mode, it means use both bfloat16 and float32.
+
+    Args:
+        func_desc ([type]): [description]
+        value (bool, optional): [description]. Defaults to True.
+    """
+    func_desc.job_config_proto.set_enable_cpu_auto_mixed_precision(value)
+
+
 @oneflow_function_config("enable_keep_header_only")
 def set_enable_keep_header_only(func_desc, value=True):
     r"""deprecated api.
@@ -64,6 +64,18 @@ class OfrecordReader(Module):
         shuffle_buffer_size: int = 1024,
         shuffle_after_epoch: bool = False,
         random_seed: int = -1,
+        num_load_workers: int = 1,
+        ordered_load: bool = True,
+        load_buffer_size: int = 256,
+        batch_buffer_size: int = 4,
+        random_access: bool = False,
+        random_access_read_size: int = 64,
+        resume_sample_ordinal: int = 0,
+        bucket_length_key: str = "",
+        bucket_boundaries: Sequence[int] = [],
+        max_tokens_per_batch: int = -1,
+        cache_memory_bytes: int = 0,
+        cache_spill_dir: str = "",
         name: Optional[str] = None,
     ):
         super().__init__()
@@ -80,6 +92,18 @@ class OfrecordReader(Module):
             .Attr("shuffle_after_epoch", shuffle_after_epoch)
             .Attr("part_name_suffix_length", part_name_suffix_length)
             .Attr("seed", seed)
+            .Attr("num_load_workers", num_load_workers)
+            .Attr("ordered_load", ordered_load)
+            .Attr("load_buffer_size", load_buffer_size)
+            .Attr("batch_buffer_size", batch_buffer_size)
+            .Attr("random_access", random_access)
+            .Attr("random_access_read_size", random_access_read_size)
+            .Attr("resume_sample_ordinal", resume_sample_ordinal)
+            .Attr("bucket_length_key", bucket_length_key)
+            .Attr("bucket_boundaries", list(bucket_boundaries))
+            .Attr("max_tokens_per_batch", max_tokens_per_batch)
+            .Attr("cache_memory_bytes", cache_memory_bytes)
+            .Attr("cache_spill_dir", cache_spill_dir)
             .Build()
         )
 
@@ -98,6 +122,7 @@ class OfrecordRawDecoder(Module):
         dtype: flow.dtype,
         dim1_varying_length: bool = False,
         auto_zero_padding: bool = False,
+        pad_to_batch_max_length: bool = False,
         name: Optional[str] = None,
     ):
         super().__init__()
@@ -111,6 +136,7 @@ class OfrecordRawDecoder(Module):
             .Attr("data_type", dtype)
             .Attr("dim1_varying_length", dim1_varying_length)
             .Attr("auto_zero_padding", auto_zero_padding)
+            .Attr("pad_to_batch_max_length", pad_to_batch_max_length)
             .Build()
         )
 
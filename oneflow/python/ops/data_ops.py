@@ -273,6 +273,18 @@ def ofrecord_reader(
     random_shuffle: bool = False,
     shuffle_buffer_size: int = 1024,
     shuffle_after_epoch: bool = False,
+    num_load_workers: int = 1,
+    ordered_load: bool = True,
+    load_buffer_size: int = 256,
+    batch_buffer_size: int = 4,
+    random_access: bool = False,
+    random_access_read_size: int = 64,
+    resume_sample_ordinal: int = 0,
+    bucket_length_key: str = "",
+    bucket_boundaries: Sequence[int] = [],
+    max_tokens_per_batch: int = -1,
+    cache_memory_bytes: int = 0,
+    cache_spill_dir: str = "",
     name: Optional[str] = None,
 ) -> oneflow._oneflow_internal.BlobDesc:
     r"""Get ofrecord object from ofrecord dataset.
@@ -286,6 +298,18 @@ def ofrecord_reader(
         random_shuffle (bool, optional): Determines records shuffled or not. Defaults to False.
         shuffle_buffer_size (int, optional): Shuffle buffer size. Defaults to 1024.
         shuffle_after_epoch (bool, optional): Shuffled or not after each epoch. Defaults to False.
+        num_load_workers (int, optional): Number of threads reading records, each from its own share of the partitions of this device. Capped by the number of those partitions. Defaults to 1.
+        ordered_load (bool, optional): Take records from the load workers in turn, so that the record order does not depend on thread timing. Defaults to True.
+        load_buffer_size (int, optional): Records prefetched by each load worker. Defaults to 256.
+        batch_buffer_size (int, optional): Batches prefetched ahead of the consumer. Defaults to 4.
+        random_access (bool, optional): Read records through the index files built by :func:`oneflow.data.build_ofrecord_index`. Every epoch then visits the records of the dataset once, in an order shuffled over the whole dataset if `random_shuffle` is set. The last `num_records % (parallel_num * num_load_workers)` records of each epoch are dropped, so that all the load workers read the same number of records. `shuffle_buffer_size` and `shuffle_after_epoch` are ignored. Defaults to False.
+        random_access_read_size (int, optional): Records each load worker fetches at a time in random access mode, sorted by file position. Defaults to 64.
+        resume_sample_ordinal (int, optional): Number of records all the devices have consumed before, so that a resumed job continues from there in random access mode. Must be a multiple of the number of devices times `num_load_workers`. Defaults to 0.
+        bucket_length_key (str, optional): Batch records of similar length together, the length of a record being the number of elements of this feature. Empty means no bucketing. With bucketing `batch_size` is the upper bound of the records in a batch and the result blob is dynamic. Defaults to "".
+        bucket_boundaries (Sequence[int], optional): Sorted lengths separating the buckets, a record goes to the first bucket whose boundary is larger than its length. Defaults to [].
+        max_tokens_per_batch (int, optional): With bucketing, a batch is closed before the number of records times the longest length in it exceeds this, -1 means no limit. Defaults to -1.
+        cache_memory_bytes (int, optional): In random access mode, keep up to this many bytes of records in memory so that later epochs do not read them again. Defaults to 0.
+        cache_spill_dir (str, optional): In random access mode, a local directory where records evicted from the memory cache are written to and read back from. Empty means records are dropped on eviction. Defaults to "".
         name (Optional[str], optional): Optional name. Defaults to None.
 
     Returns:
@@ -349,6 +373,18 @@ def ofrecord_reader(
         .Attr("shuffle_buffer_size", shuffle_buffer_size)
         .Attr("shuffle_after_epoch", shuffle_after_epoch)
         .Attr("part_name_suffix_length", part_name_suffix_length)
+        .Attr("num_load_workers", num_load_workers)
+        .Attr("ordered_load", ordered_load)
+        .Attr("load_buffer_size", load_buffer_size)
+        .Attr("batch_buffer_size", batch_buffer_size)
+        .Attr("random_access", random_access)
+        .Attr("random_access_read_size", random_access_read_size)
+        .Attr("resume_sample_ordinal", resume_sample_ordinal)
+        .Attr("bucket_length_key", bucket_length_key)
+        .Attr("bucket_boundaries", list(bucket_boundaries))
+        .Attr("max_tokens_per_batch", max_tokens_per_batch)
+        .Attr("cache_memory_bytes", cache_memory_bytes)
+        .Attr("cache_spill_dir", cache_spill_dir)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -35,6 +35,7 @@ def OFRecordRawDecoder(
     dtype: flow.dtype,
     dim1_varying_length: bool = False,
     auto_zero_padding: bool = False,
+    pad_to_batch_max_length: bool = False,
     name: Optional[str] = None,
 ) -> oneflow._oneflow_internal.BlobDesc:
     if name is None:
@@ -49,6 +50,7 @@ def OFRecordRawDecoder(
         .Attr("data_type", dtype)
         .Attr("dim1_varying_length", dim1_varying_length)
         .Attr("auto_zero_padding", auto_zero_padding)
+        .Attr("pad_to_batch_max_length", pad_to_batch_max_length)
         .Build()
         .InferAndTryRun()
         .RemoteBlobList()[0]
@@ -0,0 +1,162 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from typing import Tuple
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as oft
+
+
+def _round_to_bfloat16(x):
+    bits = x.astype(np.float32).view(np.uint32)
+    bits = bits + np.uint32(0x7FFF) + ((bits >> 16) & np.uint32(1))
+    return (bits & np.uint32(0xFFFF0000)).view(np.float32)
+
+
+def _run_on_cpu(op, inputs, dtype):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    placeholders = tuple(oft.Numpy.Placeholder(x.shape) for x in inputs)
+
+    @flow.global_function(function_config=func_config)
+    def BFloat16Job(xs: Tuple[placeholders]):
+        with flow.scope.placement("cpu", "0:0"):
+            if dtype == flow.float:
+                return op(*xs)
+            out = op(*[flow.cast(x, dtype=dtype) for x in xs])
+            return flow.cast(out, dtype=flow.float)
+
+    return BFloat16Job(inputs).get().numpy()
+
+
+def _compare_with_float(test_case, op, input_shapes, rtol=1e-2, atol=1e-2):
+    inputs = tuple(
+        np.random.uniform(-1, 1, shape).astype(np.float32) for shape in input_shapes
+    )
+    float_out = _run_on_cpu(op, inputs, flow.float)
+    bfloat16_out = _run_on_cpu(op, inputs, flow.bfloat16)
+    test_case.assertEqual(float_out.shape, bfloat16_out.shape)
+    test_case.assertTrue(np.allclose(bfloat16_out, float_out, rtol=rtol, atol=atol))
+
+
+def _get_op_names(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [op_conf.name for op_conf in job.net.op]
+    return []
+
+
+def _train_conv_net(enable_cpu_amp, images):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.enable_cpu_auto_mixed_precision(enable_cpu_amp)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def CpuAmpTrainJob(x: oft.Numpy.Placeholder(images.shape)):
+        with flow.scope.placement("cpu", "0:0"):
+            initializer = flow.constant_initializer(0.05)
+            conv = flow.layers.conv2d(
+                x,
+                8,
+                3,
+                padding="SAME",
+                kernel_initializer=initializer,
+                bias_initializer=initializer,
+                name="conv",
+            )
+            hidden = flow.math.relu(conv)
+            hidden = flow.reshape(hidden, (hidden.shape[0], -1))
+            logits = flow.layers.dense(
+                hidden,
+                4,
+                kernel_initializer=initializer,
+                bias_initializer=initializer,
+                name="dense",
+            )
+            loss = flow.math.reduce_mean(flow.math.square(logits))
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    losses = [CpuAmpTrainJob(images).get().numpy() for _ in range(5)]
+    return losses, _get_op_names("CpuAmpTrainJob")
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestBFloat16(flow.unittest.TestCase):
+    def test_cast(test_case):
+        x = np.random.uniform(-100, 100, (64, 33)).astype(np.float32)
+        out = _run_on_cpu(lambda x: x, (x,), flow.bfloat16)
+        test_case.assertTrue(np.array_equal(out, _round_to_bfloat16(x)))
+
+    def test_matmul(test_case):
+        _compare_with_float(test_case, flow.matmul, [(16, 256), (256, 8)])
+
+    def test_batch_matmul(test_case):
+        _compare_with_float(test_case, flow.matmul, [(3, 16, 64), (3, 64, 8)])
+
+    def test_conv2d(test_case):
+        def conv2d(x, w):
+            return flow.nn.conv2d(x, w, strides=1, padding="SAME")
+
+        _compare_with_float(test_case, conv2d, [(2, 8, 9, 9), (4, 8, 3, 3)])
+
+    def test_conv2d_channels_last(test_case):
+        def conv2d(x, w):
+            return flow.nn.conv2d(x, w, strides=2, padding="VALID", data_format="NHWC")
+
+        _compare_with_float(test_case, conv2d, [(2, 9, 9, 8), (4, 3, 3, 8)])
+
+    def test_relu(test_case):
+        _compare_with_float(test_case, flow.math.relu, [(16, 33)], rtol=4e-3, atol=0)
+
+    def test_add_n(test_case):
+        def add_n(*xs):
+            return flow.math.add_n(list(xs))
+
+        _compare_with_float(test_case, add_n, [(16, 33)] * 5)
+
+    def test_bias_add(test_case):
+        _compare_with_float(test_case, flow.nn.bias_add, [(4, 8, 5, 5), (8,)])
+
+    def test_reduce_sum(test_case):
+        # a sum of 4096 elements kept in bfloat16 would be off by far more than this
+        def reduce_sum(x):
+            return flow.math.reduce_sum(x, axis=[1])
+
+        _compare_with_float(test_case, reduce_sum, [(8, 4096)], rtol=1e-2, atol=1e-1)
+
+    def test_cpu_auto_mixed_precision(test_case):
+        images = np.random.uniform(-1, 1, (4, 3, 8, 8)).astype(np.float32)
+        float_losses, float_op_names = _train_conv_net(False, images)
+        amp_losses, amp_op_names = _train_conv_net(True, images)
+        test_case.assertFalse(
+            any(name.endswith("-cast_f2bf16") for name in float_op_names)
+        )
+        test_case.assertTrue(
+            any(name.endswith("-cast_f2bf16") for name in amp_op_names)
+        )
+        test_case.assertTrue(
+            np.allclose(amp_losses, float_losses, rtol=2e-2, atol=1e-3)
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
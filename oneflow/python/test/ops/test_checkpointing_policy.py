@@ -0,0 +1,94 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+from test_util import GenArgList
+
+
+def _count_recomputed_ops(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return sum(
+                op_conf.name.startswith("OneFlow-System-Checkpointing-Fake-Fw-Op_")
+                for op_conf in job.net.op
+            )
+    return 0
+
+
+def _run(policy, memory_budget_mbyte):
+    flow.clear_default_session()
+    flow.config.enable_debug_mode(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.checkpointing_policy(policy)
+    if memory_budget_mbyte is not None:
+        func_config.checkpointing_memory_budget_mbyte(memory_budget_mbyte)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def CheckpointingJob(x: tp.Numpy.Placeholder((8, 32))) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            with flow.experimental.scope.config(checkpointing=True):
+                y = x
+                for i in range(3):
+                    y = flow.layers.dense(
+                        y,
+                        32,
+                        kernel_initializer=flow.constant_initializer(0.01 * (i + 1)),
+                        name="dense{}".format(i),
+                    )
+                    y = flow.math.tanh(y)
+            loss = flow.math.reduce_mean(y * y)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    x = np.random.RandomState(0).uniform(size=(8, 32)).astype(np.float32)
+    losses = [CheckpointingJob(x) for _ in range(3)]
+    return losses, _count_recomputed_ops("CheckpointingJob")
+
+
+def _test(test_case, memory_budget_mbyte):
+    # recomputing any subset of the checkpointing ops must not change the training
+    all_losses, all_recomputed = _run("all", None)
+    cost_model_losses, cost_model_recomputed = _run("cost_model", memory_budget_mbyte)
+    test_case.assertGreater(all_recomputed, 0)
+    if memory_budget_mbyte is None:
+        # the matmul outputs are kept, so only the ops after them are recomputed
+        test_case.assertLess(cost_model_recomputed, all_recomputed)
+    else:
+        test_case.assertLessEqual(cost_model_recomputed, all_recomputed)
+    for a, b in zip(all_losses, cost_model_losses):
+        test_case.assertTrue(np.allclose(a, b, rtol=1e-5, atol=1e-5))
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestCheckpointingPolicy(flow.unittest.TestCase):
+    def test_cost_model(test_case):
+        arg_dict = OrderedDict()
+        # 0 keeps nothing, None keeps every expensive output
+        arg_dict["memory_budget_mbyte"] = [None, 0]
+        for arg in GenArgList(arg_dict):
+            _test(test_case, *arg)
+
+
+if __name__ == "__main__":
+    unittest.main()
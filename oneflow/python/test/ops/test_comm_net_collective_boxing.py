@@ -0,0 +1,112 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+import oneflow as flow
+from test_util import GenArgList
+import oneflow.typing as oft
+
+
+def _make_func_config():
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    flow.config.collective_boxing.comm_net_enable(True)
+    flow.config.collective_boxing.comm_net_chunk_size_kb(64)
+    flow.config.disable_group_boxing_by_dst_parallel(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_data_type(flow.float)
+    func_config.default_logical_view(flow.scope.consistent_view())
+    return func_config
+
+
+def _test_partial_sum_to_broadcast(test_case, shape):
+    @flow.global_function(function_config=_make_func_config())
+    def partial_sum_to_broadcast_job(x: oft.Numpy.Placeholder((2,) + shape)):
+        with flow.scope.placement("cpu", "0:0-1"):
+            src = flow.identity(x.with_distribute(flow.distribute.split(0)))
+            src = flow.math.reduce_sum(src, axis=0)
+            dst = flow.identity(src.with_distribute(flow.distribute.broadcast()))
+        return dst
+
+    x = np.random.uniform(-1, 1, (2,) + shape).astype(np.float32)
+    y = partial_sum_to_broadcast_job(x).get().numpy()
+    test_case.assertTrue(np.allclose(np.sum(x, axis=0), y, atol=1e-5))
+
+
+def _test_partial_sum_to_split(test_case):
+    @flow.global_function(function_config=_make_func_config())
+    def partial_sum_to_split_job(x: oft.Numpy.Placeholder((96, 96, 96))):
+        with flow.scope.placement("cpu", "0:0-1"):
+            src = flow.identity(x.with_distribute(flow.distribute.split(0)))
+            src = flow.math.reduce_sum(src, axis=0)
+            dst = flow.identity(src.with_distribute(flow.distribute.split(0)))
+        return dst
+
+    x = np.random.uniform(-1, 1, (96, 96, 96)).astype(np.float32)
+    y = partial_sum_to_split_job(x).get().numpy()
+    test_case.assertTrue(np.allclose(np.sum(x, axis=0), y, atol=1e-4))
+
+
+def _test_split_to_broadcast(test_case):
+    @flow.global_function(function_config=_make_func_config())
+    def split_to_broadcast_job(x: oft.Numpy.Placeholder((96, 96))):
+        with flow.scope.placement("cpu", "0:0-1"):
+            src = flow.identity(x.with_distribute(flow.distribute.split(0)))
+            dst = flow.identity(src.with_distribute(flow.distribute.broadcast()))
+        return dst
+
+    x = np.random.rand(96, 96).astype(np.float32)
+    y = split_to_broadcast_job(x).get().numpy()
+    test_case.assertTrue(np.array_equal(x, y))
+
+
+def _test_broadcast(test_case):
+    @flow.global_function(function_config=_make_func_config())
+    def broadcast_job(x: oft.Numpy.Placeholder((96, 96))):
+        with flow.scope.placement("cpu", "0:0"):
+            src = flow.identity(x)
+        with flow.scope.placement("cpu", "0:0-1"):
+            dst = flow.identity(src.with_distribute(flow.distribute.broadcast()))
+        return dst
+
+    x = np.random.rand(96, 96).astype(np.float32)
+    y = broadcast_job(x).get().numpy()
+    test_case.assertTrue(np.array_equal(x, y))
+
+
+# runs with ONEFLOW_TEST_MULTI_PROCESS=1, so that the messages go through the comm net
+@flow.unittest.skip_unless_1n2d()
+class TestCommNetCollectiveBoxing(flow.unittest.TestCase):
+    def test_partial_sum_to_broadcast(test_case):
+        arg_dict = OrderedDict()
+        # all-reduce by recursive halving-doubling and by ring
+        arg_dict["shape"] = [(16, 16), (512, 512)]
+        for arg in GenArgList(arg_dict):
+            _test_partial_sum_to_broadcast(test_case, *arg)
+
+    def test_partial_sum_to_split(test_case):
+        _test_partial_sum_to_split(test_case)
+
+    def test_split_to_broadcast(test_case):
+        _test_split_to_broadcast(test_case)
+
+    def test_broadcast(test_case):
+        _test_broadcast(test_case)
+
+
+if __name__ == "__main__":
+    unittest.main()
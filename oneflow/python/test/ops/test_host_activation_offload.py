@@ -0,0 +1,130 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import tempfile
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+
+
+def _get_op_type_names(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op_conf.user_conf.op_type_name
+                for op_conf in job.net.op
+                if op_conf.HasField("user_conf")
+            ]
+    return []
+
+
+def _get_host_mem_bytes(job_name):
+    plan = flow.experimental.get_plan()
+    job_ids = [
+        job_id
+        for job_id, job_conf in plan.job_confs.job_id2job_conf.items()
+        if job_conf.job_name == job_name
+    ]
+    assert len(job_ids) == 1
+    return sum(
+        mem_block.mem_size
+        for mem_block in plan.block_chunk_list.mem_block
+        if mem_block.mem_case.HasField("host_mem") and job_ids[0] in mem_block.job_id
+    )
+
+
+def _run(spill_dir, device_num):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(device_num)
+    flow.config.enable_debug_mode(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    if spill_dir is not None:
+        func_config.enable_host_activation_offload(True)
+        func_config.host_activation_offload_threshold_mbyte(0)
+        func_config.host_activation_offload_prefetch_lookahead(1)
+        func_config.host_activation_offload_spill_dir(spill_dir)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def ConvNet(x: tp.Numpy.Placeholder((4, 2, 32, 32))) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0-{}".format(device_num - 1)):
+            # the activations of x are split, those of the broadcast copy are broadcast
+            b = flow.parallel_cast(x, distribute=flow.distribute.broadcast())
+            b = flow.math.sigmoid(b * b)
+            y = flow.layers.conv2d(
+                x,
+                4,
+                3,
+                padding="SAME",
+                kernel_initializer=flow.constant_initializer(0.05),
+                name="conv",
+            )
+            y = flow.nn.relu(y)
+            y = flow.nn.max_pool2d(y, 2, 2, "VALID")
+            y = flow.reshape(y, (4, -1))
+            y = flow.layers.dense(
+                y, 8, kernel_initializer=flow.constant_initializer(0.01), name="dense"
+            )
+            y = flow.math.tanh(y)
+            loss = flow.math.reduce_mean(y * y) + flow.math.reduce_mean(b)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    x = np.random.RandomState(0).uniform(size=(4, 2, 32, 32)).astype(np.float32)
+    losses = [ConvNet(x) for _ in range(3)]
+    flow.sync_default_session()
+    return losses, _get_op_type_names("ConvNet"), _get_host_mem_bytes("ConvNet")
+
+
+def _test(test_case, device_num):
+    losses, _, host_mem_bytes = _run(None, device_num)
+    spill_dir = tempfile.mkdtemp()
+    offloaded_losses, op_type_names, offloaded_host_mem_bytes = _run(
+        spill_dir, device_num
+    )
+    for a, b in zip(losses, offloaded_losses):
+        test_case.assertTrue(np.allclose(a, b, rtol=1e-5, atol=1e-5))
+    # the pass spilled the activations of both the split and the broadcast branch
+    test_case.assertGreaterEqual(op_type_names.count("spill_to_file"), 2)
+    test_case.assertEqual(
+        op_type_names.count("spill_to_file"), op_type_names.count("load_spilled_file")
+    )
+    # the spilled activations and the loaded ones share the host memory with each other
+    test_case.assertLess(offloaded_host_mem_bytes, host_mem_bytes)
+    # every spilled file is deleted once it is loaded
+    test_case.assertEqual(os.listdir(spill_dir), [])
+    os.rmdir(spill_dir)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestHostActivationOffload(flow.unittest.TestCase):
+    def test_spill_to_file(test_case):
+        _test(test_case, 1)
+
+
+@flow.unittest.skip_unless_1n2d()
+class TestHostActivationOffload1n2d(flow.unittest.TestCase):
+    def test_spill_to_file(test_case):
+        _test(test_case, 2)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,69 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+
+
+def _train(enable_lazy_kernel_init):
+    flow.clear_default_session()
+    flow.config.enable_lazy_kernel_init(enable_lazy_kernel_init)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(type="train", function_config=func_config)
+    def LazyKernelInitJob(x: tp.Numpy.Placeholder((4, 2, 8, 8))) -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            y = flow.layers.conv2d(
+                x,
+                4,
+                3,
+                padding="SAME",
+                kernel_initializer=flow.constant_initializer(0.05),
+                name="conv",
+            )
+            y = flow.nn.relu(y)
+            y = flow.layers.dense(
+                flow.reshape(y, (4, -1)),
+                8,
+                kernel_initializer=flow.constant_initializer(0.01),
+                name="dense",
+            )
+            loss = flow.math.reduce_mean(y * y)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    x = np.random.RandomState(0).uniform(size=(4, 2, 8, 8)).astype(np.float32)
+    return [LazyKernelInitJob(x) for _ in range(3)]
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestLazyKernelInit(flow.unittest.TestCase):
+    def test_lazy_kernel_init(test_case):
+        # deferring kernel init to the first act must not change the training
+        eager_losses = _train(False)
+        lazy_losses = _train(True)
+        for a, b in zip(eager_losses, lazy_losses):
+            test_case.assertTrue(np.allclose(a, b, rtol=1e-5, atol=1e-5))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -207,6 +207,33 @@ class TestNnConv2d(flow.unittest.TestCase):
         for arg in GenArgList(arg_dict):
             compare_with_tensorflow(*arg)
 
+    def test_cpu4(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        # SAME pads the winograd input at stride 1, and pads unevenly at stride 2
+        arg_dict["x_shape"] = [(4, 32, 12, 12), (4, 32, 6, 7), (2, 32, 9, 11)]
+        arg_dict["filters"] = [32]
+        arg_dict["kernel_size"] = [1, 3]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NCHW"]
+        arg_dict["padding"] = ["VALID", "SAME"]
+        arg_dict["stride"] = [1, 2]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
+    def test_cpu5(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["device_type"] = ["cpu"]
+        arg_dict["x_shape"] = [(4, 12, 12, 32), (4, 6, 7, 32), (2, 9, 11, 32)]
+        arg_dict["filters"] = [32]
+        arg_dict["kernel_size"] = [1, 3]
+        arg_dict["groups"] = [1]
+        arg_dict["data_format"] = ["NHWC"]
+        arg_dict["padding"] = ["VALID", "SAME"]
+        arg_dict["stride"] = [1, 2]
+        for arg in GenArgList(arg_dict):
+            compare_with_tensorflow(*arg)
+
     def test_conv1(test_case):
         arg_dict = OrderedDict()
         arg_dict["device_type"] = ["gpu"]
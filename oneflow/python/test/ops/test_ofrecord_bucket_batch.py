@@ -0,0 +1,90 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+from typing import Tuple
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+import oneflow.core.record.record_pb2 as record_pb
+
+
+def _write_dataset(data_path, lengths):
+    with open(data_path, "wb") as f:
+        for record_id, length in enumerate(lengths):
+            record = record_pb.OFRecord()
+            record.feature["id"].int32_list.value.append(record_id)
+            record.feature["tokens"].int32_list.value.extend([record_id + 1] * length)
+            serialized = record.SerializeToString()
+            f.write(struct.pack("<q", len(serialized)))
+            f.write(serialized)
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOFRecordBucketBatch(flow.unittest.TestCase):
+    def test_token_budget(test_case):
+        max_length, max_batch_size, max_tokens = 64, 16, 96
+        bucket_boundaries = [8, 16, 32]
+        lengths = np.random.randint(1, max_length + 1, size=200)
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_dataset(os.path.join(data_dir, "part-0"), lengths)
+            flow.clear_default_session()
+            func_config = flow.FunctionConfig()
+            func_config.default_logical_view(flow.scope.mirrored_view())
+
+            @flow.global_function(type="predict", function_config=func_config)
+            def BucketJob() -> Tuple[tp.ListNumpy, tp.ListNumpy]:
+                with flow.scope.placement("cpu", "0:0"):
+                    ofrecord = flow.data.ofrecord_reader(
+                        data_dir,
+                        batch_size=max_batch_size,
+                        bucket_length_key="tokens",
+                        bucket_boundaries=bucket_boundaries,
+                        max_tokens_per_batch=max_tokens,
+                    )
+                    ids = flow.data.OFRecordRawDecoder(
+                        ofrecord, "id", shape=(1,), dtype=flow.int32
+                    )
+                    tokens = flow.data.OFRecordRawDecoder(
+                        ofrecord,
+                        "tokens",
+                        shape=(max_length,),
+                        dtype=flow.int32,
+                        pad_to_batch_max_length=True,
+                    )
+                    return ids, tokens
+
+            for _ in range(20):
+                ids, tokens = BucketJob()
+                ids, tokens = ids[0].flatten(), tokens[0]
+                batch_lengths = lengths[ids]
+                test_case.assertEqual(tokens.shape, (ids.size, batch_lengths.max()))
+                test_case.assertLessEqual(ids.size, max_batch_size)
+                if ids.size > 1:
+                    test_case.assertLessEqual(tokens.size, max_tokens)
+                buckets = np.searchsorted(bucket_boundaries, batch_lengths, "right")
+                test_case.assertTrue(np.all(buckets == buckets[0]))
+                for i, record_id in enumerate(ids):
+                    expected = np.zeros(tokens.shape[1], dtype=np.int32)
+                    expected[: lengths[record_id]] = record_id + 1
+                    test_case.assertTrue(np.array_equal(tokens[i], expected))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,94 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+import oneflow.core.record.record_pb2 as record_pb
+
+
+def _write_dataset(data_dir, num_parts, num_records_per_part):
+    for part_id in range(num_parts):
+        with open(os.path.join(data_dir, "part-{}".format(part_id)), "wb") as f:
+            for i in range(num_records_per_part):
+                record = record_pb.OFRecord()
+                record_id = part_id * num_records_per_part + i
+                record.feature["id"].int32_list.value.append(record_id)
+                serialized = record.SerializeToString()
+                f.write(struct.pack("<q", len(serialized)))
+                f.write(serialized)
+
+
+def _read_ids(data_dir, num_parts, batch_size, num_batches, num_load_workers, ordered):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ReadJob() -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            ofrecord = flow.data.ofrecord_reader(
+                data_dir,
+                batch_size=batch_size,
+                data_part_num=num_parts,
+                num_load_workers=num_load_workers,
+                ordered_load=ordered,
+                load_buffer_size=4,
+            )
+            return flow.data.OFRecordRawDecoder(
+                ofrecord, "id", shape=(1,), dtype=flow.int32
+            )
+
+    return np.concatenate([ReadJob().flatten() for _ in range(num_batches)])
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOFRecordParallelLoad(flow.unittest.TestCase):
+    def test_parallel_load(test_case):
+        num_parts, num_records_per_part, batch_size = 4, 10, 8
+        num_records = num_parts * num_records_per_part
+        num_batches = 2 * num_records // batch_size
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_dataset(data_dir, num_parts, num_records_per_part)
+            # each of the 2 workers reads 2 of the parts, over and over
+            worker_ids = [np.arange(num_records // 2), np.arange(num_records // 2)]
+            worker_ids[1] += num_records // 2
+            ordered_ids = np.stack(worker_ids, axis=1).flatten()
+            for ordered in [True, False]:
+                ids = _read_ids(
+                    data_dir, num_parts, batch_size, num_batches, 2, ordered
+                )
+                if ordered:
+                    # the workers take turns, so every epoch is the same
+                    test_case.assertTrue(np.array_equal(ids, np.tile(ordered_ids, 2)))
+                # every worker keeps the order of its own parts
+                for worker_id in range(2):
+                    begin = worker_id * num_records // 2
+                    end = begin + num_records // 2
+                    own_ids = ids[(ids >= begin) & (ids < end)]
+                    expected_ids = np.tile(np.arange(begin, end), 2)
+                    test_case.assertTrue(
+                        np.array_equal(own_ids, expected_ids[: own_ids.size])
+                    )
+                test_case.assertEqual(ids.size, 2 * num_records)
+
+
+if __name__ == "__main__":
+    unittest.main()
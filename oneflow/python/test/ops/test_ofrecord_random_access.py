@@ -0,0 +1,167 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import os
+import struct
+import tempfile
+import unittest
+
+import numpy as np
+import oneflow as flow
+import oneflow.typing as tp
+import oneflow.core.record.record_pb2 as record_pb
+
+
+def _write_dataset(data_dir, num_parts, num_records_per_part):
+    for part_id in range(num_parts):
+        with open(os.path.join(data_dir, "part-{}".format(part_id)), "wb") as f:
+            for i in range(num_records_per_part):
+                record_id = part_id * num_records_per_part + i
+                record = record_pb.OFRecord()
+                record.feature["id"].int32_list.value.append(record_id)
+                # records of different sizes
+                record.feature["pad"].bytes_list.value.append(b"x" * (record_id % 7))
+                serialized = record.SerializeToString()
+                f.write(struct.pack("<q", len(serialized)))
+                f.write(serialized)
+
+
+def _read_ids(
+    data_dir,
+    num_parts,
+    batch_size,
+    num_batches,
+    random_shuffle,
+    num_load_workers,
+    resume_sample_ordinal=0,
+    cache_memory_bytes=0,
+    cache_spill_dir="",
+):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def ReadJob() -> tp.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            ofrecord = flow.data.ofrecord_reader(
+                data_dir,
+                batch_size=batch_size,
+                data_part_num=num_parts,
+                random_shuffle=random_shuffle,
+                num_load_workers=num_load_workers,
+                random_access=True,
+                random_access_read_size=5,
+                resume_sample_ordinal=resume_sample_ordinal,
+                cache_memory_bytes=cache_memory_bytes,
+                cache_spill_dir=cache_spill_dir,
+            )
+            return flow.data.OFRecordRawDecoder(
+                ofrecord, "id", shape=(1,), dtype=flow.int32
+            )
+
+    return np.concatenate([ReadJob().flatten() for _ in range(num_batches)])
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestOFRecordRandomAccess(flow.unittest.TestCase):
+    def test_epoch_covers_dataset(test_case):
+        num_parts, num_records_per_part, batch_size = 3, 20, 6
+        num_records = num_parts * num_records_per_part
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_dataset(data_dir, num_parts, num_records_per_part)
+            test_case.assertEqual(
+                flow.data.build_ofrecord_index(data_dir, num_parts), num_records
+            )
+            for random_shuffle in [False, True]:
+                for num_load_workers in [1, 2]:
+                    ids = _read_ids(
+                        data_dir,
+                        num_parts,
+                        batch_size,
+                        2 * num_records // batch_size,
+                        random_shuffle,
+                        num_load_workers,
+                    )
+                    for epoch_ids in np.split(ids, 2):
+                        test_case.assertTrue(
+                            np.array_equal(np.sort(epoch_ids), np.arange(num_records))
+                        )
+                    if not random_shuffle and num_load_workers == 1:
+                        test_case.assertTrue(
+                            np.array_equal(ids[:num_records], np.arange(num_records))
+                        )
+                    if random_shuffle:
+                        test_case.assertFalse(
+                            np.array_equal(ids[:num_records], ids[num_records:])
+                        )
+
+    def test_resume(test_case):
+        num_parts, num_records_per_part, batch_size = 2, 25, 4
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_dataset(data_dir, num_parts, num_records_per_part)
+            flow.data.build_ofrecord_index(data_dir, num_parts)
+            for num_load_workers in [1, 2]:
+                ids = _read_ids(
+                    data_dir, num_parts, batch_size, 30, True, num_load_workers
+                )
+                resumed_ids = _read_ids(
+                    data_dir,
+                    num_parts,
+                    batch_size,
+                    10,
+                    True,
+                    num_load_workers,
+                    resume_sample_ordinal=20 * batch_size,
+                )
+                test_case.assertTrue(
+                    np.array_equal(ids[20 * batch_size :], resumed_ids)
+                )
+
+    def test_sample_cache(test_case):
+        num_parts, num_records_per_part, batch_size = 2, 25, 5
+        with tempfile.TemporaryDirectory() as data_dir:
+            _write_dataset(data_dir, num_parts, num_records_per_part)
+            flow.data.build_ofrecord_index(data_dir, num_parts)
+            ids = _read_ids(data_dir, num_parts, batch_size, 30, True, 2)
+            with tempfile.TemporaryDirectory() as spill_dir:
+                # the memory cache holds a part of the records, the rest are spilled
+                for cache_memory_bytes, cache_spill_dir in [
+                    (1 << 20, ""),
+                    (256, ""),
+                    (256, spill_dir),
+                ]:
+                    cached_ids = _read_ids(
+                        data_dir,
+                        num_parts,
+                        batch_size,
+                        30,
+                        True,
+                        2,
+                        cache_memory_bytes=cache_memory_bytes,
+                        cache_spill_dir=cache_spill_dir,
+                    )
+                    test_case.assertTrue(np.array_equal(ids, cached_ids))
+                    if cache_spill_dir:
+                        # the reader is still alive, and so are its spill files
+                        spill_file_sizes = [
+                            os.path.getsize(os.path.join(spill_dir, name))
+                            for name in os.listdir(spill_dir)
+                        ]
+                        test_case.assertGreater(sum(spill_file_sizes), 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -17,6 +17,8 @@ import unittest
 import numpy as np
 import oneflow as flow
 import oneflow.typing as oft
+import oneflow.core.common.device_type_pb2 as device_type_util
+import oneflow.core.graph.boxing.collective_boxing_pb2 as collective_boxing_util
 
 
 def _test(test_case, mode):
@@ -38,6 +40,80 @@ def _test(test_case, mode):
     Foo(np.ones((2, 1024 * 1024), dtype=np.float32))
 
 
+def _get_job(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return job
+    raise ValueError("job {} not found".format(job_name))
+
+
+def _get_collective_boxing_requests(job_name):
+    plan = flow.experimental.get_plan()
+    for job_id, job_conf in plan.job_confs.job_id2job_conf.items():
+        if job_conf.job_name == job_name:
+            return plan.collective_boxing_plan.job_id2request_set[job_id].request
+    raise ValueError("job {} not found".format(job_name))
+
+
+def _check_cpu_job(test_case, mode, job_name):
+    job = _get_job(job_name)
+    var_names = ["w", "w-m", "w-v"]
+    var_op_confs = {
+        op_conf.name: op_conf for op_conf in job.net.op if op_conf.name in var_names
+    }
+    test_case.assertEqual(sorted(var_op_confs.keys()), sorted(var_names))
+    requests = _get_collective_boxing_requests(job_name)
+    if mode == "distributed_split":
+        for op_conf in var_op_confs.values():
+            test_case.assertEqual(
+                list(op_conf.variable_conf.parallel_distribution), ["S(0)"]
+            )
+        op_types = set()
+        for request in requests:
+            test_case.assertEqual(
+                request.op_desc.backend, collective_boxing_util.kBackendCommNet
+            )
+            for device in request.device_set.device:
+                test_case.assertEqual(device.device_type, device_type_util.kCPU)
+            op_types.add(request.op_desc.op_type)
+        test_case.assertIn(collective_boxing_util.kOpTypeReduceScatter, op_types)
+        test_case.assertIn(collective_boxing_util.kOpTypeAllGather, op_types)
+    else:
+        # every variable and its optimizer state lives on a single device
+        for placement_group in job.placement.placement_group:
+            if any(name in var_names for name in placement_group.op_set.op_name):
+                device_names = placement_group.parallel_conf.device_name
+                test_case.assertEqual(len(device_names), 1)
+                test_case.assertNotIn("-", device_names[0])
+
+
+def _test_cpu(test_case, mode):
+    flow.clear_default_session()
+    flow.config.cpu_device_num(2)
+    flow.config.collective_boxing.comm_net_enable(True)
+    flow.config.enable_debug_mode(True)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    func_config.optimizer_placement_optimization_mode(mode)
+
+    @flow.global_function(type="train", function_config=func_config)
+    def Foo(x: oft.Numpy.Placeholder((2, 1024 * 1024))) -> oft.Numpy:
+        with flow.scope.placement("cpu", "0:0-1"):
+            w = flow.get_variable(
+                "w", (1024 * 1024,), initializer=flow.constant_initializer(100)
+            )
+            flow.optimizer.Adam(
+                flow.optimizer.PiecewiseConstantScheduler([], [5])
+            ).minimize(x + w)
+        return w
+
+    x = np.ones((2, 1024 * 1024), dtype=np.float32)
+    Foo(x)
+    _check_cpu_job(test_case, mode, "Foo")
+    # the first step of adam moves every element by the learning rate
+    test_case.assertTrue(np.allclose(Foo(x), 95, atol=1e-3))
+
+
 @flow.unittest.skip_unless_1n2d()
 class TestOptimizerPlacementOptimization(flow.unittest.TestCase):
     def test_non_distributed(test_case):
@@ -46,6 +122,12 @@ class TestOptimizerPlacementOptimization(flow.unittest.TestCase):
     def test_distributed_split(test_case):
         _test(test_case, "distributed_split")
 
+    def test_non_distributed_cpu(test_case):
+        _test_cpu(test_case, "non_distributed")
+
+    def test_distributed_split_cpu(test_case):
+        _test_cpu(test_case, "distributed_split")
+
 
 if __name__ == "__main__":
     unittest.main()
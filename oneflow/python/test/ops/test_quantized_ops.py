@@ -0,0 +1,229 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+from collections import OrderedDict
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as oft
+from test_util import GenArgList
+
+
+def _quantize(x, quantization_scheme, per_layer_quantization=True):
+    scale, zero_point = flow.quantization.min_max_observer(
+        x,
+        quantization_scheme=quantization_scheme,
+        per_layer_quantization=per_layer_quantization,
+    )
+    fake_quant_x = flow.quantization.fake_quantization(
+        x, scale, zero_point, quantization_scheme=quantization_scheme
+    )
+    return fake_quant_x, scale, zero_point
+
+
+def _run_test_quantized_matmul(
+    test_case, a_shape, b_shape, quantization_scheme, per_layer_quantization
+):
+    flow.clear_default_session()
+
+    @flow.global_function(type="predict", function_config=flow.FunctionConfig())
+    def QuantizedMatmulJob(
+        a: oft.Numpy.Placeholder(a_shape), b: oft.Numpy.Placeholder(b_shape)
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            fake_quant_a, a_scale, a_zero_point = _quantize(a, quantization_scheme)
+            fake_quant_b, b_scale, b_zero_point = _quantize(
+                b, quantization_scheme, per_layer_quantization
+            )
+            expected = flow.matmul(fake_quant_a, fake_quant_b, transpose_b=True)
+            out = (
+                flow.user_op_builder("quantized_matmul")
+                .Op("quantized_matmul")
+                .Input("a", [a])
+                .Input("a_scale", [a_scale])
+                .Input("a_zero_point", [a_zero_point])
+                .Input("b", [b])
+                .Input("b_scale", [b_scale])
+                .Input("b_zero_point", [b_zero_point])
+                .Output("out")
+                .Attr("transpose_b", True)
+                .Attr("quantization_scheme", quantization_scheme)
+                .Build()
+                .InferAndTryRun()
+                .RemoteBlobList()[0]
+            )
+        return out, expected
+
+    a = (np.random.random(a_shape) - 0.3).astype(np.float32)
+    b = (np.random.random(b_shape) - 0.5).astype(np.float32)
+    out, expected = QuantizedMatmulJob(a, b).get()
+    test_case.assertTrue(
+        np.allclose(out.numpy(), expected.numpy(), rtol=1e-4, atol=1e-4)
+    )
+
+
+def _run_test_quantized_conv2d(
+    test_case, in_shape, filters, quantization_scheme, per_layer_quantization
+):
+    flow.clear_default_session()
+    weight_shape = (filters, in_shape[1], 3, 3)
+
+    @flow.global_function(type="predict", function_config=flow.FunctionConfig())
+    def QuantizedConv2dJob(
+        x: oft.Numpy.Placeholder(in_shape),
+        weight: oft.Numpy.Placeholder(weight_shape),
+    ):
+        with flow.scope.placement("cpu", "0:0"):
+            fake_quant_x, x_scale, x_zero_point = _quantize(x, quantization_scheme)
+            fake_quant_weight, weight_scale, weight_zero_point = _quantize(
+                weight, quantization_scheme, per_layer_quantization
+            )
+            expected = flow.nn.conv2d(
+                fake_quant_x, fake_quant_weight, strides=1, padding="SAME"
+            )
+            out = (
+                flow.user_op_builder("quantized_conv2d")
+                .Op("quantized_conv2d")
+                .Input("in", [x])
+                .Input("in_scale", [x_scale])
+                .Input("in_zero_point", [x_zero_point])
+                .Input("weight", [weight])
+                .Input("weight_scale", [weight_scale])
+                .Input("weight_zero_point", [weight_zero_point])
+                .Output("out")
+                .Attr("filters", filters)
+                .Attr("padding_before", [1, 1])
+                .Attr("data_format", "channels_first")
+                .Attr("kernel_size", [3, 3])
+                .Attr("strides", [1, 1])
+                .Attr("dilation_rate", [1, 1])
+                .Attr("groups", 1)
+                .Attr("quantization_scheme", quantization_scheme)
+                .Build()
+                .InferAndTryRun()
+                .RemoteBlobList()[0]
+            )
+        return out, expected
+
+    x = (np.random.random(in_shape) - 0.3).astype(np.float32)
+    weight = (np.random.random(weight_shape) - 0.5).astype(np.float32)
+    out, expected = QuantizedConv2dJob(x, weight).get()
+    test_case.assertTrue(
+        np.allclose(out.numpy(), expected.numpy(), rtol=1e-4, atol=1e-4)
+    )
+
+
+def _get_op_type_names(job_name):
+    for job in flow.experimental.get_job_set().job:
+        if job.job_conf.job_name == job_name:
+            return [
+                op_conf.user_conf.op_type_name
+                for op_conf in job.net.op
+                if op_conf.HasField("user_conf")
+            ]
+    return []
+
+
+def _run_qat_inference(x, weights_list, quantization_scheme, int8_cpu_inference):
+    flow.clear_default_session()
+    func_config = flow.FunctionConfig()
+    func_config.enable_qat(True)
+    func_config.qat.symmetric(quantization_scheme == "symmetric")
+    func_config.qat.per_channel_weight_quantization(False)
+    func_config.qat.moving_min_max_stop_update_after_iters(1000)
+    func_config.qat.int8_cpu_inference(int8_cpu_inference)
+
+    @flow.global_function(type="predict", function_config=func_config)
+    def QatInferenceJob(x: oft.Numpy.Placeholder(x.shape)) -> oft.Numpy:
+        with flow.scope.placement("cpu", "0:0"):
+            y = flow.layers.conv2d(x, 4, 3, 1, "SAME", use_bias=False, name="conv")
+            y = flow.math.relu(y)
+            y = flow.reshape(y, (y.shape[0], -1))
+            return flow.layers.dense(y, 8, use_bias=False, name="dense")
+
+    # the activation observers of inference read the ranges recorded by training
+    observer_ranges = {}
+    for name in flow.get_all_variables().keys():
+        if name.endswith("-fake-quant-moving-max"):
+            observer_ranges[name] = np.array([4], dtype=np.float32)
+        elif name.endswith("-fake-quant-moving-min"):
+            observer_ranges[name] = np.array([-1], dtype=np.float32)
+    outs = []
+    for weights in weights_list:
+        flow.load_variables(dict(observer_ranges, **weights))
+        outs.append(QatInferenceJob(x))
+    return outs, _get_op_type_names("QatInferenceJob")
+
+
+def _run_test_quantized_inference_rewrite(test_case, quantization_scheme):
+    x = np.random.random((2, 3, 6, 6)).astype(np.float32)
+    # the weights change between the runs, which a stale packed weight would miss
+    weights_list = [
+        {
+            "conv-weight": (np.random.random((4, 3, 3, 3)) - 0.5).astype(np.float32),
+            "dense-weight": (np.random.random((8, 144)) - 0.5).astype(np.float32),
+        }
+        for _ in range(2)
+    ]
+    fake_quant_outs, fake_quant_op_types = _run_qat_inference(
+        x, weights_list, quantization_scheme, False
+    )
+    int8_outs, int8_op_types = _run_qat_inference(
+        x, weights_list, quantization_scheme, True
+    )
+    test_case.assertIn("fake_quantization", fake_quant_op_types)
+    test_case.assertIn("quantized_conv2d", int8_op_types)
+    test_case.assertIn("quantized_matmul", int8_op_types)
+    test_case.assertNotIn("conv2d", int8_op_types)
+    test_case.assertNotIn("matmul", int8_op_types)
+    test_case.assertNotIn("fake_quantization", int8_op_types)
+    test_case.assertFalse(np.allclose(int8_outs[0], int8_outs[1]))
+    for int8_out, fake_quant_out in zip(int8_outs, fake_quant_outs):
+        test_case.assertTrue(
+            np.allclose(int8_out, fake_quant_out, rtol=1e-4, atol=1e-4)
+        )
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestQuantizedOps(flow.unittest.TestCase):
+    def test_quantized_matmul(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["a_shape"] = [(5, 16), (33, 70)]
+        arg_dict["b_shape"] = [(12, 16)]
+        arg_dict["quantization_scheme"] = ["symmetric", "affine"]
+        arg_dict["per_layer_quantization"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            a_shape, b_shape = arg[0], arg[1]
+            b_shape = (b_shape[0], a_shape[1])
+            _run_test_quantized_matmul(test_case, a_shape, b_shape, *arg[2:])
+
+    def test_quantized_conv2d(test_case):
+        arg_dict = OrderedDict()
+        arg_dict["in_shape"] = [(2, 3, 8, 7)]
+        arg_dict["filters"] = [4]
+        arg_dict["quantization_scheme"] = ["symmetric", "affine"]
+        arg_dict["per_layer_quantization"] = [True, False]
+        for arg in GenArgList(arg_dict):
+            _run_test_quantized_conv2d(test_case, *arg)
+
+    def test_quantized_inference_rewrite(test_case):
+        for quantization_scheme in ["symmetric", "affine"]:
+            _run_test_quantized_inference_rewrite(test_case, quantization_scheme)
+
+
+if __name__ == "__main__":
+    unittest.main()
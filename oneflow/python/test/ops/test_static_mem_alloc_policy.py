@@ -0,0 +1,89 @@
+"""
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+"""
+import unittest
+
+import numpy as np
+
+import oneflow as flow
+import oneflow.typing as tp
+
+
+def _get_mem_alloc_algo_conf(job_name):
+    plan = flow.experimental.get_plan()
+    for job_conf in plan.job_confs.job_id2job_conf.values():
+        if job_conf.job_name == job_name:
+            return job_conf.memory_allocation_algorithm_conf
+    raise ValueError("job {} not found".format(job_name))
+
+
+def _run(best_fit_interval_packing_only):
+    flow.clear_default_session()
+    flow.config.gpu_device_num(1)
+    func_config = flow.FunctionConfig()
+    func_config.default_logical_view(flow.scope.consistent_view())
+    if best_fit_interval_packing_only:
+        white_list = func_config.static_mem_alloc_policy_white_list
+        white_list.remove(white_list.policy_mem_size_first())
+        white_list.remove(white_list.policy_mutual_exclusion_first())
+        white_list.remove(white_list.policy_time_line())
+        white_list.add(white_list.policy_best_fit_interval_packing())
+
+    @flow.global_function(type="train", function_config=func_config)
+    def ConvNet(x: tp.Numpy.Placeholder((8, 3, 16, 16))) -> tp.Numpy:
+        with flow.scope.placement("gpu", "0:0"):
+            y = x
+            for i in range(3):
+                y = flow.layers.conv2d(
+                    y,
+                    8,
+                    3,
+                    padding="SAME",
+                    kernel_initializer=flow.constant_initializer(0.05),
+                    name="conv{}".format(i),
+                )
+                y = flow.nn.relu(y)
+            y = flow.reshape(y, (8, -1))
+            y = flow.layers.dense(
+                y, 10, kernel_initializer=flow.constant_initializer(0.01), name="dense"
+            )
+            loss = flow.math.reduce_mean(y * y)
+            flow.optimizer.SGD(
+                flow.optimizer.PiecewiseConstantScheduler([], [0.1]), momentum=0
+            ).minimize(loss)
+        return loss
+
+    x = np.random.RandomState(0).uniform(size=(8, 3, 16, 16)).astype(np.float32)
+    losses = [ConvNet(x) for _ in range(3)]
+    flow.sync_default_session()
+    return losses, _get_mem_alloc_algo_conf("ConvNet")
+
+
+@flow.unittest.skip_unless_1n1d()
+class TestStaticMemAllocPolicy(flow.unittest.TestCase):
+    def test_best_fit_interval_packing(test_case):
+        losses, _ = _run(False)
+        best_fit_losses, mem_alloc_algo_conf = _run(True)
+        test_case.assertTrue(mem_alloc_algo_conf.use_best_fit_interval_packing_algo)
+        test_case.assertFalse(mem_alloc_algo_conf.use_mem_size_first_algo)
+        test_case.assertFalse(mem_alloc_algo_conf.use_mutual_exclusion_first_algo)
+        test_case.assertFalse(mem_alloc_algo_conf.use_time_line_algo)
+        # the regsts sharing the memory block never overwrite each other
+        for a, b in zip(losses, best_fit_losses):
+            test_case.assertTrue(np.allclose(a, b, rtol=1e-5, atol=1e-5))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -88,6 +88,19 @@ def gen_arg_list_for_test_axis():
     return GenArgList(arg_dict)
 
 
+def gen_arg_list_for_test_large_instance():
+    arg_dict = OrderedDict()
+    arg_dict["device_type"] = ["cpu"]
+    # fewer rows than threads, so that long rows are split across the threads
+    arg_dict["in_shape"] = [(2, 40000), (16, 5000)]
+    arg_dict["axis"] = [-1]
+    arg_dict["k"] = [1, 100, 1000]
+    arg_dict["data_type"] = ["float32", "int32"]
+    arg_dict["sorted"] = [True]
+
+    return GenArgList(arg_dict)
+
+
 @flow.unittest.skip_unless_1n1d()
 class TestTopK(flow.unittest.TestCase):
     @unittest.skipIf(os.getenv("ONEFLOW_TEST_CPU_ONLY"), "only test cpu cases")
@@ -97,6 +110,10 @@ class TestTopK(flow.unittest.TestCase):
         for arg in gen_arg_list_for_test_axis():
             compare_with_tensorflow(*arg)
 
+    def test_top_k_large_instance(test_case):
+        for arg in gen_arg_list_for_test_large_instance():
+            compare_with_tensorflow(*arg)
+
 
 if __name__ == "__main__":
     unittest.main()
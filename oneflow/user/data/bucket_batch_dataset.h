@@ -0,0 +1,104 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_BUCKET_BATCH_DATASET_H_
+#define ONEFLOW_USER_DATA_BUCKET_BATCH_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// Batches samples of similar length together. Bucket i holds the samples whose length is in
+// [bucket_boundaries[i - 1], bucket_boundaries[i]), the first and the last buckets are open ended.
+// A bucket gives out its batch as soon as one more sample would make the padded batch, that is
+// the sample count times the longest length, exceed max_tokens (no limit if max_tokens <= 0), or
+// as soon as it holds max_batch_size samples. Batches are returned in the order they got full
+template<typename LoadTarget>
+class BucketBatchDataset final : public Dataset<LoadTarget> {
+ public:
+  using BaseDataset = Dataset<LoadTarget>;
+  using BaseDatasetUnqPtr = std::unique_ptr<BaseDataset>;
+  using LoadTargetShdPtr = std::shared_ptr<LoadTarget>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+
+  BucketBatchDataset(const std::vector<int64_t>& bucket_boundaries, int64_t max_tokens,
+                     size_t max_batch_size,
+                     const std::function<int64_t(const LoadTargetShdPtr&)>& Length4Sample,
+                     BaseDatasetUnqPtr&& dataset)
+      : base_(std::move(dataset)),
+        bucket_boundaries_(bucket_boundaries),
+        max_tokens_(max_tokens),
+        max_batch_size_(max_batch_size),
+        length_fn_(Length4Sample),
+        buckets_(bucket_boundaries.size() + 1) {
+    CHECK(std::is_sorted(bucket_boundaries_.cbegin(), bucket_boundaries_.cend()));
+    CHECK_GT(max_batch_size_, 0);
+  }
+  ~BucketBatchDataset() = default;
+
+  LoadTargetShdPtrVec Next() override {
+    while (full_batches_.empty()) {
+      LoadTargetShdPtrVec next_sample_vec = base_->Next();
+      for (auto& sample_ptr : next_sample_vec) { AddSample(std::move(sample_ptr)); }
+    }
+    LoadTargetShdPtrVec ret = std::move(full_batches_.front());
+    full_batches_.pop_front();
+    return ret;
+  }
+
+ private:
+  struct Bucket {
+    LoadTargetShdPtrVec samples;
+    int64_t max_length = 0;
+  };
+
+  void AddSample(LoadTargetShdPtr&& sample_ptr) {
+    const int64_t length = length_fn_(sample_ptr);
+    CHECK_GE(length, 0);
+    const size_t bucket_id =
+        std::upper_bound(bucket_boundaries_.cbegin(), bucket_boundaries_.cend(), length)
+        - bucket_boundaries_.cbegin();
+    Bucket& bucket = buckets_.at(bucket_id);
+    const int64_t padded_tokens =
+        static_cast<int64_t>(bucket.samples.size() + 1) * std::max(bucket.max_length, length);
+    if (!bucket.samples.empty() && max_tokens_ > 0 && padded_tokens > max_tokens_) {
+      FlushBucket(&bucket);
+    }
+    bucket.samples.push_back(std::move(sample_ptr));
+    bucket.max_length = std::max(bucket.max_length, length);
+    if (bucket.samples.size() == max_batch_size_) { FlushBucket(&bucket); }
+  }
+
+  void FlushBucket(Bucket* bucket) {
+    full_batches_.push_back(std::move(bucket->samples));
+    bucket->samples = LoadTargetShdPtrVec();
+    bucket->samples.reserve(max_batch_size_);
+    bucket->max_length = 0;
+  }
+
+  BaseDatasetUnqPtr base_;
+  std::vector<int64_t> bucket_boundaries_;
+  int64_t max_tokens_;
+  size_t max_batch_size_;
+  std::function<int64_t(const LoadTargetShdPtr&)> length_fn_;
+  std::vector<Bucket> buckets_;
+  std::deque<LoadTargetShdPtrVec> full_batches_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_BUCKET_BATCH_DATASET_H_
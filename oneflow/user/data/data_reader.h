@@ -24,6 +24,7 @@ limitations under the License.
 namespace oneflow {
 namespace data {
 
+// Batches prefetched ahead of the parser when the reader does not configure it
 static const int32_t kDataReaderBatchBufferSize = 4;
 
 template<typename LoadTarget>
@@ -31,8 +32,9 @@ class DataReader {
  public:
   using LoadTargetPtr = std::shared_ptr<LoadTarget>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
-  DataReader(user_op::KernelInitContext* ctx)
-      : is_closed_(false), batch_buffer_(kDataReaderBatchBufferSize) {}
+  DataReader(user_op::KernelInitContext* ctx) : DataReader(ctx, kDataReaderBatchBufferSize) {}
+  DataReader(user_op::KernelInitContext* ctx, int32_t batch_buffer_size)
+      : is_closed_(false), batch_buffer_(batch_buffer_size) { CHECK_GT(batch_buffer_size, 0); }
   virtual ~DataReader() {
     Close();
     if (load_thrd_.joinable()) { load_thrd_.join(); }
@@ -46,6 +46,15 @@ class RandomAccessDataset : public Dataset<LoadTarget> {
 
   virtual LoadTargetShdPtrVec At(int64_t index) const = 0;
   virtual size_t Size() const = 0;
+  // Samples of all the indices, in the same order. Datasets that can read many samples at once
+  // more cheaply than one by one should override it
+  virtual LoadTargetShdPtrVec BatchAt(const std::vector<int64_t>& indices) const {
+    LoadTargetShdPtrVec ret;
+    for (int64_t index : indices) {
+      for (auto& sample_ptr : this->At(index)) { ret.push_back(std::move(sample_ptr)); }
+    }
+    return ret;
+  }
 
   LoadTargetShdPtrVec Next() final {
     LoadTargetShdPtrVec ret = this->At(cur_idx_);
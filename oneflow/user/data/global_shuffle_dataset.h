@@ -0,0 +1,158 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
+#define ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// A seeded permutation of [0, size), of which every index is computed on its own in constant
+// expected time. A 4-round Feistel network permutes the smallest [0, 4^k) that holds [0, size),
+// and an index permuted out of [0, size) is permuted again until it falls in
+class IndexPermutation final {
+ public:
+  IndexPermutation(int64_t size, uint64_t seed) : size_(size), seed_(seed), half_bits_(0) {
+    CHECK_GT(size_, 0);
+    while ((int64_t(1) << (2 * half_bits_)) < size_) { half_bits_ += 1; }
+  }
+  ~IndexPermutation() = default;
+
+  int64_t At(int64_t index) const {
+    CHECK_GE(index, 0);
+    CHECK_LT(index, size_);
+    uint64_t permuted = index;
+    do { permuted = Permute(permuted); } while (permuted >= static_cast<uint64_t>(size_));
+    return permuted;
+  }
+
+ private:
+  static constexpr int kNumRounds = 4;
+
+  static uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  uint64_t Permute(uint64_t x) const {
+    const uint64_t mask = (uint64_t(1) << half_bits_) - 1;
+    uint64_t left = x >> half_bits_;
+    uint64_t right = x & mask;
+    FOR_RANGE(int, round, 0, kNumRounds) {
+      const uint64_t next_right = left ^ (Mix(right + Mix(seed_ + round)) & mask);
+      left = right;
+      right = next_right;
+    }
+    return (left << half_bits_) | right;
+  }
+
+  int64_t size_;
+  uint64_t seed_;
+  int64_t half_bits_;
+};
+
+// Every epoch visits one permutation of all the samples of the base dataset, the same one on all
+// shards. The permutation is cut into num_shards contiguous pieces of num_samples / num_shards
+// samples, and the last num_samples % num_shards samples of it are dropped, so that the shards
+// never overlap. shard_id reads its piece read_size samples at a time, computing only the indices
+// of its own piece. start_pos counts the samples this shard has already produced, so a resumed
+// job picks up exactly where it stopped
+template<typename LoadTarget>
+class GlobalShuffleDataset final : public Dataset<LoadTarget> {
+ public:
+  using BaseDataset = RandomAccessDataset<LoadTarget>;
+  using BaseDatasetShdPtr = std::shared_ptr<const BaseDataset>;
+  using LoadTargetShdPtr = std::shared_ptr<LoadTarget>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(GlobalShuffleDataset);
+  GlobalShuffleDataset(BaseDatasetShdPtr dataset, int64_t num_shards, int64_t shard_id,
+                       bool shuffle, int64_t random_seed, int64_t read_size, int64_t start_pos)
+      : base_dataset_(std::move(dataset)),
+        num_shards_(num_shards),
+        shard_id_(shard_id),
+        shuffle_(shuffle),
+        rnd_seed_(random_seed),
+        read_size_(read_size),
+        next_sample_(0) {
+    const int64_t num_samples = base_dataset_->Size();
+    CHECK_GT(num_shards_, 0);
+    CHECK_LE(num_shards_, num_samples);
+    CHECK_GE(shard_id_, 0);
+    CHECK_LT(shard_id_, num_shards_);
+    CHECK_GT(read_size_, 0);
+    CHECK_GE(start_pos, 0);
+    shard_size_ = num_samples / num_shards_;
+    epoch_ = start_pos / shard_size_;
+    pos_in_shard_ = start_pos % shard_size_;
+    ResetPermutation();
+  }
+  ~GlobalShuffleDataset() = default;
+
+  LoadTargetShdPtrVec Next() override {
+    if (next_sample_ == samples_.size()) { ReadSamples(); }
+    LoadTargetShdPtrVec ret;
+    ret.push_back(std::move(samples_.at(next_sample_)));
+    next_sample_ += 1;
+    return ret;
+  }
+
+ private:
+  void ReadSamples() {
+    std::vector<int64_t> indices;
+    indices.reserve(read_size_);
+    while (static_cast<int64_t>(indices.size()) < read_size_) {
+      if (pos_in_shard_ == shard_size_) {
+        epoch_ += 1;
+        pos_in_shard_ = 0;
+        ResetPermutation();
+      }
+      const int64_t index = shard_id_ * shard_size_ + pos_in_shard_;
+      indices.push_back(permutation_ ? permutation_->At(index) : index);
+      pos_in_shard_ += 1;
+    }
+    samples_ = base_dataset_->BatchAt(indices);
+    CHECK_EQ(samples_.size(), indices.size());
+    next_sample_ = 0;
+  }
+
+  void ResetPermutation() {
+    if (!shuffle_) { return; }
+    permutation_.reset(new IndexPermutation(base_dataset_->Size(), rnd_seed_ + epoch_));
+  }
+
+  BaseDatasetShdPtr base_dataset_;
+  int64_t num_shards_;
+  int64_t shard_id_;
+  bool shuffle_;
+  int64_t rnd_seed_;
+  int64_t read_size_;
+  int64_t shard_size_;
+  int64_t epoch_;
+  int64_t pos_in_shard_;
+  std::unique_ptr<IndexPermutation> permutation_;
+  LoadTargetShdPtrVec samples_;
+  size_t next_sample_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_GLOBAL_SHUFFLE_DATASET_H_
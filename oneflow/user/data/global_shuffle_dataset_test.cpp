@@ -0,0 +1,102 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/user/data/global_shuffle_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace test {
+
+namespace {
+
+// the sample of an index is the index itself
+class IndexDataset final : public RandomAccessDataset<int64_t> {
+ public:
+  explicit IndexDataset(int64_t size) : size_(size) {}
+  ~IndexDataset() override = default;
+
+  LoadTargetShdPtrVec At(int64_t index) const override {
+    LoadTargetShdPtrVec ret;
+    ret.emplace_back(new int64_t(index));
+    return ret;
+  }
+  size_t Size() const override { return size_; }
+
+ private:
+  int64_t size_;
+};
+
+std::vector<int64_t> ReadShard(int64_t num_samples, int64_t num_shards, int64_t shard_id,
+                               bool shuffle, int64_t start_pos, int64_t num_reads) {
+  GlobalShuffleDataset<int64_t> dataset(std::make_shared<IndexDataset>(num_samples), num_shards,
+                                        shard_id, shuffle, 7, 3, start_pos);
+  std::vector<int64_t> indices;
+  FOR_RANGE(int64_t, i, 0, num_reads) { indices.push_back(*dataset.Next().at(0)); }
+  return indices;
+}
+
+}  // namespace
+
+TEST(IndexPermutation, bijective) {
+  for (int64_t size : {1, 2, 3, 7, 64, 1000, 4097}) {
+    for (uint64_t seed : {0, 1, 12345}) {
+      IndexPermutation permutation(size, seed);
+      std::vector<int64_t> permuted;
+      FOR_RANGE(int64_t, i, 0, size) { permuted.push_back(permutation.At(i)); }
+      std::sort(permuted.begin(), permuted.end());
+      FOR_RANGE(int64_t, i, 0, size) { ASSERT_EQ(permuted.at(i), i); }
+    }
+  }
+}
+
+TEST(GlobalShuffleDataset, shards_are_disjoint_and_cover_dataset) {
+  for (bool shuffle : {false, true}) {
+    for (int64_t num_samples : {60, 61, 67}) {
+      for (int64_t num_shards : {1, 2, 3, 4}) {
+        const int64_t shard_size = num_samples / num_shards;
+        // two epochs, each of which is a set of distinct samples
+        FOR_RANGE(int64_t, epoch, 0, 2) {
+          std::vector<int64_t> epoch_indices;
+          FOR_RANGE(int64_t, shard_id, 0, num_shards) {
+            const std::vector<int64_t> indices = ReadShard(
+                num_samples, num_shards, shard_id, shuffle, epoch * shard_size, shard_size);
+            epoch_indices.insert(epoch_indices.end(), indices.begin(), indices.end());
+          }
+          std::sort(epoch_indices.begin(), epoch_indices.end());
+          ASSERT_EQ(epoch_indices.size(), shard_size * num_shards);
+          ASSERT_TRUE(std::adjacent_find(epoch_indices.begin(), epoch_indices.end())
+                      == epoch_indices.end());
+          ASSERT_GE(epoch_indices.front(), 0);
+          ASSERT_LT(epoch_indices.back(), num_samples);
+        }
+      }
+    }
+  }
+}
+
+TEST(GlobalShuffleDataset, resume) {
+  const std::vector<int64_t> indices = ReadShard(50, 2, 1, true, 0, 70);
+  const std::vector<int64_t> resumed = ReadShard(50, 2, 1, true, 31, 39);
+  ASSERT_TRUE(std::equal(resumed.begin(), resumed.end(), indices.begin() + 31));
+  // the epochs are shuffled differently
+  ASSERT_FALSE(std::equal(indices.begin(), indices.begin() + 25, indices.begin() + 25));
+}
+
+}  // namespace test
+
+}  // namespace data
+}  // namespace oneflow
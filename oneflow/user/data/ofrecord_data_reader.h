@@ -21,25 +21,109 @@ limitations under the License.
 #include "oneflow/user/data/ofrecord_parser.h"
 #include "oneflow/user/data/random_shuffle_dataset.h"
 #include "oneflow/user/data/batch_dataset.h"
+#include "oneflow/user/data/bucket_batch_dataset.h"
+#include "oneflow/user/data/parallel_load_dataset.h"
+#include "oneflow/user/data/ofrecord_random_access_dataset.h"
+#include "oneflow/user/data/global_shuffle_dataset.h"
+#include "oneflow/user/data/sample_cache.h"
 #include <iostream>
 
 namespace oneflow {
 namespace data {
 
+// Lock striping of the sample cache shared by the load workers
+static const int32_t kSampleCacheNumShards = 16;
+
 class OFRecordDataReader final : public DataReader<TensorBuffer> {
  public:
-  OFRecordDataReader(user_op::KernelInitContext* ctx) : DataReader<TensorBuffer>(ctx) {
-    loader_.reset(new OFRecordDataset(ctx));
-    parser_.reset(new OFRecordParser());
-    if (ctx->Attr<bool>("random_shuffle")) {
-      loader_.reset(new RandomShuffleDataset<TensorBuffer>(ctx, std::move(loader_)));
+  OFRecordDataReader(user_op::KernelInitContext* ctx)
+      : DataReader<TensorBuffer>(ctx, ctx->Attr<int32_t>("batch_buffer_size")) {
+    std::vector<std::unique_ptr<Dataset<TensorBuffer>>> workers =
+        ctx->Attr<bool>("random_access") ? NewRandomAccessWorkers(ctx) : NewStreamWorkers(ctx);
+    if (workers.size() == 1) {
+      loader_ = std::move(workers.front());
+    } else {
+      loader_.reset(new ParallelLoadDataset<TensorBuffer>(std::move(workers),
+                                                          ctx->Attr<bool>("ordered_load"),
+                                                          ctx->Attr<int32_t>("load_buffer_size")));
     }
+    parser_.reset(new OFRecordParser());
     int32_t batch_size = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape().elem_cnt();
-    loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+    const std::string& bucket_length_key = ctx->Attr<std::string>("bucket_length_key");
+    if (bucket_length_key.empty()) {
+      loader_.reset(new BatchDataset<TensorBuffer>(batch_size, std::move(loader_)));
+    } else {
+      // the batch size is the upper bound of the sample count of a batch, the out blob is dynamic
+      loader_.reset(new BucketBatchDataset<TensorBuffer>(
+          ctx->Attr<std::vector<int64_t>>("bucket_boundaries"),
+          ctx->Attr<int64_t>("max_tokens_per_batch"), batch_size,
+          [bucket_length_key](const std::shared_ptr<TensorBuffer>& sample) -> int64_t {
+            // OFRecordParser parses the whole record later, so only the length feature is read
+            return GetFeatureLength4SerializedRecord(sample->data<char>(),
+                                                     sample->shape().elem_cnt(), bucket_length_key);
+          },
+          std::move(loader_)));
+    }
     StartLoadThread();
   }
   ~OFRecordDataReader() = default;
 
+ private:
+  // every worker reads and shuffles its own shard of the part files of this rank
+  static std::vector<std::unique_ptr<Dataset<TensorBuffer>>> NewStreamWorkers(
+      user_op::KernelInitContext* ctx) {
+    CHECK(ctx->Attr<int64_t>("cache_memory_bytes") == 0
+          && ctx->Attr<std::string>("cache_spill_dir").empty())
+        << "the sample cache works in random access mode only";
+    const int32_t num_workers = std::min<int32_t>(ctx->Attr<int32_t>("num_load_workers"),
+                                                  OFRecordDataset::GetLocalPartRange(ctx).size());
+    CHECK_GT(num_workers, 0);
+    std::vector<std::unique_ptr<Dataset<TensorBuffer>>> workers;
+    FOR_RANGE(int32_t, worker_id, 0, num_workers) {
+      std::unique_ptr<Dataset<TensorBuffer>> worker(
+          new OFRecordDataset(ctx, worker_id, num_workers));
+      if (ctx->Attr<bool>("random_shuffle")) {
+        worker.reset(
+            new RandomShuffleDataset<TensorBuffer>(ctx, std::move(worker), worker_id, num_workers));
+      }
+      workers.push_back(std::move(worker));
+    }
+    return workers;
+  }
+
+  // every worker of every rank reads its own shard of a permutation of all the samples through
+  // the part file indices. The shards are numbered rank after rank, so resuming from a sample
+  // ordinal is exact as long as the load workers are merged in order
+  static std::vector<std::unique_ptr<Dataset<TensorBuffer>>> NewRandomAccessWorkers(
+      user_op::KernelInitContext* ctx) {
+    const int32_t num_workers = ctx->Attr<int32_t>("num_load_workers");
+    CHECK_GT(num_workers, 0);
+    const int64_t num_shards = ctx->parallel_ctx().parallel_num() * num_workers;
+    const int64_t resume_sample_ordinal = ctx->Attr<int64_t>("resume_sample_ordinal");
+    CHECK_EQ(resume_sample_ordinal % num_shards, 0)
+        << "resume_sample_ordinal should be a multiple of parallel_num * num_load_workers";
+    // all the ranks have to agree on the permutation
+    int64_t seed = ctx->Attr<int64_t>("seed");
+    if (seed == -1) { seed = kOneflowDatasetSeed; }
+    std::shared_ptr<const RandomAccessDataset<TensorBuffer>> dataset(
+        new OFRecordRandomAccessDataset(DataFS(), OFRecordDataset::GetDataFilePaths(ctx)));
+    const int64_t cache_memory_bytes = ctx->Attr<int64_t>("cache_memory_bytes");
+    const std::string& cache_spill_dir = ctx->Attr<std::string>("cache_spill_dir");
+    if (cache_memory_bytes > 0 || !cache_spill_dir.empty()) {
+      std::unique_ptr<SampleCache> cache(
+          new SampleCache(cache_memory_bytes, cache_spill_dir, kSampleCacheNumShards));
+      dataset.reset(new CachedRandomAccessDataset(std::move(dataset), std::move(cache)));
+    }
+    std::vector<std::unique_ptr<Dataset<TensorBuffer>>> workers;
+    FOR_RANGE(int32_t, worker_id, 0, num_workers) {
+      workers.emplace_back(new GlobalShuffleDataset<TensorBuffer>(
+          dataset, num_shards, ctx->parallel_ctx().parallel_id() * num_workers + worker_id,
+          ctx->Attr<bool>("random_shuffle"), seed, ctx->Attr<int32_t>("random_access_read_size"),
+          resume_sample_ordinal / num_shards));
+    }
+    return workers;
+  }
+
  protected:
   using DataReader<TensorBuffer>::loader_;
   using DataReader<TensorBuffer>::parser_;
@@ -31,29 +31,23 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   OF_DISALLOW_COPY_AND_MOVE(OFRecordDataset);
-  OFRecordDataset(user_op::KernelInitContext* ctx) {
+  OFRecordDataset(user_op::KernelInitContext* ctx) : OFRecordDataset(ctx, 0, 1) {}
+  // Reads only the worker_id-th of num_workers shards of the part files of this rank
+  OFRecordDataset(user_op::KernelInitContext* ctx, int32_t worker_id, int32_t num_workers) {
     current_epoch_ = 0;
     shuffle_after_epoch_ = ctx->Attr<bool>("shuffle_after_epoch");
 
     // in stream
     data_part_num_ = ctx->Attr<int32_t>("data_part_num");
-    std::string data_dir = ctx->Attr<std::string>("data_dir");
-    std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
-    int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
-
-    for (int i = 0; i < data_part_num_; ++i) {
-      std::string num = std::to_string(i);
-      int32_t zero_count =
-          std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
-      data_file_paths_.push_back(
-          JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
-    }
+    data_file_paths_ = GetDataFilePaths(ctx);
 
     parallel_id_ = ctx->parallel_ctx().parallel_id();
     parallel_num_ = ctx->parallel_ctx().parallel_num();
-    CHECK_LE(parallel_num_, data_part_num_);
-    BalancedSplitter bs(data_part_num_, parallel_num_);
-    range_ = bs.At(parallel_id_);
+    const Range local_range = GetLocalPartRange(ctx);
+    CHECK_LE(num_workers, local_range.size());
+    const Range worker_range = BalancedSplitter(local_range.size(), num_workers).At(worker_id);
+    range_ = Range(local_range.begin() + worker_range.begin(),
+                   local_range.begin() + worker_range.end());
     std::vector<std::string> local_file_paths = GetLocalFilePaths();
     save_to_local_ = Global<const IOConf>::Get()->save_downloaded_file_to_local_fs();
     in_stream_.reset(
@@ -61,6 +55,30 @@ class OFRecordDataset final : public Dataset<TensorBuffer> {
   }
   ~OFRecordDataset() = default;
 
+  // Paths of all the part files of the dataset
+  static std::vector<std::string> GetDataFilePaths(user_op::KernelInitContext* ctx) {
+    const int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
+    const std::string data_dir = ctx->Attr<std::string>("data_dir");
+    const std::string part_name_prefix = ctx->Attr<std::string>("part_name_prefix");
+    const int32_t part_name_suffix_length = ctx->Attr<int32_t>("part_name_suffix_length");
+    std::vector<std::string> ret;
+    for (int i = 0; i < data_part_num; ++i) {
+      std::string num = std::to_string(i);
+      int32_t zero_count =
+          std::max(part_name_suffix_length - static_cast<int32_t>(num.length()), 0);
+      ret.push_back(JoinPath(data_dir, part_name_prefix + std::string(zero_count, '0') + num));
+    }
+    return ret;
+  }
+
+  // Part files read by this rank
+  static Range GetLocalPartRange(user_op::KernelInitContext* ctx) {
+    const int32_t data_part_num = ctx->Attr<int32_t>("data_part_num");
+    const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+    CHECK_LE(parallel_num, data_part_num);
+    return BalancedSplitter(data_part_num, parallel_num).At(ctx->parallel_ctx().parallel_id());
+  }
+
   LoadTargetPtrList Next() override {
     LoadTargetPtrList ret;
     LoadTargetPtr sample_ptr(new TensorBuffer());
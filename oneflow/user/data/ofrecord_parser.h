@@ -20,10 +20,79 @@ limitations under the License.
 #include "oneflow/core/common/tensor_buffer.h"
 #include "oneflow/core/record/record.pb.h"
 #include "oneflow/core/thread/thread_manager.h"
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
 
 namespace oneflow {
 namespace data {
 
+// Number of elements of a feature, the byte size of the value for a bytes feature
+inline int64_t GetFeatureLength(const Feature& feature) {
+  if (feature.has_bytes_list()) {
+    CHECK_EQ(feature.bytes_list().value_size(), 1);
+    return feature.bytes_list().value(0).size();
+  } else if (feature.has_float_list()) {
+    return feature.float_list().value_size();
+  } else if (feature.has_double_list()) {
+    return feature.double_list().value_size();
+  } else if (feature.has_int32_list()) {
+    return feature.int32_list().value_size();
+  } else if (feature.has_int64_list()) {
+    return feature.int64_list().value_size();
+  } else {
+    UNIMPLEMENTED();
+  }
+  return 0;
+}
+
+// Length of the feature named key of a serialized OFRecord. Only that feature is parsed, the
+// entries of the other features are skipped over
+inline int64_t GetFeatureLength4SerializedRecord(const char* data, int size,
+                                                 const std::string& key) {
+  using google::protobuf::internal::WireFormatLite;
+  const auto IsLengthDelimited = [](uint32_t tag, int field_number) {
+    return WireFormatLite::GetTagFieldNumber(tag) == field_number
+           && WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+  };
+  google::protobuf::io::CodedInputStream input(reinterpret_cast<const uint8_t*>(data), size);
+  for (uint32_t tag = input.ReadTag(); tag != 0; tag = input.ReadTag()) {
+    if (!IsLengthDelimited(tag, OFRecord::kFeatureFieldNumber)) {
+      CHECK(WireFormatLite::SkipField(&input, tag));
+      continue;
+    }
+    // a map entry, of the key as field 1 and the value as field 2
+    uint32_t entry_size = 0;
+    CHECK(input.ReadVarint32(&entry_size));
+    const auto limit = input.PushLimit(entry_size);
+    bool is_key_matched = false;
+    int value_offset = -1;
+    uint32_t value_size = 0;
+    for (uint32_t entry_tag = input.ReadTag(); entry_tag != 0; entry_tag = input.ReadTag()) {
+      if (IsLengthDelimited(entry_tag, 1)) {
+        std::string entry_key;
+        CHECK(WireFormatLite::ReadString(&input, &entry_key));
+        is_key_matched = entry_key == key;
+      } else if (IsLengthDelimited(entry_tag, 2)) {
+        CHECK(input.ReadVarint32(&value_size));
+        value_offset = input.CurrentPosition();
+        CHECK(input.Skip(value_size));
+      } else {
+        CHECK(WireFormatLite::SkipField(&input, entry_tag));
+      }
+    }
+    input.PopLimit(limit);
+    if (is_key_matched) {
+      Feature feature;
+      if (value_offset != -1) {
+        CHECK(feature.ParseFromArray(data + value_offset, value_size));
+      }
+      return GetFeatureLength(feature);
+    }
+  }
+  LOG(FATAL) << "Field " << key << " not found";
+  return 0;
+}
+
 class OFRecordParser final : public Parser<TensorBuffer> {
  public:
   using LoadTargetPtr = std::shared_ptr<TensorBuffer>;
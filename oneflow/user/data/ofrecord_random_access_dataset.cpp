@@ -0,0 +1,150 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/ofrecord_random_access_dataset.h"
+
+namespace oneflow {
+namespace data {
+
+namespace {
+
+// Records closer than this are fetched by one read, the bytes between them are read and dropped
+constexpr int64_t kMaxMergedReadGap = 64 * 1024;
+constexpr int64_t kMaxMergedReadSize = 16 * 1024 * 1024;
+
+struct RecordLocation {
+  int64_t part_id;
+  int64_t offset;
+  int64_t length;
+  size_t out_pos;
+};
+
+}  // namespace
+
+constexpr char OFRecordIndex::kMagicCode[];
+constexpr uint64_t OFRecordIndex::kVersion;
+
+OFRecordIndex::OFRecordIndex(fs::FileSystem* fs, const std::string& part_file_path) {
+  const std::string index_file_path = IndexFilePath(part_file_path);
+  CHECK(fs->FileExists(index_file_path))
+      << "can't find OFRecord index file " << index_file_path
+      << ", build it with oneflow.data.build_ofrecord_index";
+  std::unique_ptr<fs::RandomAccessFile> index_file;
+  fs->NewRandomAccessFile(index_file_path, &index_file);
+  const uint64_t index_file_size = fs->GetFileSize(index_file_path);
+  uint64_t pos = 0;
+  auto ReadToBuf = [&](void* buf, size_t n) {
+    CHECK_LE(pos + n, index_file_size) << "truncated OFRecord index file " << index_file_path;
+    index_file->Read(pos, n, static_cast<char*>(buf));
+    pos += n;
+  };
+  char magic_code[kMagicCodeLen];
+  ReadToBuf(magic_code, kMagicCodeLen);
+  CHECK_EQ(std::memcmp(magic_code, kMagicCode, kMagicCodeLen), 0)
+      << index_file_path << " is not an OFRecord index file";
+  uint64_t version = 0;
+  ReadToBuf(&version, sizeof(version));
+  CHECK_EQ(version, kVersion);
+  uint64_t part_file_size = 0;
+  ReadToBuf(&part_file_size, sizeof(part_file_size));
+  CHECK_EQ(part_file_size, fs->GetFileSize(part_file_path))
+      << "OFRecord index file " << index_file_path << " is out of date";
+  uint64_t num_records = 0;
+  ReadToBuf(&num_records, sizeof(num_records));
+  offsets_.resize(num_records);
+  ReadToBuf(offsets_.data(), num_records * sizeof(int64_t));
+  lengths_.resize(num_records);
+  ReadToBuf(lengths_.data(), num_records * sizeof(int64_t));
+  CHECK_EQ(pos, index_file_size);
+  FOR_RANGE(size_t, i, 0, num_records) {
+    CHECK_GT(lengths_.at(i), 0);
+    CHECK_LE(offsets_.at(i) + lengths_.at(i), static_cast<int64_t>(part_file_size));
+  }
+}
+
+OFRecordRandomAccessDataset::OFRecordRandomAccessDataset(
+    fs::FileSystem* fs, const std::vector<std::string>& part_file_paths) {
+  part_first_indices_.push_back(0);
+  for (const std::string& part_file_path : part_file_paths) {
+    part_files_.emplace_back();
+    fs->NewRandomAccessFile(part_file_path, &part_files_.back());
+    part_indices_.emplace_back(new OFRecordIndex(fs, part_file_path));
+    part_first_indices_.push_back(part_first_indices_.back()
+                                  + part_indices_.back()->num_records());
+  }
+  CHECK_GT(Size(), 0);
+}
+
+OFRecordRandomAccessDataset::LoadTargetShdPtrVec OFRecordRandomAccessDataset::At(
+    int64_t index) const {
+  return BatchAt(std::vector<int64_t>{index});
+}
+
+OFRecordRandomAccessDataset::LoadTargetShdPtrVec OFRecordRandomAccessDataset::BatchAt(
+    const std::vector<int64_t>& indices) const {
+  std::vector<RecordLocation> locations(indices.size());
+  FOR_RANGE(size_t, i, 0, indices.size()) {
+    const int64_t index = indices.at(i);
+    CHECK_GE(index, 0);
+    CHECK_LT(index, static_cast<int64_t>(Size()));
+    const int64_t part_id =
+        std::upper_bound(part_first_indices_.cbegin(), part_first_indices_.cend(), index)
+        - part_first_indices_.cbegin() - 1;
+    const OFRecordIndex* part_index = part_indices_.at(part_id).get();
+    const int64_t record_index = index - part_first_indices_.at(part_id);
+    locations.at(i).part_id = part_id;
+    locations.at(i).offset = part_index->offset(record_index);
+    locations.at(i).length = part_index->length(record_index);
+    locations.at(i).out_pos = i;
+  }
+  std::sort(locations.begin(), locations.end(),
+            [](const RecordLocation& lhs, const RecordLocation& rhs) {
+              return std::tie(lhs.part_id, lhs.offset) < std::tie(rhs.part_id, rhs.offset);
+            });
+
+  LoadTargetShdPtrVec ret(indices.size());
+  std::vector<char> read_buf;
+  size_t begin = 0;
+  while (begin < locations.size()) {
+    const RecordLocation& first = locations.at(begin);
+    int64_t read_end = first.offset + first.length;
+    size_t end = begin + 1;
+    while (end < locations.size()) {
+      const RecordLocation& next = locations.at(end);
+      const int64_t next_end = std::max(read_end, next.offset + next.length);
+      if (next.part_id != first.part_id || next.offset - read_end > kMaxMergedReadGap
+          || next_end - first.offset > kMaxMergedReadSize) {
+        break;
+      }
+      read_end = next_end;
+      end += 1;
+    }
+    read_buf.resize(read_end - first.offset);
+    part_files_.at(first.part_id)->Read(first.offset, read_buf.size(), read_buf.data());
+    FOR_RANGE(size_t, i, begin, end) {
+      const RecordLocation& location = locations.at(i);
+      LoadTargetShdPtr sample_ptr(new TensorBuffer());
+      sample_ptr->Resize(Shape({location.length}), DataType::kChar);
+      std::memcpy(sample_ptr->mut_data<char>(), read_buf.data() + location.offset - first.offset,
+                  location.length);
+      ret.at(location.out_pos) = std::move(sample_ptr);
+    }
+    begin = end;
+  }
+  return ret;
+}
+
+}  // namespace data
+}  // namespace oneflow
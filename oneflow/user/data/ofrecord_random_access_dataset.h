@@ -0,0 +1,80 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_OFRECORD_RANDOM_ACCESS_DATASET_H_
+#define ONEFLOW_USER_DATA_OFRECORD_RANDOM_ACCESS_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace data {
+
+// Sidecar index of an OFRecord part file, stored next to it as "<part file>.idx":
+//   magic code    char[8]
+//   version       uint64
+//   part size     uint64, size of the part file when it was indexed
+//   record num    uint64
+//   offsets       int64[record num], file offset of every serialized record
+//   lengths       int64[record num], byte size of every serialized record
+// The index is built by oneflow.data.build_ofrecord_index
+class OFRecordIndex final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordIndex);
+  OFRecordIndex(fs::FileSystem* fs, const std::string& part_file_path);
+  ~OFRecordIndex() = default;
+
+  static constexpr char kMagicCode[] = "OFRIDX\x00\x00";
+  static constexpr size_t kMagicCodeLen = sizeof(kMagicCode) - 1;
+  static constexpr uint64_t kVersion = 1;
+
+  static std::string IndexFilePath(const std::string& part_file_path) {
+    return part_file_path + ".idx";
+  }
+
+  size_t num_records() const { return offsets_.size(); }
+  int64_t offset(size_t record_index) const { return offsets_.at(record_index); }
+  int64_t length(size_t record_index) const { return lengths_.at(record_index); }
+
+ private:
+  std::vector<int64_t> offsets_;
+  std::vector<int64_t> lengths_;
+};
+
+// Samples of all the part files of a dataset, numbered part after part
+class OFRecordRandomAccessDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  using LoadTargetShdPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(OFRecordRandomAccessDataset);
+  OFRecordRandomAccessDataset(fs::FileSystem* fs, const std::vector<std::string>& part_file_paths);
+  ~OFRecordRandomAccessDataset() = default;
+
+  LoadTargetShdPtrVec At(int64_t index) const override;
+  // Reads the records in file order, merging those lying close to each other into one read
+  LoadTargetShdPtrVec BatchAt(const std::vector<int64_t>& indices) const override;
+  size_t Size() const override { return part_first_indices_.back(); }
+
+ private:
+  std::vector<std::unique_ptr<fs::RandomAccessFile>> part_files_;
+  std::vector<std::unique_ptr<const OFRecordIndex>> part_indices_;
+  // part_first_indices_[i] is the index of the first sample of part i, the last one is Size()
+  std::vector<int64_t> part_first_indices_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_OFRECORD_RANDOM_ACCESS_DATASET_H_
@@ -0,0 +1,82 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_PARALLEL_LOAD_DATASET_H_
+#define ONEFLOW_USER_DATA_PARALLEL_LOAD_DATASET_H_
+
+#include "oneflow/user/data/dataset.h"
+#include "oneflow/core/common/buffer.h"
+
+namespace oneflow {
+namespace data {
+
+// Runs every worker dataset on its own thread and merges their samples. Each worker is expected to
+// read a disjoint shard of the input. Ordered merging takes one sample from each worker in turn, so
+// the stream depends only on the worker count; unordered merging hands out whichever sample is
+// ready first, so one slow shard does not stall the others
+template<typename LoadTarget>
+class ParallelLoadDataset final : public Dataset<LoadTarget> {
+ public:
+  using LoadTargetPtr = std::shared_ptr<LoadTarget>;
+  using LoadTargetPtrList = std::vector<LoadTargetPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(ParallelLoadDataset);
+  ParallelLoadDataset(std::vector<std::unique_ptr<Dataset<LoadTarget>>>&& workers, bool ordered,
+                      int32_t buffer_size_per_worker)
+      : workers_(std::move(workers)), next_worker_id_(0) {
+    CHECK_GT(workers_.size(), 0);
+    CHECK_GT(buffer_size_per_worker, 0);
+    const size_t num_buffers = ordered ? workers_.size() : 1;
+    const size_t buffer_size =
+        ordered ? buffer_size_per_worker : buffer_size_per_worker * workers_.size();
+    FOR_RANGE(size_t, i, 0, num_buffers) {
+      buffers_.emplace_back(new Buffer<LoadTargetPtr>(buffer_size));
+    }
+    FOR_RANGE(size_t, i, 0, workers_.size()) {
+      Buffer<LoadTargetPtr>* buffer = buffers_.at(i % num_buffers).get();
+      Dataset<LoadTarget>* worker = workers_.at(i).get();
+      worker_threads_.emplace_back([worker, buffer]() {
+        while (true) {
+          for (auto& sample_ptr : worker->Next()) {
+            if (buffer->Send(sample_ptr) == kBufferStatusErrorClosed) { return; }
+          }
+        }
+      });
+    }
+  }
+  ~ParallelLoadDataset() override {
+    for (auto& buffer : buffers_) { buffer->Close(); }
+    for (auto& worker_thread : worker_threads_) { worker_thread.join(); }
+  }
+
+  LoadTargetPtrList Next() override {
+    LoadTargetPtrList ret;
+    LoadTargetPtr sample_ptr;
+    CHECK_EQ(buffers_.at(next_worker_id_)->Receive(&sample_ptr), kBufferStatusSuccess);
+    next_worker_id_ = (next_worker_id_ + 1) % buffers_.size();
+    ret.push_back(std::move(sample_ptr));
+    return ret;
+  }
+
+ private:
+  std::vector<std::unique_ptr<Dataset<LoadTarget>>> workers_;
+  std::vector<std::unique_ptr<Buffer<LoadTargetPtr>>> buffers_;
+  std::vector<std::thread> worker_threads_;
+  size_t next_worker_id_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_PARALLEL_LOAD_DATASET_H_
@@ -30,15 +30,25 @@ class RandomShuffleDataset final : public Dataset<LoadTarget> {
   using LoadTargetPtrList = std::vector<LoadTargetPtr>;
   RandomShuffleDataset(user_op::KernelInitContext* ctx,
                        std::unique_ptr<Dataset<LoadTarget>>&& data_set)
+      : RandomShuffleDataset(ctx, std::move(data_set), 0, 1) {}
+  // One of num_workers shuffles running side by side, each with its share of the shuffle buffer
+  // and its own seed
+  RandomShuffleDataset(user_op::KernelInitContext* ctx,
+                       std::unique_ptr<Dataset<LoadTarget>>&& data_set, int32_t worker_id,
+                       int32_t num_workers)
       : loader_(std::move(data_set)) {
     // random
     seed_ = ctx->Attr<int64_t>("seed");
-    if (seed_ == -1) { seed_ = NewRandomSeed(); }
+    if (seed_ == -1) {
+      seed_ = NewRandomSeed();
+    } else {
+      seed_ += worker_id;
+    }
     std::seed_seq seq({seed_});
     rand_engine_ = std::default_random_engine(seq);
 
     // fill buffer
-    initial_buffer_fill_ = ctx->Attr<int32_t>("shuffle_buffer_size");
+    initial_buffer_fill_ = std::max(ctx->Attr<int32_t>("shuffle_buffer_size") / num_workers, 1);
     int32_t remain_cnt = initial_buffer_fill_;
     while (remain_cnt > 0) {
       LoadTargetPtrList sample_list = loader_->Next();
@@ -0,0 +1,249 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/data/sample_cache.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+#include <unistd.h>
+
+namespace oneflow {
+namespace data {
+
+class SampleCache::Shard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(Shard);
+  Shard(int64_t capacity, const std::string& spill_file_path)
+      : capacity_(capacity),
+        memory_bytes_(0),
+        spill_file_path_(spill_file_path),
+        spill_file_size_(0),
+        spilled_bytes_(0) {
+    if (!spill_file_path_.empty()) {
+      const auto mode = std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary;
+      spill_file_.open(spill_file_path_, mode);
+      CHECK(spill_file_.is_open()) << "can't open sample cache spill file " << spill_file_path_;
+    }
+  }
+  ~Shard() {
+    if (spill_file_.is_open()) {
+      spill_file_.close();
+      std::remove(spill_file_path_.c_str());
+    }
+  }
+
+  std::shared_ptr<TensorBuffer> Get(int64_t key, bool* from_disk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    *from_disk = false;
+    auto lru_it = key2lru_it_.find(key);
+    if (lru_it != key2lru_it_.end()) {
+      lru_list_.splice(lru_list_.begin(), lru_list_, lru_it->second);
+      return lru_it->second->second;
+    }
+    auto spill_it = key2spill_offset_.find(key);
+    if (spill_it == key2spill_offset_.end()) { return nullptr; }
+    std::shared_ptr<TensorBuffer> sample = ReadSpilled(key, spill_it->second);
+    *from_disk = true;
+    InsertToMemory(key, sample);
+    return sample;
+  }
+
+  void Put(int64_t key, const std::shared_ptr<TensorBuffer>& sample) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // another reader may have missed the same key at the same time
+    if (key2lru_it_.find(key) != key2lru_it_.end()) { return; }
+    if (key2spill_offset_.find(key) != key2spill_offset_.end()) { return; }
+    InsertToMemory(key, sample);
+  }
+
+  int64_t spilled_samples() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return key2spill_offset_.size();
+  }
+  int64_t spilled_bytes() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return spilled_bytes_;
+  }
+
+ private:
+  void InsertToMemory(int64_t key, const std::shared_ptr<TensorBuffer>& sample) {
+    const int64_t nbytes = sample->nbytes();
+    if (nbytes > capacity_) {
+      if (spill_file_.is_open() && key2spill_offset_.find(key) == key2spill_offset_.end()) {
+        Spill(key, *sample);
+      }
+      return;
+    }
+    while (memory_bytes_ + nbytes > capacity_) {
+      const int64_t evicted_key = lru_list_.back().first;
+      const TensorBuffer& evicted = *lru_list_.back().second;
+      if (spill_file_.is_open() && key2spill_offset_.find(evicted_key) == key2spill_offset_.end()) {
+        Spill(evicted_key, evicted);
+      }
+      memory_bytes_ -= evicted.nbytes();
+      key2lru_it_.erase(evicted_key);
+      lru_list_.pop_back();
+    }
+    lru_list_.emplace_front(key, sample);
+    key2lru_it_.emplace(key, lru_list_.begin());
+    memory_bytes_ += nbytes;
+  }
+
+  void Spill(int64_t key, const TensorBuffer& sample) {
+    const int32_t data_type = sample.data_type();
+    const int32_t num_axes = sample.shape().NumAxes();
+    spill_file_.seekp(spill_file_size_);
+    spill_file_.write(reinterpret_cast<const char*>(&key), sizeof(key));
+    spill_file_.write(reinterpret_cast<const char*>(&data_type), sizeof(data_type));
+    spill_file_.write(reinterpret_cast<const char*>(&num_axes), sizeof(num_axes));
+    FOR_RANGE(int32_t, i, 0, num_axes) {
+      const int64_t dim = sample.shape().At(i);
+      spill_file_.write(reinterpret_cast<const char*>(&dim), sizeof(dim));
+    }
+    spill_file_.write(sample.data<char>(), sample.nbytes());
+    CHECK(spill_file_.good()) << "failed to write sample cache spill file " << spill_file_path_;
+    key2spill_offset_.emplace(key, spill_file_size_);
+    spill_file_size_ = spill_file_.tellp();
+    spilled_bytes_ += sample.nbytes();
+  }
+
+  std::shared_ptr<TensorBuffer> ReadSpilled(int64_t key, int64_t offset) {
+    int64_t spilled_key = -1;
+    int32_t data_type = DataType::kInvalidDataType;
+    int32_t num_axes = 0;
+    spill_file_.seekg(offset);
+    spill_file_.read(reinterpret_cast<char*>(&spilled_key), sizeof(spilled_key));
+    spill_file_.read(reinterpret_cast<char*>(&data_type), sizeof(data_type));
+    spill_file_.read(reinterpret_cast<char*>(&num_axes), sizeof(num_axes));
+    CHECK_EQ(spilled_key, key);
+    DimVector dim_vec(num_axes);
+    spill_file_.read(reinterpret_cast<char*>(dim_vec.data()), num_axes * sizeof(int64_t));
+    std::shared_ptr<TensorBuffer> sample(new TensorBuffer());
+    sample->Resize(Shape(dim_vec), static_cast<DataType>(data_type));
+    spill_file_.read(sample->mut_data<char>(), sample->nbytes());
+    CHECK(spill_file_.good()) << "failed to read sample cache spill file " << spill_file_path_;
+    return sample;
+  }
+
+  std::mutex mutex_;
+  int64_t capacity_;
+  int64_t memory_bytes_;
+  // the most recently used at the front
+  std::list<std::pair<int64_t, std::shared_ptr<TensorBuffer>>> lru_list_;
+  HashMap<int64_t, std::list<std::pair<int64_t, std::shared_ptr<TensorBuffer>>>::iterator>
+      key2lru_it_;
+  std::string spill_file_path_;
+  std::fstream spill_file_;
+  int64_t spill_file_size_;
+  int64_t spilled_bytes_;
+  HashMap<int64_t, int64_t> key2spill_offset_;
+};
+
+SampleCache::SampleCache(int64_t memory_capacity, const std::string& spill_dir,
+                         int32_t num_shards)
+    : memory_hits_(0), disk_hits_(0), misses_(0) {
+  CHECK_GE(memory_capacity, 0);
+  CHECK_GT(num_shards, 0);
+  static std::atomic<int64_t> cache_cnt(0);
+  const int64_t cache_id = cache_cnt.fetch_add(1);
+  if (!spill_dir.empty()) { LocalFS()->RecursivelyCreateDirIfNotExist(spill_dir); }
+  FOR_RANGE(int32_t, i, 0, num_shards) {
+    std::string spill_file_path;
+    if (!spill_dir.empty()) {
+      const std::string file_name = "sample_cache-" + std::to_string(getpid()) + "-"
+                                    + std::to_string(cache_id) + "-" + std::to_string(i);
+      spill_file_path = JoinPath(spill_dir, file_name);
+    }
+    shards_.emplace_back(new Shard(memory_capacity / num_shards, spill_file_path));
+  }
+}
+
+SampleCache::~SampleCache() { LOG(INFO) << "sample cache: " << GetStats(); }
+
+SampleCache::Shard* SampleCache::Shard4Key(int64_t key) const {
+  return shards_.at(static_cast<uint64_t>(key) % shards_.size()).get();
+}
+
+std::shared_ptr<TensorBuffer> SampleCache::Get(int64_t key) {
+  bool from_disk = false;
+  std::shared_ptr<TensorBuffer> sample = Shard4Key(key)->Get(key, &from_disk);
+  if (!sample) {
+    misses_ += 1;
+  } else if (from_disk) {
+    disk_hits_ += 1;
+  } else {
+    memory_hits_ += 1;
+  }
+  return sample;
+}
+
+void SampleCache::Put(int64_t key, const std::shared_ptr<TensorBuffer>& sample) {
+  Shard4Key(key)->Put(key, sample);
+}
+
+SampleCache::Stats SampleCache::GetStats() const {
+  Stats stats;
+  stats.memory_hits = memory_hits_.load();
+  stats.disk_hits = disk_hits_.load();
+  stats.misses = misses_.load();
+  stats.spilled_samples = 0;
+  stats.spilled_bytes = 0;
+  for (const auto& shard : shards_) {
+    stats.spilled_samples += shard->spilled_samples();
+    stats.spilled_bytes += shard->spilled_bytes();
+  }
+  return stats;
+}
+
+std::ostream& operator<<(std::ostream& out, const SampleCache::Stats& stats) {
+  const int64_t num_lookups = stats.memory_hits + stats.disk_hits + stats.misses;
+  const double hit_rate =
+      num_lookups > 0 ? static_cast<double>(stats.memory_hits + stats.disk_hits) / num_lookups : 0;
+  out << "hit rate " << hit_rate << ", memory hits " << stats.memory_hits << ", disk hits "
+      << stats.disk_hits << ", misses " << stats.misses << ", spilled samples "
+      << stats.spilled_samples << ", spilled bytes " << stats.spilled_bytes;
+  return out;
+}
+
+CachedRandomAccessDataset::LoadTargetShdPtrVec CachedRandomAccessDataset::BatchAt(
+    const std::vector<int64_t>& indices) const {
+  LoadTargetShdPtrVec ret(indices.size());
+  std::vector<int64_t> missed_indices;
+  std::vector<size_t> missed_pos;
+  FOR_RANGE(size_t, i, 0, indices.size()) {
+    ret.at(i) = cache_->Get(indices.at(i));
+    if (!ret.at(i)) {
+      missed_indices.push_back(indices.at(i));
+      missed_pos.push_back(i);
+    }
+  }
+  if (!missed_indices.empty()) {
+    LoadTargetShdPtrVec missed_samples = base_dataset_->BatchAt(missed_indices);
+    CHECK_EQ(missed_samples.size(), missed_indices.size());
+    FOR_RANGE(size_t, i, 0, missed_indices.size()) {
+      cache_->Put(missed_indices.at(i), missed_samples.at(i));
+      ret.at(missed_pos.at(i)) = std::move(missed_samples.at(i));
+    }
+  }
+  const int64_t num_samples = Size();
+  const int64_t prev_num_lookups = num_lookups_.fetch_add(indices.size());
+  const int64_t num_lookups = prev_num_lookups + indices.size();
+  if (num_lookups / num_samples != prev_num_lookups / num_samples) {
+    LOG(INFO) << "sample cache after " << num_lookups << " lookups: " << cache_->GetStats();
+  }
+  return ret;
+}
+
+}  // namespace data
+}  // namespace oneflow
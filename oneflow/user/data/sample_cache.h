@@ -0,0 +1,93 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_DATA_SAMPLE_CACHE_H_
+#define ONEFLOW_USER_DATA_SAMPLE_CACHE_H_
+
+#include "oneflow/user/data/dataset.h"
+
+namespace oneflow {
+namespace data {
+
+// Keeps samples in memory up to memory_capacity bytes, split into num_shards independently locked
+// LRU lists. Samples evicted from memory are appended to a spill file in spill_dir, one per shard,
+// if spill_dir is not empty, and read back from there when looked up again. Every spilled sample
+// is stored as
+//   key          int64
+//   data type    int32
+//   num axes     int32
+//   dims         int64[num axes]
+//   data         char[nbytes]
+// Cached samples are shared with the readers, so they must not be modified after Put
+class SampleCache final {
+ public:
+  struct Stats {
+    int64_t memory_hits;
+    int64_t disk_hits;
+    int64_t misses;
+    int64_t spilled_samples;
+    int64_t spilled_bytes;
+  };
+
+  OF_DISALLOW_COPY_AND_MOVE(SampleCache);
+  SampleCache(int64_t memory_capacity, const std::string& spill_dir, int32_t num_shards);
+  ~SampleCache();
+
+  // nullptr if the key is not cached
+  std::shared_ptr<TensorBuffer> Get(int64_t key);
+  void Put(int64_t key, const std::shared_ptr<TensorBuffer>& sample);
+  Stats GetStats() const;
+
+ private:
+  class Shard;
+
+  Shard* Shard4Key(int64_t key) const;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<int64_t> memory_hits_;
+  std::atomic<int64_t> disk_hits_;
+  std::atomic<int64_t> misses_;
+};
+
+std::ostream& operator<<(std::ostream& out, const SampleCache::Stats& stats);
+
+// Serves the samples of the base dataset from the cache, reading only the missed ones from it.
+// Logs the cache statistics every time as many samples as the dataset holds have been looked up
+class CachedRandomAccessDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  using BaseDatasetShdPtr = std::shared_ptr<const RandomAccessDataset<TensorBuffer>>;
+  using LoadTargetShdPtr = std::shared_ptr<TensorBuffer>;
+  using LoadTargetShdPtrVec = std::vector<LoadTargetShdPtr>;
+  OF_DISALLOW_COPY_AND_MOVE(CachedRandomAccessDataset);
+  CachedRandomAccessDataset(BaseDatasetShdPtr dataset, std::unique_ptr<SampleCache>&& cache)
+      : base_dataset_(std::move(dataset)), cache_(std::move(cache)), num_lookups_(0) {}
+  ~CachedRandomAccessDataset() = default;
+
+  LoadTargetShdPtrVec At(int64_t index) const override {
+    return BatchAt(std::vector<int64_t>{index});
+  }
+  LoadTargetShdPtrVec BatchAt(const std::vector<int64_t>& indices) const override;
+  size_t Size() const override { return base_dataset_->Size(); }
+
+ private:
+  BaseDatasetShdPtr base_dataset_;
+  std::unique_ptr<SampleCache> cache_;
+  mutable std::atomic<int64_t> num_lookups_;
+};
+
+}  // namespace data
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_DATA_SAMPLE_CACHE_H_
@@ -0,0 +1,124 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "gtest/gtest.h"
+#include "oneflow/user/data/sample_cache.h"
+#include "oneflow/core/common/process_state.h"
+#include "oneflow/core/common/str_util.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+namespace data {
+
+namespace test {
+
+namespace {
+
+const int64_t kSampleElemCnt = 8;
+const int64_t kSampleBytes = kSampleElemCnt * sizeof(int64_t);
+
+std::shared_ptr<TensorBuffer> NewSample(int64_t key) {
+  std::shared_ptr<TensorBuffer> sample(new TensorBuffer());
+  sample->Resize(Shape({kSampleElemCnt}), DataType::kInt64);
+  FOR_RANGE(int64_t, i, 0, kSampleElemCnt) { sample->mut_data<int64_t>()[i] = key * 100 + i; }
+  return sample;
+}
+
+void CheckSample(const TensorBuffer& sample, int64_t key) {
+  ASSERT_EQ(sample.data_type(), DataType::kInt64);
+  ASSERT_EQ(sample.shape(), Shape({kSampleElemCnt}));
+  FOR_RANGE(int64_t, i, 0, kSampleElemCnt) { ASSERT_EQ(sample.data<int64_t>()[i], key * 100 + i); }
+}
+
+// the sample of an index is made of the index, and the samples read from it are counted
+class CountingDataset final : public RandomAccessDataset<TensorBuffer> {
+ public:
+  explicit CountingDataset(int64_t size) : size_(size), num_reads_(0) {}
+  ~CountingDataset() override = default;
+
+  LoadTargetShdPtrVec At(int64_t index) const override {
+    num_reads_ += 1;
+    LoadTargetShdPtrVec ret;
+    ret.push_back(NewSample(index));
+    return ret;
+  }
+  size_t Size() const override { return size_; }
+  int64_t num_reads() const { return num_reads_; }
+
+ private:
+  int64_t size_;
+  mutable std::atomic<int64_t> num_reads_;
+};
+
+}  // namespace
+
+TEST(SampleCache, memory_hits) {
+  SampleCache cache(1 << 20, "", 2);
+  FOR_RANGE(int64_t, key, 0, 10) {
+    ASSERT_TRUE(cache.Get(key) == nullptr);
+    cache.Put(key, NewSample(key));
+  }
+  FOR_RANGE(int64_t, key, 0, 10) { CheckSample(*cache.Get(key), key); }
+  const SampleCache::Stats stats = cache.GetStats();
+  ASSERT_EQ(stats.memory_hits, 10);
+  ASSERT_EQ(stats.disk_hits, 0);
+  ASSERT_EQ(stats.misses, 10);
+  ASSERT_EQ(stats.spilled_samples, 0);
+}
+
+TEST(SampleCache, spill) {
+  std::string current_dir = GetCwd();
+  StringReplace(&current_dir, '\\', '/');
+  const std::string spill_dir = JoinPath(current_dir, "tmp_test_sample_cache_spill_dir");
+  {
+    // each of the 2 shards holds 2 of its 5 samples in memory and spills the other 3
+    SampleCache cache(4 * kSampleBytes, spill_dir, 2);
+    FOR_RANGE(int64_t, key, 0, 10) { cache.Put(key, NewSample(key)); }
+    SampleCache::Stats stats = cache.GetStats();
+    ASSERT_EQ(stats.spilled_samples, 6);
+    ASSERT_EQ(stats.spilled_bytes, 6 * kSampleBytes);
+    ASSERT_EQ(LocalFS()->ListDir(spill_dir).size(), 2);
+    // every lookup evicts a sample that is looked up later, so all of them are read from disk
+    FOR_RANGE(int64_t, key, 0, 10) { CheckSample(*cache.Get(key), key); }
+    stats = cache.GetStats();
+    ASSERT_EQ(stats.memory_hits, 0);
+    ASSERT_EQ(stats.disk_hits, 10);
+    ASSERT_EQ(stats.misses, 0);
+  }
+  // the spill files go away with the cache
+  ASSERT_TRUE(LocalFS()->ListDir(spill_dir).empty());
+  LocalFS()->RecursivelyDeleteDir(spill_dir);
+}
+
+TEST(CachedRandomAccessDataset, reads_only_missed_samples) {
+  const auto base_dataset = std::make_shared<CountingDataset>(10);
+  CachedRandomAccessDataset dataset(base_dataset,
+                                    std::unique_ptr<SampleCache>(new SampleCache(1 << 20, "", 2)));
+  const std::vector<int64_t> indices{3, 1, 4, 5, 9};
+  FOR_RANGE(int64_t, i, 0, 2) {
+    const auto samples = dataset.BatchAt(indices);
+    ASSERT_EQ(samples.size(), indices.size());
+    FOR_RANGE(size_t, j, 0, indices.size()) { CheckSample(*samples.at(j), indices.at(j)); }
+  }
+  ASSERT_EQ(base_dataset->num_reads(), indices.size());
+  const auto samples = dataset.BatchAt({1, 2, 3});
+  FOR_RANGE(int64_t, i, 0, 3) { CheckSample(*samples.at(i), i + 1); }
+  ASSERT_EQ(base_dataset->num_reads(), indices.size() + 1);
+}
+
+}  // namespace test
+
+}  // namespace data
+}  // namespace oneflow
@@ -27,6 +27,15 @@ void cpu_add(const int64_t n, T* out, const std::vector<const T*>& in) {
   }
 }
 
+// accumulates in float, and rounds only the sum to bfloat16
+void cpu_add(const int64_t n, bfloat16* out, const std::vector<const bfloat16*>& in) {
+  for (int64_t i = 0; i != n; ++i) {
+    float sum = in.at(0)[i];
+    for (int32_t j = 1; j < in.size(); ++j) { sum += in.at(j)[i]; }
+    out[i] = sum;
+  }
+}
+
 }  // namespace
 
 template<typename T>
@@ -50,7 +59,7 @@ class CpuAddNKernel : public user_op::OpKernel {
       in_dptrs.at(i) = ctx->Tensor4ArgNameAndIndex("in", i)->dptr<T>();
     }
 
-    cpu_add<T>(n, out_dptr, in_dptrs);
+    cpu_add(n, out_dptr, in_dptrs);
   }
 };
 
@@ -65,6 +74,6 @@ class CpuAddNKernel : public user_op::OpKernel {
         return Maybe<void>::Ok();                                                               \
       });
 
-OF_PP_FOR_EACH_TUPLE(REGISTER_CPU_ADDN_KERNEL, ARITHMETIC_DATA_TYPE_SEQ);
+OF_PP_FOR_EACH_TUPLE(REGISTER_CPU_ADDN_KERNEL, ARITHMETIC_DATA_TYPE_SEQ BFLOAT16_DATA_TYPE_SEQ);
 
 }  // namespace oneflow
@@ -31,8 +31,24 @@ struct BiasAddCalculation<DeviceType::kCPU, T, Index> {
   }
 };
 
+// adds in float, so that out is rounded to bfloat16 once
+template<typename Index>
+struct BiasAddCalculation<DeviceType::kCPU, bfloat16, Index> {
+  static void Invoke(DeviceCtx* ctx, int64_t outer_size, int64_t bias_size, int64_t inner_size,
+                     const bfloat16* x, const bfloat16* bias, bfloat16* y) {
+    FOR_RANGE(int64_t, i, 0, outer_size) {
+      FOR_RANGE(int64_t, j, 0, bias_size) {
+        const float bias_val = bias[j];
+        const int64_t offset = (i * bias_size + j) * inner_size;
+        FOR_RANGE(int64_t, k, 0, inner_size) { y[offset + k] = x[offset + k] + bias_val; }
+      }
+    }
+  }
+};
+
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, float)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, double)
+REGISTER_BIAS_ADD_USER_KERNEL(CPU, bfloat16)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, int8_t)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, int32_t)
 REGISTER_BIAS_ADD_USER_KERNEL(CPU, int64_t)
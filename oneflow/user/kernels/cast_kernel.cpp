@@ -32,6 +32,20 @@ struct CopyTensor<DeviceType::kCPU, T, U> {
   }
 };
 
+template<>
+struct CopyTensor<DeviceType::kCPU, bfloat16, float> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    ConvertBFloat16ToFloat(src->dptr<bfloat16>(), dst->mut_dptr<float>(), src->shape().elem_cnt());
+  }
+};
+
+template<>
+struct CopyTensor<DeviceType::kCPU, float, bfloat16> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
+    ConvertFloatToBFloat16(src->dptr<float>(), dst->mut_dptr<bfloat16>(), src->shape().elem_cnt());
+  }
+};
+
 template<typename T, typename U>
 struct CopyTensor<DeviceType::kGPU, T, U> {
   static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) {
@@ -43,6 +57,17 @@ struct CopyTensor<DeviceType::kGPU, T, U> {
   }
 };
 
+// bfloat16 is only computed on cpu
+template<typename U>
+struct CopyTensor<DeviceType::kGPU, bfloat16, U> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) { UNIMPLEMENTED(); }
+};
+
+template<typename T>
+struct CopyTensor<DeviceType::kGPU, T, bfloat16> {
+  static void Call(DeviceCtx* ctx, const Tensor* src, Tensor* dst) { UNIMPLEMENTED(); }
+};
+
 }  // namespace
 
 #define MAKE_CASE_HANDLER_ENTRY(in_type_pair, out_type_pair)                          \
@@ -61,6 +86,8 @@ struct CastUtil final {
           OF_PP_SEQ_PRODUCT_FOR_EACH_TUPLE(MAKE_CASE_HANDLER_ENTRY, POD_DATA_TYPE_SEQ, POD_DATA_TYPE_SEQ)
           MAKE_CASE_HANDLER_ENTRY((float, DataType::kFloat), (float16, DataType::kFloat16))
           MAKE_CASE_HANDLER_ENTRY((float16, DataType::kFloat16), (float, DataType::kFloat))
+          MAKE_CASE_HANDLER_ENTRY((float, DataType::kFloat), (bfloat16, DataType::kBFloat16))
+          MAKE_CASE_HANDLER_ENTRY((bfloat16, DataType::kBFloat16), (float, DataType::kFloat))
             // clang-format on
         };
     case_handler.at(key)(ctx, src, dst);
@@ -17,6 +17,8 @@ limitations under the License.
 #include "oneflow/user/ops/nn_util.h"
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
 
 namespace oneflow {
 
@@ -291,6 +293,120 @@ struct ConvKernelUtil final {
   }
 };
 
+Shape Gen5DShape(const ShapeView& shape, int32_t idx_offset) {
+  DimVector ret_vec;
+  shape.ToDimVector(&ret_vec);
+  int32_t ndims = ret_vec.size() - 2;
+  ret_vec.insert(ret_vec.begin() + idx_offset, 3 - ndims, 1);
+  return Shape(ret_vec);
+}
+
+std::vector<int32_t> Gen3DVec(const std::vector<int32_t>& origin_vec) {
+  std::vector<int32_t> ret_vec = origin_vec;
+  ret_vec.insert(ret_vec.begin(), 3 - ret_vec.size(), 1);
+  return ret_vec;
+}
+
+std::vector<int32_t> Gen3DPaddingBefore(const std::vector<int32_t>& padding_before) {
+  std::vector<int32_t> ret_vec;
+  FOR_RANGE(uint8_t, dim, 0, 3) {
+    int64_t index = static_cast<int64_t>(dim) - (3 - padding_before.size());
+    if (index < 0) {
+      ret_vec.push_back(0);
+    } else {
+      ret_vec.push_back(padding_before.at(index));
+    }
+  }
+  return ret_vec;
+}
+
+// Forward algorithms of ConvCpuKernel, picked once per kernel from the static shapes
+enum class ConvCpuAlgo {
+  kIm2ColGemm,
+  kGemm1x1,
+  kWinogradF2x3,
+  kWinogradF4x3,
+};
+
+// Images or winograd tile blocks in flight at once, each owning a slice of tmp_buffer
+constexpr int64_t kMaxConvCpuParallelNum = 8;
+// Rows of the channels_last 1x1 gemm handled by one thread at least
+constexpr int64_t kMinGemm1x1RowsPerPart = 64;
+// Below this many input or output channels the winograd transforms cost more than they save
+constexpr int64_t kMinWinogradChannels = 16;
+// Output size from which F(4x4, 3x3) wastes little on partial tiles
+constexpr int64_t kMinWinogradF4x3OutSize = 8;
+// Tiles per winograd gemm, i.e. the n dim of every elementwise product
+constexpr int64_t kWinogradTileBlockSize = 64;
+
+ConvCpuAlgo SelectConvCpuAlgo(const ShapeView& in_5d_shape, const ShapeView& weight_5d_shape,
+                              const ShapeView& out_5d_shape, int32_t idx_offset,
+                              const std::vector<int32_t>& strides_3d,
+                              const std::vector<int32_t>& dilation_rate_3d,
+                              const std::vector<int32_t>& padding_before_3d) {
+  const int64_t filters = weight_5d_shape.At(0);
+  const int64_t channels = weight_5d_shape.At(idx_offset == 2 ? 1 : 4);
+  bool is_unit_stride = true;
+  bool is_unit_dilation = true;
+  bool is_same_spatial = true;
+  FOR_RANGE(int32_t, i, 0, 3) {
+    is_unit_stride = is_unit_stride && strides_3d.at(i) == 1;
+    is_unit_dilation = is_unit_dilation && dilation_rate_3d.at(i) == 1;
+    is_same_spatial =
+        is_same_spatial && in_5d_shape.At(idx_offset + i) == out_5d_shape.At(idx_offset + i);
+  }
+  const int64_t kd = weight_5d_shape.At(idx_offset);
+  const int64_t kh = weight_5d_shape.At(idx_offset + 1);
+  const int64_t kw = weight_5d_shape.At(idx_offset + 2);
+  if (kd == 1 && kh == 1 && kw == 1 && is_unit_stride && is_same_spatial
+      && std::all_of(padding_before_3d.begin(), padding_before_3d.end(),
+                     [](int32_t padding) { return padding == 0; })) {
+    return ConvCpuAlgo::kGemm1x1;
+  }
+  if (kd == 1 && kh == 3 && kw == 3 && in_5d_shape.At(idx_offset) == 1 && is_unit_stride
+      && is_unit_dilation && padding_before_3d.at(0) == 0 && channels >= kMinWinogradChannels
+      && filters >= kMinWinogradChannels) {
+    if (out_5d_shape.At(idx_offset + 1) >= kMinWinogradF4x3OutSize
+        && out_5d_shape.At(idx_offset + 2) >= kMinWinogradF4x3OutSize) {
+      return ConvCpuAlgo::kWinogradF4x3;
+    }
+    return ConvCpuAlgo::kWinogradF2x3;
+  }
+  return ConvCpuAlgo::kIm2ColGemm;
+}
+
+template<typename ContextT>
+ConvCpuAlgo InferConvCpuAlgo(ContextT* ctx) {
+  const int32_t idx_offset = IdxOffset(ctx->template Attr<std::string>("data_format"));
+  const ConvCpuAlgo algo = SelectConvCpuAlgo(
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex("in", 0)->shape(), idx_offset),
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape(), idx_offset),
+      Gen5DShape(ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape(), idx_offset), idx_offset,
+      Gen3DVec(ctx->template Attr<std::vector<int32_t>>("strides")),
+      Gen3DVec(ctx->template Attr<std::vector<int32_t>>("dilation_rate")),
+      Gen3DPaddingBefore(ctx->template Attr<std::vector<int32_t>>("padding_before")));
+  // the winograd transforms of bfloat16 would round every intermediate sum to bfloat16
+  if ((algo == ConvCpuAlgo::kWinogradF2x3 || algo == ConvCpuAlgo::kWinogradF4x3)
+      && ctx->TensorDesc4ArgNameAndIndex("in", 0)->data_type() == DataType::kBFloat16) {
+    return ConvCpuAlgo::kIm2ColGemm;
+  }
+  return algo;
+}
+
+int64_t GetWinogradTileSize(ConvCpuAlgo algo) { return algo == ConvCpuAlgo::kWinogradF4x3 ? 4 : 2; }
+
+// Transformed weight, shared by all tile blocks
+int64_t CalcElemNumOfWinogradWeightBuf(int64_t tile_size, int64_t filters, int64_t channels) {
+  const int64_t alpha = tile_size + 2;
+  return alpha * alpha * filters * channels;
+}
+
+// Transformed input and output of one tile block
+int64_t CalcElemNumOfWinogradTileBuf(int64_t tile_size, int64_t filters, int64_t channels) {
+  const int64_t alpha = tile_size + 2;
+  return alpha * alpha * (channels + filters) * kWinogradTileBlockSize;
+}
+
 template<typename T>
 struct ConvOpKernelState final : public user_op::OpKernelState {
   Im2ColFunc<T> im2col_func_;
@@ -308,17 +424,10 @@ struct ConvOpKernelState final : public user_op::OpKernelState {
   enum CBLAS_TRANSPOSE is_out_diff_need_trans_;
   int32_t idx_offset_;
   bool is_dynamic_;
+  ConvCpuAlgo algo_;
 
   void Update(const ShapeView& x_shape, const ShapeView& out_shape) {
-    auto Gen5DShape = [](const ShapeView& shape, int32_t idx_offset) -> Shape {
-      DimVector ret_vec;
-      shape.ToDimVector(&ret_vec);
-      int32_t ndims = ret_vec.size() - 2;
-      ret_vec.insert(ret_vec.begin() + idx_offset, 3 - ndims, 1);
-      return Shape(ret_vec);
-    };
     if (is_dynamic_) {
-      Shape in_shape;
       in_5d_shape_ = Gen5DShape(x_shape, idx_offset_);
       out_5d_shape_ = Gen5DShape(out_shape, idx_offset_);
     }
@@ -347,12 +456,6 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
     state->idx_offset_ = 1;
   }
 
-  auto Gen5DShape = [](const Shape& shape, int32_t idx_offset) -> Shape {
-    DimVector ret_vec(shape.dim_vec());
-    int32_t ndims = ret_vec.size() - 2;
-    ret_vec.insert(ret_vec.begin() + idx_offset, 3 - ndims, 1);
-    return Shape(ret_vec);
-  };
   state->in_5d_shape_ =
       Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->shape(), state->idx_offset_);
   state->out_5d_shape_ =
@@ -360,23 +463,11 @@ std::shared_ptr<user_op::OpKernelState> CreateConvOpKernelState(user_op::KernelI
   state->weight_5d_shape_ =
       Gen5DShape(ctx->TensorDesc4ArgNameAndIndex(weight_name, 0)->shape(), state->idx_offset_);
 
-  auto Gen3DVec = [](const std::vector<int32_t>& origin_vec) -> std::vector<int32_t> {
-    std::vector<int32_t> ret_vec = origin_vec;
-    ret_vec.insert(ret_vec.begin(), 3 - ret_vec.size(), 1);
-    return ret_vec;
-  };
   state->strides_3d_ = Gen3DVec(ctx->Attr<std::vector<int32_t>>("strides"));
   state->dilation_rate_3d_ = Gen3DVec(ctx->Attr<std::vector<int32_t>>("dilation_rate"));
+  state->padding_before_3d_ = Gen3DPaddingBefore(ctx->Attr<std::vector<int32_t>>("padding_before"));
   state->is_dynamic_ = ctx->TensorDesc4ArgNameAndIndex(in_name, 0)->is_dynamic();
-  const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
-  FOR_RANGE(uint8_t, dim, 0, 3) {
-    int64_t index = static_cast<int64_t>(dim) - (3 - padding_before.size());
-    if (index < 0) {
-      state->padding_before_3d_.push_back(0);
-    } else {
-      state->padding_before_3d_.push_back(padding_before.at(index));
-    }
-  }
+  state->algo_ = ConvCpuAlgo::kIm2ColGemm;
 
   return std::move(state);
 }
@@ -386,6 +477,326 @@ void InitBiasMulBuf(T* dptr, int64_t num) {
   for (int64_t i = 0; i < num; ++i) { dptr[i] = 1; }
 }
 
+template<typename T>
+void AddConvBias(const T* bias, int64_t filters, int64_t spatial, bool is_channels_first,
+                 T* out_dptr) {
+  if (is_channels_first) {
+    FOR_RANGE(int64_t, c, 0, filters) {
+      const T bias_val = bias[c];
+      T* out_row = out_dptr + c * spatial;
+      FOR_RANGE(int64_t, s, 0, spatial) { out_row[s] += bias_val; }
+    }
+  } else {
+    FOR_RANGE(int64_t, s, 0, spatial) {
+      T* out_pixel = out_dptr + s * filters;
+      FOR_RANGE(int64_t, c, 0, filters) { out_pixel[c] += bias[c]; }
+    }
+  }
+}
+
+// Every image gets its own col buffer so that im2col and gemm of different images overlap
+template<typename T>
+void ConvForwardIm2ColGemm(const ConvOpKernelState<T>& state, const user_op::Tensor* in,
+                           const user_op::Tensor* weight, const user_op::Tensor* bias,
+                           user_op::Tensor* out, user_op::Tensor* tmp_buffer) {
+  const int32_t idx_offset = state.idx_offset_;
+  const int64_t batch = in->shape().At(0);
+  const int64_t filters = state.weight_5d_shape_.At(0);
+  const int64_t spatial = state.out_5d_shape_.Count(idx_offset, idx_offset + 3);
+  const int64_t col_buf_elem_cnt =
+      CalcElemNumOfColBuf(ShapeView(state.out_5d_shape_), ShapeView(state.weight_5d_shape_),
+                          idx_offset);
+  const int64_t num_col_bufs = tmp_buffer->shape().elem_cnt() / (col_buf_elem_cnt * sizeof(T));
+  CHECK_GT(num_col_bufs, 0);
+  const int64_t num_parts = std::min<int64_t>(
+      std::min(batch, num_col_bufs), Global<ThreadPool>::Get()->thread_num());
+  if (num_parts == 0) { return; }
+  const BalancedSplitter bs(batch, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    T* col_buf_dptr = tmp_buffer->mut_dptr<T>() + part_id * col_buf_elem_cnt;
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, i, range.begin(), range.end()) {
+      state.im2col_func_(GetImgDptr<T>(in, i), ShapeView(state.in_5d_shape_),
+                         ShapeView(state.weight_5d_shape_), ShapeView(state.out_5d_shape_),
+                         state.strides_3d_.data(), state.dilation_rate_3d_.data(),
+                         state.padding_before_3d_.data(), col_buf_dptr);
+
+      // channels first: out = weight * col_buf
+      // channels last:  out = (weight * col_buf)(T)
+      state.forward_func_(CblasNoTrans, CblasNoTrans,
+                          filters,                          // filter
+                          spatial,                          // od * oh * ow
+                          state.weight_5d_shape_.Count(1),  // ci * kd * kh * kw
+                          static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, static_cast<T>(0),
+                          GetImgMutDptr<T>(out, i));
+      if (bias != nullptr) {
+        AddConvBias(bias->dptr<T>(), filters, spatial, idx_offset == 2, GetImgMutDptr<T>(out, i));
+      }
+    }
+  });
+}
+
+// A 1x1 conv with unit strides and no padding reads the image itself as the col buffer
+template<typename T>
+void ConvForwardGemm1x1(const ConvOpKernelState<T>& state, const user_op::Tensor* in,
+                        const user_op::Tensor* weight, const user_op::Tensor* bias,
+                        user_op::Tensor* out) {
+  const int32_t idx_offset = state.idx_offset_;
+  const int64_t batch = in->shape().At(0);
+  const int64_t filters = state.weight_5d_shape_.At(0);
+  const int64_t channels = state.weight_5d_shape_.Count(1);
+  const int64_t spatial = state.out_5d_shape_.Count(idx_offset, idx_offset + 3);
+  if (idx_offset == 2) {
+    ParallelForEachTask(batch, [&](int64_t i) {
+      // out[i] = weight * in[i]
+      NewKernelUtil<DeviceType::kCPU>::OFGemm(nullptr, CblasNoTrans, CblasNoTrans, filters,
+                                              spatial, channels, static_cast<T>(1),
+                                              weight->dptr<T>(), GetImgDptr<T>(in, i),
+                                              static_cast<T>(0), GetImgMutDptr<T>(out, i));
+      if (bias != nullptr) {
+        AddConvBias(bias->dptr<T>(), filters, spatial, true, GetImgMutDptr<T>(out, i));
+      }
+    });
+  } else {
+    // pixels of the whole batch are the rows of a single gemm: out = in * weight(T)
+    const int64_t rows = batch * spatial;
+    const int64_t num_parts =
+        std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                          std::max<int64_t>(rows / kMinGemm1x1RowsPerPart, 1));
+    const BalancedSplitter bs(rows, num_parts);
+    MultiThreadLoop(num_parts, [&](size_t part_id) {
+      const Range range = bs.At(part_id);
+      if (range.size() == 0) { return; }
+      T* out_dptr = out->mut_dptr<T>() + range.begin() * filters;
+      NewKernelUtil<DeviceType::kCPU>::OFGemm(
+          nullptr, CblasNoTrans, CblasTrans, range.size(), filters, channels, static_cast<T>(1),
+          in->dptr<T>() + range.begin() * channels, weight->dptr<T>(), static_cast<T>(0),
+          out_dptr);
+      if (bias != nullptr) { AddConvBias(bias->dptr<T>(), filters, range.size(), false, out_dptr); }
+    });
+  }
+}
+
+template<typename T, int64_t tile_size>
+struct WinogradMatrices;
+
+// F(2x2, 3x3)
+template<typename T>
+struct WinogradMatrices<T, 2> {
+  static const T* BT() {
+    static const T bt[] = {1, 0, -1, 0,  //
+                           0, 1, 1,  0,  //
+                           0, -1, 1, 0,  //
+                           0, 1, 0,  -1};
+    return bt;
+  }
+  static const T* G() {
+    static const T g[] = {1,   0,    0,    //
+                          0.5, 0.5,  0.5,  //
+                          0.5, -0.5, 0.5,  //
+                          0,   0,    1};
+    return g;
+  }
+  static const T* AT() {
+    static const T at[] = {1, 1, 1,  0,  //
+                           0, 1, -1, -1};
+    return at;
+  }
+};
+
+// F(4x4, 3x3)
+template<typename T>
+struct WinogradMatrices<T, 4> {
+  static const T* BT() {
+    static const T bt[] = {4, 0,  -5, 0,  1, 0,  //
+                           0, -4, -4, 1,  1, 0,  //
+                           0, 4,  -4, -1, 1, 0,  //
+                           0, -2, -1, 2,  1, 0,  //
+                           0, 2,  -1, -2, 1, 0,  //
+                           0, 4,  0,  -5, 0, 1};
+    return bt;
+  }
+  static const T* G() {
+    static const T g[] = {1.0 / 4,  0,         0,         //
+                          -1.0 / 6, -1.0 / 6,  -1.0 / 6,  //
+                          -1.0 / 6, 1.0 / 6,   -1.0 / 6,  //
+                          1.0 / 24, 1.0 / 12,  1.0 / 6,   //
+                          1.0 / 24, -1.0 / 12, 1.0 / 6,   //
+                          0,        0,         1};
+    return g;
+  }
+  static const T* AT() {
+    static const T at[] = {1, 1, 1,  1, 1,  0,  //
+                           0, 1, -1, 2, -2, 0,  //
+                           0, 1, 1,  4, 4,  0,  //
+                           0, 1, -1, 8, -8, 1};
+    return at;
+  }
+};
+
+// y = p * x * p(T), where p is rows x cols and x is cols x cols
+template<typename T, int64_t rows, int64_t cols>
+void WinogradTransform(const T* p, const T* x, T* y) {
+  T px[rows * cols];
+  FOR_RANGE(int64_t, i, 0, rows) {
+    FOR_RANGE(int64_t, j, 0, cols) {
+      T sum = 0;
+      FOR_RANGE(int64_t, k, 0, cols) { sum += p[i * cols + k] * x[k * cols + j]; }
+      px[i * cols + j] = sum;
+    }
+  }
+  FOR_RANGE(int64_t, i, 0, rows) {
+    FOR_RANGE(int64_t, j, 0, rows) {
+      T sum = 0;
+      FOR_RANGE(int64_t, k, 0, cols) { sum += px[i * cols + k] * p[j * cols + k]; }
+      y[i * rows + j] = sum;
+    }
+  }
+}
+
+// Winograd minimal filtering (Lavin & Gray, 2016) for 3x3 2d convs with unit strides: every
+// alpha x alpha input tile, alpha = tile_size + 2, yields a tile_size x tile_size output tile, and
+// the channel reduction turns into alpha^2 independent gemms over a block of tiles
+template<typename T, int64_t tile_size>
+void ConvForwardWinograd(const ConvOpKernelState<T>& state, const user_op::Tensor* in,
+                         const user_op::Tensor* weight, const user_op::Tensor* bias,
+                         user_op::Tensor* out, user_op::Tensor* tmp_buffer) {
+  constexpr int64_t alpha = tile_size + 2;
+  constexpr int64_t alpha_sq = alpha * alpha;
+  typedef WinogradMatrices<T, tile_size> Matrices;
+  const int32_t idx_offset = state.idx_offset_;
+  const bool is_channels_first = idx_offset == 2;
+  const ShapeView in_shape(state.in_5d_shape_);
+  const ShapeView out_shape(state.out_5d_shape_);
+  const int64_t batch = in_shape.At(0);
+  const int64_t filters = state.weight_5d_shape_.At(0);
+  const int64_t channels = state.weight_5d_shape_.At(is_channels_first ? 1 : 4);
+  const int64_t in_height = in_shape.At(idx_offset + 1);
+  const int64_t in_width = in_shape.At(idx_offset + 2);
+  const int64_t out_height = out_shape.At(idx_offset + 1);
+  const int64_t out_width = out_shape.At(idx_offset + 2);
+  const int64_t padding_h = state.padding_before_3d_.at(1);
+  const int64_t padding_w = state.padding_before_3d_.at(2);
+  // element strides of channel, row and column
+  const int64_t in_c_stride = is_channels_first ? in_height * in_width : 1;
+  const int64_t in_h_stride = is_channels_first ? in_width : in_width * channels;
+  const int64_t in_w_stride = is_channels_first ? 1 : channels;
+  const int64_t out_c_stride = is_channels_first ? out_height * out_width : 1;
+  const int64_t out_h_stride = is_channels_first ? out_width : out_width * filters;
+  const int64_t out_w_stride = is_channels_first ? 1 : filters;
+  const int64_t weight_c_stride = is_channels_first ? 9 : 1;
+  const int64_t weight_h_stride = is_channels_first ? 3 : 3 * channels;
+  const int64_t weight_w_stride = is_channels_first ? 1 : channels;
+
+  const int64_t weight_buf_elem_cnt =
+      CalcElemNumOfWinogradWeightBuf(tile_size, filters, channels);
+  const int64_t tile_buf_elem_cnt = CalcElemNumOfWinogradTileBuf(tile_size, filters, channels);
+  const int64_t num_tile_bufs =
+      (tmp_buffer->shape().elem_cnt() / static_cast<int64_t>(sizeof(T)) - weight_buf_elem_cnt)
+      / tile_buf_elem_cnt;
+  CHECK_GT(num_tile_bufs, 0);
+  T* transformed_weight = tmp_buffer->mut_dptr<T>();
+  T* tile_bufs = transformed_weight + weight_buf_elem_cnt;
+
+  // transformed_weight[xi][filter][channel] = (G * weight * G(T))[xi]
+  ParallelForEachTask(filters, [&](int64_t f) {
+    const T* filter_dptr = weight->dptr<T>() + f * 9 * channels;
+    T g[9];
+    T u[alpha_sq];
+    FOR_RANGE(int64_t, c, 0, channels) {
+      FOR_RANGE(int64_t, kh, 0, 3) {
+        FOR_RANGE(int64_t, kw, 0, 3) {
+          g[kh * 3 + kw] =
+              filter_dptr[c * weight_c_stride + kh * weight_h_stride + kw * weight_w_stride];
+        }
+      }
+      WinogradTransform<T, alpha, 3>(Matrices::G(), g, u);
+      FOR_RANGE(int64_t, xi, 0, alpha_sq) {
+        transformed_weight[(xi * filters + f) * channels + c] = u[xi];
+      }
+    }
+  });
+
+  const int64_t tiles_h = (out_height + tile_size - 1) / tile_size;
+  const int64_t tiles_w = (out_width + tile_size - 1) / tile_size;
+  const int64_t tiles_per_image = tiles_h * tiles_w;
+  const int64_t num_tiles = batch * tiles_per_image;
+  const int64_t num_blocks = (num_tiles + kWinogradTileBlockSize - 1) / kWinogradTileBlockSize;
+  const int64_t num_parts = std::min<int64_t>(std::min(num_blocks, num_tile_bufs),
+                                              Global<ThreadPool>::Get()->thread_num());
+  if (num_parts == 0) { return; }
+  const BalancedSplitter bs(num_blocks, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    T* transformed_in = tile_bufs + part_id * tile_buf_elem_cnt;
+    T* transformed_out = transformed_in + alpha_sq * channels * kWinogradTileBlockSize;
+    T d[alpha_sq];
+    T v[alpha_sq];
+    T y[tile_size * tile_size];
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, block_id, range.begin(), range.end()) {
+      const int64_t tile_begin = block_id * kWinogradTileBlockSize;
+      const int64_t block_size = std::min(kWinogradTileBlockSize, num_tiles - tile_begin);
+
+      // transformed_in[xi][channel][tile] = (BT * in_tile * B)[xi]
+      FOR_RANGE(int64_t, t, 0, block_size) {
+        const int64_t tile_id = tile_begin + t;
+        const int64_t n = tile_id / tiles_per_image;
+        const int64_t h_begin = (tile_id % tiles_per_image) / tiles_w * tile_size - padding_h;
+        const int64_t w_begin = (tile_id % tiles_per_image) % tiles_w * tile_size - padding_w;
+        const T* img_dptr = GetImgDptr<T>(in, n);
+        FOR_RANGE(int64_t, c, 0, channels) {
+          FOR_RANGE(int64_t, i, 0, alpha) {
+            const int64_t h = h_begin + i;
+            FOR_RANGE(int64_t, j, 0, alpha) {
+              const int64_t w = w_begin + j;
+              d[i * alpha + j] = (h >= 0 && h < in_height && w >= 0 && w < in_width)
+                                     ? img_dptr[c * in_c_stride + h * in_h_stride + w * in_w_stride]
+                                     : GetZeroVal<T>();
+            }
+          }
+          WinogradTransform<T, alpha, alpha>(Matrices::BT(), d, v);
+          FOR_RANGE(int64_t, xi, 0, alpha_sq) {
+            transformed_in[(xi * channels + c) * block_size + t] = v[xi];
+          }
+        }
+      }
+
+      // transformed_out[xi] = transformed_weight[xi] * transformed_in[xi]
+      FOR_RANGE(int64_t, xi, 0, alpha_sq) {
+        NewKernelUtil<DeviceType::kCPU>::OFGemm(
+            nullptr, CblasNoTrans, CblasNoTrans, filters, block_size, channels, static_cast<T>(1),
+            transformed_weight + xi * filters * channels,
+            transformed_in + xi * channels * block_size, static_cast<T>(0),
+            transformed_out + xi * filters * block_size);
+      }
+
+      // out_tile = AT * transformed_out * A
+      FOR_RANGE(int64_t, t, 0, block_size) {
+        const int64_t tile_id = tile_begin + t;
+        const int64_t n = tile_id / tiles_per_image;
+        const int64_t h_begin = (tile_id % tiles_per_image) / tiles_w * tile_size;
+        const int64_t w_begin = (tile_id % tiles_per_image) % tiles_w * tile_size;
+        const int64_t h_size = std::min(tile_size, out_height - h_begin);
+        const int64_t w_size = std::min(tile_size, out_width - w_begin);
+        T* img_dptr = GetImgMutDptr<T>(out, n);
+        FOR_RANGE(int64_t, f, 0, filters) {
+          FOR_RANGE(int64_t, xi, 0, alpha_sq) {
+            d[xi] = transformed_out[(xi * filters + f) * block_size + t];
+          }
+          WinogradTransform<T, tile_size, alpha>(Matrices::AT(), d, y);
+          const T bias_val = bias != nullptr ? bias->dptr<T>()[f] : GetZeroVal<T>();
+          FOR_RANGE(int64_t, i, 0, h_size) {
+            FOR_RANGE(int64_t, j, 0, w_size) {
+              img_dptr[f * out_c_stride + (h_begin + i) * out_h_stride
+                       + (w_begin + j) * out_w_stride] = y[i * tile_size + j] + bias_val;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
 template<typename T, size_t NDims>
 class ConvCpuKernel final : public user_op::OpKernel {
  public:
@@ -396,88 +807,71 @@ class ConvCpuKernel final : public user_op::OpKernel {
 
   std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
       user_op::KernelInitContext* ctx) const {
-    return CreateConvOpKernelState<T>(ctx, "in", "out", "weight");
+    std::shared_ptr<user_op::OpKernelState> state =
+        CreateConvOpKernelState<T>(ctx, "in", "out", "weight");
+    // the same choice the tmp buffer was inferred for
+    dynamic_cast<ConvOpKernelState<T>*>(state.get())->algo_ = InferConvCpuAlgo(ctx);
+    return state;
   }
 
  private:
   void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
     const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
     const user_op::Tensor* weight = ctx->Tensor4ArgNameAndIndex("weight", 0);
-    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
     user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
 
-    T* col_buf_dptr = tmp_buffer->mut_dptr<T>();
-
     auto* conv_state = dynamic_cast<ConvOpKernelState<T>*>(state);
-    conv_state->Update(in->shape(), out->shape());
     CHECK_NOTNULL(conv_state);
-    bool is_bias_mul_inited = false;
-    for (int64_t i = 0; i < in->shape().At(0); ++i) {
-      conv_state->im2col_func_(GetImgDptr<T>(in, i), ShapeView(conv_state->in_5d_shape_),
-                               ShapeView(conv_state->weight_5d_shape_),
-                               ShapeView(conv_state->out_5d_shape_), conv_state->strides_3d_.data(),
-                               conv_state->dilation_rate_3d_.data(),
-                               conv_state->padding_before_3d_.data(), col_buf_dptr);
-
-      // channels first: out = weight * col_buf
-      // channels last:  out = (weight * col_buf)(T)
-      int32_t idx_offset = conv_state->idx_offset_;
-      conv_state->forward_func_(
-          CblasNoTrans, CblasNoTrans,
-          conv_state->weight_5d_shape_.At(0),                           // filter
-          conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-          conv_state->weight_5d_shape_.Count(1),                        // ci * kd * kh * kw
-          static_cast<T>(1), weight->dptr<T>(), col_buf_dptr, static_cast<T>(0),
-          GetImgMutDptr<T>(out, i));
-
-      const user_op::Tensor* bias = ctx->Tensor4ArgNameAndIndex("bias", 0);
-      if (bias != nullptr) {
-        int64_t num_of_col_buf = CalcElemNumOfColBuf(out->shape(), weight->shape(), idx_offset);
-        int64_t num_of_bias_mul = tmp_buffer->shape().elem_cnt() - num_of_col_buf;
-        CHECK_GT(num_of_bias_mul, 0);
-        T* bias_mul_dptr = col_buf_dptr + num_of_col_buf * sizeof(T);
-        if (!is_bias_mul_inited) {
-          InitBiasMulBuf(bias_mul_dptr, num_of_bias_mul);
-          is_bias_mul_inited = true;
-        }
-
-        // channels first:  out += bias * bias_mul
-        // channels last:   out += (bias * bias_mul)(T)
-        conv_state->forward_func_(
-            CblasNoTrans, CblasNoTrans,
-            conv_state->weight_5d_shape_.At(0),                           // filter
-            conv_state->out_5d_shape_.Count(idx_offset, idx_offset + 3),  // od * oh * ow
-            1,                                                            // 1
-            static_cast<T>(1), bias->dptr<T>(), bias_mul_dptr, static_cast<T>(1),
-            GetImgMutDptr<T>(out, i));
-      }
+    conv_state->Update(in->shape(), out->shape());
+    switch (conv_state->algo_) {
+      case ConvCpuAlgo::kGemm1x1:
+        ConvForwardGemm1x1(*conv_state, in, weight, bias, out);
+        break;
+      case ConvCpuAlgo::kWinogradF2x3:
+        ConvForwardWinograd<T, 2>(*conv_state, in, weight, bias, out,
+                                  ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0));
+        break;
+      case ConvCpuAlgo::kWinogradF4x3:
+        ConvForwardWinograd<T, 4>(*conv_state, in, weight, bias, out,
+                                  ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0));
+        break;
+      default:
+        ConvForwardIm2ColGemm(*conv_state, in, weight, bias, out,
+                              ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0));
     }
   }
 };
 
-#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                         \
-  REGISTER_USER_KERNEL(#op_name)                                                            \
-      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                           \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                   \
-                       & (user_op::HobAttr<int32_t>("groups") == 1)                         \
-                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value))      \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                         \
-        size_t tmp_buffer_size = 0;                                                         \
-        const auto& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();         \
-        const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();   \
-                                                                                            \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));              \
-        tmp_buffer_size +=                                                                  \
-            CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(dtype);       \
-                                                                                            \
-        const auto* bias = ctx->TensorDesc4ArgNameAndIndex("bias", 0);                      \
-        if (bias != nullptr) {                                                              \
-          int64_t bias_mul_cnt = 1;                                                         \
-          for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_shape.At(idx_offset + i); } \
-          tmp_buffer_size += bias_mul_cnt * sizeof(dtype);                                  \
-        }                                                                                   \
-        return tmp_buffer_size;                                                             \
-      })
+template<typename T>
+size_t InferConvCpuTmpBufferSize(user_op::InferContext* ctx) {
+  const auto& out_shape = ctx->TensorDesc4ArgNameAndIndex("out", 0)->shape();
+  const auto& weight_shape = ctx->TensorDesc4ArgNameAndIndex("weight", 0)->shape();
+  const int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  const ConvCpuAlgo algo = InferConvCpuAlgo(ctx);
+  if (algo == ConvCpuAlgo::kGemm1x1) {
+    return 0;
+  } else if (algo == ConvCpuAlgo::kWinogradF2x3 || algo == ConvCpuAlgo::kWinogradF4x3) {
+    const int64_t tile_size = GetWinogradTileSize(algo);
+    const int64_t filters = weight_shape.At(0);
+    const int64_t channels = weight_shape.At(idx_offset == 2 ? 1 : weight_shape.NumAxes() - 1);
+    return (CalcElemNumOfWinogradWeightBuf(tile_size, filters, channels)
+            + kMaxConvCpuParallelNum
+                  * CalcElemNumOfWinogradTileBuf(tile_size, filters, channels))
+           * sizeof(T);
+  } else {
+    const int64_t num_col_bufs = std::min(out_shape.At(0), kMaxConvCpuParallelNum);
+    return num_col_bufs * CalcElemNumOfColBuf(out_shape, weight_shape, idx_offset) * sizeof(T);
+  }
+}
+
+#define REGISTER_CONV_KERNEL(op_name, dtype, ndims)                                    \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvCpuKernel<dtype, ndims>>()                                      \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobAttr<int32_t>("groups") == 1)                    \
+                       & (user_op::HobDataType("in", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvCpuTmpBufferSize<dtype>)
 
 REGISTER_CONV_KERNEL(conv1d, float, 1);
 REGISTER_CONV_KERNEL(conv2d, float, 2);
@@ -485,6 +879,9 @@ REGISTER_CONV_KERNEL(conv3d, float, 3);
 REGISTER_CONV_KERNEL(conv1d, double, 1);
 REGISTER_CONV_KERNEL(conv2d, double, 2);
 REGISTER_CONV_KERNEL(conv3d, double, 3);
+REGISTER_CONV_KERNEL(conv1d, bfloat16, 1);
+REGISTER_CONV_KERNEL(conv2d, bfloat16, 2);
+REGISTER_CONV_KERNEL(conv3d, bfloat16, 3);
 
 template<typename T>
 class ConvDataGradCpuKernel final : public user_op::OpKernel {
@@ -535,9 +932,9 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
       const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
       CHECK_EQ(add_to_output->data_type(), dx->data_type());
       CHECK_EQ(add_to_output->shape(), dx->shape());
-      KernelUtil<DeviceType::kCPU, T>::Addition(
-          ctx->device_ctx(), add_to_output->shape().elem_cnt(), dx->mut_dptr<T>(), dx->dptr<T>(),
-          add_to_output->dptr<T>());
+      T* dx_dptr = dx->mut_dptr<T>();
+      const T* add_to_output_dptr = add_to_output->dptr<T>();
+      FOR_RANGE(int64_t, i, 0, dx->shape().elem_cnt()) { dx_dptr[i] += add_to_output_dptr[i]; }
     }
   }
 };
@@ -561,6 +958,7 @@ class ConvDataGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, float);
 REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, double);
+REGISTER_CONV_DATA_GRAD_KERNEL(conv_data_grad, bfloat16);
 
 template<typename T>
 class ConvFilterGradCpuKernel final : public user_op::OpKernel {
@@ -630,6 +1028,7 @@ class ConvFilterGradCpuKernel final : public user_op::OpKernel {
 
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, float);
 REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, double);
+REGISTER_CONV_FILTER_GRAD_KERNEL(conv_filter_grad, bfloat16);
 
 template<typename T>
 class ConvBiasGradCpuKernel final : public user_op::OpKernel {
@@ -678,22 +1077,62 @@ class ConvBiasGradCpuKernel final : public user_op::OpKernel {
   }
 };
 
-#define REGISTER_CONV_BIAS_GRAD_KERNEL(op_name, dtype)                                         \
-  REGISTER_USER_KERNEL(#op_name)                                                               \
-      .SetCreateFn<ConvBiasGradCpuKernel<dtype>>()                                             \
-      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                      \
-                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value))         \
-      .SetInferTmpSizeFn([](user_op::InferContext* ctx) -> size_t {                            \
-        const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();        \
-        const int ndims = out_diff_shape.NumAxes() - 2;                                        \
-        int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));                 \
-        int64_t bias_mul_cnt = 1;                                                              \
-        for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_diff_shape.At(idx_offset + i); } \
-        return bias_mul_cnt * sizeof(dtype);                                                   \
-      })
+// bias_diff of bfloat16 is summed in float over the whole batch and rounded once, instead of
+// rounding the partial sum after the gemm of every image
+template<>
+void ConvBiasGradCpuKernel<bfloat16>::Compute(user_op::KernelComputeContext* ctx) const {
+  const user_op::Tensor* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+  user_op::Tensor* bias_diff = ctx->Tensor4ArgNameAndIndex("bias_diff", 0);
+  user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+  const int32_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  const int64_t ndims = dy->shape().NumAxes() - 2;
+  const int64_t filter = bias_diff->shape().elem_cnt();
+  const int64_t spatial_cnt = dy->shape().Count(idx_offset, idx_offset + ndims);
+  float* float_bias_diff = tmp_buffer->mut_dptr<float>();
+  std::fill(float_bias_diff, float_bias_diff + filter, 0.f);
+  const bfloat16* dy_dptr = dy->dptr<bfloat16>();
+  FOR_RANGE(int64_t, i, 0, dy->shape().At(0)) {
+    const bfloat16* img_dy = dy_dptr + i * filter * spatial_cnt;
+    if (idx_offset == 2) {
+      FOR_RANGE(int64_t, c, 0, filter) {
+        float sum = 0;
+        FOR_RANGE(int64_t, j, 0, spatial_cnt) { sum += img_dy[c * spatial_cnt + j]; }
+        float_bias_diff[c] += sum;
+      }
+    } else {
+      FOR_RANGE(int64_t, j, 0, spatial_cnt) {
+        FOR_RANGE(int64_t, c, 0, filter) { float_bias_diff[c] += img_dy[j * filter + c]; }
+      }
+    }
+  }
+  ConvertFloatToBFloat16(float_bias_diff, bias_diff->mut_dptr<bfloat16>(), filter);
+}
+
+template<typename T>
+size_t InferConvBiasGradTmpSize(user_op::InferContext* ctx) {
+  const auto& out_diff_shape = ctx->TensorDesc4ArgNameAndIndex("dy", 0)->shape();
+  const int ndims = out_diff_shape.NumAxes() - 2;
+  int64_t idx_offset = IdxOffset(ctx->Attr<std::string>("data_format"));
+  int64_t bias_mul_cnt = 1;
+  for (int i = 0; i < ndims; ++i) { bias_mul_cnt *= out_diff_shape.At(idx_offset + i); }
+  return bias_mul_cnt * sizeof(T);
+}
+
+template<>
+size_t InferConvBiasGradTmpSize<bfloat16>(user_op::InferContext* ctx) {
+  return ctx->TensorDesc4ArgNameAndIndex("bias_diff", 0)->shape().elem_cnt() * sizeof(float);
+}
+
+#define REGISTER_CONV_BIAS_GRAD_KERNEL(op_name, dtype)                                 \
+  REGISTER_USER_KERNEL(#op_name)                                                       \
+      .SetCreateFn<ConvBiasGradCpuKernel<dtype>>()                                     \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                              \
+                       & (user_op::HobDataType("dy", 0) == GetDataType<dtype>::value)) \
+      .SetInferTmpSizeFn(InferConvBiasGradTmpSize<dtype>)
 
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, float);
 REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, double);
+REGISTER_CONV_BIAS_GRAD_KERNEL(conv_bias_grad, bfloat16);
 }  // namespace
 
 }  // namespace oneflow
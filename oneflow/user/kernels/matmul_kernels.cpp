@@ -84,6 +84,7 @@ class MatmulFloatingKernel final : public user_op::OpKernel {
 
 REGISTER_MATMUL_KERNEL(DeviceType::kCPU, float);
 REGISTER_MATMUL_KERNEL(DeviceType::kCPU, double);
+REGISTER_MATMUL_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_MATMUL_KERNEL(DeviceType::kGPU, double);
@@ -196,6 +197,7 @@ class BatchMatmulFloatingKernel final : public user_op::OpKernel {
 
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, double);
+REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_BATCH_MATMUL_KERNEL(DeviceType::kGPU, double);
@@ -353,6 +355,7 @@ class BroadcastMatmulGradBKernel final : public user_op::OpKernel {
 
 REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kCPU, float);
 REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kCPU, double);
+REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kGPU, float);
 REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kGPU, double);
@@ -374,6 +377,7 @@ REGISTER_BROADCAST_MATMUL_KERNEL(DeviceType::kGPU, float16);
 
 REGISTER_BROADCAST_MATMUL_GRAD_B_KERNEL(DeviceType::kCPU, float);
 REGISTER_BROADCAST_MATMUL_GRAD_B_KERNEL(DeviceType::kCPU, double);
+REGISTER_BROADCAST_MATMUL_GRAD_B_KERNEL(DeviceType::kCPU, bfloat16);
 #ifdef WITH_CUDA
 REGISTER_BROADCAST_MATMUL_GRAD_B_KERNEL(DeviceType::kGPU, float);
 REGISTER_BROADCAST_MATMUL_GRAD_B_KERNEL(DeviceType::kGPU, double);
@@ -0,0 +1,540 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+// x is viewed as [outer, channel, inner], inner is 1 when the normalized axis is the last one
+// (NHWC) and the spatial size otherwise (NCHW)
+struct NormalizationDims {
+  int64_t outer;
+  int64_t channel;
+  int64_t inner;
+};
+
+NormalizationDims GetNormalizationDims(const ShapeView& x_shape, const int32_t axis) {
+  CHECK_GE(axis, 0);
+  CHECK_LT(axis, x_shape.NumAxes());
+  NormalizationDims dims;
+  dims.outer = x_shape.Count(0, axis);
+  dims.channel = x_shape.At(axis);
+  dims.inner = x_shape.Count(axis + 1);
+  return dims;
+}
+
+void CheckParamTensor(const user_op::Tensor* tensor, const NormalizationDims& dims,
+                      const DataType data_type) {
+  CHECK_EQ(tensor->shape().NumAxes(), 1);
+  CHECK_EQ(tensor->shape().At(0), dims.channel);
+  CHECK_EQ(tensor->data_type(), data_type);
+}
+
+// The work is cut into tiles of the outer dimension times groups of channels. Per-channel
+// reductions keep one partial result per outer tile, so a tile never shares state with another
+class NormalizationTilePartition final {
+ public:
+  explicit NormalizationTilePartition(const NormalizationDims& dims)
+      : num_outer_tiles_(std::max<int64_t>(
+            std::min<int64_t>(dims.outer, Global<ThreadPool>::Get()->thread_num()), 1)),
+        num_channel_groups_(std::max<int64_t>(
+            std::min<int64_t>(dims.channel,
+                              (Global<ThreadPool>::Get()->thread_num() + num_outer_tiles_ - 1)
+                                  / num_outer_tiles_),
+            1)),
+        outer_splitter_(dims.outer, num_outer_tiles_),
+        channel_splitter_(dims.channel, num_channel_groups_) {}
+  ~NormalizationTilePartition() = default;
+
+  int64_t num_outer_tiles() const { return num_outer_tiles_; }
+
+  void ParallelForEachTile(
+      const std::function<void(int64_t outer_tile_id, const Range& outer_range,
+                               const Range& channel_range)>& Handler) const {
+    MultiThreadLoop(num_outer_tiles_ * num_channel_groups_, [&](size_t task_id) {
+      const int64_t outer_tile_id = task_id / num_channel_groups_;
+      Handler(outer_tile_id, outer_splitter_.At(outer_tile_id),
+              channel_splitter_.At(task_id % num_channel_groups_));
+    });
+  }
+
+ private:
+  const int64_t num_outer_tiles_;
+  const int64_t num_channel_groups_;
+  const BalancedSplitter outer_splitter_;
+  const BalancedSplitter channel_splitter_;
+};
+
+// Sums of x - shift and (x - shift)^2 in one pass, the per-channel shift keeps the
+// E[x^2] - E[x]^2 formula from cancelling catastrophically when |mean| >> stddev
+template<typename T>
+void AccumulateShiftedSum(const T* x, const NormalizationDims& dims, const Range& outer_range,
+                          const Range& channel_range, const T* shift, T* sum, T* square_sum) {
+  if (dims.inner == 1) {
+    FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+      sum[c] = 0;
+      square_sum[c] = 0;
+    }
+    FOR_RANGE(int64_t, o, outer_range.begin(), outer_range.end()) {
+      const T* x_o = x + o * dims.channel;
+      FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+        const T diff = x_o[c] - shift[c];
+        sum[c] += diff;
+        square_sum[c] += diff * diff;
+      }
+    }
+  } else {
+    FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+      const T shift_c = shift[c];
+      T sum_c = 0;
+      T square_sum_c = 0;
+      FOR_RANGE(int64_t, o, outer_range.begin(), outer_range.end()) {
+        const T* x_oc = x + (o * dims.channel + c) * dims.inner;
+        FOR_RANGE(int64_t, i, 0, dims.inner) {
+          const T diff = x_oc[i] - shift_c;
+          sum_c += diff;
+          square_sum_c += diff * diff;
+        }
+      }
+      sum[c] = sum_c;
+      square_sum[c] = square_sum_c;
+    }
+  }
+}
+
+// mean/inv_variance are the batch statistics of x, variance is the unbiased batch variance used
+// to update the moving variance
+template<typename T>
+void ComputeMeanAndVariance(const T* x, const NormalizationDims& dims,
+                            const NormalizationTilePartition& partition, const float epsilon,
+                            T* mean, T* inv_variance, T* variance) {
+  const int64_t n = dims.outer * dims.inner;
+  CHECK_GT(n, 0);
+  std::vector<T> shift(dims.channel);
+  FOR_RANGE(int64_t, c, 0, dims.channel) { shift[c] = x[c * dims.inner]; }
+  std::vector<T> sum(partition.num_outer_tiles() * dims.channel);
+  std::vector<T> square_sum(partition.num_outer_tiles() * dims.channel);
+  partition.ParallelForEachTile(
+      [&](int64_t outer_tile_id, const Range& outer_range, const Range& channel_range) {
+        AccumulateShiftedSum(x, dims, outer_range, channel_range, shift.data(),
+                             sum.data() + outer_tile_id * dims.channel,
+                             square_sum.data() + outer_tile_id * dims.channel);
+      });
+  FOR_RANGE(int64_t, c, 0, dims.channel) {
+    T sum_c = 0;
+    T square_sum_c = 0;
+    FOR_RANGE(int64_t, tile_id, 0, partition.num_outer_tiles()) {
+      sum_c += sum[tile_id * dims.channel + c];
+      square_sum_c += square_sum[tile_id * dims.channel + c];
+    }
+    const T shifted_mean = sum_c / n;
+    const T sum_of_square_diff =
+        std::max(square_sum_c - shifted_mean * sum_c, static_cast<T>(0));
+    mean[c] = shift[c] + shifted_mean;
+    inv_variance[c] = static_cast<T>(1) / std::sqrt(sum_of_square_diff / n + epsilon);
+    variance[c] = n > 1 ? sum_of_square_diff / (n - 1) : sum_of_square_diff;
+  }
+}
+
+// y = relu(x * scale + bias + addend), both the addend and the relu are optional
+template<typename T, bool with_addend, bool with_relu>
+void ScaleBiasAddRelu(const T* x, const T* addend, const NormalizationDims& dims,
+                      const Range& outer_range, const Range& channel_range, const T* scale,
+                      const T* bias, T* y) {
+  FOR_RANGE(int64_t, o, outer_range.begin(), outer_range.end()) {
+    FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+      const int64_t offset = (o * dims.channel + c) * dims.inner;
+      const T scale_c = scale[c];
+      const T bias_c = bias[c];
+      FOR_RANGE(int64_t, i, offset, offset + dims.inner) {
+        T val = x[i] * scale_c + bias_c;
+        if (with_addend) { val += addend[i]; }
+        if (with_relu) { val = val > static_cast<T>(0) ? val : static_cast<T>(0); }
+        y[i] = val;
+      }
+    }
+  }
+}
+
+template<typename T>
+void Normalize(const T* x, const T* addend, const NormalizationDims& dims,
+               const NormalizationTilePartition& partition, const bool with_relu, const T* scale,
+               const T* bias, T* y) {
+  partition.ParallelForEachTile(
+      [&](int64_t outer_tile_id, const Range& outer_range, const Range& channel_range) {
+        if (addend != nullptr && with_relu) {
+          ScaleBiasAddRelu<T, true, true>(x, addend, dims, outer_range, channel_range, scale, bias,
+                                          y);
+        } else if (addend != nullptr) {
+          ScaleBiasAddRelu<T, true, false>(x, addend, dims, outer_range, channel_range, scale,
+                                           bias, y);
+        } else if (with_relu) {
+          ScaleBiasAddRelu<T, false, true>(x, addend, dims, outer_range, channel_range, scale,
+                                           bias, y);
+        } else {
+          ScaleBiasAddRelu<T, false, false>(x, addend, dims, outer_range, channel_range, scale,
+                                            bias, y);
+        }
+      });
+}
+
+// Same bit layout as the gpu kernels: bit (i % 32) of mask[i / 32] is set when y[i] > 0
+template<typename T>
+void ComputeReluMask(const int64_t elem_cnt, const T* y, int32_t* mask) {
+  const int64_t mask_cnt = RoundUp(elem_cnt, 32) / 32;
+  const int64_t num_parts = std::min<int64_t>(mask_cnt, Global<ThreadPool>::Get()->thread_num());
+  const BalancedSplitter bs(mask_cnt, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    FOR_RANGE(int64_t, mask_id, range.begin(), range.end()) {
+      const int64_t begin = mask_id * 32;
+      const int64_t end = std::min(begin + 32, elem_cnt);
+      uint32_t bits = 0;
+      FOR_RANGE(int64_t, i, begin, end) {
+        bits |= static_cast<uint32_t>(y[i] > static_cast<T>(0)) << (i - begin);
+      }
+      mask[mask_id] = static_cast<int32_t>(bits);
+    }
+  });
+}
+
+template<typename T>
+class NormalizationInferenceCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationInferenceCpuKernel() = default;
+  ~NormalizationInferenceCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const bool training = ctx->Attr<bool>("training");
+    CHECK(!training);
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    const auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    const auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+
+    const DataType data_type = x->data_type();
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), data_type);
+    const NormalizationDims dims = GetNormalizationDims(x->shape(), axis);
+    CheckParamTensor(gamma, dims, data_type);
+    CheckParamTensor(beta, dims, data_type);
+    CheckParamTensor(moving_mean, dims, data_type);
+    CheckParamTensor(moving_variance, dims, data_type);
+
+    const T* addend = nullptr;
+    if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape(), y->shape());
+      addend = add_to_output->dptr<T>();
+    }
+
+    // Fold the moving statistics and the affine transform into y = x * scale + bias
+    std::vector<T> scale(dims.channel);
+    std::vector<T> bias(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      scale[c] = gamma->dptr<T>()[c]
+                 / std::sqrt(moving_variance->dptr<T>()[c] + static_cast<T>(epsilon));
+      bias[c] = beta->dptr<T>()[c] - moving_mean->dptr<T>()[c] * scale[c];
+    }
+    const NormalizationTilePartition partition(dims);
+    Normalize(x->dptr<T>(), addend, dims, partition, false, scale.data(), bias.data(),
+              y->mut_dptr<T>());
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_INFERENCE_CPU_KERNEL(dtype)                                                 \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationInferenceCpuKernel<dtype>>()                                    \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == false))                         \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_INFERENCE_CPU_KERNEL(float)
+REGISTER_BN_INFERENCE_CPU_KERNEL(double)
+
+#undef REGISTER_BN_INFERENCE_CPU_KERNEL
+
+template<typename T>
+class NormalizationTrainCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationTrainCpuKernel() = default;
+  ~NormalizationTrainCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    if (ctx->op_type_name() == "normalization") { CHECK(ctx->Attr<bool>("training")); }
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* y = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    const auto* beta = ctx->Tensor4ArgNameAndIndex("beta", 0);
+    auto* moving_mean = ctx->Tensor4ArgNameAndIndex("moving_mean", 0);
+    auto* moving_variance = ctx->Tensor4ArgNameAndIndex("moving_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+    const auto epsilon = ctx->Attr<float>("epsilon");
+    const auto momentum = ctx->Attr<float>("momentum");
+    auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+
+    const DataType data_type = x->data_type();
+    CHECK_EQ(x->shape(), y->shape());
+    CHECK_EQ(y->data_type(), data_type);
+    const NormalizationDims dims = GetNormalizationDims(x->shape(), axis);
+    CheckParamTensor(gamma, dims, data_type);
+    CheckParamTensor(beta, dims, data_type);
+    CheckParamTensor(moving_mean, dims, data_type);
+    CheckParamTensor(moving_variance, dims, data_type);
+    CheckParamTensor(mean, dims, data_type);
+    CheckParamTensor(inv_variance, dims, data_type);
+
+    const NormalizationTilePartition partition(dims);
+    std::vector<T> variance(dims.channel);
+    ComputeMeanAndVariance(x->dptr<T>(), dims, partition, epsilon, mean->mut_dptr<T>(),
+                           inv_variance->mut_dptr<T>(), variance.data());
+
+    std::vector<T> scale(dims.channel);
+    std::vector<T> bias(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      const T mean_c = mean->dptr<T>()[c];
+      scale[c] = gamma->dptr<T>()[c] * inv_variance->dptr<T>()[c];
+      bias[c] = beta->dptr<T>()[c] - mean_c * scale[c];
+      T* moving_mean_c = moving_mean->mut_dptr<T>() + c;
+      T* moving_variance_c = moving_variance->mut_dptr<T>() + c;
+      *moving_mean_c = *moving_mean_c * momentum + mean_c * (1 - momentum);
+      *moving_variance_c = *moving_variance_c * momentum + variance[c] * (1 - momentum);
+    }
+
+    const T* addend = nullptr;
+    bool with_relu = false;
+    if (ctx->op_type_name() == "normalization_add_relu") {
+      CHECK(!ctx->has_input("_add_to_output", 0));
+      if (ctx->has_input("addend", 0)) {
+        addend = ctx->Tensor4ArgNameAndIndex("addend", 0)->dptr<T>();
+      }
+      with_relu = true;
+    } else if (ctx->has_input("_add_to_output", 0)) {
+      const user_op::Tensor* add_to_output = ctx->Tensor4ArgNameAndIndex("_add_to_output", 0);
+      CHECK_EQ(add_to_output->data_type(), y->data_type());
+      CHECK_EQ(add_to_output->shape(), y->shape());
+      addend = add_to_output->dptr<T>();
+    }
+    Normalize(x->dptr<T>(), addend, dims, partition, with_relu, scale.data(), bias.data(),
+              y->mut_dptr<T>());
+    if (with_relu) {
+      auto* mask = ctx->Tensor4ArgNameAndIndex("reserve_space", 0);
+      ComputeReluMask(x->shape().elem_cnt(), y->dptr<T>(), mask->mut_dptr<int32_t>());
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_TRAIN_CPU_KERNEL(dtype)                                                     \
+  REGISTER_USER_KERNEL("normalization")                                                         \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()                                        \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")                                       \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)            \
+                       & (user_op::HobAttr<bool>("training") == true))                          \
+      .SetInplaceProposalFn([](const user_op::InferContext& ctx,                                \
+                               user_op::AddInplaceArgPair AddInplaceArgPairFn) -> Maybe<void> { \
+        if (ctx.has_input("_add_to_output", 0)) {                                               \
+          OF_RETURN_IF_ERROR(AddInplaceArgPairFn("y", 0, "_add_to_output", 0, true));           \
+        }                                                                                       \
+        return Maybe<void>::Ok();                                                               \
+      });
+
+REGISTER_BN_TRAIN_CPU_KERNEL(float)
+REGISTER_BN_TRAIN_CPU_KERNEL(double)
+
+#undef REGISTER_BN_TRAIN_CPU_KERNEL
+
+#define REGISTER_BN_ADD_RELU_CPU_KERNEL(dtype)            \
+  REGISTER_USER_KERNEL("normalization_add_relu")          \
+      .SetCreateFn<NormalizationTrainCpuKernel<dtype>>()  \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value));
+
+REGISTER_BN_ADD_RELU_CPU_KERNEL(float)
+REGISTER_BN_ADD_RELU_CPU_KERNEL(double)
+
+#undef REGISTER_BN_ADD_RELU_CPU_KERNEL
+
+// dy is masked by the relu of the forward pass when y is given, the relu mask in reserve_space
+// and y > 0 select the same elements
+template<typename T>
+T MaskedDy(const T* dy, const T* y, int64_t i) {
+  return (y == nullptr || y[i] > static_cast<T>(0)) ? dy[i] : static_cast<T>(0);
+}
+
+template<typename T>
+void AccumulateGradSum(const T* x, const T* dy, const T* y, const NormalizationDims& dims,
+                       const Range& outer_range, const Range& channel_range, const T* mean,
+                       T* sum_dy, T* sum_dy_x_diff, T* addend_diff) {
+  FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+    sum_dy[c] = 0;
+    sum_dy_x_diff[c] = 0;
+  }
+  FOR_RANGE(int64_t, o, outer_range.begin(), outer_range.end()) {
+    FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+      const int64_t offset = (o * dims.channel + c) * dims.inner;
+      const T mean_c = mean[c];
+      T sum_dy_c = 0;
+      T sum_dy_x_diff_c = 0;
+      FOR_RANGE(int64_t, i, offset, offset + dims.inner) {
+        const T dy_i = MaskedDy(dy, y, i);
+        if (addend_diff != nullptr) { addend_diff[i] = dy_i; }
+        sum_dy_c += dy_i;
+        sum_dy_x_diff_c += dy_i * (x[i] - mean_c);
+      }
+      sum_dy[c] += sum_dy_c;
+      sum_dy_x_diff[c] += sum_dy_x_diff_c;
+    }
+  }
+}
+
+// dx = gamma * inv_variance * (dy - mean(dy) - x_hat * mean(dy * x_hat)), expanded per channel
+// into dx = dy * dy_scale + x * x_scale + bias
+template<typename T>
+void ComputeDx(const T* x, const T* dy, const T* y, const NormalizationDims& dims,
+               const Range& outer_range, const Range& channel_range, const T* dy_scale,
+               const T* x_scale, const T* bias, T* dx) {
+  FOR_RANGE(int64_t, o, outer_range.begin(), outer_range.end()) {
+    FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+      const int64_t offset = (o * dims.channel + c) * dims.inner;
+      const T dy_scale_c = dy_scale[c];
+      const T x_scale_c = x_scale[c];
+      const T bias_c = bias[c];
+      FOR_RANGE(int64_t, i, offset, offset + dims.inner) {
+        dx[i] = MaskedDy(dy, y, i) * dy_scale_c + x[i] * x_scale_c + bias_c;
+      }
+    }
+  }
+}
+
+template<typename T>
+class NormalizationGradCpuKernel final : public user_op::OpKernel {
+ public:
+  NormalizationGradCpuKernel() = default;
+  ~NormalizationGradCpuKernel() override = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const auto* x = ctx->Tensor4ArgNameAndIndex("x", 0);
+    auto* dx = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    const auto* dy = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const auto* gamma = ctx->Tensor4ArgNameAndIndex("gamma", 0);
+    auto* gamma_diff = ctx->Tensor4ArgNameAndIndex("gamma_diff", 0);
+    auto* beta_diff = ctx->Tensor4ArgNameAndIndex("beta_diff", 0);
+    const auto* mean = ctx->Tensor4ArgNameAndIndex("mean", 0);
+    const auto* inv_variance = ctx->Tensor4ArgNameAndIndex("inv_variance", 0);
+    const auto axis = ctx->Attr<int32_t>("axis");
+
+    const DataType data_type = x->data_type();
+    CHECK_EQ(dy->shape(), x->shape());
+    CHECK_EQ(dy->data_type(), data_type);
+    CHECK_EQ(dx->shape(), x->shape());
+    CHECK_EQ(dx->data_type(), data_type);
+    const NormalizationDims dims = GetNormalizationDims(x->shape(), axis);
+    CheckParamTensor(gamma, dims, data_type);
+    CheckParamTensor(gamma_diff, dims, data_type);
+    CheckParamTensor(beta_diff, dims, data_type);
+    CheckParamTensor(mean, dims, data_type);
+    CheckParamTensor(inv_variance, dims, data_type);
+
+    const T* y_ptr = nullptr;
+    T* addend_diff_ptr = nullptr;
+    if (ctx->op_type_name() == "normalization_add_relu_grad") {
+      y_ptr = ctx->Tensor4ArgNameAndIndex("y", 0)->dptr<T>();
+      if (ctx->has_output("addend_diff", 0)) {
+        addend_diff_ptr = ctx->Tensor4ArgNameAndIndex("addend_diff", 0)->mut_dptr<T>();
+      }
+    } else {
+      CHECK_EQ(ctx->op_type_name(), "normalization_grad");
+    }
+
+    const NormalizationTilePartition partition(dims);
+    std::vector<T> sum_dy(partition.num_outer_tiles() * dims.channel);
+    std::vector<T> sum_dy_x_diff(partition.num_outer_tiles() * dims.channel);
+    partition.ParallelForEachTile(
+        [&](int64_t outer_tile_id, const Range& outer_range, const Range& channel_range) {
+          AccumulateGradSum(x->dptr<T>(), dy->dptr<T>(), y_ptr, dims, outer_range, channel_range,
+                            mean->dptr<T>(), sum_dy.data() + outer_tile_id * dims.channel,
+                            sum_dy_x_diff.data() + outer_tile_id * dims.channel, addend_diff_ptr);
+        });
+
+    const int64_t n = dims.outer * dims.inner;
+    std::vector<T> dy_scale(dims.channel);
+    std::vector<T> x_scale(dims.channel);
+    std::vector<T> bias(dims.channel);
+    FOR_RANGE(int64_t, c, 0, dims.channel) {
+      T sum_dy_c = 0;
+      T sum_dy_x_diff_c = 0;
+      FOR_RANGE(int64_t, tile_id, 0, partition.num_outer_tiles()) {
+        sum_dy_c += sum_dy[tile_id * dims.channel + c];
+        sum_dy_x_diff_c += sum_dy_x_diff[tile_id * dims.channel + c];
+      }
+      const T inv_variance_c = inv_variance->dptr<T>()[c];
+      const T mean_c = mean->dptr<T>()[c];
+      const T sum_dy_x_hat_c = sum_dy_x_diff_c * inv_variance_c;
+      gamma_diff->mut_dptr<T>()[c] = sum_dy_x_hat_c;
+      beta_diff->mut_dptr<T>()[c] = sum_dy_c;
+      dy_scale[c] = gamma->dptr<T>()[c] * inv_variance_c;
+      x_scale[c] = -dy_scale[c] * inv_variance_c * sum_dy_x_hat_c / n;
+      bias[c] = -dy_scale[c] * sum_dy_c / n - x_scale[c] * mean_c;
+    }
+    partition.ParallelForEachTile(
+        [&](int64_t outer_tile_id, const Range& outer_range, const Range& channel_range) {
+          ComputeDx(x->dptr<T>(), dy->dptr<T>(), y_ptr, dims, outer_range, channel_range,
+                    dy_scale.data(), x_scale.data(), bias.data(), dx->mut_dptr<T>());
+        });
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_BN_GRAD_CPU_KERNEL(op_type_name, dtype)  \
+  REGISTER_USER_KERNEL(op_type_name)                      \
+      .SetCreateFn<NormalizationGradCpuKernel<dtype>>()   \
+      .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu") \
+                       & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value));
+
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_grad", double)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", float)
+REGISTER_BN_GRAD_CPU_KERNEL("normalization_add_relu_grad", double)
+
+#undef REGISTER_BN_GRAD_CPU_KERNEL
+
+}  // namespace
+
+}  // namespace oneflow
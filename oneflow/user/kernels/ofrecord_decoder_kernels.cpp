@@ -20,6 +20,7 @@ limitations under the License.
 #include "oneflow/core/kernel/new_kernel_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
 #include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/user/data/ofrecord_parser.h"
 #include "oneflow/user/image/random_crop_generator.h"
 #include "oneflow/user/image/image_util.h"
 #include "oneflow/user/kernels/random_crop_kernel_state.h"
@@ -90,6 +91,25 @@ class OFRecordRawDecoderKernel final : public user_op::OpKernel {
 
     bool auto_zero_padding = ctx->Attr<bool>("auto_zero_padding");
     bool dim1_varying_length = ctx->Attr<bool>("dim1_varying_length");
+    if (ctx->Attr<bool>("pad_to_batch_max_length")) {
+      // pad only up to the longest sample of this batch instead of the static shape
+      CHECK_EQ(out_blob->shape().NumAxes(), 2);
+      int64_t max_length = 0;
+      FOR_RANGE(int64_t, i, 0, record_num) {
+        const auto feature_it = records[i].feature().find(name);
+        CHECK(feature_it != records[i].feature().end()) << "Field " << name << " not found";
+        max_length = std::max(max_length, data::GetFeatureLength(feature_it->second));
+      }
+      CHECK_LE(max_length, sample_elem_cnt);
+      sample_elem_cnt = max_length;
+      out_blob->mut_shape()->Set(0, record_num);
+      out_blob->mut_shape()->Set(1, sample_elem_cnt);
+      std::memset(out_dptr, 0, record_num * sample_elem_cnt * sizeof(T));
+      auto_zero_padding = true;
+      dim1_varying_length = true;
+    } else if (out_blob->shape().At(0) != record_num) {
+      out_blob->mut_shape()->Set(0, record_num);
+    }
 
     MultiThreadLoop(record_num, [&](size_t i) {
       const OFRecord& record = *(records + i);
@@ -0,0 +1,130 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/variable_write_count.h"
+#include "oneflow/user/kernels/quantized_gemm_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// Lays out the receptive field of each output pixel of an image in a row, ordered by channel,
+// kernel row and kernel column as the weight, so that the conv is a gemm of the rows and the
+// packed weight. The padding is the zero point, which is 0 after dequantization
+void Im2Row(const uint8_t* in, const ShapeView& in_shape, const ShapeView& out_shape,
+            const std::vector<int32_t>& kernel_size, const std::vector<int32_t>& strides,
+            const std::vector<int32_t>& dilation_rate,
+            const std::vector<int32_t>& padding_before, uint8_t pad_value, uint8_t* rows) {
+  const int64_t channels = in_shape.At(1);
+  const int64_t in_h = in_shape.At(2);
+  const int64_t in_w = in_shape.At(3);
+  const int64_t out_h = out_shape.At(2);
+  const int64_t out_w = out_shape.At(3);
+  FOR_RANGE(int64_t, oh, 0, out_h) {
+    FOR_RANGE(int64_t, ow, 0, out_w) {
+      uint8_t* row = rows;
+      FOR_RANGE(int64_t, c, 0, channels) {
+        const uint8_t* in_channel = in + c * in_h * in_w;
+        FOR_RANGE(int64_t, kh, 0, kernel_size.at(0)) {
+          const int64_t ih = oh * strides.at(0) - padding_before.at(0) + kh * dilation_rate.at(0);
+          FOR_RANGE(int64_t, kw, 0, kernel_size.at(1)) {
+            const int64_t iw =
+                ow * strides.at(1) - padding_before.at(1) + kw * dilation_rate.at(1);
+            const bool is_padding = ih < 0 || ih >= in_h || iw < 0 || iw >= in_w;
+            *row++ = is_padding ? pad_value : in_channel[ih * in_w + iw];
+          }
+        }
+      }
+      rows = row;
+    }
+  }
+}
+
+class CpuQuantizedConv2dKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedConv2dKernel() = default;
+  ~CpuQuantizedConv2dKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<PackedInt8WeightState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    const user_op::Tensor* in_scale = ctx->Tensor4ArgNameAndIndex("in_scale", 0);
+    const user_op::Tensor* in_zero_point = ctx->Tensor4ArgNameAndIndex("in_zero_point", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const bool symmetric = ctx->Attr<std::string>("quantization_scheme") == "symmetric";
+
+    auto* weight_state = dynamic_cast<PackedInt8WeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    const user_op::Tensor* weight_tensor = ctx->Tensor4ArgNameAndIndex("weight", 0);
+    const user_op::Tensor* weight_scale = ctx->Tensor4ArgNameAndIndex("weight_scale", 0);
+    const user_op::Tensor* weight_zero_point = ctx->Tensor4ArgNameAndIndex("weight_zero_point", 0);
+    if (weight_state->TryUpdateVariableWriteCount(VariableWriteCount())) {
+      PackInt8Weight(weight_tensor->dptr<float>(), weight_tensor->shape().At(0),
+                     weight_tensor->shape().Count(1), false, weight_scale->dptr<float>(),
+                     weight_zero_point->dptr<float>(), weight_scale->shape().elem_cnt(),
+                     symmetric, weight_state->mut_weight());
+    }
+    const PackedInt8Weight& weight = weight_state->weight();
+
+    const float scale = *in_scale->dptr<float>();
+    uint8_t* quantized_in = tmp_buffer->mut_dptr<uint8_t>();
+    uint8_t* rows = quantized_in + in->shape().elem_cnt();
+    const int32_t in_zero_point_val =
+        QuantizeToUInt8(in->dptr<float>(), in->shape().elem_cnt(), scale,
+                        *in_zero_point->dptr<float>(), symmetric, quantized_in);
+
+    const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+    const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+    const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+    const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+    const int64_t batch = in->shape().At(0);
+    const int64_t in_image_size = in->shape().Count(1);
+    const int64_t out_image_size = out->shape().Count(1);
+    const int64_t out_spatial_size = out->shape().Count(2);
+    FOR_RANGE(int64_t, i, 0, batch) {
+      Im2Row(quantized_in + i * in_image_size, in->shape(), out->shape(), kernel_size, strides,
+             dilation_rate, padding_before, static_cast<uint8_t>(in_zero_point_val), rows);
+      // the rows are the output pixels and the columns are the filters in NCHW
+      Int8GemmAndDequantize(rows, out_spatial_size, in_zero_point_val, scale, weight,
+                            out->mut_dptr<float>() + i * out_image_size, 1, out_spatial_size);
+    }
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_conv2d")
+    .SetCreateFn<CpuQuantizedConv2dKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("in", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) {
+      const Shape* in_shape = ctx->Shape4ArgNameAndIndex("in", 0);
+      const Shape* weight_shape = ctx->Shape4ArgNameAndIndex("weight", 0);
+      const Shape* out_shape = ctx->Shape4ArgNameAndIndex("out", 0);
+      // the quantized input and the rows of an image
+      return (in_shape->elem_cnt() + out_shape->Count(2) * weight_shape->Count(1))
+             * sizeof(uint8_t);
+    });
+
+}  // namespace
+
+}  // namespace oneflow
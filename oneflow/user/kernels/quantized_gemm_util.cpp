@@ -0,0 +1,201 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/user/kernels/quantized_gemm_util.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+#include <cfenv>
+
+namespace oneflow {
+
+namespace {
+
+// the rows of a computed together, which share the loads of a row of the weight
+constexpr int64_t kInt8GemmRowBlock = 4;
+constexpr int64_t kMinInt8GemmRowsPerPart = 16;
+
+// rounds half to even as fake_quantization does
+class RoundToNearestEvenGuard final {
+ public:
+  OF_DISALLOW_COPY_AND_MOVE(RoundToNearestEvenGuard);
+  RoundToNearestEvenGuard() : origin_round_mode_(std::fegetround()) {
+    std::fesetround(FE_TONEAREST);
+  }
+  ~RoundToNearestEvenGuard() { std::fesetround(origin_round_mode_); }
+
+ private:
+  int origin_round_mode_;
+};
+
+template<typename T>
+T QuantizeAndClamp(float x, float scale, float zero_point, float lower_bound, float upper_bound) {
+  float out = std::nearbyint(x / scale + zero_point);
+  out = out > upper_bound ? upper_bound : out;
+  out = out < lower_bound ? lower_bound : out;
+  return static_cast<T>(out);
+}
+
+class Int8GemmDequantizer final {
+ public:
+  Int8GemmDequantizer(int32_t a_zero_point, float a_scale, const PackedInt8Weight& weight,
+                      float* out, int64_t out_row_stride, int64_t out_col_stride)
+      : a_zero_point_(a_zero_point),
+        a_scale_(a_scale),
+        weight_(weight),
+        out_(out),
+        out_row_stride_(out_row_stride),
+        out_col_stride_(out_col_stride) {}
+
+  void Store(int64_t i, int64_t j, int32_t acc, int32_t a_row_sum) const {
+    const int32_t w_zero_point = weight_.zero_point[j];
+    acc += -a_zero_point_ * weight_.row_sum[j] - w_zero_point * a_row_sum
+           + static_cast<int32_t>(weight_.k) * a_zero_point_ * w_zero_point;
+    out_[i * out_row_stride_ + j * out_col_stride_] =
+        a_scale_ * weight_.scale[j] * static_cast<float>(acc);
+  }
+
+ private:
+  int32_t a_zero_point_;
+  float a_scale_;
+  const PackedInt8Weight& weight_;
+  float* out_;
+  int64_t out_row_stride_;
+  int64_t out_col_stride_;
+};
+
+int32_t RowSum(const uint8_t* row, int64_t k) {
+  int32_t sum = 0;
+  for (int64_t p = 0; p < k; ++p) { sum += row[p]; }
+  return sum;
+}
+
+void Int8GemmRows(const uint8_t* a, int64_t row_begin, int64_t row_end,
+                  const PackedInt8Weight& weight, const Int8GemmDequantizer& dequantizer) {
+  const int64_t n = weight.n;
+  const int64_t k = weight.k;
+  const int8_t* w = weight.data.data();
+  int64_t i = row_begin;
+  for (; i + kInt8GemmRowBlock <= row_end; i += kInt8GemmRowBlock) {
+    const uint8_t* a0 = a + i * k;
+    const uint8_t* a1 = a0 + k;
+    const uint8_t* a2 = a1 + k;
+    const uint8_t* a3 = a2 + k;
+    const int32_t sum0 = RowSum(a0, k);
+    const int32_t sum1 = RowSum(a1, k);
+    const int32_t sum2 = RowSum(a2, k);
+    const int32_t sum3 = RowSum(a3, k);
+    for (int64_t j = 0; j < n; ++j) {
+      const int8_t* w_row = w + j * k;
+      int32_t acc0 = 0;
+      int32_t acc1 = 0;
+      int32_t acc2 = 0;
+      int32_t acc3 = 0;
+      for (int64_t p = 0; p < k; ++p) {
+        const int32_t w_val = w_row[p];
+        acc0 += static_cast<int32_t>(a0[p]) * w_val;
+        acc1 += static_cast<int32_t>(a1[p]) * w_val;
+        acc2 += static_cast<int32_t>(a2[p]) * w_val;
+        acc3 += static_cast<int32_t>(a3[p]) * w_val;
+      }
+      dequantizer.Store(i, j, acc0, sum0);
+      dequantizer.Store(i + 1, j, acc1, sum1);
+      dequantizer.Store(i + 2, j, acc2, sum2);
+      dequantizer.Store(i + 3, j, acc3, sum3);
+    }
+  }
+  for (; i < row_end; ++i) {
+    const uint8_t* a_row = a + i * k;
+    const int32_t sum = RowSum(a_row, k);
+    for (int64_t j = 0; j < n; ++j) {
+      const int8_t* w_row = w + j * k;
+      int32_t acc = 0;
+      for (int64_t p = 0; p < k; ++p) {
+        acc += static_cast<int32_t>(a_row[p]) * static_cast<int32_t>(w_row[p]);
+      }
+      dequantizer.Store(i, j, acc, sum);
+    }
+  }
+}
+
+}  // namespace
+
+void PackInt8Weight(const float* weight, int64_t n, int64_t k, bool transpose, const float* scale,
+                    const float* zero_point, int64_t num_scales, bool symmetric,
+                    PackedInt8Weight* packed) {
+  CHECK(num_scales == 1 || num_scales == n);
+  RoundToNearestEvenGuard round_guard;
+  packed->n = n;
+  packed->k = k;
+  packed->data.resize(n * k);
+  packed->zero_point.resize(n);
+  packed->row_sum.resize(n);
+  packed->scale.resize(n);
+  FOR_RANGE(int64_t, j, 0, n) {
+    const int64_t scale_idx = num_scales == 1 ? 0 : j;
+    const float row_scale = scale[scale_idx];
+    // the unsigned values of the affine scheme are shifted to int8
+    const float row_zero_point = symmetric ? 0 : std::round(zero_point[scale_idx]);
+    const float lower_bound = symmetric ? -128 : 0;
+    const float upper_bound = symmetric ? 127 : 255;
+    const int32_t shift = symmetric ? 0 : 128;
+    int8_t* row = packed->data.data() + j * k;
+    int32_t row_sum = 0;
+    FOR_RANGE(int64_t, p, 0, k) {
+      const float x = transpose ? weight[p * n + j] : weight[j * k + p];
+      row[p] = static_cast<int8_t>(QuantizeAndClamp<int32_t>(x, row_scale, row_zero_point,
+                                                             lower_bound, upper_bound)
+                                   - shift);
+      row_sum += row[p];
+    }
+    packed->zero_point.at(j) = static_cast<int32_t>(row_zero_point) - shift;
+    packed->row_sum.at(j) = row_sum;
+    packed->scale.at(j) = row_scale;
+  }
+}
+
+int32_t QuantizeToUInt8(const float* in, int64_t num, float scale, float zero_point,
+                        bool symmetric, uint8_t* out) {
+  RoundToNearestEvenGuard round_guard;
+  if (symmetric) {
+    FOR_RANGE(int64_t, i, 0, num) {
+      out[i] = static_cast<uint8_t>(QuantizeAndClamp<int32_t>(in[i], scale, 0, -128, 127) + 128);
+    }
+    return 128;
+  } else {
+    const float rounded_zero_point = std::round(zero_point);
+    FOR_RANGE(int64_t, i, 0, num) {
+      out[i] = QuantizeAndClamp<uint8_t>(in[i], scale, rounded_zero_point, 0, 255);
+    }
+    return static_cast<int32_t>(rounded_zero_point);
+  }
+}
+
+void Int8GemmAndDequantize(const uint8_t* a, int64_t m, int32_t a_zero_point, float a_scale,
+                           const PackedInt8Weight& weight, float* out, int64_t out_row_stride,
+                           int64_t out_col_stride) {
+  if (m == 0) { return; }
+  const Int8GemmDequantizer dequantizer(a_zero_point, a_scale, weight, out, out_row_stride,
+                                        out_col_stride);
+  const int64_t num_parts =
+      std::min<int64_t>(Global<ThreadPool>::Get()->thread_num(),
+                        std::max<int64_t>(m / kMinInt8GemmRowsPerPart, 1));
+  const BalancedSplitter bs(m, num_parts);
+  MultiThreadLoop(num_parts, [&](size_t part_id) {
+    const Range range = bs.At(part_id);
+    Int8GemmRows(a, range.begin(), range.end(), weight, dequantizer);
+  });
+}
+
+}  // namespace oneflow
@@ -0,0 +1,76 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#ifndef ONEFLOW_USER_KERNELS_QUANTIZED_GEMM_UTIL_H_
+#define ONEFLOW_USER_KERNELS_QUANTIZED_GEMM_UTIL_H_
+
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+// The weight of a quantized matmul or conv, quantized to int8 with the scale and the zero point of
+// the QAT observers and laid out as n rows of k, so that a row is contiguous in the dot products
+struct PackedInt8Weight {
+  int64_t n = 0;
+  int64_t k = 0;
+  std::vector<int8_t> data;
+  // the zero point of each row of data, which is 0 for the symmetric scheme
+  std::vector<int32_t> zero_point;
+  std::vector<int32_t> row_sum;
+  std::vector<float> scale;
+};
+
+// The weight is packed on the first run, and again only when a variable may have been written
+// since, e.g. by loading a checkpoint or by the model update of a train job, which the variable
+// write count tells
+class PackedInt8WeightState final : public user_op::OpKernelState {
+ public:
+  PackedInt8WeightState() = default;
+  ~PackedInt8WeightState() override = default;
+
+  const PackedInt8Weight& weight() const { return weight_; }
+  PackedInt8Weight* mut_weight() { return &weight_; }
+  // returns true once per variable write count, for the caller to pack the weight
+  bool TryUpdateVariableWriteCount(int64_t variable_write_count) {
+    if (variable_write_count == packed_variable_write_count_) { return false; }
+    packed_variable_write_count_ = variable_write_count;
+    return true;
+  }
+
+ private:
+  PackedInt8Weight weight_;
+  int64_t packed_variable_write_count_ = -1;
+};
+
+// Quantizes the n x k weight, or the k x n one if transpose, as fake_quantization does. The scale
+// and the zero point are per row if num_scales is n, otherwise per tensor
+void PackInt8Weight(const float* weight, int64_t n, int64_t k, bool transpose, const float* scale,
+                    const float* zero_point, int64_t num_scales, bool symmetric,
+                    PackedInt8Weight* packed);
+
+// Quantizes in as fake_quantization does, and shifts the signed values of the symmetric scheme to
+// uint8. Returns the zero point of out
+int32_t QuantizeToUInt8(const float* in, int64_t num, float scale, float zero_point,
+                        bool symmetric, uint8_t* out);
+
+// out(i, j) = a_scale * weight.scale[j] * sum_p (a(i, p) - a_zero_point) * (w(j, p) - w_zero_point)
+// with int32 accumulation, for the m x k matrix a. The rows of a are split across the threads
+void Int8GemmAndDequantize(const uint8_t* a, int64_t m, int32_t a_zero_point, float a_scale,
+                           const PackedInt8Weight& weight, float* out, int64_t out_row_stride,
+                           int64_t out_col_stride);
+
+}  // namespace oneflow
+
+#endif  // ONEFLOW_USER_KERNELS_QUANTIZED_GEMM_UTIL_H_
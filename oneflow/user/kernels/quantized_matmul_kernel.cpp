@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/kernel/variable_write_count.h"
+#include "oneflow/user/kernels/quantized_gemm_util.h"
+
+namespace oneflow {
+
+namespace {
+
+class CpuQuantizedMatmulKernel final : public user_op::OpKernel {
+ public:
+  CpuQuantizedMatmulKernel() = default;
+  ~CpuQuantizedMatmulKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return std::make_shared<PackedInt8WeightState>();
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* a = ctx->Tensor4ArgNameAndIndex("a", 0);
+    const user_op::Tensor* a_scale = ctx->Tensor4ArgNameAndIndex("a_scale", 0);
+    const user_op::Tensor* a_zero_point = ctx->Tensor4ArgNameAndIndex("a_zero_point", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const bool symmetric = ctx->Attr<std::string>("quantization_scheme") == "symmetric";
+    const int64_t m = a->shape().At(0);
+    const int64_t k = a->shape().At(1);
+
+    auto* weight_state = dynamic_cast<PackedInt8WeightState*>(state);
+    CHECK_NOTNULL(weight_state);
+    const user_op::Tensor* b = ctx->Tensor4ArgNameAndIndex("b", 0);
+    const user_op::Tensor* b_scale = ctx->Tensor4ArgNameAndIndex("b_scale", 0);
+    const user_op::Tensor* b_zero_point = ctx->Tensor4ArgNameAndIndex("b_zero_point", 0);
+    const bool transpose_b = ctx->Attr<bool>("transpose_b");
+    const int64_t n = out->shape().At(1);
+    if (weight_state->TryUpdateVariableWriteCount(VariableWriteCount())) {
+      // b is n x k if transpose_b, which is the layout of the packed weight
+      PackInt8Weight(b->dptr<float>(), n, k, !transpose_b, b_scale->dptr<float>(),
+                     b_zero_point->dptr<float>(), b_scale->shape().elem_cnt(), symmetric,
+                     weight_state->mut_weight());
+    }
+    const PackedInt8Weight& weight = weight_state->weight();
+
+    const float scale = *a_scale->dptr<float>();
+    uint8_t* quantized_a = tmp_buffer->mut_dptr<uint8_t>();
+    const int32_t a_zero_point_val = QuantizeToUInt8(
+        a->dptr<float>(), m * k, scale, *a_zero_point->dptr<float>(), symmetric, quantized_a);
+    Int8GemmAndDequantize(quantized_a, m, a_zero_point_val, scale, weight,
+                          out->mut_dptr<float>(), weight.n, 1);
+  }
+
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("quantized_matmul")
+    .SetCreateFn<CpuQuantizedMatmulKernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == DeviceType::kCPU)
+                     & (user_op::HobDataType("a", 0) == DataType::kFloat))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) {
+      return ctx->Shape4ArgNameAndIndex("a", 0)->elem_cnt() * sizeof(uint8_t);
+    });
+
+}  // namespace
+
+}  // namespace oneflow
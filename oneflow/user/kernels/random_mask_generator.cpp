@@ -14,15 +14,14 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 #include "oneflow/user/kernels/random_mask_generator.h"
+#include "oneflow/core/kernel/philox_random.h"
 
 namespace oneflow {
 
 void RandomMaskGenerator<DeviceType::kCPU>::Generate(DeviceCtx* device_ctx, const int64_t n,
                                                      const float rate, int8_t* mask) {
   CHECK_GE(n, 0);
-  std::uniform_real_distribution<float> random_distribution(GetZeroVal<float>(),
-                                                            GetOneVal<float>());
-  for (int64_t i = 0; i < n; ++i) { mask[i] = random_distribution(mt19937_generator_) > rate; }
+  offset_ = PhiloxBernoulliMask(seed_, offset_, n, rate, mask);
 }
 
 template class RandomMaskGenerator<DeviceType::kCPU>;
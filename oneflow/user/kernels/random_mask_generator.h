@@ -32,13 +32,15 @@ template<>
 class RandomMaskGenerator<DeviceType::kCPU> final {
  public:
   OF_DISALLOW_COPY_AND_MOVE(RandomMaskGenerator);
-  RandomMaskGenerator(int64_t seed) : mt19937_generator_(seed) {}
+  RandomMaskGenerator(int64_t seed) : seed_(seed), offset_(0) {}
   ~RandomMaskGenerator() {}
 
   void Generate(DeviceCtx* device_ctx, int64_t n, float rate, int8_t* mask);
 
  private:
-  std::mt19937 mt19937_generator_;
+  uint64_t seed_;
+  // philox counter the next call starts from
+  uint64_t offset_;
 };
 
 #ifdef WITH_CUDA
@@ -78,6 +78,50 @@ REGISTER_REDUCE_ARITHMETIC_KERNELS_BY_DEVICE(DeviceType::kGPU)
   REGISTER_REDUCE_XPU_KERNEL("reduce_all", BinaryFuncAll, device, int8_t)
 
 REGISTER_REDUCE_LOGICAL_KERNELS(DeviceType::kCPU)
+
+namespace {
+
+// Reduces in float, so that only the sums are rounded to bfloat16
+class ReduceSumCpuBFloat16Kernel final : public user_op::OpKernel {
+ public:
+  ReduceSumCpuBFloat16Kernel() = default;
+  ~ReduceSumCpuBFloat16Kernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* input_tensor = ctx->Tensor4ArgNameAndIndex("input_tensor", 0);
+    user_op::Tensor* output_tensor = ctx->Tensor4ArgNameAndIndex("output_tensor", 0);
+    user_op::Tensor* tmp_buffer = ctx->Tensor4ArgNameAndIndex("tmp_buffer", 0);
+    const auto& axis = ctx->Attr<std::vector<int32_t>>("axis");
+    const ShapeView& in_shape = input_tensor->shape();
+    const Shape& reduced_shape = CreateReducedShape(in_shape, {axis.begin(), axis.end()});
+    const int64_t in_elem_cnt = in_shape.elem_cnt();
+    float* in_tmp_buffer = tmp_buffer->mut_dptr<float>();
+    float* reduce_tmp_buffer = in_tmp_buffer + in_elem_cnt;
+    float* out_tmp_buffer = reduce_tmp_buffer + in_elem_cnt;
+    ConvertBFloat16ToFloat(input_tensor->dptr<bfloat16>(), in_tmp_buffer, in_elem_cnt);
+    NdarrayReduce<DeviceType::kCPU, float, BinaryFuncSum>::Reduce(
+        ctx->device_ctx(), XpuVarNdarray<float>(reduced_shape, out_tmp_buffer),
+        XpuVarNdarray<const float>(in_shape, in_tmp_buffer),
+        XpuVarNdarray<float>(in_shape, reduce_tmp_buffer));
+    ConvertFloatToBFloat16(out_tmp_buffer, output_tensor->mut_dptr<bfloat16>(),
+                           output_tensor->shape().elem_cnt());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+}  // namespace
+
+REGISTER_USER_KERNEL("reduce_sum")
+    .SetCreateFn<ReduceSumCpuBFloat16Kernel>()
+    .SetIsMatchedHob((user_op::HobDeviceTag() == "cpu")
+                     & (user_op::HobDataType("output_tensor", 0) == DataType::kBFloat16))
+    .SetInferTmpSizeFn([](user_op::InferContext* ctx) {
+      const Shape* in_shape = ctx->Shape4ArgNameAndIndex("input_tensor", 0);
+      const Shape* out_shape = ctx->Shape4ArgNameAndIndex("output_tensor", 0);
+      return (2 * in_shape->elem_cnt() + out_shape->elem_cnt()) * sizeof(float);
+    });
+
 #ifdef WITH_CUDA
 REGISTER_REDUCE_LOGICAL_KERNELS(DeviceType::kGPU)
 
@@ -49,6 +49,7 @@ class ReluKernel final : public user_op::OpKernel {
 
 REGISTER_RELU_KERNEL(DeviceType::kCPU, float)
 REGISTER_RELU_KERNEL(DeviceType::kCPU, double)
+REGISTER_RELU_KERNEL(DeviceType::kCPU, bfloat16)
 #ifdef WITH_CUDA
 REGISTER_RELU_KERNEL(DeviceType::kGPU, float)
 REGISTER_RELU_KERNEL(DeviceType::kGPU, double)
@@ -86,6 +87,7 @@ class ReluGradKernel final : public user_op::OpKernel {
 
 REGISTER_RELU_GRAD_KERNEL(DeviceType::kCPU, float)
 REGISTER_RELU_GRAD_KERNEL(DeviceType::kCPU, double)
+REGISTER_RELU_GRAD_KERNEL(DeviceType::kCPU, bfloat16)
 #ifdef WITH_CUDA
 REGISTER_RELU_GRAD_KERNEL(DeviceType::kGPU, float)
 REGISTER_RELU_GRAD_KERNEL(DeviceType::kGPU, double)
@@ -18,6 +18,7 @@ limitations under the License.
 #include "oneflow/core/framework/framework.h"
 #include "oneflow/user/kernels/slice_util.h"
 #include "oneflow/core/kernel/kernel_util.h"
+#include "oneflow/core/kernel/variable_write_count.h"
 #include "oneflow/user/kernels/op_kernel_state_wrapper.h"
 
 namespace oneflow {
@@ -355,6 +356,8 @@ class LogicalSliceAssignKernel final : public user_op::OpKernel {
     const SliceContext& slice_ctx = dynamic_cast<OpKernelStateWrapper<SliceContext>*>(state)->Get();
     SwitchWriteSlice(SwitchCase(value_tensor->shape().NumAxes(), value_tensor->data_type()), ctx,
                      value_tensor, ref_tensor, slice_ctx, false);
+    // the eager checkpoint loading writes the variables of the lazy jobs with this kernel
+    IncreaseVariableWriteCount();
   }
   bool AlwaysComputeWhenAllOutputsEmpty() const override { return true; }
 };
@@ -0,0 +1,109 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/persistence/file_system.h"
+
+namespace oneflow {
+
+namespace {
+
+class SpillFileState final : public user_op::OpKernelState {
+ public:
+  SpillFileState(const std::string& path, int64_t parallel_id)
+      : path_prefix_(path + "-" + std::to_string(parallel_id)), next_seq_(0) {}
+  ~SpillFileState() override = default;
+
+  std::string FilePath4Seq(int64_t seq) const { return path_prefix_ + "-" + std::to_string(seq); }
+  int64_t NextSeq() { return next_seq_++; }
+
+ private:
+  std::string path_prefix_;
+  int64_t next_seq_;
+};
+
+std::shared_ptr<user_op::OpKernelState> CreateSpillFileState(user_op::KernelInitContext* ctx) {
+  return std::make_shared<SpillFileState>(ctx->Attr<std::string>("path"),
+                                          ctx->parallel_ctx().parallel_id());
+}
+
+// every piece is spilled to a file of its own, as the next pieces may be spilled before the
+// previous ones are loaded
+class SpillToFileKernel final : public user_op::OpKernel {
+ public:
+  SpillToFileKernel() = default;
+  ~SpillToFileKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateSpillFileState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* in = ctx->Tensor4ArgNameAndIndex("in", 0);
+    user_op::Tensor* handle = ctx->Tensor4ArgNameAndIndex("handle", 0);
+    auto* spill_state = dynamic_cast<SpillFileState*>(state);
+    CHECK_NOTNULL(spill_state);
+    const int64_t seq = spill_state->NextSeq();
+    std::unique_ptr<fs::WritableFile> file;
+    LocalFS()->NewWritableFile(spill_state->FilePath4Seq(seq), &file);
+    file->Append(in->dptr<char>(), in->shape().elem_cnt() * GetSizeOfDataType(in->data_type()));
+    file->Close();
+    *handle->mut_dptr<int64_t>() = seq;
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+class LoadSpilledFileKernel final : public user_op::OpKernel {
+ public:
+  LoadSpilledFileKernel() = default;
+  ~LoadSpilledFileKernel() = default;
+
+  std::shared_ptr<user_op::OpKernelState> CreateOpKernelState(
+      user_op::KernelInitContext* ctx) const override {
+    return CreateSpillFileState(ctx);
+  }
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx, user_op::OpKernelState* state) const override {
+    const user_op::Tensor* handle = ctx->Tensor4ArgNameAndIndex("handle", 0);
+    user_op::Tensor* out = ctx->Tensor4ArgNameAndIndex("out", 0);
+    auto* spill_state = dynamic_cast<SpillFileState*>(state);
+    CHECK_NOTNULL(spill_state);
+    const std::string file_path = spill_state->FilePath4Seq(*handle->dptr<int64_t>());
+    const size_t size = out->shape().elem_cnt() * GetSizeOfDataType(out->data_type());
+    CHECK_EQ(LocalFS()->GetFileSize(file_path), size);
+    {
+      std::unique_ptr<fs::RandomAccessFile> file;
+      LocalFS()->NewRandomAccessFile(file_path, &file);
+      file->Read(0, size, out->mut_dptr<char>());
+    }
+    LocalFS()->DelFile(file_path);
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+REGISTER_USER_KERNEL("spill_to_file")
+    .SetCreateFn<SpillToFileKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceTag() == DeviceType::kCPU);
+
+REGISTER_USER_KERNEL("load_spilled_file")
+    .SetCreateFn<LoadSpilledFileKernel>()
+    .SetIsMatchedHob(user_op::HobDeviceTag() == DeviceType::kCPU);
+
+}  // namespace
+
+}  // namespace oneflow
@@ -21,6 +21,174 @@ namespace oneflow {
 
 namespace {
 
+// Rows shorter than this fall back to std::nth_element, which is hard to beat for small inputs
+constexpr int32_t kMinRadixSelectInstanceSize = 4096;
+// A size-k heap wins as long as k stays small compared to the row
+constexpr int32_t kMaxHeapSelectK = 128;
+// Elements are tested against the heap threshold in blocks of this size before touching the heap
+constexpr int32_t kThresholdFilterBlockSize = 64;
+// Rows are only split across threads when every chunk holds at least this many elements
+constexpr int32_t kMinSplitChunkSize = 16384;
+
+// Ranking used by top_k: larger value first, smaller index first among equal values
+template<typename T>
+struct TopKComp {
+  const T* data;
+  bool operator()(const int32_t lhs, const int32_t rhs) const {
+    const T l = data[lhs];
+    const T r = data[rhs];
+    if (l == r) {
+      return lhs < rhs;
+    } else {
+      return l > r;
+    }
+  }
+};
+
+template<typename T>
+struct RadixKeyTrait;
+
+// Maps a value to an unsigned key whose natural order equals the order of the values
+template<>
+struct RadixKeyTrait<float> {
+  using KeyType = uint32_t;
+  static KeyType Convert(float val) {
+    if (val == 0.f) { val = 0.f; }  // -0.0 and +0.0 compare equal
+    KeyType bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return (bits & 0x80000000U) ? ~bits : (bits | 0x80000000U);
+  }
+};
+
+template<>
+struct RadixKeyTrait<double> {
+  using KeyType = uint64_t;
+  static KeyType Convert(double val) {
+    if (val == 0.0) { val = 0.0; }
+    KeyType bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+  }
+};
+
+template<>
+struct RadixKeyTrait<int32_t> {
+  using KeyType = uint32_t;
+  static KeyType Convert(int32_t val) { return static_cast<KeyType>(val) ^ 0x80000000U; }
+};
+
+template<>
+struct RadixKeyTrait<int64_t> {
+  using KeyType = uint64_t;
+  static KeyType Convert(int64_t val) {
+    return static_cast<KeyType>(val) ^ 0x8000000000000000ULL;
+  }
+};
+
+enum class TopKAlgo {
+  kTopOne,
+  kHeapSelect,
+  kRadixSelect,
+  kNthElement,
+};
+
+TopKAlgo GetTopKAlgo(int32_t instance_size, int32_t k) {
+  if (k == 1) { return TopKAlgo::kTopOne; }
+  if (k <= kMaxHeapSelectK) { return TopKAlgo::kHeapSelect; }
+  if (instance_size >= kMinRadixSelectInstanceSize) { return TopKAlgo::kRadixSelect; }
+  return TopKAlgo::kNthElement;
+}
+
+// Branch free so that the compiler is able to vectorize it
+template<typename T>
+bool AnyGreaterThan(const T* in_ptr, int32_t n, T threshold) {
+  bool ret = false;
+  FOR_RANGE(int32_t, i, 0, n) { ret |= (in_ptr[i] > threshold); }
+  return ret;
+}
+
+// Keeps the best k indices of [begin, end) in a heap whose top is the worst of them, the heap is
+// built in place in out_ptr
+template<typename T>
+void HeapSelectTopK(const T* in_ptr, int32_t begin, int32_t end, int32_t k, bool sorted,
+                    int32_t* out_ptr) {
+  const TopKComp<T> comp{in_ptr};
+  std::iota(out_ptr, out_ptr + k, begin);
+  std::make_heap(out_ptr, out_ptr + k, comp);
+  T threshold = in_ptr[out_ptr[0]];
+  int32_t i = begin + k;
+  while (i < end) {
+    // Every index visited from now on is larger than the ones in the heap, so a candidate has to
+    // be strictly greater than the current threshold
+    while (i + kThresholdFilterBlockSize <= end
+           && !AnyGreaterThan(in_ptr + i, kThresholdFilterBlockSize, threshold)) {
+      i += kThresholdFilterBlockSize;
+    }
+    const int32_t block_end = std::min(i + kThresholdFilterBlockSize, end);
+    for (; i < block_end; ++i) {
+      if (in_ptr[i] > threshold) {
+        std::pop_heap(out_ptr, out_ptr + k, comp);
+        out_ptr[k - 1] = i;
+        std::push_heap(out_ptr, out_ptr + k, comp);
+        threshold = in_ptr[out_ptr[0]];
+      }
+    }
+  }
+  if (sorted) { std::sort_heap(out_ptr, out_ptr + k, comp); }
+}
+
+// Finds the key of the k-th best element digit by digit, then gathers everything ranked above it
+// plus the lowest indices among the elements equal to it
+template<typename T>
+void RadixSelectTopK(const T* in_ptr, int32_t begin, int32_t end, int32_t k, bool sorted,
+                     int32_t* out_ptr) {
+  using KeyType = typename RadixKeyTrait<T>::KeyType;
+  constexpr int32_t kRadixBits = 8;
+  constexpr int32_t kRadixSize = 1 << kRadixBits;
+  constexpr KeyType kRadixMask = kRadixSize - 1;
+  KeyType prefix = 0;
+  KeyType prefix_mask = 0;
+  int32_t remaining = k;
+  int32_t hist[kRadixSize];
+  for (int32_t shift = sizeof(KeyType) * 8 - kRadixBits; shift >= 0; shift -= kRadixBits) {
+    std::fill(hist, hist + kRadixSize, 0);
+    FOR_RANGE(int32_t, i, begin, end) {
+      const KeyType key = RadixKeyTrait<T>::Convert(in_ptr[i]);
+      if ((key & prefix_mask) == prefix) { hist[(key >> shift) & kRadixMask] += 1; }
+    }
+    int32_t digit = kRadixSize - 1;
+    for (; digit > 0; --digit) {
+      if (hist[digit] >= remaining) { break; }
+      remaining -= hist[digit];
+    }
+    prefix |= static_cast<KeyType>(digit) << shift;
+    prefix_mask |= kRadixMask << shift;
+  }
+  const KeyType kth_key = prefix;
+  int32_t out_idx = 0;
+  FOR_RANGE(int32_t, i, begin, end) {
+    if (RadixKeyTrait<T>::Convert(in_ptr[i]) > kth_key) { out_ptr[out_idx++] = i; }
+  }
+  for (int32_t i = begin; i < end && remaining > 0; ++i) {
+    if (RadixKeyTrait<T>::Convert(in_ptr[i]) == kth_key) {
+      out_ptr[out_idx++] = i;
+      remaining -= 1;
+    }
+  }
+  CHECK_EQ(out_idx, k);
+  if (sorted) { std::sort(out_ptr, out_ptr + k, TopKComp<T>{in_ptr}); }
+}
+
+template<typename T>
+void NthElementTopK(const T* in_ptr, int32_t* indices_ptr, int32_t instance_size, int32_t k,
+                    bool sorted, int32_t* out_ptr) {
+  const TopKComp<T> comp{in_ptr};
+  std::iota(indices_ptr, indices_ptr + instance_size, 0);
+  std::nth_element(indices_ptr, indices_ptr + k, indices_ptr + instance_size, comp);
+  if (sorted) { std::sort(indices_ptr, indices_ptr + k, comp); }
+  std::copy(indices_ptr, indices_ptr + k, out_ptr);
+}
+
 template<typename T>
 void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, int32_t* out_ptr) {
   FOR_RANGE(int32_t, i, range.begin(), range.end()) {
@@ -32,21 +200,51 @@ void ComputeTopOne(const T* in_ptr, const Range& range, int32_t instance_size, i
 template<typename T>
 void ComputeTopK(const T* in_ptr, int32_t* indices_ptr, const Range& range, int32_t instance_size,
                  int32_t k, bool sorted, int32_t* out_ptr) {
+  const TopKAlgo algo = GetTopKAlgo(instance_size, k);
   FOR_RANGE(int32_t, i, range.begin(), range.end()) {
     const int32_t offset = i * instance_size;
     const T* in_ptr_i = in_ptr + offset;
-    int32_t* indices_ptr_i = indices_ptr + offset;
-    std::iota(indices_ptr_i, indices_ptr_i + instance_size, 0);
-    auto comp = [&](const int32_t lhs, const int32_t rhs) {
-      const T l = in_ptr_i[lhs];
-      const T r = in_ptr_i[rhs];
-      if (l == r) {
-        return lhs < rhs;
-      } else {
-        return l > r;
-      }
-    };
-    std::nth_element(indices_ptr_i, indices_ptr_i + k, indices_ptr_i + instance_size, comp);
+    int32_t* out_ptr_i = out_ptr + i * k;
+    if (algo == TopKAlgo::kHeapSelect) {
+      HeapSelectTopK(in_ptr_i, 0, instance_size, k, sorted, out_ptr_i);
+    } else if (algo == TopKAlgo::kRadixSelect) {
+      RadixSelectTopK(in_ptr_i, 0, instance_size, k, sorted, out_ptr_i);
+    } else {
+      NthElementTopK(in_ptr_i, indices_ptr + offset, instance_size, k, sorted, out_ptr_i);
+    }
+  }
+}
+
+// Used when there are fewer instances than threads: every instance is cut into chunks, the top k
+// of each chunk is selected in parallel into the chunk's own part of indices_ptr, and the
+// candidates of all chunks are reduced to the final top k afterwards
+template<typename T>
+void ComputeTopKWithSplitInstance(const T* in_ptr, int32_t* indices_ptr, int32_t instance_num,
+                                  int32_t instance_size, int32_t k, bool sorted,
+                                  int32_t num_chunks, int32_t* out_ptr) {
+  const BalancedSplitter bs(instance_size, num_chunks);
+  MultiThreadLoop(instance_num * num_chunks, [&](size_t task_id) {
+    const int32_t i = task_id / num_chunks;
+    const Range range = bs.At(task_id % num_chunks);
+    const T* in_ptr_i = in_ptr + i * instance_size;
+    int32_t* chunk_out_ptr = indices_ptr + i * instance_size + range.begin();
+    if (k <= kMaxHeapSelectK) {
+      HeapSelectTopK(in_ptr_i, range.begin(), range.end(), k, false, chunk_out_ptr);
+    } else {
+      RadixSelectTopK(in_ptr_i, range.begin(), range.end(), k, false, chunk_out_ptr);
+    }
+  });
+  FOR_RANGE(int32_t, i, 0, instance_num) {
+    const T* in_ptr_i = in_ptr + i * instance_size;
+    int32_t* indices_ptr_i = indices_ptr + i * instance_size;
+    // Chunk c starts at or after c * k, so compacting front to back never overwrites candidates
+    FOR_RANGE(int32_t, c, 1, num_chunks) {
+      const int32_t* chunk_begin = indices_ptr_i + bs.At(c).begin();
+      std::copy(chunk_begin, chunk_begin + k, indices_ptr_i + c * k);
+    }
+    const int32_t num_candidates = num_chunks * k;
+    const TopKComp<T> comp{in_ptr_i};
+    std::nth_element(indices_ptr_i, indices_ptr_i + k, indices_ptr_i + num_candidates, comp);
     if (sorted) { std::sort(indices_ptr_i, indices_ptr_i + k, comp); }
     std::copy(indices_ptr_i, indices_ptr_i + k, out_ptr + i * k);
   }
@@ -55,7 +253,18 @@ void ComputeTopK(const T* in_ptr, int32_t* indices_ptr, const Range& range, int3
 template<typename T>
 void CpuTopK(DeviceCtx* ctx, const T* in_ptr, int32_t* indices_ptr, int32_t instance_num,
              int32_t instance_size, int32_t k, bool sorted, int32_t* out_ptr) {
-  const int32_t num_thread = std::min(instance_num, Global<ThreadPool>::Get()->thread_num());
+  const int32_t thread_num = Global<ThreadPool>::Get()->thread_num();
+  // the tmp buffer is empty for k == 1, which the top one path does without
+  if (k > 1 && indices_ptr != nullptr && instance_num < thread_num) {
+    const int32_t num_chunks =
+        std::min(thread_num, instance_size / std::max(k, kMinSplitChunkSize));
+    if (num_chunks > 1) {
+      ComputeTopKWithSplitInstance(in_ptr, indices_ptr, instance_num, instance_size, k, sorted,
+                                   num_chunks, out_ptr);
+      return;
+    }
+  }
+  const int32_t num_thread = std::min(instance_num, thread_num);
   const BalancedSplitter bs(instance_num, num_thread);
   BlockingCounter bc(num_thread);
   FOR_RANGE(int32_t, thread_id, 0, num_thread) {
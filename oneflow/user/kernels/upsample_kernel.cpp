@@ -0,0 +1,455 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/thread/thread_manager.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+// Channels of one pixel handled by a single task in channels_last backward, small enough to
+// spread an image over the thread pool, large enough to keep the inner loop vectorized
+constexpr int64_t kMinChannelsPerTask = 16;
+
+struct UpsampleDims {
+  int64_t num;
+  int64_t channels;
+  int64_t in_height;
+  int64_t in_width;
+  int64_t out_height;
+  int64_t out_width;
+};
+
+UpsampleDims GetUpsampleDims(const ShapeView& in_shape, const ShapeView& out_shape,
+                             const bool channels_first) {
+  CHECK_EQ(in_shape.NumAxes(), 4);
+  CHECK_EQ(out_shape.NumAxes(), 4);
+  UpsampleDims dims;
+  dims.num = in_shape.At(0);
+  if (channels_first) {
+    dims.channels = in_shape.At(1);
+    dims.in_height = in_shape.At(2);
+    dims.in_width = in_shape.At(3);
+    dims.out_height = out_shape.At(2);
+    dims.out_width = out_shape.At(3);
+  } else {
+    dims.channels = in_shape.At(3);
+    dims.in_height = in_shape.At(1);
+    dims.in_width = in_shape.At(2);
+    dims.out_height = out_shape.At(1);
+    dims.out_width = out_shape.At(2);
+  }
+  return dims;
+}
+
+bool IsChannelsFirst(user_op::KernelComputeContext* ctx) {
+  const std::string& data_format = ctx->Attr<std::string>("data_format");
+  CHECK(data_format == "channels_first" || data_format == "channels_last");
+  return data_format == "channels_first";
+}
+
+// Source index of every output row or column, computed once per launch instead of per element
+void InitNearestIndexTable(const int64_t in_size, const int64_t out_size, const float scale,
+                           std::vector<int64_t>* table) {
+  table->resize(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    const int64_t index = static_cast<int64_t>(std::floor((static_cast<float>(i) + 0.5f) * scale));
+    table->at(i) = std::max<int64_t>(std::min(index, in_size - 1), 0);
+  }
+}
+
+template<typename T>
+T GetAreaPixelScale(const int64_t input_size, const int64_t output_size, bool align_corners,
+                    const T scale) {
+  return align_corners ? static_cast<T>(input_size - 1) / (output_size - 1)
+                       : (scale > 0. ? 1.0 / scale : static_cast<T>(input_size) / output_size);
+}
+
+template<typename T>
+struct BilinearIndexTable {
+  std::vector<int64_t> low_index;
+  std::vector<int64_t> high_index;
+  std::vector<T> lambda;
+};
+
+template<typename T>
+void InitBilinearIndexTable(const int64_t in_size, const int64_t out_size, const T scale,
+                            const bool align_corners, BilinearIndexTable<T>* table) {
+  table->low_index.resize(out_size);
+  table->high_index.resize(out_size);
+  table->lambda.resize(out_size);
+  FOR_RANGE(int64_t, i, 0, out_size) {
+    T src_index;
+    if (align_corners) {
+      src_index = scale * static_cast<T>(i);
+    } else {
+      src_index = (static_cast<T>(i) + 0.5f) * scale - 0.5f;
+      if (src_index < 0) { src_index = 0; }
+    }
+    const T src_floor = std::floor(src_index);
+    table->low_index[i] = src_index > 0 ? static_cast<int64_t>(src_floor) : 0;
+    table->high_index[i] =
+        src_index < in_size - 1 ? static_cast<int64_t>(std::ceil(src_index)) : in_size - 1;
+    table->lambda[i] = src_index - src_floor;
+  }
+}
+
+template<typename T>
+void UpsampleNearestForward(const UpsampleDims& dims, const bool channels_first,
+                            const std::vector<int64_t>& h_table,
+                            const std::vector<int64_t>& w_table, const T* x, T* y) {
+  if (channels_first) {
+    ParallelForEachTask(dims.num * dims.channels, [&](int64_t plane_id) {
+      const T* x_plane = x + plane_id * dims.in_height * dims.in_width;
+      T* y_plane = y + plane_id * dims.out_height * dims.out_width;
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        const T* x_row = x_plane + h_table[oh] * dims.in_width;
+        T* y_row = y_plane + oh * dims.out_width;
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) { y_row[ow] = x_row[w_table[ow]]; }
+      }
+    });
+  } else {
+    ParallelForEachTask(dims.num * dims.out_height, [&](int64_t out_row_id) {
+      const int64_t n = out_row_id / dims.out_height;
+      const int64_t oh = out_row_id % dims.out_height;
+      const T* x_row = x + (n * dims.in_height + h_table[oh]) * dims.in_width * dims.channels;
+      T* y_row = y + out_row_id * dims.out_width * dims.channels;
+      FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+        const T* x_pixel = x_row + w_table[ow] * dims.channels;
+        T* y_pixel = y_row + ow * dims.channels;
+        FOR_RANGE(int64_t, c, 0, dims.channels) { y_pixel[c] = x_pixel[c]; }
+      }
+    });
+  }
+}
+
+// Every task owns whole planes (channels_first) or a channel slice of whole images
+// (channels_last) of dx, so the accumulation needs no atomics
+template<typename T>
+void UpsampleNearestBackward(const UpsampleDims& dims, const bool channels_first,
+                             const std::vector<int64_t>& h_table,
+                             const std::vector<int64_t>& w_table, const T* dy, T* dx) {
+  if (channels_first) {
+    ParallelForEachTask(dims.num * dims.channels, [&](int64_t plane_id) {
+      const T* dy_plane = dy + plane_id * dims.out_height * dims.out_width;
+      T* dx_plane = dx + plane_id * dims.in_height * dims.in_width;
+      std::fill(dx_plane, dx_plane + dims.in_height * dims.in_width, GetZeroVal<T>());
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        const T* dy_row = dy_plane + oh * dims.out_width;
+        T* dx_row = dx_plane + h_table[oh] * dims.in_width;
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) { dx_row[w_table[ow]] += dy_row[ow]; }
+      }
+    });
+  } else {
+    const int64_t num_channel_groups =
+        std::max<int64_t>(std::min<int64_t>(dims.channels / kMinChannelsPerTask,
+                                            Global<ThreadPool>::Get()->thread_num()),
+                          1);
+    const BalancedSplitter channel_bs(dims.channels, num_channel_groups);
+    ParallelForEachTask(dims.num * num_channel_groups, [&](int64_t task_id) {
+      const int64_t n = task_id / num_channel_groups;
+      const Range channel_range = channel_bs.At(task_id % num_channel_groups);
+      const T* dy_image = dy + n * dims.out_height * dims.out_width * dims.channels;
+      T* dx_image = dx + n * dims.in_height * dims.in_width * dims.channels;
+      FOR_RANGE(int64_t, i, 0, dims.in_height * dims.in_width) {
+        T* dx_pixel = dx_image + i * dims.channels;
+        FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+          dx_pixel[c] = GetZeroVal<T>();
+        }
+      }
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+          const T* dy_pixel = dy_image + (oh * dims.out_width + ow) * dims.channels;
+          T* dx_pixel = dx_image + (h_table[oh] * dims.in_width + w_table[ow]) * dims.channels;
+          FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+            dx_pixel[c] += dy_pixel[c];
+          }
+        }
+      }
+    });
+  }
+}
+
+template<typename T>
+void UpsampleBilinearForward(const UpsampleDims& dims, const bool channels_first,
+                             const BilinearIndexTable<T>& h_table,
+                             const BilinearIndexTable<T>& w_table, const T* x, T* y) {
+  if (channels_first) {
+    ParallelForEachTask(dims.num * dims.channels, [&](int64_t plane_id) {
+      const T* x_plane = x + plane_id * dims.in_height * dims.in_width;
+      T* y_plane = y + plane_id * dims.out_height * dims.out_width;
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        const T* top_row = x_plane + h_table.low_index[oh] * dims.in_width;
+        const T* bottom_row = x_plane + h_table.high_index[oh] * dims.in_width;
+        const T h_lerp = h_table.lambda[oh];
+        T* y_row = y_plane + oh * dims.out_width;
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+          const int64_t left = w_table.low_index[ow];
+          const int64_t right = w_table.high_index[ow];
+          const T w_lerp = w_table.lambda[ow];
+          const T top = top_row[left] + (top_row[right] - top_row[left]) * w_lerp;
+          const T bottom = bottom_row[left] + (bottom_row[right] - bottom_row[left]) * w_lerp;
+          y_row[ow] = top + (bottom - top) * h_lerp;
+        }
+      }
+    });
+  } else {
+    const int64_t row_size = dims.in_width * dims.channels;
+    ParallelForEachTask(dims.num * dims.out_height, [&](int64_t out_row_id) {
+      const int64_t n = out_row_id / dims.out_height;
+      const int64_t oh = out_row_id % dims.out_height;
+      const T* x_image = x + n * dims.in_height * row_size;
+      const T* top_row = x_image + h_table.low_index[oh] * row_size;
+      const T* bottom_row = x_image + h_table.high_index[oh] * row_size;
+      const T h_lerp = h_table.lambda[oh];
+      T* y_row = y + out_row_id * dims.out_width * dims.channels;
+      FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+        const T* top_left = top_row + w_table.low_index[ow] * dims.channels;
+        const T* top_right = top_row + w_table.high_index[ow] * dims.channels;
+        const T* bottom_left = bottom_row + w_table.low_index[ow] * dims.channels;
+        const T* bottom_right = bottom_row + w_table.high_index[ow] * dims.channels;
+        const T w_lerp = w_table.lambda[ow];
+        T* y_pixel = y_row + ow * dims.channels;
+        FOR_RANGE(int64_t, c, 0, dims.channels) {
+          const T top = top_left[c] + (top_right[c] - top_left[c]) * w_lerp;
+          const T bottom = bottom_left[c] + (bottom_right[c] - bottom_left[c]) * w_lerp;
+          y_pixel[c] = top + (bottom - top) * h_lerp;
+        }
+      }
+    });
+  }
+}
+
+template<typename T>
+void UpsampleBilinearBackward(const UpsampleDims& dims, const bool channels_first,
+                              const BilinearIndexTable<T>& h_table,
+                              const BilinearIndexTable<T>& w_table, const T* dy, T* dx) {
+  if (channels_first) {
+    ParallelForEachTask(dims.num * dims.channels, [&](int64_t plane_id) {
+      const T* dy_plane = dy + plane_id * dims.out_height * dims.out_width;
+      T* dx_plane = dx + plane_id * dims.in_height * dims.in_width;
+      std::fill(dx_plane, dx_plane + dims.in_height * dims.in_width, GetZeroVal<T>());
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        const T* dy_row = dy_plane + oh * dims.out_width;
+        T* top_row = dx_plane + h_table.low_index[oh] * dims.in_width;
+        T* bottom_row = dx_plane + h_table.high_index[oh] * dims.in_width;
+        const T h_lerp = h_table.lambda[oh];
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+          const int64_t left = w_table.low_index[ow];
+          const int64_t right = w_table.high_index[ow];
+          const T w_lerp = w_table.lambda[ow];
+          const T dbottom = h_lerp * dy_row[ow];
+          const T dtop = dy_row[ow] - dbottom;
+          top_row[left] += (1 - w_lerp) * dtop;
+          top_row[right] += w_lerp * dtop;
+          bottom_row[left] += (1 - w_lerp) * dbottom;
+          bottom_row[right] += w_lerp * dbottom;
+        }
+      }
+    });
+  } else {
+    const int64_t num_channel_groups =
+        std::max<int64_t>(std::min<int64_t>(dims.channels / kMinChannelsPerTask,
+                                            Global<ThreadPool>::Get()->thread_num()),
+                          1);
+    const BalancedSplitter channel_bs(dims.channels, num_channel_groups);
+    const int64_t row_size = dims.in_width * dims.channels;
+    ParallelForEachTask(dims.num * num_channel_groups, [&](int64_t task_id) {
+      const int64_t n = task_id / num_channel_groups;
+      const Range channel_range = channel_bs.At(task_id % num_channel_groups);
+      const T* dy_image = dy + n * dims.out_height * dims.out_width * dims.channels;
+      T* dx_image = dx + n * dims.in_height * row_size;
+      FOR_RANGE(int64_t, i, 0, dims.in_height * dims.in_width) {
+        T* dx_pixel = dx_image + i * dims.channels;
+        FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+          dx_pixel[c] = GetZeroVal<T>();
+        }
+      }
+      FOR_RANGE(int64_t, oh, 0, dims.out_height) {
+        T* top_row = dx_image + h_table.low_index[oh] * row_size;
+        T* bottom_row = dx_image + h_table.high_index[oh] * row_size;
+        const T h_lerp = h_table.lambda[oh];
+        FOR_RANGE(int64_t, ow, 0, dims.out_width) {
+          const T* dy_pixel = dy_image + (oh * dims.out_width + ow) * dims.channels;
+          T* top_left = top_row + w_table.low_index[ow] * dims.channels;
+          T* top_right = top_row + w_table.high_index[ow] * dims.channels;
+          T* bottom_left = bottom_row + w_table.low_index[ow] * dims.channels;
+          T* bottom_right = bottom_row + w_table.high_index[ow] * dims.channels;
+          const T w_lerp = w_table.lambda[ow];
+          FOR_RANGE(int64_t, c, channel_range.begin(), channel_range.end()) {
+            const T dbottom = h_lerp * dy_pixel[c];
+            const T dtop = dy_pixel[c] - dbottom;
+            top_left[c] += (1 - w_lerp) * dtop;
+            top_right[c] += w_lerp * dtop;
+            bottom_left[c] += (1 - w_lerp) * dbottom;
+            bottom_right[c] += w_lerp * dbottom;
+          }
+        }
+      }
+    });
+  }
+}
+
+}  // namespace
+
+template<typename T>
+class UpsampleNearestCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestCPUKernel() = default;
+  ~UpsampleNearestCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    const bool channels_first = IsChannelsFirst(ctx);
+    const UpsampleDims dims = GetUpsampleDims(x_blob->shape(), y_blob->shape(), channels_first);
+    std::vector<int64_t> h_table;
+    std::vector<int64_t> w_table;
+    InitNearestIndexTable(dims.in_height, dims.out_height, 1.f / height_scale, &h_table);
+    InitNearestIndexTable(dims.in_width, dims.out_width, 1.f / width_scale, &w_table);
+    UpsampleNearestForward(dims, channels_first, h_table, w_table, x_blob->dptr<T>(),
+                           y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleNearestGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleNearestGradCPUKernel() = default;
+  ~UpsampleNearestGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    const bool channels_first = IsChannelsFirst(ctx);
+    const UpsampleDims dims = GetUpsampleDims(dx_blob->shape(), dy_blob->shape(), channels_first);
+    std::vector<int64_t> h_table;
+    std::vector<int64_t> w_table;
+    InitNearestIndexTable(dims.in_height, dims.out_height, 1.f / height_scale, &h_table);
+    InitNearestIndexTable(dims.in_width, dims.out_width, 1.f / width_scale, &w_table);
+    UpsampleNearestBackward(dims, channels_first, h_table, w_table, dy_blob->dptr<T>(),
+                            dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                       \
+      .SetCreateFn<UpsampleNearestCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceTag() == "cpu")                                             \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                  \
+      .SetCreateFn<UpsampleNearestGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                  \
+          (user_op::HobDeviceTag() == "cpu")                                             \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                 \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("nearest")));
+
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_NEAREST_CPU_KERNEL(double)
+
+template<typename T>
+class UpsampleBilinearCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearCPUKernel() = default;
+  ~UpsampleBilinearCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    const user_op::Tensor* x_blob = ctx->Tensor4ArgNameAndIndex("x", 0);
+    user_op::Tensor* y_blob = ctx->Tensor4ArgNameAndIndex("y", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    const bool align_corners = ctx->Attr<bool>("align_corners");
+    const bool channels_first = IsChannelsFirst(ctx);
+    const UpsampleDims dims = GetUpsampleDims(x_blob->shape(), y_blob->shape(), channels_first);
+    BilinearIndexTable<T> h_table;
+    BilinearIndexTable<T> w_table;
+    InitBilinearIndexTable<T>(
+        dims.in_height, dims.out_height,
+        GetAreaPixelScale<T>(dims.in_height, dims.out_height, align_corners, height_scale),
+        align_corners, &h_table);
+    InitBilinearIndexTable<T>(
+        dims.in_width, dims.out_width,
+        GetAreaPixelScale<T>(dims.in_width, dims.out_width, align_corners, width_scale),
+        align_corners, &w_table);
+    UpsampleBilinearForward(dims, channels_first, h_table, w_table, x_blob->dptr<T>(),
+                            y_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+template<typename T>
+class UpsampleBilinearGradCPUKernel final : public user_op::OpKernel {
+ public:
+  UpsampleBilinearGradCPUKernel() = default;
+  ~UpsampleBilinearGradCPUKernel() = default;
+
+ private:
+  void Compute(user_op::KernelComputeContext* ctx) const override {
+    user_op::Tensor* dx_blob = ctx->Tensor4ArgNameAndIndex("dx", 0);
+    if (dx_blob == nullptr) { return; }
+    const user_op::Tensor* dy_blob = ctx->Tensor4ArgNameAndIndex("dy", 0);
+    const float height_scale = ctx->Attr<float>("height_scale");
+    const float width_scale = ctx->Attr<float>("width_scale");
+    const bool align_corners = ctx->Attr<bool>("align_corners");
+    const bool channels_first = IsChannelsFirst(ctx);
+    const UpsampleDims dims = GetUpsampleDims(dx_blob->shape(), dy_blob->shape(), channels_first);
+    BilinearIndexTable<T> h_table;
+    BilinearIndexTable<T> w_table;
+    InitBilinearIndexTable<T>(
+        dims.in_height, dims.out_height,
+        GetAreaPixelScale<T>(dims.in_height, dims.out_height, align_corners, height_scale),
+        align_corners, &h_table);
+    InitBilinearIndexTable<T>(
+        dims.in_width, dims.out_width,
+        GetAreaPixelScale<T>(dims.in_width, dims.out_width, align_corners, width_scale),
+        align_corners, &w_table);
+    UpsampleBilinearBackward(dims, channels_first, h_table, w_table, dy_blob->dptr<T>(),
+                             dx_blob->mut_dptr<T>());
+  }
+  bool AlwaysComputeWhenAllOutputsEmpty() const override { return false; }
+};
+
+#define REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(dtype)                                      \
+  REGISTER_USER_KERNEL("upsample")                                                        \
+      .SetCreateFn<UpsampleBilinearCPUKernel<dtype>>()                                    \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceTag() == "cpu")                                              \
+          & (user_op::HobDataType("y", 0) == GetDataType<dtype>::value)                   \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear"))); \
+  REGISTER_USER_KERNEL("upsample_grad")                                                   \
+      .SetCreateFn<UpsampleBilinearGradCPUKernel<dtype>>()                                \
+      .SetIsMatchedHob(                                                                   \
+          (user_op::HobDeviceTag() == "cpu")                                              \
+          & (user_op::HobDataType("dx", 0) == GetDataType<dtype>::value)                  \
+          & (user_op::HobAttr<std::string>("interpolation") == std::string("bilinear")));
+
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(float)
+REGISTER_UPSAMPLE_BILINEAR_CPU_KERNEL(double)
+
+}  // namespace oneflow
@@ -26,6 +26,7 @@ REGISTER_CPU_ONLY_USER_OP("ofrecord_raw_decoder")
     .Attr<DataType>("data_type")
     .Attr<bool>("dim1_varying_length", false)
     .Attr<bool>("auto_zero_padding", false)
+    .Attr<bool>("pad_to_batch_max_length", false)
     .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* in_tensor = ctx->TensorDesc4ArgNameAndIndex("in", 0);
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
@@ -35,6 +36,13 @@ REGISTER_CPU_ONLY_USER_OP("ofrecord_raw_decoder")
       dim_vec[0] = in_tensor->shape().At(0);
       for (int i = 1; i < dim_vec.size(); ++i) { dim_vec[i] = conf_shape.At(i - 1); }
       *out_tensor->mut_shape() = Shape(dim_vec);
+      if (ctx->Attr<bool>("pad_to_batch_max_length")) {
+        // the shape is the upper bound, dim 1 shrinks to the longest sample of every batch
+        CHECK_EQ_OR_RETURN(conf_shape.NumAxes(), 1);
+        *out_tensor->mut_is_dynamic() = true;
+      } else {
+        *out_tensor->mut_is_dynamic() = in_tensor->is_dynamic();
+      }
       return Maybe<void>::Ok();
     })
     .SetInputArgModifyFn([](user_op::GetInputArgModifier GetInputArgModifierFn,
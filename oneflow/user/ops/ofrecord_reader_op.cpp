@@ -28,6 +28,18 @@ REGISTER_CPU_ONLY_USER_OP("OFRecordReader")
     .Attr<int64_t>("seed", -1)
     .Attr<int32_t>("shuffle_buffer_size", 1024)
     .Attr<bool>("shuffle_after_epoch", false)
+    .Attr<int32_t>("num_load_workers", 1)
+    .Attr<bool>("ordered_load", true)
+    .Attr<int32_t>("load_buffer_size", 256)
+    .Attr<int32_t>("batch_buffer_size", 4)
+    .Attr<bool>("random_access", false)
+    .Attr<int32_t>("random_access_read_size", 64)
+    .Attr<int64_t>("resume_sample_ordinal", 0)
+    .Attr<std::string>("bucket_length_key", "")
+    .Attr<std::vector<int64_t>>("bucket_boundaries", std::vector<int64_t>())
+    .Attr<int64_t>("max_tokens_per_batch", -1)
+    .Attr<int64_t>("cache_memory_bytes", 0)
+    .Attr<std::string>("cache_spill_dir", "")
     .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
       int32_t local_batch_size = ctx->Attr<int32_t>("batch_size");
@@ -38,12 +50,19 @@ REGISTER_CPU_ONLY_USER_OP("OFRecordReader")
         local_batch_size /= parallel_num;
       }
       *out_tensor->mut_shape() = Shape({local_batch_size});
+      // length bucketed batches hold up to batch_size records
+      if (!ctx->Attr<std::string>("bucket_length_key").empty()) {
+        *out_tensor->mut_is_dynamic() = true;
+      }
       return Maybe<void>::Ok();
     })
     .SetLogicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
       user_op::TensorDesc* out_tensor = ctx->TensorDesc4ArgNameAndIndex("out", 0);
       int32_t batch_size = ctx->Attr<int32_t>("batch_size");
       *out_tensor->mut_shape() = Shape({batch_size});
+      if (!ctx->Attr<std::string>("bucket_length_key").empty()) {
+        *out_tensor->mut_is_dynamic() = true;
+      }
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
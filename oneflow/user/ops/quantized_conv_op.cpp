@@ -0,0 +1,102 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/user/ops/nn_util.h"
+
+namespace oneflow {
+
+namespace {
+
+// NOTE: out = conv2d(fake_quantization(in), fake_quantization(weight)) computed in int8, which is
+// what QuantizedInferenceRewritePass replaces them with in the cpu inference jobs
+REGISTER_USER_OP("quantized_conv2d")
+    .Input("in")
+    .Input("in_scale")
+    .Input("in_zero_point")
+    .Input("weight")
+    .Input("weight_scale")
+    .Input("weight_zero_point")
+    .Output("out")
+    .Attr<int32_t>("filters")
+    .Attr<std::vector<int32_t>>("padding_before")
+    .Attr<std::string>("data_format")
+    .Attr<std::vector<int32_t>>("kernel_size")
+    .Attr<std::vector<int32_t>>("strides")
+    .Attr<std::vector<int32_t>>("dilation_rate")
+    .Attr<int32_t>("groups", 1)
+    // "symmetric" or "affine", the same as the quantization_scheme of fake_quantization
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .Attr<int32_t>("quantization_bit", 8)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->Attr<int32_t>("quantization_bit"), 8);
+      const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+      CHECK_OR_RETURN(quantization_scheme == "symmetric" || quantization_scheme == "affine");
+      CHECK_EQ_OR_RETURN(ctx->Attr<std::string>("data_format"), "channels_first");
+      CHECK_EQ_OR_RETURN(ctx->Attr<int32_t>("groups"), 1);
+      const user_op::TensorDesc* in = ctx->TensorDesc4ArgNameAndIndex("in", 0);
+      CHECK_EQ_OR_RETURN(in->shape().NumAxes(), 4);
+      const int32_t filters = ctx->Attr<int32_t>("filters");
+      const auto& kernel_size = ctx->Attr<std::vector<int32_t>>("kernel_size");
+      const auto& padding_before = ctx->Attr<std::vector<int32_t>>("padding_before");
+      const auto& strides = ctx->Attr<std::vector<int32_t>>("strides");
+      const auto& dilation_rate = ctx->Attr<std::vector<int32_t>>("dilation_rate");
+      CHECK_EQ_OR_RETURN(kernel_size.size(), 2);
+      CHECK_EQ_OR_RETURN(padding_before.size(), 2);
+      CHECK_EQ_OR_RETURN(strides.size(), 2);
+      CHECK_EQ_OR_RETURN(dilation_rate.size(), 2);
+      const Shape weight_shape({filters, in->shape().At(1), kernel_size.at(0), kernel_size.at(1)});
+      CHECK_EQ_OR_RETURN(*ctx->Shape4ArgNameAndIndex("weight", 0), weight_shape);
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("in_scale", 0)->elem_cnt(), 1);
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("in_zero_point", 0)->elem_cnt(), 1);
+      const int64_t weight_scale_cnt = ctx->Shape4ArgNameAndIndex("weight_scale", 0)->elem_cnt();
+      CHECK_OR_RETURN(weight_scale_cnt == 1 || weight_scale_cnt == filters);
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("weight_zero_point", 0)->elem_cnt(),
+                         weight_scale_cnt);
+
+      DimVector out_shape(4);
+      out_shape.at(0) = in->shape().At(0);
+      out_shape.at(1) = filters;
+      for (int32_t i = 0; i < 2; ++i) {
+        CalcConvOut(in->shape().At(2 + i), kernel_size.at(i), dilation_rate.at(i), strides.at(i),
+                    padding_before.at(i), &out_shape.at(2 + i));
+      }
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out->mut_shape() = Shape(out_shape);
+      *out->mut_is_dynamic() = in->is_dynamic();
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("in", 0), 0)
+          .Broadcast(user_op::OpArg("in_scale", 0))
+          .Broadcast(user_op::OpArg("in_zero_point", 0))
+          .Broadcast(user_op::OpArg("weight", 0))
+          .Broadcast(user_op::OpArg("weight_scale", 0))
+          .Broadcast(user_op::OpArg("weight_zero_point", 0))
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("in", 0), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("weight", 0), DataType::kFloat);
+      *ctx->Dtype4ArgNameAndIndex("out", 0) = DataType::kFloat;
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace
+
+}  // namespace oneflow
@@ -0,0 +1,81 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+
+namespace oneflow {
+
+namespace {
+
+// NOTE: out = matmul(fake_quantization(a), fake_quantization(b)) computed in int8, which is what
+// QuantizedInferenceRewritePass replaces them with in the cpu inference jobs
+REGISTER_USER_OP("quantized_matmul")
+    .Input("a")
+    .Input("a_scale")
+    .Input("a_zero_point")
+    .Input("b")
+    .Input("b_scale")
+    .Input("b_zero_point")
+    .Output("out")
+    .Attr<bool>("transpose_b", false)
+    // "symmetric" or "affine", the same as the quantization_scheme of fake_quantization
+    .Attr<std::string>("quantization_scheme", "symmetric")
+    .Attr<int32_t>("quantization_bit", 8)
+    .SetTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(ctx->Attr<int32_t>("quantization_bit"), 8);
+      const std::string& quantization_scheme = ctx->Attr<std::string>("quantization_scheme");
+      CHECK_OR_RETURN(quantization_scheme == "symmetric" || quantization_scheme == "affine");
+      const user_op::TensorDesc* a = ctx->TensorDesc4ArgNameAndIndex("a", 0);
+      const user_op::TensorDesc* b = ctx->TensorDesc4ArgNameAndIndex("b", 0);
+      CHECK_EQ_OR_RETURN(a->shape().NumAxes(), 2);
+      CHECK_EQ_OR_RETURN(b->shape().NumAxes(), 2);
+      const bool transpose_b = ctx->Attr<bool>("transpose_b");
+      const int64_t k = a->shape().At(1);
+      const int64_t n = transpose_b ? b->shape().At(0) : b->shape().At(1);
+      CHECK_EQ_OR_RETURN(k, transpose_b ? b->shape().At(1) : b->shape().At(0));
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("a_scale", 0)->elem_cnt(), 1);
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("a_zero_point", 0)->elem_cnt(), 1);
+      // the per-channel scales of b are along its axis 0, which must be the axis of n
+      const int64_t b_scale_cnt = ctx->Shape4ArgNameAndIndex("b_scale", 0)->elem_cnt();
+      CHECK_OR_RETURN(b_scale_cnt == 1 || (transpose_b && b_scale_cnt == n));
+      CHECK_EQ_OR_RETURN(ctx->Shape4ArgNameAndIndex("b_zero_point", 0)->elem_cnt(), b_scale_cnt);
+
+      user_op::TensorDesc* out = ctx->TensorDesc4ArgNameAndIndex("out", 0);
+      *out->mut_shape() = Shape({a->shape().At(0), n});
+      *out->mut_is_dynamic() = a->is_dynamic();
+      return Maybe<void>::Ok();
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Split(user_op::OpArg("a", 0), 0)
+          .Broadcast(user_op::OpArg("a_scale", 0))
+          .Broadcast(user_op::OpArg("a_zero_point", 0))
+          .Broadcast(user_op::OpArg("b", 0))
+          .Broadcast(user_op::OpArg("b_scale", 0))
+          .Broadcast(user_op::OpArg("b_zero_point", 0))
+          .Split(user_op::OpArg("out", 0), 0)
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("a", 0), DataType::kFloat);
+      CHECK_EQ_OR_RETURN(*ctx->Dtype4ArgNameAndIndex("b", 0), DataType::kFloat);
+      *ctx->Dtype4ArgNameAndIndex("out", 0) = DataType::kFloat;
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace
+
+}  // namespace oneflow
@@ -0,0 +1,134 @@
+/*
+Copyright 2020 The OneFlow Authors. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "oneflow/core/framework/framework.h"
+#include "oneflow/core/operator/operator.h"
+#include "oneflow/core/common/balanced_splitter.h"
+
+namespace oneflow {
+
+namespace {
+
+// the handle of a spilled blob tells load_spilled_file which file the blob is in, it is the same
+// on all the ranks as the ranks spill the same pieces
+Maybe<void> InferHandleTensorDesc(user_op::InferContext* ctx) {
+  *ctx->Shape4ArgNameAndIndex("handle", 0) = Shape({1});
+  *ctx->IsDynamic4ArgNameAndIndex("handle", 0) = false;
+  return Maybe<void>::Ok();
+}
+
+Maybe<void> InferSpilledTensorDesc(user_op::InferContext* ctx, bool is_logical) {
+  DimVector dim_vec = ctx->Attr<Shape>("shape").dim_vec();
+  const SbpParallel& out_sbp = ctx->SbpParallel4ArgNameAndIndex("out", 0);
+  const int64_t parallel_num = ctx->parallel_ctx().parallel_num();
+  if (!is_logical && out_sbp.has_split_parallel() && parallel_num > 1) {
+    const int64_t split_axis = out_sbp.split_parallel().axis();
+    CHECK_LT_OR_RETURN(split_axis, dim_vec.size());
+    BalancedSplitter bs(dim_vec.at(split_axis), parallel_num);
+    dim_vec[split_axis] = bs.At(ctx->parallel_ctx().parallel_id()).size();
+  }
+  *ctx->Shape4ArgNameAndIndex("out", 0) = Shape(dim_vec);
+  *ctx->IsDynamic4ArgNameAndIndex("out", 0) = false;
+  return Maybe<void>::Ok();
+}
+
+// the sbp of the spilled blob, which the blob keeps from its producer to load_spilled_file
+Maybe<SbpParallel> GetSpilledSbpParallel(user_op::InferSbpSignatureFnContext* ctx,
+                                         int64_t num_axes) {
+  const std::string& sbp_parallel_str = ctx->Attr<std::string>("sbp_parallel");
+  SbpParallel sbp_parallel;
+  CHECK_OR_RETURN(ParseSbpParallelFromString(sbp_parallel_str, &sbp_parallel))
+      << "invalid sbp_parallel: " << sbp_parallel_str;
+  if (sbp_parallel.has_split_parallel()) {
+    CHECK_GE_OR_RETURN(sbp_parallel.split_parallel().axis(), 0);
+    CHECK_LT_OR_RETURN(sbp_parallel.split_parallel().axis(), num_axes);
+  }
+  return sbp_parallel;
+}
+
+}  // namespace
+
+REGISTER_USER_OP("spill_to_file")
+    .Input("in")
+    .Output("handle")
+    .Attr<std::string>("path")
+    .Attr<std::string>("sbp_parallel")
+    .SetTensorDescInferFn(InferHandleTensorDesc)
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      const user_op::TensorDesc& in_tensor = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0);
+      FOR_RANGE(int64_t, i, 0, in_tensor.shape().NumAxes()) {
+        ctx->NewBuilder()
+            .Split(user_op::OpArg("in", 0), i)
+            .Broadcast(user_op::OpArg("handle", 0))
+            .Build();
+      }
+      ctx->NewBuilder()
+          .PartialSum(user_op::OpArg("in", 0))
+          .Broadcast(user_op::OpArg("handle", 0))
+          .Build();
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("in", 0))
+          .Broadcast(user_op::OpArg("handle", 0))
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetSbpSignatureInferFn([](user_op::InferSbpSignatureFnContext* ctx) -> Maybe<void> {
+      // in is spilled with the sbp of its producer, which load_spilled_file restores, so that it
+      // is never boxed before the spill
+      const Shape& in_shape = ctx->LogicalTensorDesc4InputArgNameAndIndex("in", 0).shape();
+      auto* bn2sbp = ctx->mutable_sbp_signature()->mutable_bn_in_op2sbp_parallel();
+      (*bn2sbp)[GenRepeatedBn("in", 0)] = *JUST(GetSpilledSbpParallel(ctx, in_shape.NumAxes()));
+      (*bn2sbp)[GenRepeatedBn("handle", 0)].mutable_broadcast_parallel();
+      return Maybe<void>::Ok();
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      *ctx->Dtype4ArgNameAndIndex("handle", 0) = DataType::kInt64;
+      return Maybe<void>::Ok();
+    });
+
+REGISTER_USER_OP("load_spilled_file")
+    .Input("handle")
+    .Output("out")
+    .Attr<std::string>("path")
+    .Attr<Shape>("shape")
+    .Attr<DataType>("dtype")
+    .Attr<std::string>("sbp_parallel")
+    .SetLogicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferSpilledTensorDesc(ctx, true);
+    })
+    .SetPhysicalTensorDescInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      return InferSpilledTensorDesc(ctx, false);
+    })
+    .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
+      ctx->NewBuilder()
+          .Broadcast(user_op::OpArg("handle", 0))
+          .Broadcast(user_op::OpArg("out", 0))
+          .Build();
+      return Maybe<void>::Ok();
+    })
+    .SetSbpSignatureInferFn([](user_op::InferSbpSignatureFnContext* ctx) -> Maybe<void> {
+      // out has the sbp of the spilled blob, whatever the sbp of handle is
+      auto* bn2sbp = ctx->mutable_sbp_signature()->mutable_bn_in_op2sbp_parallel();
+      (*bn2sbp)[GenRepeatedBn("handle", 0)].mutable_broadcast_parallel();
+      (*bn2sbp)[GenRepeatedBn("out", 0)] =
+          *JUST(GetSpilledSbpParallel(ctx, ctx->Attr<Shape>("shape").NumAxes()));
+      return Maybe<void>::Ok();
+    })
+    .SetDataTypeInferFn([](user_op::InferContext* ctx) -> Maybe<void> {
+      *ctx->Dtype4ArgNameAndIndex("out", 0) = ctx->Attr<DataType>("dtype");
+      return Maybe<void>::Ok();
+    });
+
+}  // namespace oneflow
@@ -30,13 +30,20 @@ REGISTER_USER_OP("upsample")
       user_op::TensorDesc* y_desc = ctx->TensorDesc4ArgNameAndIndex("y", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first"
-          || x_desc->shape().NumAxes() != 4) {
-        LOG(FATAL) << "upsample only supports NCHW";
+      const std::string& data_format = ctx->Attr<std::string>("data_format");
+      if (x_desc->shape().NumAxes() != 4) { LOG(FATAL) << "upsample only supports 4-D input"; }
+      if (data_format == "channels_first") {
+        *y_desc->mut_shape() = Shape({x_desc->shape().At(0), x_desc->shape().At(1),
+                                      static_cast<int32_t>(height_scale * x_desc->shape().At(2)),
+                                      static_cast<int32_t>(width_scale * x_desc->shape().At(3))});
+      } else if (data_format == "channels_last") {
+        *y_desc->mut_shape() = Shape({x_desc->shape().At(0),
+                                      static_cast<int32_t>(height_scale * x_desc->shape().At(1)),
+                                      static_cast<int32_t>(width_scale * x_desc->shape().At(2)),
+                                      x_desc->shape().At(3)});
+      } else {
+        LOG(FATAL) << "upsample only supports NCHW and NHWC";
       }
-      *y_desc->mut_shape() = Shape({x_desc->shape().At(0), x_desc->shape().At(1),
-                                    static_cast<int32_t>(height_scale * x_desc->shape().At(2)),
-                                    static_cast<int32_t>(width_scale * x_desc->shape().At(3))});
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {
@@ -61,12 +68,18 @@ REGISTER_USER_OP("upsample_grad")
       Shape* dx_shape = ctx->Shape4ArgNameAndIndex("dx", 0);
       const float height_scale = ctx->Attr<float>("height_scale");
       const float width_scale = ctx->Attr<float>("width_scale");
-      if (ctx->Attr<std::string>("data_format") != "channels_first" || dy_shape->NumAxes() != 4) {
-        LOG(FATAL) << "upsample_nearest only supports NCHW";
+      const std::string& data_format = ctx->Attr<std::string>("data_format");
+      if (dy_shape->NumAxes() != 4) { LOG(FATAL) << "upsample_grad only supports 4-D input"; }
+      if (data_format == "channels_first") {
+        *dx_shape = Shape({dy_shape->At(0), dy_shape->At(1),
+                           static_cast<int32_t>(dy_shape->At(2) / height_scale),
+                           static_cast<int32_t>(dy_shape->At(3) / width_scale)});
+      } else if (data_format == "channels_last") {
+        *dx_shape = Shape({dy_shape->At(0), static_cast<int32_t>(dy_shape->At(1) / height_scale),
+                           static_cast<int32_t>(dy_shape->At(2) / width_scale), dy_shape->At(3)});
+      } else {
+        LOG(FATAL) << "upsample_grad only supports NCHW and NHWC";
       }
-      *dx_shape = Shape({dy_shape->At(0), dy_shape->At(1),
-                         static_cast<int32_t>(dy_shape->At(2) / height_scale),
-                         static_cast<int32_t>(dy_shape->At(3) / width_scale)});
       return Maybe<void>::Ok();
     })
     .SetGetSbpFn([](user_op::SbpContext* ctx) -> Maybe<void> {